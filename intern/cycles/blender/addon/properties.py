@@ -919,6 +919,17 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         default=0,
         min=0, max=16,
     )
+    debug_use_bvh_cache: BoolProperty(
+        name="Use BVH Cache",
+        description="Reuse the BVH of objects that did not change since a previous render, "
+        "and refit the BVH of deforming objects instead of building it again",
+        default=False,
+    )
+    debug_use_bvh_disk_cache: BoolProperty(
+        name="Store on Disk",
+        description="Store the BVH cache in the user cache directory, to reuse it between Blender sessions",
+        default=False,
+    )
 
     bake_type: EnumProperty(
         name="Bake Type",
@@ -1041,6 +1052,25 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         min=8, max=8192,
     )
 
+    use_texture_cache: BoolProperty(
+        name="Texture Cache",
+        description="Load image textures on demand from tiled and mipmapped files while rendering on the CPU, "
+                    "keeping only the used tiles at the needed resolution in memory",
+        default=False,
+    )
+    texture_cache_size: IntProperty(
+        name="Cache Size",
+        description="Maximum memory used by the texture cache, in megabytes",
+        default=4096,
+        min=64, soft_max=65536,
+    )
+    use_texture_cache_auto_convert: BoolProperty(
+        name="Auto Convert",
+        description="Generate tiled and mipmapped versions of image files that are not, "
+                    "stored in the user cache directory",
+        default=True,
+    )
+
     # Various fine-tuning debug flags
 
     def _devices_update_callback(self, context):
@@ -1055,6 +1085,11 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         items=enum_bvh_layouts,
         default='EMBREE',
     )
+    debug_use_cpu_wavefront: BoolProperty(
+        name="Wavefront",
+        description="Render batches of paths kernel by kernel instead of tracing each path to completion",
+        default=False,
+    )
 
     debug_use_cuda_adaptive_compile: BoolProperty(name="Adaptive Compile", default=False)
 
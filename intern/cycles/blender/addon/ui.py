@@ -834,6 +834,14 @@ class CYCLES_RENDER_PT_performance_memory(CyclesButtonsPanel, Panel):
         sub.active = cscene.use_auto_tile
         sub.prop(cscene, "tile_size")
 
+        col = layout.column()
+        col.active = use_cpu(context)
+        col.prop(cscene, "use_texture_cache")
+        sub = col.column()
+        sub.active = cscene.use_texture_cache
+        sub.prop(cscene, "texture_cache_size")
+        sub.prop(cscene, "use_texture_cache_auto_convert")
+
 
 class CYCLES_RENDER_PT_performance_acceleration_structure(CyclesButtonsPanel, Panel):
     bl_label = "Acceleration Structure"
@@ -868,6 +876,11 @@ class CYCLES_RENDER_PT_performance_acceleration_structure(CyclesButtonsPanel, Pa
 
                 col.prop(cscene, "debug_use_hair_bvh")
 
+                col.prop(cscene, "debug_use_bvh_cache")
+                sub = col.column()
+                sub.active = cscene.debug_use_bvh_cache
+                sub.prop(cscene, "debug_use_bvh_disk_cache")
+
                 sub = col.column(align=True)
                 sub.label(text="Cycles built without Embree support")
                 sub.label(text="CPU raytracing performance will be poor")
@@ -879,6 +892,11 @@ class CYCLES_RENDER_PT_performance_acceleration_structure(CyclesButtonsPanel, Pa
 
             col.prop(cscene, "debug_use_hair_bvh")
 
+            col.prop(cscene, "debug_use_bvh_cache")
+            sub = col.column()
+            sub.active = cscene.debug_use_bvh_cache
+            sub.prop(cscene, "debug_use_bvh_disk_cache")
+
             # CPU is used in addition to a GPU
             if use_multi_device(context) and use_embree:
                 col.prop(cscene, "debug_use_compact_bvh")
@@ -2270,6 +2288,7 @@ class CYCLES_RENDER_PT_debug(CyclesDebugButtonsPanel, Panel):
         row.prop(cscene, "debug_use_cpu_sse42", toggle=True)
         row.prop(cscene, "debug_use_cpu_avx2", toggle=True)
         col.prop(cscene, "debug_bvh_layout", text="BVH")
+        col.prop(cscene, "debug_use_cpu_wavefront")
 
         col.separator()
 
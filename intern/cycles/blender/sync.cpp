@@ -30,6 +30,7 @@
 #include "util/hash.h"
 #include "util/log.h"
 #include "util/openimagedenoise.h"
+#include "util/path.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -860,6 +861,10 @@ SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene,
   params.use_bvh_compact_structure = RNA_boolean_get(&cscene, "debug_use_compact_bvh");
   params.use_bvh_unaligned_nodes = RNA_boolean_get(&cscene, "debug_use_hair_bvh");
   params.num_bvh_time_steps = RNA_int_get(&cscene, "debug_bvh_time_steps");
+  params.use_bvh_cache = RNA_boolean_get(&cscene, "debug_use_bvh_cache");
+  if (params.use_bvh_cache && RNA_boolean_get(&cscene, "debug_use_bvh_disk_cache")) {
+    params.bvh_cache_path = path_cache_get("bvh");
+  }
 
   PointerRNA csscene = RNA_pointer_get(&b_scene.ptr, "cycles_curves");
   params.hair_subdivisions = get_int(csscene, "subdivisions");
@@ -880,6 +885,11 @@ SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene,
     params.texture_limit = 0;
   }
 
+  params.use_texture_cache = RNA_boolean_get(&cscene, "use_texture_cache");
+  params.texture_cache_size = RNA_int_get(&cscene, "texture_cache_size");
+  params.use_texture_cache_auto_convert = RNA_boolean_get(&cscene,
+                                                          "use_texture_cache_auto_convert");
+
   params.bvh_layout = DebugFlags().cpu.bvh_layout;
 
   params.background = background;
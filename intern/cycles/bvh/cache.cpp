@@ -0,0 +1,435 @@
+/* SPDX-FileCopyrightText: 2011-2024 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "bvh/cache.h"
+
+#include "scene/attribute.h"
+#include "scene/geometry.h"
+#include "scene/hair.h"
+#include "scene/mesh.h"
+#include "scene/object.h"
+#include "scene/pointcloud.h"
+
+#include "util/log.h"
+#include "util/md5.h"
+#include "util/path.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Increment when the layout of packed BVH2 nodes changes, to not use stale builds from disk. */
+static const uint32_t BVH_CACHE_VERSION = 1;
+static const char BVH_CACHE_MAGIC[4] = {'C', 'B', 'V', 'H'};
+
+/* Maximum number of builds stored on disk, older ones are removed when new ones are added. The
+ * same limit applies to the files that map a topology to its most recent build. */
+static const size_t BVH_CACHE_MAX_FILES = 1024;
+
+/* Key */
+
+template<typename T> static void hash_value(MD5Hash &md5, const T value)
+{
+  md5.append((const uint8_t *)&value, sizeof(value));
+}
+
+template<typename T> static void hash_array(MD5Hash &md5, const T *data, const size_t size)
+{
+  hash_value(md5, uint64_t(size));
+
+  /* MD5Hash takes the size as int, so large arrays are appended in chunks. */
+  const uint8_t *bytes = (const uint8_t *)data;
+  size_t num_bytes = size * sizeof(T);
+  while (num_bytes > 0) {
+    const size_t chunk_size = min(num_bytes, size_t(1) << 30);
+    md5.append(bytes, int(chunk_size));
+    bytes += chunk_size;
+    num_bytes -= chunk_size;
+  }
+}
+
+static void hash_float3_array(MD5Hash &md5, const float3 *data, const size_t size)
+{
+  hash_value(md5, uint64_t(size));
+
+  /* Don't hash the 4th element used for padding. */
+  for (size_t i = 0; i < size; i++) {
+    md5.append((const uint8_t *)&data[i], sizeof(float) * 3);
+  }
+}
+
+static void hash_motion(MD5Hash &md5, const Geometry *geom)
+{
+  const Attribute *attr = (geom->has_motion_blur()) ?
+                              geom->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION) :
+                              nullptr;
+  if (attr == nullptr) {
+    hash_value(md5, uint64_t(0));
+    return;
+  }
+  hash_float3_array(md5, attr->data_float3(), attr->buffer.size() / sizeof(float3));
+}
+
+BVHCache::Key BVHCache::key(const Geometry *geom,
+                            const vector<Object *> &objects,
+                            const BVHParams &params)
+{
+  /* The topology hash includes everything that defines which primitives are in the tree, the
+   * content hash adds everything that only affects the bounds of the nodes. */
+  MD5Hash topology;
+  hash_value(topology, BVH_CACHE_VERSION);
+  hash_value(topology, params.bvh_layout);
+  hash_value(topology, params.use_spatial_split);
+  hash_value(topology, params.use_compact_structure);
+  hash_value(topology, params.use_unaligned_nodes);
+  hash_value(topology, params.num_motion_triangle_steps);
+  hash_value(topology, params.num_motion_curve_steps);
+  hash_value(topology, params.num_motion_point_steps);
+  hash_value(topology, params.curve_subdivisions);
+  hash_value(topology, geom->geometry_type);
+  hash_value(topology, geom->primitive_type());
+  hash_value(topology, geom->get_motion_steps());
+
+  MD5Hash content;
+  hash_motion(content, geom);
+
+  /* Primitives store the index and visibility of their object. The visibility is only in the
+   * content hash, because refitting updates it. */
+  hash_value(topology, uint64_t(objects.size()));
+  for (const Object *ob : objects) {
+    hash_value(content, ob->visibility_for_tracing());
+  }
+
+  if (geom->is_mesh() || geom->is_volume()) {
+    const Mesh *mesh = static_cast<const Mesh *>(geom);
+    const array<int> &triangles = mesh->get_triangles();
+    const array<float3> &verts = mesh->get_verts();
+    hash_array(topology, triangles.data(), triangles.size());
+    hash_float3_array(content, verts.data(), verts.size());
+  }
+  else if (geom->is_hair()) {
+    const Hair *hair = static_cast<const Hair *>(geom);
+    const array<int> &curve_first_key = hair->get_curve_first_key();
+    const array<float3> &curve_keys = hair->get_curve_keys();
+    const array<float> &curve_radius = hair->get_curve_radius();
+    hash_array(topology, curve_first_key.data(), curve_first_key.size());
+    hash_value(topology, uint64_t(curve_keys.size()));
+    hash_float3_array(content, curve_keys.data(), curve_keys.size());
+    hash_array(content, curve_radius.data(), curve_radius.size());
+  }
+  else if (geom->is_pointcloud()) {
+    const PointCloud *pointcloud = static_cast<const PointCloud *>(geom);
+    const array<float3> &points = pointcloud->get_points();
+    const array<float> &radius = pointcloud->get_radius();
+    hash_value(topology, uint64_t(points.size()));
+    hash_float3_array(content, points.data(), points.size());
+    hash_array(content, radius.data(), radius.size());
+  }
+
+  Key key;
+  key.topology = topology.get_hex();
+  content.append(key.topology);
+  key.content = content.get_hex();
+  return key;
+}
+
+/* Serialization */
+
+static size_t pack_memory_size(const PackedBVH &pack)
+{
+  return pack.nodes.size() * sizeof(int4) + pack.leaf_nodes.size() * sizeof(int4) +
+         pack.object_node.size() * sizeof(int) + pack.prim_type.size() * sizeof(int) +
+         pack.prim_visibility.size() * sizeof(uint) + pack.prim_index.size() * sizeof(int) +
+         pack.prim_object.size() * sizeof(int) + pack.prim_time.size() * sizeof(float2);
+}
+
+template<typename T> static void write_array(vector<uint8_t> &data, const array<T> &values)
+{
+  const uint64_t size = values.size();
+  const uint8_t *size_bytes = (const uint8_t *)&size;
+  data.insert(data.end(), size_bytes, size_bytes + sizeof(size));
+  if (size) {
+    const uint8_t *bytes = (const uint8_t *)values.data();
+    data.insert(data.end(), bytes, bytes + size * sizeof(T));
+  }
+}
+
+template<typename T>
+static bool read_array(const vector<uint8_t> &data, size_t &offset, array<T> &values)
+{
+  uint64_t size;
+  if (offset + sizeof(size) > data.size()) {
+    return false;
+  }
+  memcpy(&size, data.data() + offset, sizeof(size));
+  offset += sizeof(size);
+
+  if (size > (data.size() - offset) / sizeof(T)) {
+    return false;
+  }
+  T *values_data = values.resize(size);
+  if (size) {
+    memcpy((void *)values_data, data.data() + offset, size * sizeof(T));
+  }
+  offset += size * sizeof(T);
+  return true;
+}
+
+void BVHCache::pack_write(const PackedBVH &pack, vector<uint8_t> &data)
+{
+  data.clear();
+  data.reserve(pack_memory_size(pack) + 128);
+
+  data.insert(data.end(), BVH_CACHE_MAGIC, BVH_CACHE_MAGIC + sizeof(BVH_CACHE_MAGIC));
+  const uint32_t header[2] = {BVH_CACHE_VERSION, uint32_t(pack.root_index)};
+  const uint8_t *header_bytes = (const uint8_t *)header;
+  data.insert(data.end(), header_bytes, header_bytes + sizeof(header));
+
+  write_array(data, pack.nodes);
+  write_array(data, pack.leaf_nodes);
+  write_array(data, pack.object_node);
+  write_array(data, pack.prim_type);
+  write_array(data, pack.prim_visibility);
+  write_array(data, pack.prim_index);
+  write_array(data, pack.prim_object);
+  write_array(data, pack.prim_time);
+}
+
+bool BVHCache::pack_read(const vector<uint8_t> &data, PackedBVH &pack)
+{
+  uint32_t header[2];
+  size_t offset = sizeof(BVH_CACHE_MAGIC) + sizeof(header);
+  if (data.size() < offset || memcmp(data.data(), BVH_CACHE_MAGIC, sizeof(BVH_CACHE_MAGIC)) != 0)
+  {
+    return false;
+  }
+  memcpy(header, data.data() + sizeof(BVH_CACHE_MAGIC), sizeof(header));
+  if (header[0] != BVH_CACHE_VERSION) {
+    return false;
+  }
+  pack.root_index = int(header[1]);
+
+  /* Files may be truncated when another process was writing them at the same time. */
+  return read_array(data, offset, pack.nodes) && read_array(data, offset, pack.leaf_nodes) &&
+         read_array(data, offset, pack.object_node) && read_array(data, offset, pack.prim_type) &&
+         read_array(data, offset, pack.prim_visibility) &&
+         read_array(data, offset, pack.prim_index) &&
+         read_array(data, offset, pack.prim_object) &&
+         read_array(data, offset, pack.prim_time) && offset == data.size();
+}
+
+/* Cache */
+
+BVHCache &BVHCache::instance()
+{
+  static BVHCache cache;
+  return cache;
+}
+
+BVHCache::BVHCache() : memory_limit_(size_t(1) << 30), memory_used_(0), use_count_(0) {}
+
+BVHCache::~BVHCache() {}
+
+void BVHCache::set_directory(const string &directory)
+{
+  thread_scoped_lock lock(mutex_);
+  directory_ = directory;
+}
+
+void BVHCache::set_memory_limit(const size_t memory_limit)
+{
+  thread_scoped_lock lock(mutex_);
+  memory_limit_ = memory_limit;
+  while (memory_used_ > memory_limit_ && !entries_.empty()) {
+    remove_least_recently_used();
+  }
+}
+
+bool BVHCache::lookup(const Key &key, PackedBVH &pack, bool &refit)
+{
+  std::shared_ptr<const PackedBVH> cached = find(key, refit);
+  if (!cached) {
+    cached = find_file(key, refit);
+  }
+  if (!cached) {
+    return false;
+  }
+
+  /* Copy outside of the lock, geometry BVHs are built from multiple threads. */
+  pack = *cached;
+  return true;
+}
+
+std::shared_ptr<const PackedBVH> BVHCache::find(const Key &key, bool &refit)
+{
+  thread_scoped_lock lock(mutex_);
+
+  auto it = entries_.find(key.content);
+  refit = false;
+  if (it == entries_.end()) {
+    auto topology_it = topology_entries_.find(key.topology);
+    if (topology_it == topology_entries_.end()) {
+      return nullptr;
+    }
+    it = entries_.find(topology_it->second);
+    refit = true;
+  }
+
+  it->second.last_used = ++use_count_;
+  return it->second.pack;
+}
+
+/* Builds and topology files are in separate directories, because old files are removed per
+ * directory. */
+static string build_filepath_get(const string &directory, const string &content)
+{
+  return path_join(path_join(directory, "builds"), content + ".bvh");
+}
+
+static string topology_filepath_get(const string &directory, const string &topology)
+{
+  return path_join(path_join(directory, "topology"), topology);
+}
+
+std::shared_ptr<const PackedBVH> BVHCache::find_file(const Key &key, bool &refit)
+{
+  string directory;
+  {
+    thread_scoped_lock lock(mutex_);
+    directory = directory_;
+  }
+  if (directory.empty()) {
+    return nullptr;
+  }
+
+  /* Topology files contain the content hash of the last build with that topology. */
+  string content = key.content;
+  string filepath = build_filepath_get(directory, content);
+  refit = false;
+  if (!path_cache_kernel_exists_and_mark_used(filepath)) {
+    const string topology_filepath = topology_filepath_get(directory, key.topology);
+    if (!path_cache_kernel_exists_and_mark_used(topology_filepath) ||
+        !path_read_text(topology_filepath, content) || content.empty())
+    {
+      return nullptr;
+    }
+    filepath = build_filepath_get(directory, content);
+    if (!path_cache_kernel_exists_and_mark_used(filepath)) {
+      return nullptr;
+    }
+    refit = true;
+  }
+
+  vector<uint8_t> data;
+  std::shared_ptr<PackedBVH> pack = std::make_shared<PackedBVH>();
+  if (!path_read_binary(filepath, data) || !pack_read(data, *pack)) {
+    VLOG_WARNING << "Failed to read cached BVH " << filepath;
+    return nullptr;
+  }
+
+  /* Only keep exact matches in memory, refit builds are stored once they are refit. */
+  if (!refit) {
+    add(key, pack);
+  }
+  return pack;
+}
+
+void BVHCache::store(const Key &key, const PackedBVH &pack)
+{
+  std::shared_ptr<const PackedBVH> cached = std::make_shared<PackedBVH>(pack);
+  add(key, cached);
+
+  string directory;
+  {
+    thread_scoped_lock lock(mutex_);
+    directory = directory_;
+  }
+  if (directory.empty()) {
+    return;
+  }
+
+  const string filepath = build_filepath_get(directory, key.content);
+  if (path_cache_kernel_exists_and_mark_used(filepath)) {
+    return;
+  }
+
+  vector<uint8_t> data;
+  pack_write(*cached, data);
+  if (!path_write_binary(filepath, data)) {
+    VLOG_WARNING << "Failed to write cached BVH " << filepath;
+    return;
+  }
+  path_cache_kernel_mark_added_and_clear_old(filepath, BVH_CACHE_MAX_FILES);
+
+  const string topology_filepath = topology_filepath_get(directory, key.topology);
+  string content = key.content;
+  if (path_write_text(topology_filepath, content)) {
+    path_cache_kernel_mark_added_and_clear_old(topology_filepath, BVH_CACHE_MAX_FILES);
+  }
+}
+
+void BVHCache::add(const Key &key, std::shared_ptr<const PackedBVH> pack)
+{
+  thread_scoped_lock lock(mutex_);
+
+  const size_t memory_size = pack_memory_size(*pack);
+  if (memory_size > memory_limit_) {
+    return;
+  }
+
+  auto it = entries_.find(key.content);
+  if (it != entries_.end()) {
+    it->second.last_used = ++use_count_;
+    return;
+  }
+
+  Entry &entry = entries_[key.content];
+  entry.pack = std::move(pack);
+  entry.topology = key.topology;
+  entry.memory_size = memory_size;
+  entry.last_used = ++use_count_;
+  topology_entries_[key.topology] = key.content;
+  memory_used_ += memory_size;
+
+  while (memory_used_ > memory_limit_) {
+    remove_least_recently_used();
+  }
+}
+
+void BVHCache::remove_least_recently_used()
+{
+  auto oldest = entries_.begin();
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (it->second.last_used < oldest->second.last_used) {
+      oldest = it;
+    }
+  }
+
+  auto topology_it = topology_entries_.find(oldest->second.topology);
+  if (topology_it != topology_entries_.end() && topology_it->second == oldest->first) {
+    topology_entries_.erase(topology_it);
+  }
+  memory_used_ -= oldest->second.memory_size;
+  entries_.erase(oldest);
+}
+
+void BVHCache::clear()
+{
+  thread_scoped_lock lock(mutex_);
+  entries_.clear();
+  topology_entries_.clear();
+  memory_used_ = 0;
+}
+
+size_t BVHCache::memory_used()
+{
+  thread_scoped_lock lock(mutex_);
+  return memory_used_;
+}
+
+size_t BVHCache::size()
+{
+  thread_scoped_lock lock(mutex_);
+  return entries_.size();
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,99 @@
+/* SPDX-FileCopyrightText: 2011-2024 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#ifndef __BVH_CACHE_H__
+#define __BVH_CACHE_H__
+
+#include "bvh/bvh.h"
+#include "bvh/params.h"
+
+#include "util/map.h"
+#include "util/string.h"
+#include "util/thread.h"
+#include "util/types.h"
+#include "util/vector.h"
+
+#include <memory>
+
+CCL_NAMESPACE_BEGIN
+
+class Geometry;
+class Object;
+
+/* BVH Cache
+ *
+ * Keeps the BVH2 of individual geometries between sessions, so rendering consecutive frames or
+ * rendering the same frame again does not build the BVH of static geometry again. Builds can
+ * additionally be stored in a directory on disk, to be reused by other processes.
+ *
+ * Entries are identified by a hash of everything the build depends on, so they never need to be
+ * invalidated. Geometry with the same primitives but different positions, like deforming meshes,
+ * reuses the tree of an entry with the same topology and only refits its bounds.
+ *
+ * Only BVH2 is cached, the acceleration structures of Embree, OptiX, Metal and HIP-RT are owned by
+ * the device they were built for. */
+
+class BVHCache {
+ public:
+  struct Key {
+    /* Hash of the primitives, their positions, the visibility and the build parameters. */
+    string content;
+    /* Hash of the primitives, the objects and the build parameters only. */
+    string topology;
+  };
+
+  static BVHCache &instance();
+
+  BVHCache();
+  ~BVHCache();
+
+  /* Directory to store builds in, an empty path keeps them in memory only. */
+  void set_directory(const string &directory);
+  void set_memory_limit(size_t memory_limit);
+
+  /* The objects are the ones the BVH is built for, their visibility and indices are stored in
+   * the packed primitives. */
+  static Key key(const Geometry *geom, const vector<Object *> &objects, const BVHParams &params);
+
+  /* Copy the cached BVH with the given key into pack. When only the topology matches, refit is
+   * set and the bounds of the nodes need to be updated from the geometry. */
+  bool lookup(const Key &key, PackedBVH &pack, bool &refit);
+  void store(const Key &key, const PackedBVH &pack);
+
+  void clear();
+
+  size_t memory_used();
+  size_t size();
+
+  /* Serialization for the disk cache. */
+  static void pack_write(const PackedBVH &pack, vector<uint8_t> &data);
+  static bool pack_read(const vector<uint8_t> &data, PackedBVH &pack);
+
+ protected:
+  struct Entry {
+    std::shared_ptr<const PackedBVH> pack;
+    string topology;
+    size_t memory_size;
+    uint64_t last_used;
+  };
+
+  std::shared_ptr<const PackedBVH> find(const Key &key, bool &refit);
+  std::shared_ptr<const PackedBVH> find_file(const Key &key, bool &refit);
+  void add(const Key &key, std::shared_ptr<const PackedBVH> pack);
+  void remove_least_recently_used();
+
+  thread_mutex mutex_;
+  map<string, Entry> entries_;
+  /* Content hash of the most recent entry for every topology. */
+  map<string, string> topology_entries_;
+
+  string directory_;
+  size_t memory_limit_;
+  size_t memory_used_;
+  uint64_t use_count_;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __BVH_CACHE_H__ */
@@ -83,6 +83,7 @@ CPUDevice::~CPUDevice()
 #endif
 
   texture_info.free();
+  texture_cache_globals.reset();
 }
 
 BVHLayoutMask CPUDevice::get_bvh_layout_mask(uint /*kernel_features*/) const
@@ -310,6 +311,8 @@ void CPUDevice::get_cpu_kernel_thread_globals(
   /* Ensure latest texture info is loaded into kernel globals before returning. */
   load_texture_info();
 
+  kernel_globals.texture_cache = (texture_cache_globals.use) ? &texture_cache_globals : nullptr;
+
   kernel_thread_globals.clear();
   void *osl_memory = get_cpu_osl_memory();
   for (int i = 0; i < info.cpu_threads; i++) {
@@ -326,6 +329,11 @@ void *CPUDevice::get_cpu_osl_memory()
 #endif
 }
 
+void *CPUDevice::get_cpu_texture_cache_memory()
+{
+  return &texture_cache_globals;
+}
+
 bool CPUDevice::load_kernels(const uint /*kernel_features*/)
 {
   return true;
@@ -27,6 +27,7 @@
 #include "kernel/device/cpu/compat.h"
 #include "kernel/device/cpu/kernel.h"
 #include "kernel/device/cpu/globals.h"
+#include "kernel/device/cpu/texture_cache.h"
 
 #include "kernel/osl/globals.h"
 // clang-format on
@@ -46,6 +47,7 @@ class CPUDevice : public Device {
 #ifdef WITH_OSL
   OSLGlobals osl_globals;
 #endif
+  TextureCacheGlobals texture_cache_globals;
 #ifdef WITH_EMBREE
   RTCScene embree_scene = NULL;
   RTCDevice embree_device;
@@ -88,6 +90,7 @@ class CPUDevice : public Device {
   virtual void get_cpu_kernel_thread_globals(
       vector<CPUKernelThreadGlobals> &kernel_thread_globals) override;
   virtual void *get_cpu_osl_memory() override;
+  virtual void *get_cpu_texture_cache_memory() override;
 
  protected:
   virtual bool load_kernels(uint /*kernel_features*/) override;
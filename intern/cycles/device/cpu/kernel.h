@@ -13,8 +13,11 @@ CCL_NAMESPACE_BEGIN
 struct KernelGlobalsCPU;
 struct KernelFilmConvert;
 struct IntegratorStateCPU;
+struct IntegratorShadowStateCPU;
 struct TileInfo;
 
+enum DeviceKernel : int;
+
 class CPUKernels {
  public:
   /* Integrator. */
@@ -43,6 +46,24 @@ class CPUKernels {
   IntegratorShadeFunction integrator_shade_dedicated_light;
   IntegratorShadeFunction integrator_megakernel;
 
+  /* Batched execution of a single kernel, used by the wavefront integrator. */
+
+  using IntegratorQueuedPathsFunction =
+      CPUKernelFunction<void (*)(const KernelGlobalsCPU *kg,
+                                 const DeviceKernel kernel,
+                                 IntegratorStateCPU *const *states,
+                                 const int num_states,
+                                 ccl_global float *render_buffer)>;
+  using IntegratorQueuedShadowPathsFunction =
+      CPUKernelFunction<void (*)(const KernelGlobalsCPU *kg,
+                                 const DeviceKernel kernel,
+                                 IntegratorShadowStateCPU *const *states,
+                                 const int num_states,
+                                 ccl_global float *render_buffer)>;
+
+  IntegratorQueuedPathsFunction integrator_queued_paths;
+  IntegratorQueuedShadowPathsFunction integrator_queued_shadow_paths;
+
   /* Shader evaluation. */
 
   using ShaderEvalFunction = CPUKernelFunction<void (*)(
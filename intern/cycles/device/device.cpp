@@ -489,6 +489,11 @@ void *Device::get_cpu_osl_memory()
   return nullptr;
 }
 
+void *Device::get_cpu_texture_cache_memory()
+{
+  return nullptr;
+}
+
 GPUDevice::~GPUDevice() noexcept(false) {}
 
 bool GPUDevice::load_texture_info()
@@ -220,6 +220,8 @@ class Device {
       vector<CPUKernelThreadGlobals> & /*kernel_thread_globals*/);
   /* Get OpenShadingLanguage memory buffer. */
   virtual void *get_cpu_osl_memory();
+  /* Get texture cache memory buffer, only CPU devices read images on demand. */
+  virtual void *get_cpu_texture_cache_memory();
 
   /* Acceleration structure building. */
   virtual void build_bvh(BVH *bvh, Progress &progress, bool refit);
@@ -16,7 +16,9 @@
 #include "scene/scene.h"
 #include "session/buffers.h"
 
+#include "util/algorithm.h"
 #include "util/atomic.h"
+#include "util/debug.h"
 #include "util/log.h"
 #include "util/tbb.h"
 
@@ -42,6 +44,42 @@ static inline CPUKernelThreadGlobals *kernel_thread_globals_get(
   return &kernel_thread_globals[thread_index];
 }
 
+/* Number of pixels whose paths are traced together by the wavefront integrator. Large enough
+ * for kernels to run back to back many times, small enough for the states to stay in cache. */
+static constexpr int WAVEFRONT_BATCH_SIZE = 64;
+
+/* Order in which kernels of main paths are executed within one wavefront iteration.
+ * Intersection kernels come first so that the shading they queue happens in the same
+ * iteration. */
+static constexpr DeviceKernel wavefront_path_kernels[] = {
+    DEVICE_KERNEL_INTEGRATOR_INTERSECT_CLOSEST,
+    DEVICE_KERNEL_INTEGRATOR_INTERSECT_SUBSURFACE,
+    DEVICE_KERNEL_INTEGRATOR_INTERSECT_VOLUME_STACK,
+    DEVICE_KERNEL_INTEGRATOR_INTERSECT_DEDICATED_LIGHT,
+    DEVICE_KERNEL_INTEGRATOR_SHADE_BACKGROUND,
+    DEVICE_KERNEL_INTEGRATOR_SHADE_LIGHT,
+    DEVICE_KERNEL_INTEGRATOR_SHADE_DEDICATED_LIGHT,
+    DEVICE_KERNEL_INTEGRATOR_SHADE_SURFACE,
+    DEVICE_KERNEL_INTEGRATOR_SHADE_SURFACE_RAYTRACE,
+    DEVICE_KERNEL_INTEGRATOR_SHADE_SURFACE_MNEE,
+    DEVICE_KERNEL_INTEGRATOR_SHADE_VOLUME,
+};
+
+static constexpr DeviceKernel wavefront_shadow_path_kernels[] = {
+    DEVICE_KERNEL_INTEGRATOR_INTERSECT_SHADOW,
+    DEVICE_KERNEL_INTEGRATOR_SHADE_SHADOW,
+};
+
+static inline bool integrator_state_has_queued_shadow(const IntegratorStateCPU *state)
+{
+  return state->shadow.shadow_path.queued_kernel != 0 || state->ao.shadow_path.queued_kernel != 0;
+}
+
+static inline bool integrator_state_is_terminated(const IntegratorStateCPU *state)
+{
+  return state->path.queued_kernel == 0 && !integrator_state_has_queued_shadow(state);
+}
+
 PathTraceWorkCPU::PathTraceWorkCPU(Device *device,
                                    Film *film,
                                    DeviceScene *device_scene,
@@ -73,8 +111,41 @@ void PathTraceWorkCPU::render_samples(RenderStatistics &statistics,
     }
   }
 
+  /* Path guiding records the segments of a single path at a time per thread, so it requires
+   * paths to be traced to completion one after another. */
+  const bool use_wavefront = DebugFlags().cpu.wavefront &&
+                             !device_scene_->data.integrator.use_guiding;
+  if (use_wavefront) {
+    wavefront_thread_states_.resize(kernel_thread_globals_.size());
+  }
+
   tbb::task_arena local_arena = local_tbb_arena_create(device_);
   local_arena.execute([&]() {
+    if (use_wavefront) {
+      const int64_t num_batches = divide_up(total_pixels_num, WAVEFRONT_BATCH_SIZE);
+      parallel_for(int64_t(0), num_batches, [&](int64_t batch_index) {
+        if (is_cancel_requested()) {
+          return;
+        }
+
+        const int64_t first_work_index = batch_index * WAVEFRONT_BATCH_SIZE;
+        const int num_pixels = int(
+            std::min(int64_t(WAVEFRONT_BATCH_SIZE), total_pixels_num - first_work_index));
+
+        const int thread_index = tbb::this_task_arena::current_thread_index();
+        CPUKernelThreadGlobals *kernel_globals = kernel_thread_globals_get(kernel_thread_globals_);
+
+        render_samples_wavefront(kernel_globals,
+                                 wavefront_thread_states_[thread_index],
+                                 first_work_index,
+                                 num_pixels,
+                                 start_sample,
+                                 samples_num,
+                                 sample_offset);
+      });
+      return;
+    }
+
     parallel_for(int64_t(0), total_pixels_num, [&](int64_t work_index) {
       if (is_cancel_requested()) {
         return;
@@ -164,6 +235,170 @@ void PathTraceWorkCPU::render_samples_full_pipeline(KernelGlobalsCPU *kernel_glo
   }
 }
 
+void PathTraceWorkCPU::render_samples_wavefront(KernelGlobalsCPU *kernel_globals,
+                                                vector<IntegratorStateCPU> &states,
+                                                const int64_t first_work_index,
+                                                const int num_pixels,
+                                                const int start_sample,
+                                                const int samples_num,
+                                                const int sample_offset)
+{
+  const bool has_bake = device_scene_->data.bake.use;
+  const int64_t image_width = effective_buffer_params_.width;
+
+  /* The shadow catcher path of a pixel is split off into the state following its main path
+   * state, same as in the full pipeline. */
+  const int states_per_pixel = device_scene_->data.integrator.has_shadow_catcher ? 2 : 1;
+  states.resize(WAVEFRONT_BATCH_SIZE * 2);
+  for (IntegratorStateCPU &state : states) {
+    path_state_init_queues(&state);
+  }
+
+  /* Pixels stop being sampled once path initialization fails, e.g. when adaptive sampling
+   * considers them converged. */
+  vector<bool> pixel_active(num_pixels, true);
+  vector<IntegratorStateCPU *> paths;
+  paths.reserve(num_pixels * states_per_pixel);
+
+  float *render_buffer = buffers_->buffer.data();
+
+  for (int sample = 0; sample < samples_num; ++sample) {
+    if (is_cancel_requested()) {
+      break;
+    }
+
+    paths.clear();
+    for (int i = 0; i < num_pixels; ++i) {
+      if (!pixel_active[i]) {
+        continue;
+      }
+
+      const int64_t work_index = first_work_index + i;
+      const int y = work_index / image_width;
+      const int x = work_index - y * image_width;
+
+      KernelWorkTile work_tile;
+      work_tile.x = effective_buffer_params_.full_x + x;
+      work_tile.y = effective_buffer_params_.full_y + y;
+      work_tile.w = 1;
+      work_tile.h = 1;
+      work_tile.start_sample = start_sample + sample;
+      work_tile.sample_offset = sample_offset;
+      work_tile.num_samples = 1;
+      work_tile.offset = effective_buffer_params_.offset;
+      work_tile.stride = effective_buffer_params_.stride;
+
+      IntegratorStateCPU *state = &states[i * states_per_pixel];
+      const bool path_started =
+          has_bake ?
+              kernels_.integrator_init_from_bake(kernel_globals, state, &work_tile, render_buffer) :
+              kernels_.integrator_init_from_camera(
+                  kernel_globals, state, &work_tile, render_buffer);
+      if (!path_started) {
+        pixel_active[i] = false;
+        continue;
+      }
+
+      paths.push_back(state);
+      if (states_per_pixel == 2) {
+        paths.push_back(state + 1);
+      }
+    }
+
+    if (paths.empty()) {
+      break;
+    }
+
+    render_paths_wavefront(kernel_globals, paths, render_buffer);
+  }
+}
+
+void PathTraceWorkCPU::render_paths_wavefront(KernelGlobalsCPU *kernel_globals,
+                                              vector<IntegratorStateCPU *> &paths,
+                                              ccl_global float *render_buffer)
+{
+  /* Paths start out as pairs of main and shadow catcher states when there is a shadow catcher,
+   * so the parity relative to the first path tells which kind a state is. */
+  const bool has_shadow_catcher = device_scene_->data.integrator.has_shadow_catcher;
+  const IntegratorStateCPU *first_state = paths.empty() ? nullptr : paths.front();
+
+  vector<IntegratorStateCPU *> batch;
+  vector<IntegratorShadowStateCPU *> shadow_batch;
+  batch.reserve(paths.size());
+  shadow_batch.reserve(paths.size());
+
+  while (!paths.empty()) {
+    /* Handle any shadow and AO paths before main paths potentially create more of them,
+     * same order as in the megakernel. */
+    for (IntegratorShadowStateCPU IntegratorStateCPU::*shadow_member :
+         {&IntegratorStateCPU::shadow, &IntegratorStateCPU::ao})
+    {
+      bool has_queued_shadow = true;
+      while (has_queued_shadow) {
+        has_queued_shadow = false;
+        for (const DeviceKernel kernel : wavefront_shadow_path_kernels) {
+          shadow_batch.clear();
+          for (IntegratorStateCPU *state : paths) {
+            IntegratorShadowStateCPU *shadow_state = &(state->*shadow_member);
+            if (shadow_state->shadow_path.queued_kernel == kernel) {
+              shadow_batch.push_back(shadow_state);
+            }
+          }
+          if (!shadow_batch.empty()) {
+            kernels_.integrator_queued_shadow_paths(
+                kernel_globals, kernel, shadow_batch.data(), shadow_batch.size(), render_buffer);
+            has_queued_shadow = true;
+          }
+        }
+      }
+    }
+
+    /* Then advance main paths. A path that queued shadow rays is not advanced any further
+     * in this iteration, its shadows are handled first. */
+    for (const DeviceKernel kernel : wavefront_path_kernels) {
+      batch.clear();
+      for (IntegratorStateCPU *state : paths) {
+        if (state->path.queued_kernel == kernel && !integrator_state_has_queued_shadow(state)) {
+          batch.push_back(state);
+        }
+      }
+      if (batch.empty()) {
+        continue;
+      }
+
+      if (kernel == DEVICE_KERNEL_INTEGRATOR_SHADE_SURFACE ||
+          kernel == DEVICE_KERNEL_INTEGRATOR_SHADE_SURFACE_RAYTRACE ||
+          kernel == DEVICE_KERNEL_INTEGRATOR_SHADE_SURFACE_MNEE)
+      {
+        /* Group paths hitting the same shader for coherent shader evaluation. */
+        std::stable_sort(batch.begin(),
+                         batch.end(),
+                         [](const IntegratorStateCPU *a, const IntegratorStateCPU *b) {
+                           return a->path.shader_sort_key < b->path.shader_sort_key;
+                         });
+      }
+
+      kernels_.integrator_queued_paths(
+          kernel_globals, kernel, batch.data(), batch.size(), render_buffer);
+    }
+
+    /* Compact the list of paths. A shadow catcher state can only become active again while
+     * its main path (the state before it) is still running. */
+    paths.erase(std::remove_if(paths.begin(),
+                               paths.end(),
+                               [&](const IntegratorStateCPU *state) {
+                                 if (!integrator_state_is_terminated(state)) {
+                                   return false;
+                                 }
+                                 if (has_shadow_catcher && (state - first_state) % 2 == 1) {
+                                   return integrator_state_is_terminated(state - 1);
+                                 }
+                                 return true;
+                               }),
+                paths.end());
+  }
+}
+
 void PathTraceWorkCPU::copy_to_display(PathTraceDisplay *display,
                                        PassMode pass_mode,
                                        int num_samples)
@@ -74,6 +74,22 @@ class PathTraceWorkCPU : public PathTraceWork {
                                     const KernelWorkTile &work_tile,
                                     const int samples_num);
 
+  /* Wavefront path tracing routine. Renders all samples of a batch of consecutive pixels,
+   * advancing the paths of all pixels kernel by kernel. */
+  void render_samples_wavefront(KernelGlobalsCPU *kernel_globals,
+                                vector<IntegratorStateCPU> &states,
+                                const int64_t first_work_index,
+                                const int num_pixels,
+                                const int start_sample,
+                                const int samples_num,
+                                const int sample_offset);
+
+  /* Advance the given paths until all of them are terminated. Paths with the same kernel
+   * queued are executed together, shading is additionally grouped by shader. */
+  void render_paths_wavefront(KernelGlobalsCPU *kernel_globals,
+                              vector<IntegratorStateCPU *> &paths,
+                              ccl_global float *render_buffer);
+
   /* CPU kernels. */
   const CPUKernels &kernels_;
 
@@ -83,6 +99,9 @@ class PathTraceWorkCPU : public PathTraceWork {
    * accessing it, but some "localization" is required to decouple from kernel globals stored
    * on the device level. */
   vector<CPUKernelThreadGlobals> kernel_thread_globals_;
+
+  /* Per-thread storage of integrator states used by the wavefront integrator. */
+  vector<vector<IntegratorStateCPU>> wavefront_thread_states_;
 };
 
 CCL_NAMESPACE_END
@@ -25,6 +25,8 @@ struct OSLThreadData;
 struct OSLShadingSystem;
 #endif
 
+struct TextureCacheGlobals;
+
 /* Array for kernel data, with size to be able to assert on invalid data access. */
 template<typename T> struct kernel_array {
   ccl_always_inline const T &fetch(int index) const
@@ -52,6 +54,9 @@ typedef struct KernelGlobalsCPU {
   int osl_thread_index = 0;
 #endif
 
+  /* Images read on demand from tiled files, NULL when the texture cache is not used. */
+  TextureCacheGlobals *texture_cache = nullptr;
+
 #ifdef __PATH_GUIDING__
   /* Pointers to global data structures. */
   openpgl::cpp::SampleStorage *opgl_sample_data_storage = nullptr;
@@ -10,6 +10,18 @@
 
 CCL_NAMESPACE_BEGIN
 
+struct TextureCacheGlobals;
+
+/* Look up an image that is read on demand from a tiled file, see #TextureCacheGlobals. Returns
+ * false if the image is loaded into memory instead. */
+bool kernel_tex_image_interp_cache(const TextureCacheGlobals *texture_cache,
+                                   int id,
+                                   float x,
+                                   float y,
+                                   float2 dx,
+                                   float2 dy,
+                                   float4 *r);
+
 /* Make template functions private so symbols don't conflict between kernels with different
  * instruction sets. */
 namespace {
@@ -811,8 +823,17 @@ template<typename TexT, typename OutT> struct NanoVDBInterpolator {
 
 #undef SET_CUBIC_SPLINE_WEIGHTS
 
-ccl_device float4 kernel_tex_image_interp(KernelGlobals kg, int id, float x, float y)
+/* Derivatives of the texture coordinates are only used to pick mip levels of cached images. */
+ccl_device float4
+kernel_tex_image_interp(KernelGlobals kg, int id, float x, float y, float2 dx, float2 dy)
 {
+  if (kg->texture_cache) {
+    float4 r;
+    if (kernel_tex_image_interp_cache(kg->texture_cache, id, x, y, dx, dy, &r)) {
+      return r;
+    }
+  }
+
   const TextureInfo &info = kernel_data_fetch(texture_info, id);
 
   if (UNLIKELY(!info.data)) {
@@ -851,6 +872,11 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals kg, int id, float x, flo
   }
 }
 
+ccl_device float4 kernel_tex_image_interp(KernelGlobals kg, int id, float x, float y)
+{
+  return kernel_tex_image_interp(kg, id, x, y, zero_float2(), zero_float2());
+}
+
 ccl_device float4 kernel_tex_image_interp_3d(KernelGlobals kg,
                                              int id,
                                              float3 P,
@@ -38,6 +38,18 @@ KERNEL_INTEGRATOR_SHADE_FUNCTION(shade_volume);
 KERNEL_INTEGRATOR_SHADE_FUNCTION(shade_dedicated_light);
 KERNEL_INTEGRATOR_SHADE_FUNCTION(megakernel);
 
+void KERNEL_FUNCTION_FULL_NAME(integrator_queued_paths)(const KernelGlobalsCPU *ccl_restrict kg,
+                                                        const DeviceKernel kernel,
+                                                        IntegratorStateCPU *const *states,
+                                                        const int num_states,
+                                                        ccl_global float *render_buffer);
+void KERNEL_FUNCTION_FULL_NAME(integrator_queued_shadow_paths)(
+    const KernelGlobalsCPU *ccl_restrict kg,
+    const DeviceKernel kernel,
+    IntegratorShadowStateCPU *const *states,
+    const int num_states,
+    ccl_global float *render_buffer);
+
 #undef KERNEL_INTEGRATOR_FUNCTION
 #undef KERNEL_INTEGRATOR_INIT_FUNCTION
 #undef KERNEL_INTEGRATOR_SHADE_FUNCTION
@@ -113,6 +113,33 @@ DEFINE_INTEGRATOR_SHADE_KERNEL(megakernel)
 DEFINE_INTEGRATOR_SHADOW_KERNEL(intersect_shadow)
 DEFINE_INTEGRATOR_SHADOW_SHADE_KERNEL(shade_shadow)
 
+void KERNEL_FUNCTION_FULL_NAME(integrator_queued_paths)(const KernelGlobalsCPU *kg,
+                                                        const DeviceKernel kernel,
+                                                        IntegratorStateCPU *const *states,
+                                                        const int num_states,
+                                                        ccl_global float *render_buffer)
+{
+#ifdef KERNEL_STUB
+  STUB_ASSERT(KERNEL_ARCH, integrator_queued_paths);
+#else
+  integrator_queued_paths(kg, kernel, states, num_states, render_buffer);
+#endif
+}
+
+void KERNEL_FUNCTION_FULL_NAME(integrator_queued_shadow_paths)(
+    const KernelGlobalsCPU *kg,
+    const DeviceKernel kernel,
+    IntegratorShadowStateCPU *const *states,
+    const int num_states,
+    ccl_global float *render_buffer)
+{
+#ifdef KERNEL_STUB
+  STUB_ASSERT(KERNEL_ARCH, integrator_queued_shadow_paths);
+#else
+  integrator_queued_shadow_paths(kg, kernel, states, num_states, render_buffer);
+#endif
+}
+
 /* --------------------------------------------------------------------
  * Shader evaluation.
  */
@@ -0,0 +1,111 @@
+/* SPDX-FileCopyrightText: 2011-2024 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "kernel/device/cpu/texture_cache.h"
+
+#include "util/math.h"
+
+CCL_NAMESPACE_BEGIN
+
+using OIIO::TextureOpt;
+
+void TextureCacheGlobals::reset()
+{
+  if (ts) {
+    OIIO::TextureSystem::destroy(ts);
+    ts = NULL;
+  }
+
+  images.clear();
+  to_scene_linear = NULL;
+  use = false;
+}
+
+static TextureOpt::InterpMode texture_cache_interp_mode(const InterpolationType interpolation)
+{
+  switch (interpolation) {
+    case INTERPOLATION_CLOSEST:
+      return TextureOpt::InterpClosest;
+    case INTERPOLATION_CUBIC:
+      return TextureOpt::InterpBicubic;
+    case INTERPOLATION_SMART:
+      return TextureOpt::InterpSmartBicubic;
+    default:
+      return TextureOpt::InterpBilinear;
+  }
+}
+
+static TextureOpt::Wrap texture_cache_wrap_mode(const ExtensionType extension)
+{
+  switch (extension) {
+    case EXTENSION_EXTEND:
+      return TextureOpt::WrapClamp;
+    case EXTENSION_CLIP:
+      return TextureOpt::WrapBlack;
+    case EXTENSION_MIRROR:
+      return TextureOpt::WrapMirror;
+    default:
+      return TextureOpt::WrapPeriodic;
+  }
+}
+
+bool kernel_tex_image_interp_cache(const TextureCacheGlobals *texture_cache,
+                                   int id,
+                                   float x,
+                                   float y,
+                                   float2 dx,
+                                   float2 dy,
+                                   float4 *r)
+{
+  if (id < 0 || id >= (int)texture_cache->images.size()) {
+    return false;
+  }
+
+  const TextureCacheImage &image = texture_cache->images[id];
+  if (!image.handle) {
+    return false;
+  }
+
+  TextureOpt opt;
+  opt.interpmode = texture_cache_interp_mode(image.interpolation);
+  opt.swrap = opt.twrap = texture_cache_wrap_mode(image.extension);
+
+  /* Image rows are flipped compared to OIIO texture coordinates. */
+  const int channels = min(image.channels, 4);
+  float result[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+  if (!texture_cache->ts->texture(image.handle,
+                                  NULL,
+                                  opt,
+                                  x,
+                                  1.0f - y,
+                                  dx.x,
+                                  -dx.y,
+                                  dy.x,
+                                  -dy.y,
+                                  channels,
+                                  result))
+  {
+    *r = make_float4(
+        TEX_IMAGE_MISSING_R, TEX_IMAGE_MISSING_G, TEX_IMAGE_MISSING_B, TEX_IMAGE_MISSING_A);
+    return true;
+  }
+
+  /* The kernel works with single channel and RGBA images, like in ImageManager::file_load_image. */
+  if (channels == 1) {
+    result[1] = result[2] = result[0];
+  }
+  else if (channels == 2) {
+    result[3] = result[1];
+    result[1] = result[2] = result[0];
+  }
+
+  if (image.processor) {
+    texture_cache->to_scene_linear(image.processor, result, 4);
+  }
+
+  *r = make_float4(result[0], result[1], result[2], result[3]);
+  return true;
+}
+
+CCL_NAMESPACE_END
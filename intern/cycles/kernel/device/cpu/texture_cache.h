@@ -0,0 +1,69 @@
+/* SPDX-FileCopyrightText: 2011-2024 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#pragma once
+
+#include <OpenImageIO/texture.h>
+
+#include "util/texture.h"
+#include "util/thread.h"
+#include "util/types.h"
+#include "util/vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+class ColorSpaceProcessor;
+
+/* Texture Cache Globals
+ *
+ * Image textures that are not loaded into memory, but read on demand from tiled and mip-mapped
+ * files through an OIIO texture system. Only the tiles of the mip levels that are sampled are kept
+ * in memory, up to a fixed memory budget. The mip level is chosen from the derivatives of the
+ * texture coordinates, which SVM computes from ray differentials.
+ *
+ * Owned by the CPU device and filled in by the image manager, images are indexed by their slot. */
+
+struct TextureCacheImage {
+  TextureCacheImage()
+  {
+    handle = NULL;
+    processor = NULL;
+    channels = 0;
+    interpolation = INTERPOLATION_LINEAR;
+    extension = EXTENSION_REPEAT;
+  }
+
+  OIIO::TextureSystem::TextureHandle *handle;
+  OIIO::ustring filepath;
+  /* Conversion to scene linear, NULL for images that need none. */
+  ColorSpaceProcessor *processor;
+  int channels;
+  InterpolationType interpolation;
+  ExtensionType extension;
+};
+
+struct TextureCacheGlobals {
+  TextureCacheGlobals()
+  {
+    ts = NULL;
+    to_scene_linear = NULL;
+    use = false;
+  }
+
+  /* Free the texture system and all images in it. */
+  void reset();
+
+  bool use;
+  OIIO::TextureSystem *ts;
+
+  /* Conversion of looked up pixels to scene linear, set by the image manager along with the
+   * processors of the images, so the kernel doesn't depend on the scene color management. */
+  void (*to_scene_linear)(ColorSpaceProcessor *processor, float *pixel, int channels);
+
+  /* Images by slot, with a NULL handle for slots that are loaded into memory. */
+  vector<TextureCacheImage> images;
+  thread_mutex images_mutex;
+};
+
+CCL_NAMESPACE_END
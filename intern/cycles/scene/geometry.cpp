@@ -4,6 +4,7 @@
 
 #include "bvh/bvh.h"
 #include "bvh/bvh2.h"
+#include "bvh/cache.h"
 
 #include "device/device.h"
 
@@ -939,6 +940,10 @@ void GeometryManager::device_update(Device *device,
         scene->update_stats->geometry.times.add_entry({"device_update (build object BVHs)", time});
       }
     });
+    if (scene->params.use_bvh_cache) {
+      BVHCache::instance().set_directory(scene->params.bvh_cache_path);
+    }
+
     TaskPool pool;
 
     size_t i = 0;
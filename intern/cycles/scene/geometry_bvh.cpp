@@ -4,6 +4,7 @@
 
 #include "bvh/bvh.h"
 #include "bvh/bvh2.h"
+#include "bvh/cache.h"
 
 #include "device/device.h"
 
@@ -95,7 +96,31 @@ void Geometry::compute_bvh(Device *device,
 
       delete bvh;
       bvh = BVH::create(bparams, geometry, objects, device);
-      MEM_GUARDED_CALL(progress, device->build_bvh, bvh, *progress, false);
+
+      /* Reuse the BVH built for equal geometry in an earlier session, or refit the tree of
+       * geometry with the same topology. */
+      if (params->use_bvh_cache && bvh_layout == BVH_LAYOUT_BVH2) {
+        BVHCache &cache = BVHCache::instance();
+        const BVHCache::Key key = BVHCache::key(this, objects, bparams);
+        BVH2 *bvh2 = static_cast<BVH2 *>(bvh);
+        bool refit = false;
+        if (cache.lookup(key, bvh2->pack, refit)) {
+          if (refit) {
+            progress->set_status(msg, "Refitting cached BVH");
+            device->build_bvh(bvh, *progress, true);
+            cache.store(key, bvh2->pack);
+          }
+        }
+        else {
+          MEM_GUARDED_CALL(progress, device->build_bvh, bvh, *progress, false);
+          if (!progress->get_cancel()) {
+            cache.store(key, bvh2->pack);
+          }
+        }
+      }
+      else {
+        MEM_GUARDED_CALL(progress, device->build_bvh, bvh, *progress, false);
+      }
     }
   }
 
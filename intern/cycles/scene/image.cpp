@@ -4,6 +4,7 @@
 
 #include "scene/image.h"
 #include "device/device.h"
+#include "kernel/device/cpu/texture_cache.h"
 #include "scene/colorspace.h"
 #include "scene/image_oiio.h"
 #include "scene/image_vdb.h"
@@ -14,12 +15,15 @@
 #include "util/image.h"
 #include "util/image_impl.h"
 #include "util/log.h"
+#include "util/md5.h"
 #include "util/path.h"
 #include "util/progress.h"
 #include "util/task.h"
 #include "util/texture.h"
 #include "util/unique_ptr.h"
 
+#include <OpenImageIO/imagebufalgo.h>
+
 #ifdef WITH_OSL
 #  include <OSL/oslexec.h>
 #endif
@@ -322,6 +326,7 @@ ImageManager::ImageManager(const DeviceInfo &info)
 {
   need_update_ = true;
   osl_texture_system = NULL;
+  texture_cache = NULL;
   animation_frame = 0;
 
   /* Set image limits */
@@ -340,6 +345,16 @@ void ImageManager::set_osl_texture_system(void *texture_system)
   osl_texture_system = texture_system;
 }
 
+void ImageManager::set_texture_cache(TextureCacheGlobals *texture_cache)
+{
+  this->texture_cache = texture_cache;
+}
+
+bool ImageManager::use_texture_cache() const
+{
+  return texture_cache != NULL;
+}
+
 bool ImageManager::set_animation_frame_update(int frame)
 {
   if (frame != animation_frame) {
@@ -689,6 +704,119 @@ bool ImageManager::file_load_image(Image *img, int texture_limit)
   return true;
 }
 
+/* Path of a tiled and mip-mapped version of the image, generated in the cache directory when the
+ * image is not stored like that already. Falls back to the original file on failure, which the
+ * texture system then tiles and mip-maps in memory. */
+static string texture_cache_tiled_filepath(const string &filepath)
+{
+  unique_ptr<ImageInput> in(ImageInput::open(filepath));
+  if (!in) {
+    return filepath;
+  }
+
+  const bool is_tiled = in->spec().tile_width > 0 && in->seek_subimage(0, 1);
+  in->close();
+
+  if (is_tiled) {
+    return filepath;
+  }
+
+  const uint64_t modified_time = path_modified_time(filepath);
+  MD5Hash md5;
+  md5.append((const uint8_t *)filepath.c_str(), filepath.size());
+  md5.append((const uint8_t *)&modified_time, sizeof(modified_time));
+
+  const string tx_filepath = path_cache_get(path_join("textures", md5.get_hex() + ".tx"));
+  if (path_cache_kernel_exists_and_mark_used(tx_filepath)) {
+    return tx_filepath;
+  }
+
+  /* Write to a temporary file first, so other processes never read partially written files. */
+  path_create_directories(tx_filepath);
+  const string tmp_filepath = tx_filepath + "." + OIIO::Filesystem::unique_path() + ".tmp";
+
+  ImageSpec config;
+  config.tile_width = 64;
+  config.tile_height = 64;
+  config.tile_depth = 1;
+
+  string rename_error;
+  if (!ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxTexture, filepath, tmp_filepath, config) ||
+      !OIIO::Filesystem::rename(tmp_filepath, tx_filepath, rename_error))
+  {
+    VLOG_WARNING << "Failed to generate tiled texture for " << filepath << ": "
+                 << OIIO::geterror() << rename_error;
+    path_remove(tmp_filepath);
+    return filepath;
+  }
+
+  VLOG_INFO << "Generated tiled texture " << tx_filepath << " for " << filepath << ".";
+  path_cache_kernel_mark_added_and_clear_old(tx_filepath, 4096);
+  return tx_filepath;
+}
+
+bool ImageManager::texture_cache_load_image(Scene *scene, size_t slot, Progress *progress)
+{
+  Image *img = images[slot];
+  const ImageMetaData &metadata = img->metadata;
+  const string filepath = img->loader->osl_filepath().string();
+
+  /* Only 2D images read from files. The texture system associates alpha for all images, so
+   * images that need to keep it unassociated are loaded into memory. */
+  const bool has_alpha = (metadata.channels == 2 || metadata.channels == 4);
+  if (filepath.empty() || metadata.channels == 0 || metadata.depth > 1 ||
+      metadata.use_transform_3d || (has_alpha && !image_associate_alpha(img)))
+  {
+    return false;
+  }
+
+  string texture_filepath = filepath;
+  if (scene->params.use_texture_cache_auto_convert) {
+    progress->set_status("Updating Images", "Converting " + img->loader->name());
+    texture_filepath = texture_cache_tiled_filepath(filepath);
+  }
+
+  thread_scoped_lock cache_lock(texture_cache->images_mutex);
+
+  if (!texture_cache->ts) {
+    OIIO::TextureSystem *ts = OIIO::TextureSystem::create(false);
+    /* Untiled images are still supported, but read and mip-mapped in memory. */
+    ts->attribute("automip", 1);
+    ts->attribute("autotile", 64);
+    ts->attribute("max_memory_MB", scene->params.texture_cache_size);
+    texture_cache->ts = ts;
+    texture_cache->to_scene_linear = ColorSpaceManager::to_scene_linear;
+    texture_cache->use = true;
+  }
+
+  const ustring texture_filepath_u(texture_filepath);
+  int exists = 0;
+  if (!texture_cache->ts->get_texture_info(
+          texture_filepath_u, 0, ustring("exists"), TypeDesc::INT, &exists) ||
+      !exists)
+  {
+    return false;
+  }
+
+  if (slot >= texture_cache->images.size()) {
+    texture_cache->images.resize(slot + 1);
+  }
+
+  TextureCacheImage &image = texture_cache->images[slot];
+  image.handle = texture_cache->ts->get_texture_handle(texture_filepath_u);
+  image.filepath = texture_filepath_u;
+  image.channels = metadata.channels;
+  image.interpolation = img->params.interpolation;
+  image.extension = img->params.extension;
+  /* Images in sRGB are converted by the kernel, like images loaded into memory. */
+  image.processor = (metadata.colorspace != u_colorspace_raw &&
+                     metadata.colorspace != u_colorspace_srgb) ?
+                        ColorSpaceManager::get_processor(metadata.colorspace) :
+                        NULL;
+
+  return image.handle != NULL;
+}
+
 void ImageManager::device_load_image(Device *device, Scene *scene, size_t slot, Progress *progress)
 {
   if (progress->get_cancel()) {
@@ -714,6 +842,13 @@ void ImageManager::device_load_image(Device *device, Scene *scene, size_t slot,
     img->mem = NULL;
   }
 
+  /* Images in the texture cache are read on demand while rendering. */
+  if (texture_cache && texture_cache_load_image(scene, slot, progress)) {
+    img->loader->cleanup();
+    img->need_load = false;
+    return;
+  }
+
   img->mem = new device_texture(
       device, img->mem_name.c_str(), slot, type, img->params.interpolation, img->params.extension);
   img->mem->info.use_transform_3d = img->metadata.use_transform_3d;
@@ -843,6 +978,14 @@ void ImageManager::device_free_image(Device *, size_t slot)
 #endif
   }
 
+  if (texture_cache) {
+    thread_scoped_lock cache_lock(texture_cache->images_mutex);
+    if (slot < texture_cache->images.size() && texture_cache->images[slot].handle) {
+      texture_cache->ts->invalidate(texture_cache->images[slot].filepath);
+      texture_cache->images[slot] = TextureCacheImage();
+    }
+  }
+
   if (img->mem) {
     thread_scoped_lock device_lock(device_mutex);
     delete img->mem;
@@ -934,6 +1077,11 @@ void ImageManager::device_free(Device *device)
     device_free_image(device, slot);
   }
   images.clear();
+
+  if (texture_cache && texture_cache->ts) {
+    VLOG_INFO << "Texture cache statistics:\n" << texture_cache->ts->getstats(1);
+    texture_cache->reset();
+  }
 }
 
 void ImageManager::collect_statistics(RenderStats *stats)
@@ -943,9 +1091,33 @@ void ImageManager::collect_statistics(RenderStats *stats)
       /* Image may have been freed due to lack of users. */
       continue;
     }
+    if (!image->mem) {
+      /* Image is read on demand by the texture cache or by OSL. */
+      continue;
+    }
     stats->image.textures.add_entry(
         NamedSizeEntry(image->loader->name(), image->mem->memory_size()));
   }
+
+  if (texture_cache && texture_cache->ts) {
+    OIIO::TextureSystem *ts = texture_cache->ts;
+    long long memory_used = 0, bytes_read = 0, tile_lookups = 0;
+    int tile_misses = 0;
+    float memory_limit_mb = 0.0f;
+    ts->getattribute("stat:cache_memory_used", TypeDesc::INT64, &memory_used);
+    ts->getattribute("stat:bytes_read", TypeDesc::INT64, &bytes_read);
+    ts->getattribute("stat:find_tile_calls", TypeDesc::INT64, &tile_lookups);
+    ts->getattribute("stat:find_tile_cache_misses", TypeDesc::INT, &tile_misses);
+    ts->getattribute("max_memory_MB", TypeDesc::FLOAT, &memory_limit_mb);
+
+    TextureCacheStats &cache_stats = stats->image.texture_cache;
+    cache_stats.used = true;
+    cache_stats.memory_used = memory_used;
+    cache_stats.memory_limit = (size_t)(memory_limit_mb * 1024.0f * 1024.0f);
+    cache_stats.bytes_read = bytes_read;
+    cache_stats.tile_lookups = tile_lookups;
+    cache_stats.tile_misses = tile_misses;
+  }
 }
 
 void ImageManager::tag_update()
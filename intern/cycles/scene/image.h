@@ -28,6 +28,7 @@ class RenderStats;
 class Scene;
 class ColorSpaceProcessor;
 class VDBImageLoader;
+struct TextureCacheGlobals;
 
 /* Image Parameters */
 class ImageParams {
@@ -187,6 +188,8 @@ class ImageManager {
   void device_free_builtin(Device *device);
 
   void set_osl_texture_system(void *texture_system);
+  void set_texture_cache(TextureCacheGlobals *texture_cache);
+  bool use_texture_cache() const;
   bool set_animation_frame_update(int frame);
 
   void collect_statistics(RenderStats *stats);
@@ -223,6 +226,7 @@ class ImageManager {
 
   vector<Image *> images;
   void *osl_texture_system;
+  TextureCacheGlobals *texture_cache;
 
   size_t add_image_slot(ImageLoader *loader, const ImageParams &params, const bool builtin);
   void add_image_user(size_t slot);
@@ -234,6 +238,7 @@ class ImageManager {
   bool file_load_image(Image *img, int texture_limit);
 
   void device_load_image(Device *device, Scene *scene, size_t slot, Progress *progress);
+  bool texture_cache_load_image(Scene *scene, size_t slot, Progress *progress);
   void device_free_image(Device *device, size_t slot);
 
   friend class ImageHandle;
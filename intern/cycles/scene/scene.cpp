@@ -60,6 +60,10 @@ Scene::Scene(const SceneParams &params_, Device *device)
   geometry_manager = new GeometryManager();
   object_manager = new ObjectManager();
   image_manager = new ImageManager(device->info);
+  if (params.use_texture_cache) {
+    image_manager->set_texture_cache(
+        (TextureCacheGlobals *)device->get_cpu_texture_cache_memory());
+  }
   particle_system_manager = new ParticleSystemManager();
   bake_manager = new BakeManager();
   procedural_manager = new ProceduralManager();
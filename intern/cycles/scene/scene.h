@@ -72,6 +72,19 @@ class SceneParams {
   CurveShapeType hair_shape;
   int texture_limit;
 
+  /* Read image textures on demand from tiled and mip-mapped files instead of loading them into
+   * memory, when rendering on the CPU. See #TextureCacheGlobals. */
+  bool use_texture_cache;
+  /* Memory budget of the texture cache in megabytes. */
+  int texture_cache_size;
+  /* Generate tiled and mip-mapped files in the cache directory for images that are not. */
+  bool use_texture_cache_auto_convert;
+
+  /* Reuse geometry BVHs built in earlier sessions, see #BVHCache. */
+  bool use_bvh_cache;
+  /* Directory to store geometry BVHs in, when empty they are kept in memory only. */
+  string bvh_cache_path;
+
   bool background;
 
   SceneParams()
@@ -86,6 +99,10 @@ class SceneParams {
     hair_subdivisions = 3;
     hair_shape = CURVE_RIBBON;
     texture_limit = 0;
+    use_texture_cache = false;
+    texture_cache_size = 4096;
+    use_texture_cache_auto_convert = false;
+    use_bvh_cache = false;
     background = true;
   }
 
@@ -98,7 +115,10 @@ class SceneParams {
              use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes &&
              num_bvh_time_steps == params.num_bvh_time_steps &&
              hair_subdivisions == params.hair_subdivisions && hair_shape == params.hair_shape &&
-             texture_limit == params.texture_limit);
+             texture_limit == params.texture_limit &&
+             use_texture_cache == params.use_texture_cache &&
+             texture_cache_size == params.texture_cache_size &&
+             use_texture_cache_auto_convert == params.use_texture_cache_auto_convert);
   }
 
   int curve_subdivisions()
@@ -5,6 +5,7 @@
 #include "scene/shader_graph.h"
 #include "scene/attribute.h"
 #include "scene/constant_fold.h"
+#include "scene/image.h"
 #include "scene/scene.h"
 #include "scene/shader.h"
 #include "scene/shader_nodes.h"
@@ -364,6 +365,9 @@ void ShaderGraph::simplify(Scene *scene)
     default_inputs(scene->shader_manager->use_osl());
     clean(scene);
     refine_bump_nodes();
+    if (scene->image_manager->use_texture_cache() && !scene->shader_manager->use_osl()) {
+      refine_texture_derivatives();
+    }
 
     simplified = true;
   }
@@ -987,6 +991,51 @@ void ShaderGraph::refine_bump_nodes()
   }
 }
 
+void ShaderGraph::refine_texture_derivatives()
+{
+  /* Images in the texture cache pick their mip level from the derivatives of the texture
+   * coordinates. Like in refine_bump_nodes(), we copy the sub-graph defining the texture
+   * coordinates twice, with texture coordinates shifted by the ray differentials, and connect
+   * the copies to the internal inputs of the image texture. */
+
+  foreach (ShaderNode *node, nodes) {
+    if (node->type != ImageTextureNode::get_node_type() || node->bump == SHADER_BUMP_DX ||
+        node->bump == SHADER_BUMP_DY)
+    {
+      continue;
+    }
+
+    ImageTextureNode *image_node = static_cast<ImageTextureNode *>(node);
+    ShaderInput *vector_in = node->input("Vector");
+    if (image_node->get_projection() == NODE_IMAGE_PROJ_BOX || !vector_in->link) {
+      continue;
+    }
+
+    ShaderNodeSet nodes_vector;
+    ShaderNodeMap nodes_dx;
+    ShaderNodeMap nodes_dy;
+
+    find_dependencies(nodes_vector, vector_in);
+
+    copy_nodes(nodes_vector, nodes_dx);
+    copy_nodes(nodes_vector, nodes_dy);
+
+    foreach (NodePair &pair, nodes_dx)
+      pair.second->bump = SHADER_BUMP_DX;
+    foreach (NodePair &pair, nodes_dy)
+      pair.second->bump = SHADER_BUMP_DY;
+
+    ShaderOutput *out = vector_in->link;
+    connect(nodes_dx[out->parent]->output(out->name()), node->input("VectorDx"));
+    connect(nodes_dy[out->parent]->output(out->name()), node->input("VectorDy"));
+
+    foreach (NodePair &pair, nodes_dx)
+      add(pair.second);
+    foreach (NodePair &pair, nodes_dy)
+      add(pair.second);
+  }
+}
+
 void ShaderGraph::bump_from_displacement(bool use_object_space)
 {
   /* generate bump mapping automatically from displacement. bump mapping is
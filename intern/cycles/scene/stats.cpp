@@ -210,6 +210,31 @@ string MeshStats::full_report(int indent_level)
   return result;
 }
 
+/* Texture cache statistics. */
+
+TextureCacheStats::TextureCacheStats()
+    : used(false), memory_used(0), memory_limit(0), bytes_read(0), tile_lookups(0), tile_misses(0)
+{
+}
+
+string TextureCacheStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  const double hit_rate = (tile_lookups) ? 1.0 - (double)tile_misses / tile_lookups : 1.0;
+  string result = "";
+  result += string_printf("%sMemory: %s of %s\n",
+                          indent.c_str(),
+                          string_human_readable_size(memory_used).c_str(),
+                          string_human_readable_size(memory_limit).c_str());
+  result += string_printf(
+      "%sRead from disk: %s\n", indent.c_str(), string_human_readable_size(bytes_read).c_str());
+  result += string_printf("%sTile lookups: %s (%.2f%% hit rate)\n",
+                          indent.c_str(),
+                          string_human_readable_number(tile_lookups).c_str(),
+                          hit_rate * 100.0);
+  return result;
+}
+
 /* Image statistics. */
 
 ImageStats::ImageStats() {}
@@ -219,6 +244,9 @@ string ImageStats::full_report(int indent_level)
   const string indent(indent_level * kIndentNumSpaces, ' ');
   string result = "";
   result += indent + "Textures:\n" + textures.full_report(indent_level + 1);
+  if (texture_cache.used) {
+    result += indent + "Texture cache:\n" + texture_cache.full_report(indent_level + 1);
+  }
   return result;
 }
 
@@ -150,6 +150,22 @@ class MeshStats {
   NamedSizeStats geometry;
 };
 
+/* Statistics about images read on demand by the texture cache. */
+class TextureCacheStats {
+ public:
+  TextureCacheStats();
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  bool used;
+  size_t memory_used;
+  size_t memory_limit;
+  size_t bytes_read;
+  uint64_t tile_lookups;
+  uint64_t tile_misses;
+};
+
 /* Statistics about images held in memory. */
 class ImageStats {
  public:
@@ -159,6 +175,7 @@ class ImageStats {
   string full_report(int indent_level = 0);
 
   NamedSizeStats textures;
+  TextureCacheStats texture_cache;
 };
 
 /* Render process statistics. */
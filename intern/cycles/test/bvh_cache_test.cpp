@@ -0,0 +1,179 @@
+/* SPDX-FileCopyrightText: 2011-2024 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "bvh/cache.h"
+
+#include "scene/mesh.h"
+#include "scene/object.h"
+
+#include "util/path.h"
+
+#include <OpenImageIO/filesystem.h>
+
+CCL_NAMESPACE_BEGIN
+
+static void add_quad(Mesh &mesh, const float z)
+{
+  const int v = mesh.get_verts().size();
+  mesh.reserve_mesh(v + 4, mesh.num_triangles() + 2);
+  mesh.add_vertex(make_float3(0.0f, 0.0f, z));
+  mesh.add_vertex(make_float3(1.0f, 0.0f, z));
+  mesh.add_vertex(make_float3(1.0f, 1.0f, z));
+  mesh.add_vertex(make_float3(0.0f, 1.0f, z));
+  mesh.add_triangle(v + 0, v + 1, v + 2, 0, false);
+  mesh.add_triangle(v + 0, v + 2, v + 3, 0, false);
+}
+
+static PackedBVH create_pack(const int num_nodes)
+{
+  PackedBVH pack;
+  pack.nodes.resize(num_nodes * 4);
+  for (int i = 0; i < pack.nodes.size(); i++) {
+    pack.nodes[i] = make_int4(i, i + 1, i + 2, i + 3);
+  }
+  pack.prim_index.resize(num_nodes);
+  for (int i = 0; i < pack.prim_index.size(); i++) {
+    pack.prim_index[i] = i;
+  }
+  pack.prim_time.resize(1);
+  pack.prim_time[0] = make_float2(0.0f, 1.0f);
+  pack.root_index = -1;
+  return pack;
+}
+
+TEST(bvh_cache, key)
+{
+  BVHParams params;
+
+  Mesh mesh;
+  add_quad(mesh, 0.0f);
+  Object object;
+  object.set_geometry(&mesh);
+  object.set_visibility(~0);
+  vector<Object *> objects = {&object};
+  const BVHCache::Key key = BVHCache::key(&mesh, objects, params);
+  EXPECT_EQ(BVHCache::key(&mesh, objects, params).content, key.content);
+
+  /* Moving vertices keeps the topology. */
+  mesh.get_verts()[0].z = 0.5f;
+  const BVHCache::Key moved_key = BVHCache::key(&mesh, objects, params);
+  EXPECT_NE(moved_key.content, key.content);
+  EXPECT_EQ(moved_key.topology, key.topology);
+
+  /* Visibility is stored in the nodes, but is updated when refitting. */
+  object.set_visibility(PATH_RAY_CAMERA);
+  const BVHCache::Key visibility_key = BVHCache::key(&mesh, objects, params);
+  EXPECT_NE(visibility_key.content, moved_key.content);
+  EXPECT_EQ(visibility_key.topology, key.topology);
+
+  /* Object indices are stored in the primitives. */
+  Object other_object;
+  other_object.set_geometry(&mesh);
+  objects.push_back(&other_object);
+  EXPECT_NE(BVHCache::key(&mesh, objects, params).topology, key.topology);
+  objects.pop_back();
+
+  add_quad(mesh, 1.0f);
+  EXPECT_NE(BVHCache::key(&mesh, objects, params).topology, key.topology);
+
+  /* Build parameters affect the tree. */
+  params.use_spatial_split = !params.use_spatial_split;
+  EXPECT_NE(BVHCache::key(&mesh, objects, params).topology, key.topology);
+}
+
+TEST(bvh_cache, pack_read_write)
+{
+  const PackedBVH pack = create_pack(8);
+
+  vector<uint8_t> data;
+  BVHCache::pack_write(pack, data);
+
+  PackedBVH read_pack;
+  EXPECT_TRUE(BVHCache::pack_read(data, read_pack));
+  EXPECT_EQ(read_pack.root_index, -1);
+  ASSERT_EQ(read_pack.nodes.size(), pack.nodes.size());
+  EXPECT_EQ(read_pack.nodes[13].y, pack.nodes[13].y);
+  ASSERT_EQ(read_pack.prim_index.size(), pack.prim_index.size());
+  EXPECT_EQ(read_pack.prim_index[7], 7);
+  EXPECT_EQ(read_pack.prim_time[0].y, 1.0f);
+  EXPECT_EQ(read_pack.leaf_nodes.size(), 0);
+
+  /* Truncated files are rejected. */
+  data.resize(data.size() - 1);
+  EXPECT_FALSE(BVHCache::pack_read(data, read_pack));
+}
+
+TEST(bvh_cache, lookup)
+{
+  BVHCache cache;
+
+  const BVHCache::Key key = {"content", "topology"};
+  cache.store(key, create_pack(4));
+
+  PackedBVH pack;
+  bool refit = true;
+  EXPECT_TRUE(cache.lookup(key, pack, refit));
+  EXPECT_FALSE(refit);
+  EXPECT_EQ(pack.nodes.size(), 16);
+
+  /* Geometry with equal topology reuses the tree, but needs to refit it. */
+  EXPECT_TRUE(cache.lookup({"moved", "topology"}, pack, refit));
+  EXPECT_TRUE(refit);
+
+  EXPECT_FALSE(cache.lookup({"other", "other"}, pack, refit));
+}
+
+TEST(bvh_cache, memory_limit)
+{
+  BVHCache cache;
+
+  cache.store({"a", "a"}, create_pack(4));
+  const size_t memory_size = cache.memory_used();
+  cache.set_memory_limit(memory_size * 2);
+  cache.store({"b", "b"}, create_pack(4));
+
+  /* Use the first entry, so the second one is the least recently used. */
+  PackedBVH pack;
+  bool refit;
+  EXPECT_TRUE(cache.lookup({"a", "a"}, pack, refit));
+  cache.store({"c", "c"}, create_pack(4));
+
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.memory_used(), memory_size * 2);
+  EXPECT_TRUE(cache.lookup({"a", "a"}, pack, refit));
+  EXPECT_FALSE(cache.lookup({"b", "b"}, pack, refit));
+  EXPECT_TRUE(cache.lookup({"c", "c"}, pack, refit));
+}
+
+TEST(bvh_cache, directory)
+{
+  const string directory = OIIO::Filesystem::unique_path(
+      path_join(OIIO::Filesystem::temp_directory_path(), "cycles_bvh_cache_test_%%%%%%%%"));
+
+  {
+    BVHCache cache;
+    cache.set_directory(directory);
+    cache.store({"content", "topology"}, create_pack(4));
+  }
+
+  /* Another process finds the build, or the tree to refit. */
+  BVHCache cache;
+  cache.set_directory(directory);
+  PackedBVH pack;
+  bool refit = true;
+  EXPECT_TRUE(cache.lookup({"content", "topology"}, pack, refit));
+  EXPECT_FALSE(refit);
+  EXPECT_EQ(pack.nodes.size(), 16);
+
+  cache.clear();
+  EXPECT_TRUE(cache.lookup({"moved", "topology"}, pack, refit));
+  EXPECT_TRUE(refit);
+  EXPECT_FALSE(cache.lookup({"other", "other"}, pack, refit));
+
+  OIIO::Filesystem::remove_all(directory);
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,220 @@
+/* SPDX-FileCopyrightText: 2011-2024 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "device/cpu/kernel_thread_globals.h"
+#include "device/device.h"
+
+#include "kernel/device/cpu/compat.h"
+#include "kernel/device/cpu/globals.h"
+#include "kernel/device/cpu/image.h"
+
+#include "scene/colorspace.h"
+#include "scene/image.h"
+#include "scene/scene.h"
+
+#include "util/image.h"
+#include "util/path.h"
+#include "util/progress.h"
+#include "util/stats.h"
+#include "util/string.h"
+#include "util/unique_ptr.h"
+
+#include <OpenImageIO/filesystem.h>
+
+#ifdef WITH_OCIO
+#  include <OpenColorIO/OpenColorIO.h>
+namespace OCIO = OCIO_NAMESPACE;
+#endif
+
+CCL_NAMESPACE_BEGIN
+
+static const int image_width = 16;
+static const int image_height = 8;
+
+/* Write an image where every pixel and channel has a different value. */
+static void write_image(const string &filepath, const int channels, const float offset)
+{
+  vector<float> pixels(image_width * image_height * channels);
+  for (int i = 0; i < pixels.size(); i++) {
+    pixels[i] = fmodf(offset + float(i) * 0.037f, 1.0f);
+  }
+
+  unique_ptr<ImageOutput> out(ImageOutput::create(filepath));
+  ASSERT_TRUE(out);
+  const bool is_float = string_endswith(filepath, ".exr");
+  ImageSpec spec(image_width, image_height, channels, is_float ? TypeDesc::FLOAT : TypeDesc::UINT8);
+  ASSERT_TRUE(out->open(filepath, spec));
+  ASSERT_TRUE(out->write_image(TypeDesc::FLOAT, pixels.data()));
+  out->close();
+}
+
+/* An image loaded into memory and the same image read on demand by the texture cache. */
+class TextureCache : public testing::Test {
+ protected:
+  Stats stats;
+  Profiler profiler;
+  DeviceInfo device_info;
+  Device *device_memory;
+  Device *device_cache;
+  Scene *scene_memory;
+  Scene *scene_cache;
+  string temp_dir;
+
+  virtual void SetUp()
+  {
+#ifdef WITH_OCIO
+    /* Use the Blender configuration when available, so images in other color spaces than sRGB
+     * and linear are converted. */
+    const string config_filepath = path_join(blender::tests::flags_test_release_dir(),
+                                             "datafiles/colormanagement/config.ocio");
+    if (path_exists(config_filepath)) {
+      OCIO::SetCurrentConfig(OCIO::Config::CreateFromFile(config_filepath.c_str()));
+    }
+    else {
+      ColorSpaceManager::init_fallback_config();
+    }
+#endif
+
+    temp_dir = path_join(OIIO::Filesystem::temp_directory_path(),
+                         OIIO::Filesystem::unique_path("cycles_texture_cache_test_%%%%%%%%"));
+    path_create_directories(path_join(temp_dir, "file"));
+
+    SceneParams params;
+    device_memory = Device::create(device_info, stats, profiler, true);
+    scene_memory = new Scene(params, device_memory);
+
+    params.use_texture_cache = true;
+    device_cache = Device::create(device_info, stats, profiler, true);
+    scene_cache = new Scene(params, device_cache);
+  }
+
+  virtual void TearDown()
+  {
+    delete scene_memory;
+    delete scene_cache;
+    delete device_memory;
+    delete device_cache;
+    OIIO::Filesystem::remove_all(temp_dir);
+  }
+
+  static ImageHandle add_image(Scene *scene,
+                               const string &filepath,
+                               const ImageParams &params,
+                               const array<int> &tiles)
+  {
+    if (tiles.empty()) {
+      return scene->image_manager->add_image(filepath, params);
+    }
+    return scene->image_manager->add_image(filepath, params, tiles);
+  }
+
+  /* Load the image into both scenes and compare every pixel of every tile. */
+  void expect_images_match(const string &filepath,
+                           const ImageParams &params,
+                           const array<int> &tiles = array<int>())
+  {
+    ImageHandle handle_memory = add_image(scene_memory, filepath, params, tiles);
+    ImageHandle handle_cache = add_image(scene_cache, filepath, params, tiles);
+
+    Progress progress;
+    scene_memory->image_manager->device_update(device_memory, scene_memory, progress);
+    scene_cache->image_manager->device_update(device_cache, scene_cache, progress);
+
+    vector<CPUKernelThreadGlobals> kg_memory;
+    vector<CPUKernelThreadGlobals> kg_cache;
+    device_memory->get_cpu_kernel_thread_globals(kg_memory);
+    device_cache->get_cpu_kernel_thread_globals(kg_cache);
+    ASSERT_EQ(kg_memory[0].texture_cache, nullptr);
+    ASSERT_NE(kg_cache[0].texture_cache, nullptr);
+
+    ASSERT_EQ(handle_memory.num_tiles(), handle_cache.num_tiles());
+    for (int tile = 0; tile < handle_memory.num_tiles(); tile++) {
+      const int slot_memory = handle_memory.svm_slot(tile);
+      const int slot_cache = handle_cache.svm_slot(tile);
+      /* The image must actually be read by the texture cache. */
+      ASSERT_LT(slot_cache, kg_cache[0].texture_cache->images.size());
+      ASSERT_NE(kg_cache[0].texture_cache->images[slot_cache].handle, nullptr);
+
+      for (int y = 0; y < image_height; y++) {
+        for (int x = 0; x < image_width; x++) {
+          /* Pixel centers, with closest interpolation and the full resolution mip level. */
+          const float u = (x + 0.5f) / image_width;
+          const float v = (y + 0.5f) / image_height;
+          const float4 memory = kernel_tex_image_interp(&kg_memory[0], slot_memory, u, v);
+          const float4 cache = kernel_tex_image_interp(&kg_cache[0], slot_cache, u, v);
+          for (int c = 0; c < 4; c++) {
+            EXPECT_NEAR(memory[c], cache[c], 3e-3f)
+                << filepath << " tile " << tile << " x " << x << " y " << y << " channel " << c;
+          }
+        }
+      }
+    }
+
+    handle_memory.clear();
+    handle_cache.clear();
+  }
+};
+
+TEST_F(TextureCache, srgb)
+{
+  const string filepath = path_join(temp_dir, "srgb.png");
+  write_image(filepath, 3, 0.0f);
+
+  ImageParams params;
+  params.interpolation = INTERPOLATION_CLOSEST;
+  expect_images_match(filepath, params);
+}
+
+TEST_F(TextureCache, alpha)
+{
+  const string filepath = path_join(temp_dir, "alpha.png");
+  write_image(filepath, 4, 0.1f);
+
+  ImageParams params;
+  params.interpolation = INTERPOLATION_CLOSEST;
+  expect_images_match(filepath, params);
+}
+
+TEST_F(TextureCache, single_channel)
+{
+  const string filepath = path_join(temp_dir, "gray.exr");
+  write_image(filepath, 1, 0.2f);
+
+  ImageParams params;
+  params.interpolation = INTERPOLATION_CLOSEST;
+  expect_images_match(filepath, params);
+}
+
+TEST_F(TextureCache, colorspace)
+{
+  /* Byte and float images in color spaces converted to scene linear by the texture cache. */
+  const string filepath_byte = path_join(temp_dir, "p3.png");
+  const string filepath_float = path_join(temp_dir, "rec2020.exr");
+  write_image(filepath_byte, 3, 0.3f);
+  write_image(filepath_float, 3, 0.4f);
+
+  ImageParams params;
+  params.interpolation = INTERPOLATION_CLOSEST;
+  params.colorspace = ustring("Display P3");
+  expect_images_match(filepath_byte, params);
+  params.colorspace = ustring("Linear Rec.2020");
+  expect_images_match(filepath_float, params);
+}
+
+TEST_F(TextureCache, udim)
+{
+  write_image(path_join(temp_dir, "udim.1001.png"), 4, 0.5f);
+  write_image(path_join(temp_dir, "udim.1002.png"), 4, 0.6f);
+
+  ImageParams params;
+  params.interpolation = INTERPOLATION_CLOSEST;
+  array<int> tiles;
+  tiles.push_back_slow(1001);
+  tiles.push_back_slow(1002);
+  expect_images_match(path_join(temp_dir, "udim.<UDIM>.png"), params, tiles);
+}
+
+CCL_NAMESPACE_END
@@ -46,6 +46,10 @@ class DebugFlags {
      * CPUs and GPUs can be selected here instead.
      */
     BVHLayout bvh_layout = BVH_LAYOUT_AUTO;
+
+    /* Advance batches of paths kernel by kernel in lock-step, as done on GPUs, instead of
+     * tracing every path to completion with the megakernel. */
+    bool wavefront = false;
   };
 
   /* Descriptor of CUDA feature-set to be used. */
@@ -362,6 +362,18 @@ void BKE_animsys_eval_driver(struct Depsgraph *depsgraph,
 
 void BKE_animsys_update_driver_array(struct ID *id);
 
+/**
+ * Free the compiled evaluation of the active action, see #BKE_animsys_evaluate_animdata.
+ */
+void BKE_animsys_eval_plan_free(struct AnimData *adt);
+/**
+ * Tag the compiled evaluations of all evaluated data-blocks to be compiled again on their next
+ * evaluation. Needed when the data their RNA paths were resolved in may have been freed, like
+ * after evaluated copies of actions are updated or the relations of a dependency graph are
+ * rebuilt.
+ */
+void BKE_animsys_eval_plans_invalidate(void);
+
 /* ************************************* */
 
 #ifdef __cplusplus
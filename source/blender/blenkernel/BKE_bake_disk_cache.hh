@@ -0,0 +1,98 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bke
+ *
+ * A persistent cache for geometry that is stored in the user's cache directory. Entries are
+ * identified by a key that is computed from everything that the cached geometry depends on, so
+ * they never have to be invalidated explicitly. This allows reusing e.g. the result of an
+ * expensive geometry nodes modifier across sessions when neither its inputs nor the node tree
+ * changed.
+ *
+ * The data is stored in the same format as baked geometry.
+ */
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "BLI_string_ref.hh"
+
+#include "BKE_bake_data_block_map.hh"
+#include "BKE_geometry_set.hh"
+
+namespace blender::bke::bake {
+
+/**
+ * Incrementally computes the key of a disk cache entry. All data that may have an effect on the
+ * cached value has to be added to the key.
+ */
+class DiskCacheKeyBuilder : NonCopyable, NonMovable {
+ private:
+  struct State;
+  std::unique_ptr<State> state_;
+
+ public:
+  DiskCacheKeyBuilder();
+  ~DiskCacheKeyBuilder();
+
+  void add(const void *data, int64_t size);
+  void add(StringRef str);
+
+  template<typename T> void add_value(const T &value)
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    this->add(&value, sizeof(T));
+  }
+
+  /**
+   * Add the content of the geometry to the key. Only geometries for which
+   * #geometry_is_disk_cacheable returns true are supported. Anonymous attributes are ignored,
+   * because they are not stored in the cache either.
+   */
+  void add(const GeometrySet &geometry);
+
+  /** Get the final key. It only contains characters that can be used in file names. */
+  std::string build() const;
+};
+
+/**
+ * Not all geometry can be stored in the cache, because it can't be serialized fully. This is
+ * the case for e.g. instances that reference objects or collections and for Grease Pencil data.
+ */
+bool geometry_is_disk_cacheable(const GeometrySet &geometry);
+
+/**
+ * Load the geometry that has been stored for the given key before.
+ * \param data_block_map: Used to restore references to data-blocks like materials.
+ * \return None if there is no cache entry for the key, or if it could not be loaded.
+ */
+std::optional<GeometrySet> disk_cache_read_geometry(StringRef key,
+                                                    BakeDataBlockMap *data_block_map);
+
+/**
+ * Store the geometry for the given key. Existing entries are not overwritten. Concurrent writes
+ * of the same key (e.g. from multiple Blender instances) are supported, because the entry is only
+ * moved to its final location once it is complete.
+ */
+void disk_cache_write_geometry(StringRef key, GeometrySet geometry);
+
+/**
+ * Remove the least recently used entries until the cache is not larger than the given size.
+ * This is done automatically when a new entry makes the cache larger than its maximum size.
+ * The size is only computed from the files in the cache directory on the first write and on
+ * cleanup, in between it is kept up to date by the writes of this process.
+ */
+void disk_cache_cleanup(int64_t max_size);
+
+/**
+ * Use a different directory than the one in the user's cache directory, e.g. for tests.
+ * Passing none restores the default.
+ */
+void disk_cache_dir_override_set(std::optional<std::string> dir);
+
+}  // namespace blender::bke::bake
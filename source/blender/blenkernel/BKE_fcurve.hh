@@ -599,6 +599,12 @@ void BKE_fcurve_correct_bezpart(const float v1[2], float v2[2], float v3[2], con
 
 /* evaluate fcurve */
 float evaluate_fcurve(const FCurve *fcu, float evaltime);
+/**
+ * Same as #evaluate_fcurve, for evaluating the same F-Curve at many nearby times, like on every
+ * frame during playback. \a segment_hint is the keyframe segment found by the previous evaluation,
+ * which is checked before searching all keyframes. Initialize it to zero.
+ */
+float evaluate_fcurve_segment_hint(const FCurve *fcu, float evaltime, int *segment_hint);
 float evaluate_fcurve_only_curve(const FCurve *fcu, float evaltime);
 float evaluate_fcurve_driver(PathResolvedRNA *anim_rna,
                              FCurve *fcu,
@@ -62,6 +62,14 @@ enum {
    * IDs have at least an 'extra user' (#LIB_TAG_EXTRAUSER).
    */
   IDTYPE_FLAGS_NEVER_UNUSED = 1 << 6,
+  /**
+   * Indicates that the `blend_write` callback of the given IDType only modifies the temporary
+   * copy of the ID it is given, and only reads the original data. This allows to serialize
+   * several IDs of this type in parallel when writing a file to disk.
+   *
+   * \note Does not apply to undo steps, which always write IDs one after the other.
+   */
+  IDTYPE_FLAGS_THREADSAFE_BLEND_WRITE = 1 << 7,
 };
 
 struct IDCacheKey {
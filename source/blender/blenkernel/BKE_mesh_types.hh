@@ -23,6 +23,7 @@
 
 struct BMEditMesh;
 struct BVHCache;
+struct MDeformVert;
 struct Mesh;
 class ShrinkwrapBoundaryData;
 struct SubdivCCG;
@@ -107,6 +108,59 @@ struct TrianglesCache {
   void tag_dirty();
 };
 
+/**
+ * Vertex group weights of a mesh in a fixed width table, used to avoid walking the
+ * #MDeformVert lists of every vertex in every evaluation of the armature deform.
+ */
+struct DeformWeightTable : NonCopyable, NonMovable {
+  /** Number of vertex groups stored for every vertex. */
+  static constexpr int width = 4;
+  /** The vertex group data the table was built from. */
+  const MDeformVert *dverts = nullptr;
+  /**
+   * Sharing info of the vertex group layer the table was built from. Only a weak user is held,
+   * so the table doesn't keep old vertex group data alive and doesn't force a copy of the layer
+   * when it is changed in place, e.g. by weight painting.
+   */
+  const ImplicitSharingInfo *dverts_sharing_info = nullptr;
+  /** Version of #dverts_sharing_info when the table was built, to detect changes in place. */
+  int64_t dverts_version = 0;
+  /**
+   * #width vertex group indices and weights for every vertex, sorted by decreasing weight.
+   * Unused entries have a group index of -1 and a zero weight.
+   */
+  Array<int> groups;
+  Array<float> weights;
+  /** Vertices with more vertex groups than fit in the table. */
+  Array<bool> overflow;
+
+  DeformWeightTable() = default;
+  ~DeformWeightTable()
+  {
+    if (dverts_sharing_info) {
+      dverts_sharing_info->remove_weak_user_and_delete_if_last();
+    }
+  }
+};
+
+/**
+ * Lazily built #DeformWeightTable, shared between copies of a mesh. Copies with different vertex
+ * group data (e.g. after the Data Transfer modifier) each get their own table, the least recently
+ * used ones are removed, see #deform_weight_table_get. A table that is outdated because its
+ * vertex group data changed is replaced right away.
+ *
+ * Every table takes 33 bytes per vertex (#width group indices and weights and the overflow flag),
+ * so up to #tables_max times that is kept for every mesh that is deformed by an armature. The
+ * vertex group data itself is not kept alive by the cache.
+ */
+struct DeformWeightTableCache {
+  /** Number of tables kept, enough for the original and an evaluated mesh with other weights. */
+  static constexpr int tables_max = 2;
+  std::mutex mutex;
+  /** Most recently used first. */
+  Vector<std::shared_ptr<const DeformWeightTable>, tables_max> tables;
+};
+
 struct MeshRuntime {
   /**
    * "Evaluated" mesh owned by this mesh. Used for objects which don't have effective modifiers, so
@@ -220,6 +274,10 @@ struct MeshRuntime {
   /** Cache of non-manifold boundary data for shrinkwrap target Project. */
   SharedCache<ShrinkwrapBoundaryData> shrinkwrap_boundary_cache;
 
+  /** Cache of vertex group weights for the armature deform. */
+  std::shared_ptr<DeformWeightTableCache> deform_weight_table_cache =
+      std::make_shared<DeformWeightTableCache>();
+
   /**
    * A bit vector the size of the number of vertices, set to true for the center vertices of
    * subdivided faces. The values are set by the subdivision surface modifier and used by
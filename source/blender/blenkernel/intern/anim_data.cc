@@ -260,6 +260,9 @@ void BKE_animdata_free(ID *id, const bool do_id_user)
   /* free driver array cache */
   MEM_SAFE_FREE(adt->driver_array);
 
+  /* free evaluation plan cache */
+  BKE_animsys_eval_plan_free(adt);
+
   /* free overrides */
   /* TODO... */
 
@@ -370,6 +373,7 @@ AnimData *BKE_animdata_copy_in_lib(Main *bmain,
   /* duplicate drivers (F-Curves) */
   BKE_fcurves_copy(&dadt->drivers, &adt->drivers);
   dadt->driver_array = nullptr;
+  dadt->eval_plan = nullptr;
 
   /* don't copy overrides */
   BLI_listbase_clear(&dadt->overrides);
@@ -1514,6 +1518,7 @@ void BKE_animdata_blend_read_data(BlendDataReader *reader, ID *id)
   BLO_read_struct_list(reader, FCurve, &adt->drivers);
   BKE_fcurve_blend_read_data_listbase(reader, &adt->drivers);
   adt->driver_array = nullptr;
+  adt->eval_plan = nullptr;
 
   /* link overrides */
   /* TODO... */
@@ -15,6 +15,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_alloca.h"
+#include "BLI_array.hh"
 #include "BLI_bit_vector.hh"
 #include "BLI_blenlib.h"
 #include "BLI_dynstr.h"
@@ -23,6 +24,7 @@
 #include "BLI_math_vector.h"
 #include "BLI_string_utils.hh"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BLT_translation.hh"
 
@@ -42,6 +44,7 @@
 #include "BKE_context.hh"
 #include "BKE_fcurve.hh"
 #include "BKE_global.hh"
+#include "BKE_idtype.hh"
 #include "BKE_lib_id.hh"
 #include "BKE_lib_query.hh"
 #include "BKE_main.hh"
@@ -896,6 +899,260 @@ void animsys_blend_in_action(PointerRNA *ptr,
   animsys_blend_in_fcurves(ptr, &act->curves, anim_eval_context, blend_factor);
 }
 
+/* ***************************************** */
+/* Compiled Action Evaluation */
+
+namespace blender::bke {
+
+/**
+ * Active action of an evaluated #AnimData, with the RNA paths of its F-Curves resolved.
+ *
+ * Resolving RNA paths is the main cost of evaluating actions with many F-Curves, so the resolved
+ * targets are kept until the evaluated data-block is copied again, the active action changes or
+ * #BKE_animsys_eval_plans_invalidate is called.
+ */
+struct AnimDataEvalPlan {
+  struct Channel {
+    FCurve *fcu;
+    /* Target in the evaluated data-block. Resolved on every evaluation when not cached. */
+    PathResolvedRNA anim_rna;
+    bool is_cached;
+    /* Target in the original data-block, for flushing values to the original. */
+    PathResolvedRNA orig_anim_rna;
+    bool is_orig_cached;
+    /* Keyframe segment of the last evaluation, see #evaluate_fcurve_segment_hint. */
+    int segment_hint;
+  };
+
+  const bAction *action;
+  uint64_t generation;
+  bool flush_to_original;
+
+  Vector<Channel> channels;
+  /* Ranges of channels covering all channels in order. Consecutive channels that write to the
+   * same cached float array property share a range, so the array is read and written once. */
+  Vector<IndexRange> groups;
+};
+
+}  // namespace blender::bke
+
+using blender::Array;
+using blender::IndexRange;
+using blender::MutableSpan;
+using blender::bke::AnimDataEvalPlan;
+
+static uint64_t animsys_eval_plan_generation = 0;
+
+void BKE_animsys_eval_plans_invalidate()
+{
+  atomic_add_and_fetch_uint64(&animsys_eval_plan_generation, 1);
+}
+
+void BKE_animsys_eval_plan_free(AnimData *adt)
+{
+  MEM_delete(adt->eval_plan);
+  adt->eval_plan = nullptr;
+}
+
+/**
+ * Whether the resolved target stays valid until the data-block is copied again or the relations
+ * are rebuilt. This is the case for data stored in the ID itself and for pose channels, which
+ * covers most animated properties of rigs. Other data, like geometry arrays, can be reallocated
+ * during evaluation.
+ */
+static bool animsys_eval_plan_target_is_stable(const PathResolvedRNA &anim_rna)
+{
+  const ID *id = anim_rna.ptr.owner_id;
+  const IDTypeInfo *id_type = BKE_idtype_get_info_from_id(id);
+  const char *data = static_cast<const char *>(anim_rna.ptr.data);
+  if (id_type != nullptr && data >= reinterpret_cast<const char *>(id) &&
+      data < reinterpret_cast<const char *>(id) + id_type->struct_size)
+  {
+    return true;
+  }
+  return RNA_struct_is_a(anim_rna.ptr.type, &RNA_PoseBone);
+}
+
+static bool animsys_eval_plan_channels_share_array(const AnimDataEvalPlan::Channel &a,
+                                                   const AnimDataEvalPlan::Channel &b)
+{
+  return a.is_cached && b.is_cached && a.anim_rna.ptr.data == b.anim_rna.ptr.data &&
+         a.anim_rna.prop == b.anim_rna.prop && a.anim_rna.prop_index != -1 &&
+         b.anim_rna.prop_index != -1 && RNA_property_type(a.anim_rna.prop) == PROP_FLOAT;
+}
+
+static AnimDataEvalPlan *animsys_eval_plan_compile(PointerRNA *ptr,
+                                                   bAction *act,
+                                                   const uint64_t generation,
+                                                   const bool flush_to_original)
+{
+  AnimDataEvalPlan *plan = MEM_new<AnimDataEvalPlan>(__func__);
+  plan->action = act;
+  plan->generation = generation;
+  plan->flush_to_original = flush_to_original;
+
+  PointerRNA ptr_orig;
+  const bool use_orig = flush_to_original && animsys_construct_orig_pointer_rna(ptr, &ptr_orig);
+
+  plan->channels.reserve(BLI_listbase_count(&act->curves));
+  LISTBASE_FOREACH (FCurve *, fcu, &act->curves) {
+    AnimDataEvalPlan::Channel channel = {};
+    channel.fcu = fcu;
+
+    /* Paths that fail to resolve are tried again on every evaluation, like before. */
+    channel.is_cached = BKE_animsys_rna_path_resolve(
+                            ptr, fcu->rna_path, fcu->array_index, &channel.anim_rna) &&
+                        animsys_eval_plan_target_is_stable(channel.anim_rna);
+
+    /* ID properties of the original can be removed without tagging anything for update. */
+    channel.is_orig_cached = use_orig && channel.is_cached &&
+                             BKE_animsys_rna_path_resolve(&ptr_orig,
+                                                          fcu->rna_path,
+                                                          fcu->array_index,
+                                                          &channel.orig_anim_rna) &&
+                             animsys_eval_plan_target_is_stable(channel.orig_anim_rna) &&
+                             !RNA_property_is_idprop(channel.orig_anim_rna.prop);
+
+    const int64_t index = plan->channels.append_and_get_index(channel);
+    if (!plan->groups.is_empty() &&
+        animsys_eval_plan_channels_share_array(plan->channels[index - 1], plan->channels[index]))
+    {
+      plan->groups.last() = plan->groups.last().with_new_end(index + 1);
+    }
+    else {
+      plan->groups.append(IndexRange(index, 1));
+    }
+  }
+
+  return plan;
+}
+
+static float animsys_eval_plan_channel_value(AnimDataEvalPlan::Channel &channel,
+                                             const AnimationEvalContext *anim_eval_context)
+{
+  FCurve *fcu = channel.fcu;
+  if (fcu->driver) {
+    return calculate_fcurve(&channel.anim_rna, fcu, anim_eval_context);
+  }
+  const float curval = evaluate_fcurve_segment_hint(
+      fcu, anim_eval_context->eval_time, &channel.segment_hint);
+  fcu->curval = curval; /* Debug display only, not thread safe! */
+  return curval;
+}
+
+static void animsys_eval_plan_flush_channel(PointerRNA *ptr,
+                                            AnimDataEvalPlan::Channel &channel,
+                                            const float curval)
+{
+  if (channel.is_orig_cached) {
+    BKE_animsys_write_to_rna_path(&channel.orig_anim_rna, curval);
+  }
+  else {
+    animsys_write_orig_anim_rna(ptr, channel.fcu->rna_path, channel.fcu->array_index, curval);
+  }
+}
+
+static void animsys_eval_plan_evaluate_channel(PointerRNA *ptr,
+                                               AnimDataEvalPlan::Channel &channel,
+                                               const AnimationEvalContext *anim_eval_context,
+                                               const bool flush_to_original)
+{
+  FCurve *fcu = channel.fcu;
+  if (!is_fcurve_evaluatable(fcu)) {
+    return;
+  }
+  if (!channel.is_cached &&
+      !BKE_animsys_rna_path_resolve(ptr, fcu->rna_path, fcu->array_index, &channel.anim_rna))
+  {
+    return;
+  }
+
+  const float curval = animsys_eval_plan_channel_value(channel, anim_eval_context);
+  BKE_animsys_write_to_rna_path(&channel.anim_rna, curval);
+  if (flush_to_original) {
+    animsys_eval_plan_flush_channel(ptr, channel, curval);
+  }
+}
+
+/* Same as evaluating the channels one by one, but the float array is only read and written once,
+ * instead of for every index. */
+static void animsys_eval_plan_evaluate_array(PointerRNA *ptr,
+                                             MutableSpan<AnimDataEvalPlan::Channel> channels,
+                                             const AnimationEvalContext *anim_eval_context,
+                                             const bool flush_to_original)
+{
+  PointerRNA *target_ptr = &channels.first().anim_rna.ptr;
+  PropertyRNA *prop = channels.first().anim_rna.prop;
+
+  Array<float> values(RNA_property_array_length(target_ptr, prop));
+  RNA_property_float_get_array(target_ptr, prop, values.data());
+
+  bool changed = false;
+  for (AnimDataEvalPlan::Channel &channel : channels) {
+    if (!is_fcurve_evaluatable(channel.fcu)) {
+      continue;
+    }
+
+    const float curval = animsys_eval_plan_channel_value(channel, anim_eval_context);
+    float value_coerce = curval;
+    RNA_property_float_clamp(target_ptr, prop, &value_coerce);
+    if (values[channel.anim_rna.prop_index] != value_coerce) {
+      values[channel.anim_rna.prop_index] = value_coerce;
+      changed = true;
+    }
+
+    if (flush_to_original) {
+      animsys_eval_plan_flush_channel(ptr, channel, curval);
+    }
+  }
+
+  if (changed) {
+    RNA_property_float_set_array(target_ptr, prop, values.data());
+  }
+}
+
+/**
+ * Evaluate the active action of an evaluated data-block, the same way #animsys_evaluate_action
+ * does, using the compiled evaluation plan stored in the animation data.
+ */
+static void animsys_evaluate_action_plan(PointerRNA *ptr,
+                                         AnimData *adt,
+                                         const AnimationEvalContext *anim_eval_context,
+                                         const bool flush_to_original)
+{
+  bAction *act = adt->action;
+
+  /* The original data can change at any time, only evaluated copies are updated in a way that
+   * lets the plan know when it is outdated. */
+  if (!DEG_is_evaluated_id(ptr->owner_id)) {
+    animsys_evaluate_action(ptr, act, anim_eval_context, flush_to_original);
+    return;
+  }
+
+  action_idcode_patch_check(ptr->owner_id, act);
+
+  const uint64_t generation = atomic_load_uint64(&animsys_eval_plan_generation);
+  AnimDataEvalPlan *plan = adt->eval_plan;
+  if (plan == nullptr || plan->action != act || plan->generation != generation ||
+      plan->flush_to_original != flush_to_original)
+  {
+    BKE_animsys_eval_plan_free(adt);
+    plan = animsys_eval_plan_compile(ptr, act, generation, flush_to_original);
+    adt->eval_plan = plan;
+  }
+
+  for (const IndexRange group : plan->groups) {
+    if (group.size() == 1) {
+      animsys_eval_plan_evaluate_channel(
+          ptr, plan->channels[group.first()], anim_eval_context, flush_to_original);
+    }
+    else {
+      animsys_eval_plan_evaluate_array(
+          ptr, plan->channels.as_mutable_span().slice(group), anim_eval_context, flush_to_original);
+    }
+  }
+}
+
 /* ***************************************** */
 /* NLA System - Evaluation */
 
@@ -3953,7 +4210,7 @@ void BKE_animsys_evaluate_animdata(ID *id,
             id_ptr, action, adt->binding_handle, *anim_eval_context, flush_to_original);
       }
       else {
-        animsys_evaluate_action(&id_ptr, adt->action, anim_eval_context, flush_to_original);
+        animsys_evaluate_action_plan(&id_ptr, adt, anim_eval_context, flush_to_original);
       }
     }
   }
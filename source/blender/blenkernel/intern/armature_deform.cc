@@ -14,6 +14,8 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
+#include <mutex>
 
 #include "MEM_guardedalloc.h"
 
@@ -21,7 +23,9 @@
 #include "BLI_math_matrix.h"
 #include "BLI_math_rotation.h"
 #include "BLI_math_vector.h"
+#include "BLI_simd.hh"
 #include "BLI_task.h"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
 
 #include "DNA_armature_types.h"
@@ -40,6 +44,7 @@
 #include "BKE_editmesh.hh"
 #include "BKE_lattice.hh"
 #include "BKE_mesh.hh"
+#include "BKE_mesh_types.hh"
 
 #include "DEG_depsgraph_build.hh"
 
@@ -229,6 +234,107 @@ static void pchan_bone_deform(const bPoseChannel *pchan,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Vertex Group Weight Table
+ *
+ * Most vertices are deformed by only a few bones, so their vertex group weights are stored in a
+ * fixed width table that is cached in the mesh runtime data. Reading the table is faster than
+ * walking the #MDeformVert lists and the weights are already sorted by influence.
+ * \{ */
+
+using blender::bke::DeformWeightTable;
+
+static std::shared_ptr<const DeformWeightTable> deform_weight_table_build(
+    const blender::Span<MDeformVert> dverts, const blender::ImplicitSharingInfo &sharing_info)
+{
+  using namespace blender;
+  constexpr int width = DeformWeightTable::width;
+
+  std::shared_ptr<DeformWeightTable> table = std::make_shared<DeformWeightTable>();
+  table->dverts = dverts.data();
+  sharing_info.add_weak_user();
+  table->dverts_sharing_info = &sharing_info;
+  table->dverts_version = sharing_info.version();
+  table->groups.reinitialize(dverts.size() * width);
+  table->weights.reinitialize(dverts.size() * width);
+  table->overflow.reinitialize(dverts.size());
+
+  threading::parallel_for(dverts.index_range(), 4096, [&](const IndexRange range) {
+    for (const int i : range) {
+      const MDeformVert &dvert = dverts[i];
+      MutableSpan<int> groups = table->groups.as_mutable_span().slice(i * width, width);
+      MutableSpan<float> weights = table->weights.as_mutable_span().slice(i * width, width);
+      groups.fill(-1);
+      weights.fill(0.0f);
+      table->overflow[i] = dvert.totweight > width;
+      if (table->overflow[i]) {
+        continue;
+      }
+      /* Insertion sort by decreasing weight, keeping the order of equal weights. */
+      for (const int j : IndexRange(dvert.totweight)) {
+        const MDeformWeight &dw = dvert.dw[j];
+        int k = j;
+        for (; k > 0 && weights[k - 1] < dw.weight; k--) {
+          groups[k] = groups[k - 1];
+          weights[k] = weights[k - 1];
+        }
+        groups[k] = dw.def_nr;
+        weights[k] = dw.weight;
+      }
+    }
+  });
+
+  return table;
+}
+
+/**
+ * Get the weight table of the mesh, building it when the vertex group data changed. The tables
+ * are shared with copies of the mesh, so they are only built once for consecutive evaluations.
+ * Returns null when the vertex group layer has no sharing info to detect changes with.
+ */
+static std::shared_ptr<const DeformWeightTable> deform_weight_table_get(const Mesh &mesh)
+{
+  using namespace blender;
+  const int layer_index = CustomData_get_layer_index(&mesh.vert_data, CD_MDEFORMVERT);
+  if (layer_index == -1) {
+    return nullptr;
+  }
+  const ImplicitSharingInfo *sharing_info = mesh.vert_data.layers[layer_index].sharing_info;
+  if (sharing_info == nullptr) {
+    return nullptr;
+  }
+  const Span<MDeformVert> dverts = mesh.deform_verts();
+  bke::DeformWeightTableCache &cache = *mesh.runtime->deform_weight_table_cache;
+
+  std::lock_guard lock(cache.mutex);
+  for (const int i : cache.tables.index_range()) {
+    std::shared_ptr<const DeformWeightTable> table = cache.tables[i];
+    if (table->dverts_sharing_info != sharing_info) {
+      continue;
+    }
+    cache.tables.remove(i);
+    if (table->dverts_version == sharing_info->version() && table->dverts == dverts.data() &&
+        table->overflow.size() == dverts.size())
+    {
+      cache.tables.insert(0, table);
+      return table;
+    }
+    /* The data was changed in place, the old table can't be used anymore. */
+    break;
+  }
+
+  std::shared_ptr<const DeformWeightTable> table;
+  /* Isolate the build so that this thread doesn't start other tasks waiting for the lock. */
+  threading::isolate_task([&]() { table = deform_weight_table_build(dverts, *sharing_info); });
+  if (cache.tables.size() == bke::DeformWeightTableCache::tables_max) {
+    cache.tables.remove_last();
+  }
+  cache.tables.insert(0, table);
+  return table;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Armature Deform #BKE_armature_deform_coords API
  *
@@ -251,6 +357,8 @@ struct ArmatureUserdata {
 
   const MDeformVert *dverts;
   int dverts_len;
+  /** Weights of the #dverts in a table, or null when the #dverts are used directly. */
+  const DeformWeightTable *weight_table;
 
   bPoseChannel **pchan_from_defbase;
   int defbase_len;
@@ -264,6 +372,146 @@ struct ArmatureUserdata {
   } bmesh;
 };
 
+/* Add the effect of a bone without B-Bone segments with dual quaternion skinning. */
+static void pchan_deform_accumulate_dq(const DualQuat *deform_dq,
+                                       const float co_in[3],
+                                       float weight,
+                                       DualQuat *dq_accum,
+                                       const bool full_deform)
+{
+  if (deform_dq->scale_weight) {
+    add_weighted_dq_dq_pivot(dq_accum, deform_dq, co_in, weight, full_deform);
+    return;
+  }
+#if BLI_HAVE_SSE2
+  const __m128 quat = _mm_loadu_ps(deform_dq->quat);
+  const __m128 quat_accum = _mm_loadu_ps(dq_accum->quat);
+
+  /* Make sure we interpolate quaternions in the right direction. */
+  __m128 dot = _mm_mul_ps(quat, quat_accum);
+  dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(2, 3, 0, 1)));
+  dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(1, 0, 3, 2)));
+  if (_mm_cvtss_f32(dot) < 0.0f) {
+    weight = -weight;
+  }
+
+  const __m128 weight_vec = _mm_set1_ps(weight);
+  _mm_storeu_ps(dq_accum->quat, _mm_add_ps(quat_accum, _mm_mul_ps(quat, weight_vec)));
+  _mm_storeu_ps(dq_accum->trans,
+                _mm_add_ps(_mm_loadu_ps(dq_accum->trans),
+                           _mm_mul_ps(_mm_loadu_ps(deform_dq->trans), weight_vec)));
+#else
+  add_weighted_dq_dq(dq_accum, deform_dq, weight);
+#endif
+}
+
+/**
+ * Deform a vertex by the bones of its vertex groups in the weight table.
+ *
+ * With linear blend skinning the bone matrices are blended first, so the coordinate only needs to
+ * be transformed once. This gives the same result as accumulating the transformed coordinates.
+ *
+ * \return True when any of the vertex groups has a bone.
+ */
+static bool armature_vert_deform_weight_table(const ArmatureUserdata *data,
+                                              const int i,
+                                              const float co[3],
+                                              float vec[3],
+                                              DualQuat *dq,
+                                              float mat[3][3],
+                                              const bool full_deform,
+                                              float *contrib)
+{
+  constexpr int width = DeformWeightTable::width;
+  const int *groups = &data->weight_table->groups[i * width];
+  const float *weights = &data->weight_table->weights[i * width];
+  bool deformed = false;
+
+  float weight_sum = 0.0f;
+#if BLI_HAVE_SSE2
+  __m128 mat_sum[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+#else
+  float mat_sum[4][4] = {{0.0f}};
+#endif
+
+  for (int j = 0; j < width; j++) {
+    const uint index = uint(groups[j]);
+    if (index >= uint(data->defbase_len)) {
+      continue;
+    }
+    const bPoseChannel *pchan = data->pchan_from_defbase[index];
+    if (pchan == nullptr) {
+      continue;
+    }
+    const Bone *bone = pchan->bone;
+    float weight = weights[j];
+
+    deformed = true;
+
+    if (bone && bone->flag & BONE_MULT_VG_ENV) {
+      weight *= distfactor_to_bone(
+          co, bone->arm_head, bone->arm_tail, bone->rad_head, bone->rad_tail, bone->dist);
+    }
+    if (weight == 0.0f) {
+      continue;
+    }
+    *contrib += weight;
+
+    if (bone->segments > 1 && pchan->runtime.bbone_segments == bone->segments) {
+      b_bone_deform(pchan, co, weight, vec, dq, mat, full_deform);
+    }
+    else if (dq) {
+      pchan_deform_accumulate_dq(&pchan->runtime.deform_dual_quat, co, weight, dq, full_deform);
+    }
+    else {
+#if BLI_HAVE_SSE2
+      const __m128 weight_vec = _mm_set1_ps(weight);
+      for (int col = 0; col < 4; col++) {
+        mat_sum[col] = _mm_add_ps(mat_sum[col],
+                                  _mm_mul_ps(_mm_loadu_ps(pchan->chan_mat[col]), weight_vec));
+      }
+#else
+      madd_m4_m4m4fl(mat_sum, mat_sum, pchan->chan_mat, weight);
+#endif
+      weight_sum += weight;
+    }
+  }
+
+  if (weight_sum == 0.0f) {
+    return deformed;
+  }
+
+  /* Same as accumulating `weight * (chan_mat * co - co)` for every bone. */
+  float offset[4];
+#if BLI_HAVE_SSE2
+  __m128 co_deform = _mm_add_ps(mat_sum[3], _mm_mul_ps(mat_sum[0], _mm_set1_ps(co[0])));
+  co_deform = _mm_add_ps(co_deform, _mm_mul_ps(mat_sum[1], _mm_set1_ps(co[1])));
+  co_deform = _mm_add_ps(co_deform, _mm_mul_ps(mat_sum[2], _mm_set1_ps(co[2])));
+  const __m128 co_vec = _mm_set_ps(0.0f, co[2], co[1], co[0]);
+  _mm_storeu_ps(offset, _mm_sub_ps(co_deform, _mm_mul_ps(co_vec, _mm_set1_ps(weight_sum))));
+#else
+  mul_v3_m4v3(offset, mat_sum, co);
+  madd_v3_v3fl(offset, co, -weight_sum);
+#endif
+  add_v3_v3(vec, offset);
+
+  if (full_deform) {
+    float mat_sum_3x3[3][3];
+#if BLI_HAVE_SSE2
+    float mat_sum_4x4[4][4];
+    for (int col = 0; col < 4; col++) {
+      _mm_storeu_ps(mat_sum_4x4[col], mat_sum[col]);
+    }
+    copy_m3_m4(mat_sum_3x3, mat_sum_4x4);
+#else
+    copy_m3_m4(mat_sum_3x3, mat_sum);
+#endif
+    add_m3_m3m3(mat, mat, mat_sum_3x3);
+  }
+
+  return deformed;
+}
+
 static void armature_vert_task_with_dvert(const ArmatureUserdata *data,
                                           const int i,
                                           const MDeformVert *dvert)
@@ -339,23 +587,29 @@ static void armature_vert_task_with_dvert(const ArmatureUserdata *data,
   mul_m4_v3(data->premat, co);
 
   if (use_dverts && dvert && dvert->totweight) { /* use weight groups ? */
-    const MDeformWeight *dw = dvert->dw;
     int deformed = 0;
-    uint j;
-    for (j = dvert->totweight; j != 0; j--, dw++) {
-      const uint index = dw->def_nr;
-      if (index < data->defbase_len && (pchan = data->pchan_from_defbase[index])) {
-        float weight = dw->weight;
-        const Bone *bone = pchan->bone;
-
-        deformed = 1;
-
-        if (bone && bone->flag & BONE_MULT_VG_ENV) {
-          weight *= distfactor_to_bone(
-              co, bone->arm_head, bone->arm_tail, bone->rad_head, bone->rad_tail, bone->dist);
-        }
+    if (data->weight_table && !data->weight_table->overflow[i]) {
+      deformed = armature_vert_deform_weight_table(
+          data, i, co, vec, dq, smat, full_deform, &contrib);
+    }
+    else {
+      const MDeformWeight *dw = dvert->dw;
+      uint j;
+      for (j = dvert->totweight; j != 0; j--, dw++) {
+        const uint index = dw->def_nr;
+        if (index < data->defbase_len && (pchan = data->pchan_from_defbase[index])) {
+          float weight = dw->weight;
+          const Bone *bone = pchan->bone;
+
+          deformed = 1;
+
+          if (bone && bone->flag & BONE_MULT_VG_ENV) {
+            weight *= distfactor_to_bone(
+                co, bone->arm_head, bone->arm_tail, bone->rad_head, bone->rad_tail, bone->dist);
+          }
 
-        pchan_bone_deform(pchan, weight, vec, dq, smat, co, full_deform, &contrib);
+          pchan_bone_deform(pchan, weight, vec, dq, smat, co, full_deform, &contrib);
+        }
       }
     }
     /* If there are vertex-groups but not groups with bones (like for soft-body groups). */
@@ -501,6 +755,7 @@ static void armature_deform_coords_impl(const Object *ob_arm,
   bool use_dverts = false;
   int armature_def_nr = -1;
   int cd_dvert_offset = -1;
+  const Mesh *dverts_mesh = nullptr;
 
   /* in editmode, or not an armature */
   if (arm->edbo || (ob_arm->pose == nullptr)) {
@@ -521,6 +776,7 @@ static void armature_deform_coords_impl(const Object *ob_arm,
       if (em_target == nullptr) {
         const Mesh *mesh = (const Mesh *)target_data_id;
         dverts = mesh->deform_verts();
+        dverts_mesh = mesh;
       }
     }
     else if (ob_target->type == OB_LATTICE) {
@@ -594,6 +850,13 @@ static void armature_deform_coords_impl(const Object *ob_arm,
   data.defbase_len = defbase_len;
   data.bmesh.cd_dvert_offset = cd_dvert_offset;
 
+  std::shared_ptr<const DeformWeightTable> weight_table;
+  if (use_dverts && dverts_mesh != nullptr) {
+    weight_table = deform_weight_table_get(*dverts_mesh);
+    BLI_assert(!weight_table || weight_table->dverts == dverts.data());
+  }
+  data.weight_table = weight_table.get();
+
   float obinv[4][4];
   invert_m4_m4(obinv, ob_target->object_to_world().ptr());
 
@@ -0,0 +1,253 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_armature.hh"
+#include "BKE_customdata.hh"
+#include "BKE_deform.hh"
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_main.hh"
+#include "BKE_mesh.h"
+#include "BKE_object.hh"
+
+#include "BLI_array.hh"
+#include "BLI_listbase.h"
+#include "BLI_math_matrix.h"
+#include "BLI_math_matrix_types.hh"
+#include "BLI_math_rotation.h"
+#include "BLI_math_vector.h"
+#include "BLI_math_vector.hh"
+#include "BLI_string.h"
+
+#include "DNA_armature_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+
+namespace blender::bke::tests {
+
+static constexpr int bones_num = 3;
+static constexpr int verts_num = 100;
+/* Vertex group without a bone. */
+static constexpr int unused_group = bones_num;
+
+struct DeformResult {
+  Array<float3> positions;
+  Array<float3x3> deform_mats;
+};
+
+class ArmatureDeformTest : public testing::Test {
+ public:
+  Main *bmain;
+  Object *armature_object;
+  Object *mesh_object;
+
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+
+  void SetUp() override
+  {
+    bmain = BKE_main_new();
+    bArmature *armature = BKE_armature_add(bmain, "Armature");
+    for (int i = 0; i < bones_num; i++) {
+      Bone *bone = static_cast<Bone *>(MEM_callocN(sizeof(Bone), "Bone"));
+      SNPRINTF(bone->name, "Bone%d", i);
+      unit_m4(bone->arm_mat);
+      copy_v3_fl3(bone->arm_mat[3], 0.0f, 0.0f, float(i));
+      copy_v3_v3(bone->arm_head, bone->arm_mat[3]);
+      copy_v3_fl3(bone->arm_tail, 0.0f, 0.0f, float(i + 1));
+      BLI_addtail(&armature->bonebase, bone);
+    }
+
+    armature_object = BKE_object_add_only_object(bmain, OB_ARMATURE, "Armature");
+    armature_object->data = armature;
+    BKE_pose_ensure(bmain, armature_object, armature, false);
+    armature_object->pose->flag &= ~POSE_RECALC;
+
+    /* Rotations in the same hemisphere, the last bone is scaled so that it doesn't use the
+     * vectorized dual quaternion code. */
+    int i = 0;
+    LISTBASE_FOREACH (bPoseChannel *, pchan, &armature_object->pose->chanbase) {
+      const float loc[3] = {0.1f * i, -0.2f, 0.3f * i};
+      const float eul[3] = {0.3f, -0.2f * i, 0.5f + 0.1f * i};
+      const float size[3] = {1.0f, i == bones_num - 1 ? 1.5f : 1.0f, 1.0f};
+      loc_eul_size_to_mat4(pchan->chan_mat, loc, eul, size);
+      mat4_to_dquat(&pchan->runtime.deform_dual_quat, pchan->bone->arm_mat, pchan->chan_mat);
+      i++;
+    }
+
+    mesh_object = BKE_object_add_only_object(bmain, OB_MESH, "Mesh");
+  }
+
+  void TearDown() override
+  {
+    mesh_object->data = nullptr;
+    BKE_main_free(bmain);
+  }
+
+  /**
+   * Create a mesh where every vertex is in one to three of the bone vertex groups. With
+   * `add_unused_group`, every vertex is also in a group without a bone, which doesn't change the
+   * deformation but doesn't fit in the weight table, so the #MDeformVert data is used instead.
+   */
+  static Mesh *create_mesh(const bool add_unused_group, const int weights_seed = 0)
+  {
+    Mesh *mesh = BKE_mesh_new_nomain(verts_num, 0, 0, 0);
+    for (int i = 0; i <= unused_group; i++) {
+      bDeformGroup *group = static_cast<bDeformGroup *>(
+          MEM_callocN(sizeof(bDeformGroup), __func__));
+      if (i == unused_group) {
+        STRNCPY(group->name, "Unused");
+      }
+      else {
+        SNPRINTF(group->name, "Bone%d", i);
+      }
+      BLI_addtail(&mesh->vertex_group_names, group);
+    }
+
+    MutableSpan<float3> positions = mesh->vert_positions_for_write();
+    MutableSpan<MDeformVert> dverts = mesh->deform_verts_for_write();
+    for (const int i : positions.index_range()) {
+      positions[i] = float3(0.1f * (i % 7), 0.2f * (i % 5), 0.03f * i);
+      for (int j = 0; j <= i % bones_num; j++) {
+        /* Not normalized, and in different orders for different vertices. */
+        const int group = (i + j) % bones_num;
+        BKE_defvert_add_index_notest(
+            &dverts[i], group, 0.1f + float((i * 7 + j * 3 + weights_seed) % 10) / 10.0f);
+      }
+      if (add_unused_group) {
+        /* More groups than fit in the weight table. */
+        for (int j = 0; j <= bones_num; j++) {
+          BKE_defvert_add_index_notest(&dverts[i], unused_group, 0.0f);
+        }
+      }
+    }
+    return mesh;
+  }
+
+  /** Change the weights like the Data Transfer modifier, without #Mesh::deform_verts_for_write. */
+  static void change_weights_in_place(Mesh &mesh, const int weights_seed)
+  {
+    MDeformVert *dverts = static_cast<MDeformVert *>(
+        CustomData_get_layer_for_write(&mesh.vert_data, CD_MDEFORMVERT, mesh.verts_num));
+    for (const int i : IndexRange(mesh.verts_num)) {
+      for (const int j : IndexRange(dverts[i].totweight)) {
+        dverts[i].dw[j].weight = 0.1f + float((i * 7 + j * 3 + weights_seed) % 10) / 10.0f;
+      }
+    }
+  }
+
+  DeformResult deform(const Mesh &mesh, const int deformflag)
+  {
+    DeformResult result;
+    result.positions = Array<float3>(mesh.vert_positions());
+    result.deform_mats = Array<float3x3>(mesh.verts_num, float3x3::identity());
+    mesh_object->data = const_cast<Mesh *>(&mesh);
+    BKE_armature_deform_coords_with_mesh(
+        armature_object,
+        mesh_object,
+        reinterpret_cast<float(*)[3]>(result.positions.data()),
+        reinterpret_cast<float(*)[3][3]>(result.deform_mats.data()),
+        mesh.verts_num,
+        deformflag,
+        nullptr,
+        nullptr,
+        &mesh);
+    mesh_object->data = nullptr;
+    return result;
+  }
+};
+
+static void expect_deform_result_near(const DeformResult &a, const DeformResult &b)
+{
+  ASSERT_EQ(a.positions.size(), b.positions.size());
+  for (const int i : a.positions.index_range()) {
+    for (int axis = 0; axis < 3; axis++) {
+      EXPECT_NEAR(a.positions[i][axis], b.positions[i][axis], 1e-5f) << "vertex " << i;
+      for (int row = 0; row < 3; row++) {
+        EXPECT_NEAR(a.deform_mats[i][axis][row], b.deform_mats[i][axis][row], 1e-5f)
+            << "vertex " << i;
+      }
+    }
+  }
+}
+
+static void expect_deform_result_not_near(const DeformResult &a, const DeformResult &b)
+{
+  bool differs = false;
+  for (const int i : a.positions.index_range()) {
+    differs |= math::distance(a.positions[i], b.positions[i]) > 1e-3f;
+  }
+  EXPECT_TRUE(differs);
+}
+
+TEST_F(ArmatureDeformTest, WeightTableMatchesDeformVerts)
+{
+  Mesh *mesh = create_mesh(false);
+  Mesh *mesh_overflow = create_mesh(true);
+  for (const int deformflag : {int(ARM_DEF_VGROUP), int(ARM_DEF_VGROUP | ARM_DEF_QUATERNION)}) {
+    const DeformResult result = deform(*mesh, deformflag);
+    expect_deform_result_near(result, deform(*mesh_overflow, deformflag));
+    expect_deform_result_not_near(result, {Array<float3>(mesh->vert_positions()), {}});
+  }
+  BKE_id_free(nullptr, mesh);
+  BKE_id_free(nullptr, mesh_overflow);
+}
+
+TEST_F(ArmatureDeformTest, WeightTableRebuiltAfterWriteInPlace)
+{
+  Mesh *mesh = create_mesh(false);
+  const DeformResult result_before = deform(*mesh, ARM_DEF_VGROUP);
+
+  change_weights_in_place(*mesh, 5);
+  const DeformResult result_after = deform(*mesh, ARM_DEF_VGROUP);
+  expect_deform_result_not_near(result_before, result_after);
+
+  Mesh *mesh_expected = create_mesh(false, 5);
+  expect_deform_result_near(result_after, deform(*mesh_expected, ARM_DEF_VGROUP));
+  BKE_id_free(nullptr, mesh);
+  BKE_id_free(nullptr, mesh_expected);
+}
+
+TEST_F(ArmatureDeformTest, WeightTableDoesNotShareDeformVerts)
+{
+  Mesh *mesh = create_mesh(false);
+  deform(*mesh, ARM_DEF_VGROUP);
+
+  /* The cached table doesn't hold a user of the vertex groups, so they are still changed in place
+   * instead of being copied. */
+  const MDeformVert *dverts = mesh->deform_verts().data();
+  change_weights_in_place(*mesh, 5);
+  EXPECT_EQ(mesh->deform_verts().data(), dverts);
+
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(ArmatureDeformTest, WeightTableOfCopies)
+{
+  Mesh *mesh = create_mesh(false);
+  const DeformResult result = deform(*mesh, ARM_DEF_VGROUP);
+
+  /* The copy shares the cached weight tables, but has different weights. */
+  Mesh *mesh_copy = BKE_mesh_copy_for_eval(*mesh);
+  change_weights_in_place(*mesh_copy, 5);
+  Mesh *mesh_expected = create_mesh(false, 5);
+  for (int i = 0; i < 2; i++) {
+    expect_deform_result_near(deform(*mesh_copy, ARM_DEF_VGROUP),
+                              deform(*mesh_expected, ARM_DEF_VGROUP));
+    expect_deform_result_near(deform(*mesh, ARM_DEF_VGROUP), result);
+  }
+
+  BKE_id_free(nullptr, mesh);
+  BKE_id_free(nullptr, mesh_copy);
+  BKE_id_free(nullptr, mesh_expected);
+}
+
+}  // namespace blender::bke::tests
@@ -0,0 +1,429 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include <algorithm>
+#include <ctime>
+#include <mutex>
+#include <random>
+
+#include <fmt/format.h>
+#include <xxhash.h>
+
+#include "BKE_appdir.hh"
+#include "BKE_bake_disk_cache.hh"
+#include "BKE_bake_items.hh"
+#include "BKE_bake_items_serialize.hh"
+#include "BKE_curves.hh"
+#include "BKE_instances.hh"
+#include "BKE_mesh.hh"
+#include "BKE_pointcloud.hh"
+
+#include "BLI_fileops.h"
+#include "BLI_fileops.hh"
+#include "BLI_fileops_types.h"
+#include "BLI_math_matrix_types.hh"
+#include "BLI_path_util.h"
+
+#include "DNA_curves_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_pointcloud_types.h"
+
+namespace blender::bke::bake {
+
+/** Least recently used entries are removed when the cache becomes larger than this. */
+static constexpr int64_t DISK_CACHE_SIZE_MAX = int64_t(4) * 1024 * 1024 * 1024;
+/**
+ * Size the cache is reduced to when it became too large. Leaving some room avoids scanning the
+ * whole cache directory again on the next writes.
+ */
+static constexpr int64_t DISK_CACHE_SIZE_AFTER_CLEANUP = DISK_CACHE_SIZE_MAX / 8 * 7;
+/** Temporary directories of unfinished writes are removed after this time. */
+static constexpr int64_t DISK_CACHE_TMP_LIFETIME_SECONDS = 60 * 60;
+
+/**
+ * Running total of the cache size, so that it doesn't have to be computed from the files on every
+ * write. Entries written by other processes are only taken into account on the next cleanup.
+ */
+struct DiskCacheSize {
+  std::mutex mutex;
+  /** Unknown until the cache directory has been scanned by a cleanup. */
+  std::optional<int64_t> total;
+};
+
+static DiskCacheSize &disk_cache_size()
+{
+  static DiskCacheSize size;
+  return size;
+}
+
+struct DiskCacheKeyBuilder::State {
+  XXH3_state_t *xxh_state;
+};
+
+DiskCacheKeyBuilder::DiskCacheKeyBuilder() : state_(std::make_unique<State>())
+{
+  state_->xxh_state = XXH3_createState();
+  XXH3_128bits_reset(state_->xxh_state);
+}
+
+DiskCacheKeyBuilder::~DiskCacheKeyBuilder()
+{
+  XXH3_freeState(state_->xxh_state);
+}
+
+void DiskCacheKeyBuilder::add(const void *data, const int64_t size)
+{
+  XXH3_128bits_update(state_->xxh_state, data, size_t(size));
+}
+
+void DiskCacheKeyBuilder::add(const StringRef str)
+{
+  /* Also add the size, so that e.g. "ab" + "c" is different from "a" + "bc". */
+  this->add_value(str.size());
+  this->add(str.data(), str.size());
+}
+
+static void add_materials_to_key(DiskCacheKeyBuilder &key,
+                                 const Material *const *materials,
+                                 const int materials_num)
+{
+  /* Materials are restored by name when the entry is read. */
+  key.add_value(materials_num);
+  for (const int i : IndexRange(materials_num)) {
+    const ID *id = reinterpret_cast<const ID *>(materials[i]);
+    key.add(id ? id->name : "");
+    key.add((id && id->lib) ? id->lib->id.name : "");
+  }
+}
+
+static void add_attributes_to_key(DiskCacheKeyBuilder &key, const AttributeAccessor &attributes)
+{
+  /* Anonymous attributes are not stored in the cache. Sort by name, so that the order in which
+   * attributes are stored doesn't matter. */
+  Vector<AttributeIDRef> ids;
+  attributes.for_all([&](const AttributeIDRef &id, const AttributeMetaData & /*meta_data*/) {
+    if (!id.is_anonymous()) {
+      ids.append(id);
+    }
+    return true;
+  });
+  std::sort(ids.begin(), ids.end(), [](const AttributeIDRef &a, const AttributeIDRef &b) {
+    return a.name() < b.name();
+  });
+  for (const AttributeIDRef &id : ids) {
+    const GAttributeReader attribute = attributes.lookup(id);
+    key.add(id.name());
+    key.add_value(attribute.domain);
+    key.add_value(attribute.varray.type().size());
+    key.add(attribute.varray.type().name());
+    const GVArraySpan data{*attribute};
+    key.add(data.data(), data.size_in_bytes());
+  }
+}
+
+void DiskCacheKeyBuilder::add(const GeometrySet &geometry)
+{
+  BLI_assert(geometry_is_disk_cacheable(geometry));
+  /* Hash the geometry data directly, this is much cheaper than serializing it. All attribute
+   * types are trivial and don't contain padding. */
+  if (const Mesh *mesh = geometry.get_mesh()) {
+    this->add("mesh");
+    this->add_value(mesh->verts_num);
+    this->add_value(mesh->edges_num);
+    this->add_value(mesh->faces_num);
+    this->add_value(mesh->corners_num);
+    const Span<int> face_offsets = mesh->face_offsets();
+    this->add(face_offsets.data(), face_offsets.size_in_bytes());
+    add_materials_to_key(*this, mesh->mat, mesh->totcol);
+    add_attributes_to_key(*this, mesh->attributes());
+  }
+  if (const Curves *curves_id = geometry.get_curves()) {
+    const CurvesGeometry &curves = curves_id->geometry.wrap();
+    this->add("curves");
+    this->add_value(curves.points_num());
+    this->add_value(curves.curves_num());
+    const Span<int> offsets = curves.offsets();
+    this->add(offsets.data(), offsets.size_in_bytes());
+    add_materials_to_key(*this, curves_id->mat, curves_id->totcol);
+    add_attributes_to_key(*this, curves.attributes());
+  }
+  if (const PointCloud *pointcloud = geometry.get_pointcloud()) {
+    this->add("pointcloud");
+    this->add_value(pointcloud->totpoint);
+    add_materials_to_key(*this, pointcloud->mat, pointcloud->totcol);
+    add_attributes_to_key(*this, pointcloud->attributes());
+  }
+  if (const Instances *instances = geometry.get_instances()) {
+    this->add("instances");
+    this->add_value(instances->instances_num());
+    const Span<int> handles = instances->reference_handles();
+    this->add(handles.data(), handles.size_in_bytes());
+    const Span<float4x4> transforms = instances->transforms();
+    this->add(transforms.data(), transforms.size_in_bytes());
+    add_attributes_to_key(*this, instances->attributes());
+    this->add_value(instances->references().size());
+    for (const InstanceReference &reference : instances->references()) {
+      this->add_value(reference.type());
+      if (reference.type() == InstanceReference::Type::GeometrySet) {
+        this->add(reference.geometry_set());
+      }
+    }
+  }
+}
+
+std::string DiskCacheKeyBuilder::build() const
+{
+  const XXH128_hash_t hash = XXH3_128bits_digest(state_->xxh_state);
+  return fmt::format("{:016x}{:016x}", hash.high64, hash.low64);
+}
+
+bool geometry_is_disk_cacheable(const GeometrySet &geometry)
+{
+  for (const GeometryComponent::Type type : {GeometryComponent::Type::Edit,
+                                             GeometryComponent::Type::GreasePencil,
+                                             GeometryComponent::Type::Volume})
+  {
+    if (geometry.has(type)) {
+      return false;
+    }
+  }
+  if (const Instances *instances = geometry.get_instances()) {
+    for (const InstanceReference &reference : instances->references()) {
+      switch (reference.type()) {
+        case InstanceReference::Type::None:
+          break;
+        case InstanceReference::Type::GeometrySet:
+          if (!geometry_is_disk_cacheable(reference.geometry_set())) {
+            return false;
+          }
+          break;
+        case InstanceReference::Type::Object:
+        case InstanceReference::Type::Collection:
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+static std::optional<std::string> &disk_cache_dir_override()
+{
+  static std::optional<std::string> dir;
+  return dir;
+}
+
+void disk_cache_dir_override_set(std::optional<std::string> dir)
+{
+  disk_cache_dir_override() = std::move(dir);
+  DiskCacheSize &size = disk_cache_size();
+  std::lock_guard lock{size.mutex};
+  size.total.reset();
+}
+
+static std::optional<std::string> get_disk_cache_dir()
+{
+  if (const std::optional<std::string> &dir = disk_cache_dir_override()) {
+    return *dir;
+  }
+  char caches_dir[FILE_MAX];
+  if (!BKE_appdir_folder_caches(caches_dir, sizeof(caches_dir))) {
+    return std::nullopt;
+  }
+  char dir[FILE_MAX];
+  BLI_path_join(dir, sizeof(dir), caches_dir, "geometry_nodes");
+  return dir;
+}
+
+static std::string get_entry_dir(const StringRef cache_dir, const StringRef entry_name)
+{
+  char dir[FILE_MAX];
+  BLI_path_join(
+      dir, sizeof(dir), std::string(cache_dir).c_str(), std::string(entry_name).c_str());
+  return dir;
+}
+
+static std::string get_meta_path(const StringRef entry_dir)
+{
+  char meta_path[FILE_MAX];
+  BLI_path_join(meta_path, sizeof(meta_path), std::string(entry_dir).c_str(), "meta.json");
+  return meta_path;
+}
+
+static std::string get_blobs_dir(const StringRef entry_dir)
+{
+  char blobs_dir[FILE_MAX];
+  BLI_path_join(blobs_dir, sizeof(blobs_dir), std::string(entry_dir).c_str(), "blobs");
+  return blobs_dir;
+}
+
+static int64_t dir_size_recursive(const char *dir)
+{
+  direntry *entries;
+  const uint entries_num = BLI_filelist_dir_contents(dir, &entries);
+  int64_t size = 0;
+  for (const direntry &entry : Span(entries, entries_num)) {
+    if (FILENAME_IS_CURRPAR(entry.relname)) {
+      continue;
+    }
+    if (S_ISDIR(entry.s.st_mode)) {
+      size += dir_size_recursive(entry.path);
+    }
+    else {
+      size += int64_t(entry.s.st_size);
+    }
+  }
+  BLI_filelist_free(entries, entries_num);
+  return size;
+}
+
+std::optional<GeometrySet> disk_cache_read_geometry(const StringRef key,
+                                                    BakeDataBlockMap *data_block_map)
+{
+  const std::optional<std::string> cache_dir = get_disk_cache_dir();
+  if (!cache_dir) {
+    return std::nullopt;
+  }
+  const std::string entry_dir = get_entry_dir(*cache_dir, key);
+  const std::string meta_path = get_meta_path(entry_dir);
+  if (!BLI_exists(meta_path.c_str())) {
+    return std::nullopt;
+  }
+  /* The modification time is used to find the least recently used entries on cleanup. */
+  BLI_file_touch(meta_path.c_str());
+  fstream meta_file{meta_path.c_str(), std::ios::in};
+  const DiskBlobReader blob_reader{get_blobs_dir(entry_dir)};
+  const BlobReadSharing blob_sharing;
+  std::optional<BakeState> bake_state = deserialize_bake(meta_file, blob_reader, blob_sharing);
+  if (!bake_state) {
+    return std::nullopt;
+  }
+  std::unique_ptr<BakeItem> *item = bake_state->items_by_id.lookup_ptr(0);
+  if (item == nullptr) {
+    return std::nullopt;
+  }
+  GeometryBakeItem *geometry_item = dynamic_cast<GeometryBakeItem *>(item->get());
+  if (geometry_item == nullptr) {
+    return std::nullopt;
+  }
+  GeometrySet geometry = std::move(geometry_item->geometry);
+  GeometryBakeItem::try_restore_data_blocks(geometry, data_block_map);
+  return geometry;
+}
+
+void disk_cache_write_geometry(const StringRef key, GeometrySet geometry)
+{
+  BLI_assert(geometry_is_disk_cacheable(geometry));
+  const std::optional<std::string> cache_dir = get_disk_cache_dir();
+  if (!cache_dir) {
+    return;
+  }
+  const std::string entry_dir = get_entry_dir(*cache_dir, key);
+  if (BLI_exists(entry_dir.c_str())) {
+    return;
+  }
+
+  GeometryBakeItem::prepare_geometry_for_bake(geometry, nullptr);
+  BakeState bake_state;
+  bake_state.items_by_id.add_new(0, std::make_unique<GeometryBakeItem>(std::move(geometry)));
+
+  /* Write into a temporary directory first, so that readers never see incomplete entries. */
+  const std::string tmp_entry_dir = get_entry_dir(
+      *cache_dir, fmt::format("{}.{:08x}.tmp", key, std::random_device{}()));
+  const std::string meta_path = get_meta_path(tmp_entry_dir);
+  if (!BLI_file_ensure_parent_dir_exists(meta_path.c_str())) {
+    return;
+  }
+  {
+    DiskBlobWriter blob_writer{get_blobs_dir(tmp_entry_dir), "geometry"};
+    BlobWriteSharing blob_sharing;
+    fstream meta_file{meta_path.c_str(), std::ios::out};
+    serialize_bake(bake_state, blob_writer, blob_sharing, meta_file);
+  }
+  if (BLI_rename(tmp_entry_dir.c_str(), entry_dir.c_str()) != 0) {
+    /* Another process has written the same entry in the mean-time. */
+    BLI_delete(tmp_entry_dir.c_str(), true, true);
+    return;
+  }
+
+  const int64_t entry_size = dir_size_recursive(entry_dir.c_str());
+  /* The first write only has to compute the size, the cache only shrinks once it is too large. */
+  std::optional<int64_t> cleanup_size = DISK_CACHE_SIZE_MAX;
+  {
+    DiskCacheSize &size = disk_cache_size();
+    std::lock_guard lock{size.mutex};
+    if (size.total) {
+      *size.total += entry_size;
+      if (*size.total > DISK_CACHE_SIZE_MAX) {
+        cleanup_size = DISK_CACHE_SIZE_AFTER_CLEANUP;
+      }
+      else {
+        cleanup_size.reset();
+      }
+    }
+  }
+  if (cleanup_size) {
+    disk_cache_cleanup(*cleanup_size);
+  }
+}
+
+void disk_cache_cleanup(const int64_t max_size)
+{
+  const std::optional<std::string> cache_dir = get_disk_cache_dir();
+  if (!cache_dir || !BLI_is_dir(cache_dir->c_str())) {
+    return;
+  }
+  struct Entry {
+    std::string dir;
+    int64_t size;
+    int64_t mtime;
+  };
+  /* Held during the whole cleanup, so that concurrent writes don't start another scan. */
+  DiskCacheSize &cache_size = disk_cache_size();
+  std::lock_guard lock{cache_size.mutex};
+
+  Vector<Entry> cache_entries;
+  int64_t size_total = 0;
+  const int64_t now = int64_t(time(nullptr));
+
+  direntry *entries;
+  const uint entries_num = BLI_filelist_dir_contents(cache_dir->c_str(), &entries);
+  for (const direntry &entry : Span(entries, entries_num)) {
+    if (FILENAME_IS_CURRPAR(entry.relname) || !S_ISDIR(entry.s.st_mode)) {
+      continue;
+    }
+    if (BLI_path_extension_check(entry.relname, ".tmp")) {
+      /* Left behind by a writer that didn't finish, e.g. because Blender crashed. */
+      if (now - int64_t(entry.s.st_mtime) > DISK_CACHE_TMP_LIFETIME_SECONDS) {
+        BLI_delete(entry.path, true, true);
+      }
+      continue;
+    }
+    BLI_stat_t meta_stat;
+    if (BLI_stat(get_meta_path(entry.path).c_str(), &meta_stat) != 0) {
+      continue;
+    }
+    const int64_t size = dir_size_recursive(entry.path);
+    cache_entries.append({entry.path, size, int64_t(meta_stat.st_mtime)});
+    size_total += size;
+  }
+  BLI_filelist_free(entries, entries_num);
+
+  if (size_total <= max_size) {
+    cache_size.total = size_total;
+    return;
+  }
+  std::sort(cache_entries.begin(), cache_entries.end(), [](const Entry &a, const Entry &b) {
+    return a.mtime < b.mtime;
+  });
+  for (const Entry &entry : cache_entries) {
+    if (size_total <= max_size) {
+      break;
+    }
+    BLI_delete(entry.dir.c_str(), true, true);
+    size_total -= entry.size;
+  }
+  cache_size.total = size_total;
+}
+
+}  // namespace blender::bke::bake
@@ -0,0 +1,159 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+
+#include "BKE_attribute.hh"
+#include "BKE_bake_disk_cache.hh"
+#include "BKE_idtype.hh"
+#include "BKE_pointcloud.hh"
+
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_system.h"
+#include "BLI_tempfile.h"
+
+#include "DNA_pointcloud_types.h"
+
+#include BLI_SYSTEM_PID_H
+
+namespace blender::bke::bake::tests {
+
+class DiskCacheTest : public testing::Test {
+ public:
+  std::string cache_dir;
+
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+
+  void SetUp() override
+  {
+    char temp_dir[FILE_MAX];
+    BLI_temp_directory_path_get(temp_dir, sizeof(temp_dir));
+    cache_dir = std::string(temp_dir) + SEP_STR + "blender_bake_disk_cache_test_" +
+                std::to_string(getpid());
+    BLI_dir_create_recursive(cache_dir.c_str());
+    disk_cache_dir_override_set(cache_dir);
+  }
+
+  void TearDown() override
+  {
+    disk_cache_dir_override_set(std::nullopt);
+    BLI_delete(cache_dir.c_str(), true, true);
+  }
+
+  std::string meta_path(const StringRef key)
+  {
+    return cache_dir + SEP_STR + std::string(key) + SEP_STR + "meta.json";
+  }
+
+  /** Make the file look like it was last modified the given number of seconds ago. */
+  static void set_age(const std::string &path, const int seconds)
+  {
+    std::filesystem::last_write_time(path,
+                                     std::filesystem::file_time_type::clock::now() -
+                                         std::chrono::seconds(seconds));
+  }
+};
+
+static GeometrySet create_points(const int points_num, const float offset)
+{
+  PointCloud *pointcloud = BKE_pointcloud_new_nomain(points_num);
+  MutableSpan<float3> positions = pointcloud->positions_for_write();
+  for (const int i : positions.index_range()) {
+    positions[i] = float3(float(i), offset, 0.0f);
+  }
+  return GeometrySet::from_pointcloud(pointcloud);
+}
+
+static std::string geometry_key(const GeometrySet &geometry)
+{
+  DiskCacheKeyBuilder key;
+  key.add(geometry);
+  return key.build();
+}
+
+TEST_F(DiskCacheTest, KeyDependsOnContent)
+{
+  const GeometrySet geometry = create_points(10, 0.0f);
+  EXPECT_EQ(geometry_key(geometry), geometry_key(create_points(10, 0.0f)));
+  EXPECT_NE(geometry_key(geometry), geometry_key(create_points(10, 1.0f)));
+  EXPECT_NE(geometry_key(geometry), geometry_key(create_points(11, 0.0f)));
+
+  GeometrySet geometry_with_attribute = create_points(10, 0.0f);
+  PointCloud *pointcloud = geometry_with_attribute.get_pointcloud_for_write();
+  pointcloud->attributes_for_write().add<int>(
+      "test", AttrDomain::Point, AttributeInitDefaultValue());
+  const std::string key_with_attribute = geometry_key(geometry_with_attribute);
+  EXPECT_NE(geometry_key(geometry), key_with_attribute);
+
+  SpanAttributeWriter<int> attribute =
+      pointcloud->attributes_for_write().lookup_for_write_span<int>("test");
+  attribute.span[3] = 1;
+  attribute.finish();
+  EXPECT_NE(geometry_key(geometry_with_attribute), key_with_attribute);
+}
+
+TEST_F(DiskCacheTest, WriteRead)
+{
+  const std::string key = geometry_key(create_points(10, 2.0f));
+  EXPECT_FALSE(disk_cache_read_geometry(key, nullptr).has_value());
+
+  disk_cache_write_geometry(key, create_points(10, 2.0f));
+  const std::optional<GeometrySet> geometry = disk_cache_read_geometry(key, nullptr);
+  ASSERT_TRUE(geometry.has_value());
+  const PointCloud *pointcloud = geometry->get_pointcloud();
+  ASSERT_NE(pointcloud, nullptr);
+  const GeometrySet expected = create_points(10, 2.0f);
+  EXPECT_TRUE(pointcloud->positions() == expected.get_pointcloud()->positions());
+}
+
+TEST_F(DiskCacheTest, CleanupLeastRecentlyUsed)
+{
+  /* Much larger than the size passed to the cleanup, the other entries are smaller. */
+  const int large_points_num = 200000;
+  const std::string key_a = geometry_key(create_points(10, 0.0f));
+  const std::string key_b = geometry_key(create_points(large_points_num, 0.0f));
+  const std::string key_c = geometry_key(create_points(10, 1.0f));
+  disk_cache_write_geometry(key_a, create_points(10, 0.0f));
+  disk_cache_write_geometry(key_b, create_points(large_points_num, 0.0f));
+  disk_cache_write_geometry(key_c, create_points(10, 1.0f));
+  set_age(meta_path(key_a), 300);
+  set_age(meta_path(key_b), 200);
+  set_age(meta_path(key_c), 100);
+
+  /* Reading marks the oldest entry as recently used. */
+  EXPECT_TRUE(disk_cache_read_geometry(key_a, nullptr).has_value());
+
+  disk_cache_cleanup(1024 * 1024);
+  EXPECT_TRUE(BLI_exists(meta_path(key_a).c_str()));
+  EXPECT_FALSE(BLI_exists(meta_path(key_b).c_str()));
+  EXPECT_TRUE(BLI_exists(meta_path(key_c).c_str()));
+
+  disk_cache_cleanup(0);
+  EXPECT_FALSE(BLI_exists(meta_path(key_a).c_str()));
+  EXPECT_FALSE(BLI_exists(meta_path(key_c).c_str()));
+}
+
+TEST_F(DiskCacheTest, CleanupUnfinishedWrites)
+{
+  const std::string old_tmp_dir = cache_dir + SEP_STR + "old.tmp";
+  const std::string new_tmp_dir = cache_dir + SEP_STR + "new.tmp";
+  BLI_dir_create_recursive(old_tmp_dir.c_str());
+  BLI_dir_create_recursive(new_tmp_dir.c_str());
+  set_age(old_tmp_dir, 2 * 60 * 60);
+
+  disk_cache_cleanup(0);
+  EXPECT_FALSE(BLI_exists(old_tmp_dir.c_str()));
+  /* May still be written by another Blender instance. */
+  EXPECT_TRUE(BLI_exists(new_tmp_dir.c_str()));
+}
+
+}  // namespace blender::bke::bake::tests
@@ -2091,7 +2091,8 @@ static float fcurve_eval_keyframes_extrapolate(const FCurve *fcu,
 
 static float fcurve_eval_keyframes_interpolate(const FCurve *fcu,
                                                const BezTriple *bezts,
-                                               float evaltime)
+                                               float evaltime,
+                                               int *segment_hint)
 {
   const float eps = 1.e-8f;
   uint a;
@@ -2109,7 +2110,23 @@ static float fcurve_eval_keyframes_interpolate(const FCurve *fcu,
    *   Weird errors, like selecting the wrong keyframe range (see #39207), occur.
    *   This lower bound was established in b888a32eee8147b028464336ad2404d8155c64dd.
    */
-  a = BKE_fcurve_bezt_binarysearch_index_ex(bezts, evaltime, fcu->totvert, 0.0001, &exact);
+  const float threshold = 0.0001f;
+
+  /* When evaluating nearby times, the segment of the previous evaluation usually still contains
+   * the evaluation-time. Only use it when it is not within the threshold of either keyframe, so
+   * the result is the same as the binary search would give. */
+  if (segment_hint && *segment_hint > 0 && *segment_hint < fcu->totvert &&
+      evaltime - bezts[*segment_hint - 1].vec[1][0] > threshold &&
+      bezts[*segment_hint].vec[1][0] - evaltime > threshold)
+  {
+    a = *segment_hint;
+  }
+  else {
+    a = BKE_fcurve_bezt_binarysearch_index_ex(bezts, evaltime, fcu->totvert, threshold, &exact);
+    if (segment_hint) {
+      *segment_hint = a;
+    }
+  }
   const BezTriple *bezt = bezts + a;
 
   if (exact) {
@@ -2353,7 +2370,10 @@ static float fcurve_eval_keyframes_interpolate(const FCurve *fcu,
 }
 
 /* Calculate F-Curve value for 'evaltime' using #BezTriple keyframes. */
-static float fcurve_eval_keyframes(const FCurve *fcu, const BezTriple *bezts, float evaltime)
+static float fcurve_eval_keyframes(const FCurve *fcu,
+                                   const BezTriple *bezts,
+                                   float evaltime,
+                                   int *segment_hint)
 {
   if (evaltime <= bezts->vec[1][0]) {
     return fcurve_eval_keyframes_extrapolate(fcu, bezts, evaltime, 0, +1);
@@ -2364,7 +2384,7 @@ static float fcurve_eval_keyframes(const FCurve *fcu, const BezTriple *bezts, fl
     return fcurve_eval_keyframes_extrapolate(fcu, bezts, evaltime, fcu->totvert - 1, -1);
   }
 
-  return fcurve_eval_keyframes_interpolate(fcu, bezts, evaltime);
+  return fcurve_eval_keyframes_interpolate(fcu, bezts, evaltime, segment_hint);
 }
 
 /* Calculate F-Curve value for 'evaltime' using #FPoint samples. */
@@ -2412,7 +2432,10 @@ static float fcurve_eval_samples(const FCurve *fcu, const FPoint *fpts, float ev
 /* Evaluate and return the value of the given F-Curve at the specified frame ("evaltime")
  * NOTE: this is also used for drivers.
  */
-static float evaluate_fcurve_ex(const FCurve *fcu, float evaltime, float cvalue)
+static float evaluate_fcurve_ex(const FCurve *fcu,
+                                float evaltime,
+                                float cvalue,
+                                int *segment_hint = nullptr)
 {
   /* Evaluate modifiers which modify time to evaluate the base curve at. */
   FModifiersStackStorage storage;
@@ -2428,7 +2451,7 @@ static float evaluate_fcurve_ex(const FCurve *fcu, float evaltime, float cvalue)
    *   F-Curve modifier on the stack requested the curve to be evaluated at.
    */
   if (fcu->bezt) {
-    cvalue = fcurve_eval_keyframes(fcu, fcu->bezt, devaltime);
+    cvalue = fcurve_eval_keyframes(fcu, fcu->bezt, devaltime, segment_hint);
   }
   else if (fcu->fpt) {
     cvalue = fcurve_eval_samples(fcu, fcu->fpt, devaltime);
@@ -2454,6 +2477,13 @@ float evaluate_fcurve(const FCurve *fcu, float evaltime)
   return evaluate_fcurve_ex(fcu, evaltime, 0.0);
 }
 
+float evaluate_fcurve_segment_hint(const FCurve *fcu, float evaltime, int *segment_hint)
+{
+  BLI_assert(fcu->driver == nullptr);
+
+  return evaluate_fcurve_ex(fcu, evaltime, 0.0, segment_hint);
+}
+
 float evaluate_fcurve_only_curve(const FCurve *fcu, float evaltime)
 {
   /* Can be used to evaluate the (key-framed) f-curve only.
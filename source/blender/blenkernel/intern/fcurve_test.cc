@@ -95,6 +95,35 @@ TEST(evaluate_fcurve, InterpolationLinear)
   BKE_fcurve_free(fcu);
 }
 
+TEST(evaluate_fcurve, SegmentHint)
+{
+  FCurve *fcu = BKE_fcurve_create();
+
+  const KeyframeSettings settings = get_keyframe_settings(false);
+  for (int i = 0; i < 8; i++) {
+    insert_vert_fcurve(fcu, {float(i), float(i * i)}, settings, INSERTKEY_NOFLAGS);
+  }
+
+  /* Moving forward and backward in time gives the same results as without a hint. */
+  int segment_hint = 0;
+  for (const float time : {0.5f, 0.75f, 1.5f, 3.0f, 3.00005f, 6.25f, 2.5f, 2.5f, -1.0f, 9.0f}) {
+    EXPECT_NEAR(
+        evaluate_fcurve_segment_hint(fcu, time, &segment_hint), evaluate_fcurve(fcu, time), EPSILON);
+  }
+
+  /* The hint is the index of the keyframe after the last evaluated segment. */
+  evaluate_fcurve_segment_hint(fcu, 4.5f, &segment_hint);
+  EXPECT_EQ(segment_hint, 5);
+
+  /* A hint that is out of range is ignored. */
+  segment_hint = 100;
+  EXPECT_NEAR(
+      evaluate_fcurve_segment_hint(fcu, 1.5f, &segment_hint), evaluate_fcurve(fcu, 1.5f), EPSILON);
+  EXPECT_EQ(segment_hint, 2);
+
+  BKE_fcurve_free(fcu);
+}
+
 TEST(evaluate_fcurve, InterpolationBezier)
 {
   FCurve *fcu = BKE_fcurve_create();
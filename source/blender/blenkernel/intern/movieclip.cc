@@ -582,6 +582,9 @@ static void movieclip_open_anim_file(MovieClip *clip)
     clip->anim = openanim(filepath_abs, IB_rect, 0, clip->colorspace_settings.name);
 
     if (clip->anim) {
+      /* Decode a few frames ahead during playback and tracking. */
+      IMB_anim_set_read_ahead(clip->anim, 4);
+
       if (clip->flag & MCLIP_USE_PROXY_CUSTOM_DIR) {
         char dir[FILE_MAX];
         STRNCPY(dir, clip->proxy.dir);
@@ -32,12 +32,21 @@ struct FileReader;
 typedef int64_t (*FileReaderReadFn)(struct FileReader *reader, void *buffer, size_t size);
 typedef off64_t (*FileReaderSeekFn)(struct FileReader *reader, off64_t offset, int whence);
 typedef void (*FileReaderCloseFn)(struct FileReader *reader);
+typedef int64_t (*FileReaderReadAtFn)(struct FileReader *reader,
+                                      void *buffer,
+                                      size_t size,
+                                      off64_t offset);
 
 /** General structure for all #FileReaders, implementations add custom fields at the end. */
 typedef struct FileReader {
   FileReaderReadFn read;
   FileReaderSeekFn seek;
   FileReaderCloseFn close;
+  /**
+   * Optional: read from an absolute position without changing `offset`.
+   * Unlike `read`, this may be called from multiple threads at once. NULL when not supported.
+   */
+  FileReaderReadAtFn read_at;
 
   off64_t offset;
 } FileReader;
@@ -55,6 +55,19 @@
 #  define KDOPBVH_THREAD_LEAF_THRESHOLD 1024
 #endif
 
+/* Nodes with more leafs than this are partitioned and refit using multiple threads. This is
+ * mostly relevant for the first levels of the tree, which have too few nodes to keep all threads
+ * busy otherwise. Use a small value in debug builds so that tests cover this code path. */
+#ifndef NDEBUG
+#  define KDOPBVH_PARALLEL_SPLIT_THRESHOLD 4096
+#else
+#  define KDOPBVH_PARALLEL_SPLIT_THRESHOLD 65536
+#endif
+/* Number of leafs that is processed by a single task when a node is split using multiple
+ * threads, the chunk size grows for bigger nodes to limit the number of chunks. */
+#define KDOPBVH_PARALLEL_SPLIT_CHUNK_SIZE 4096
+#define KDOPBVH_PARALLEL_SPLIT_MAX_CHUNKS 256
+
 /* -------------------------------------------------------------------- */
 /** \name Struct Definitions
  * \{ */
@@ -370,18 +383,12 @@ static void create_kdop_hull(
   }
 }
 
-/**
- * \note depends on the fact that the BVH's for each face is already built
- */
-static void refit_kdop_hull(const BVHTree *tree, BVHNode *node, int start, int end)
+static void bv_expand_by_nodes(const BVHTree *tree, float *__restrict bv, int start, int end)
 {
   float newmin, newmax;
-  float *__restrict bv = node->bv;
   int j;
   axis_t axis_iter;
 
-  node_minmax_init(tree, node);
-
   for (j = start; j < end; j++) {
     float *__restrict node_bv = tree->nodes[j]->bv;
 
@@ -400,6 +407,211 @@ static void refit_kdop_hull(const BVHTree *tree, BVHNode *node, int start, int e
   }
 }
 
+static int parallel_split_chunk_size(int len)
+{
+  return max_ii(KDOPBVH_PARALLEL_SPLIT_CHUNK_SIZE,
+                (len + KDOPBVH_PARALLEL_SPLIT_MAX_CHUNKS - 1) / KDOPBVH_PARALLEL_SPLIT_MAX_CHUNKS);
+}
+
+typedef struct BVHRefitData {
+  const BVHTree *tree;
+  int start, end;
+  int chunk_size;
+} BVHRefitData;
+
+static void refit_kdop_hull_task_cb(void *__restrict userdata,
+                                    const int chunk,
+                                    const TaskParallelTLS *__restrict tls)
+{
+  const BVHRefitData *data = userdata;
+  const int start = data->start + chunk * data->chunk_size;
+  const int end = min_ii(start + data->chunk_size, data->end);
+  bv_expand_by_nodes(data->tree, tls->userdata_chunk, start, end);
+}
+
+static void refit_kdop_hull_reduce(const void *__restrict userdata,
+                                   void *__restrict chunk_join,
+                                   void *__restrict chunk)
+{
+  const BVHRefitData *data = userdata;
+  float *bv_join = chunk_join;
+  const float *bv = chunk;
+  axis_t axis_iter;
+
+  for (axis_iter = data->tree->start_axis; axis_iter < data->tree->stop_axis; axis_iter++) {
+    bv_join[(2 * axis_iter)] = min_ff(bv_join[(2 * axis_iter)], bv[(2 * axis_iter)]);
+    bv_join[(2 * axis_iter) + 1] = max_ff(bv_join[(2 * axis_iter) + 1], bv[(2 * axis_iter) + 1]);
+  }
+}
+
+/**
+ * \note depends on the fact that the BVH's for each face is already built
+ */
+static void refit_kdop_hull(const BVHTree *tree, BVHNode *node, int start, int end)
+{
+  node_minmax_init(tree, node);
+
+  if (end - start <= KDOPBVH_PARALLEL_SPLIT_THRESHOLD) {
+    bv_expand_by_nodes(tree, node->bv, start, end);
+    return;
+  }
+
+  BVHRefitData data = {
+      .tree = tree,
+      .start = start,
+      .end = end,
+      .chunk_size = parallel_split_chunk_size(end - start),
+  };
+  const int chunks_num = (end - start + data.chunk_size - 1) / data.chunk_size;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  settings.userdata_chunk = node->bv;
+  settings.userdata_chunk_size = sizeof(float) * (size_t)tree->axis;
+  settings.func_reduce = refit_kdop_hull_reduce;
+  BLI_task_parallel_range(0, chunks_num, &data, refit_kdop_hull_task_cb, &settings);
+}
+
+typedef struct BVHPartitionData {
+  BVHNode **a;
+  /** Buffer with the same size as `a`, only the range that is partitioned is used. */
+  BVHNode **tmp;
+  int begin, end;
+  int chunk_size;
+  int axis;
+  float pivot;
+  /** Number of elements that are less than, equal to and greater than the pivot per chunk.
+   * After counting, this is turned into the offsets where each chunk writes its elements. */
+  int (*chunk_counts)[3];
+} BVHPartitionData;
+
+static void parallel_partition_count_task_cb(void *__restrict userdata,
+                                             const int chunk,
+                                             const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHPartitionData *data = userdata;
+  const int start = data->begin + chunk * data->chunk_size;
+  const int end = min_ii(start + data->chunk_size, data->end);
+  int counts[3] = {0, 0, 0};
+  for (int i = start; i < end; i++) {
+    const float value = data->a[i]->bv[data->axis];
+    counts[(value < data->pivot) ? 0 : ((value > data->pivot) ? 2 : 1)]++;
+  }
+  copy_v3_v3_int(data->chunk_counts[chunk], counts);
+}
+
+static void parallel_partition_scatter_task_cb(void *__restrict userdata,
+                                               const int chunk,
+                                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHPartitionData *data = userdata;
+  const int start = data->begin + chunk * data->chunk_size;
+  const int end = min_ii(start + data->chunk_size, data->end);
+  int *offsets = data->chunk_counts[chunk];
+  for (int i = start; i < end; i++) {
+    const float value = data->a[i]->bv[data->axis];
+    data->tmp[offsets[(value < data->pivot) ? 0 : ((value > data->pivot) ? 2 : 1)]++] = data->a[i];
+  }
+}
+
+static void parallel_partition_copy_task_cb(void *__restrict userdata,
+                                            const int chunk,
+                                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHPartitionData *data = userdata;
+  const int start = data->begin + chunk * data->chunk_size;
+  const int end = min_ii(start + data->chunk_size, data->end);
+  memcpy(&data->a[start], &data->tmp[start], sizeof(*data->a) * (size_t)(end - start));
+}
+
+/**
+ * Choose a pivot that is expected to be close to the n-th element, based on a regular sample of
+ * the range. A good estimate keeps the number of passes over the data low.
+ */
+static float parallel_partition_estimate_pivot(
+    BVHNode **a, const int begin, const int end, const int n, const int axis)
+{
+  enum { SAMPLES_NUM = 63 };
+  float samples[SAMPLES_NUM];
+  const int len = end - begin;
+  for (int i = 0; i < SAMPLES_NUM; i++) {
+    const int index = begin + (int)(((int64_t)len * (2 * i + 1)) / (2 * SAMPLES_NUM));
+    const float value = a[index]->bv[axis];
+    /* Insertion sort, the number of samples is small. */
+    int j = i;
+    while (j > 0 && value < samples[j - 1]) {
+      samples[j] = samples[j - 1];
+      j--;
+    }
+    samples[j] = value;
+  }
+  const int sample_index = (int)(((int64_t)(n - begin) * SAMPLES_NUM) / len);
+  return samples[min_ii(sample_index, SAMPLES_NUM - 1)];
+}
+
+/**
+ * Same as #partition_nth_element, but large ranges are partitioned around a pivot using multiple
+ * threads until the remaining range that contains the n-th element is small.
+ */
+static void parallel_partition_nth_element(
+    BVHNode **a, BVHNode **tmp, int begin, int end, const int n, const int axis)
+{
+  int chunk_counts[KDOPBVH_PARALLEL_SPLIT_MAX_CHUNKS][3];
+
+  while (end - begin > KDOPBVH_PARALLEL_SPLIT_THRESHOLD) {
+    BVHPartitionData data = {
+        .a = a,
+        .tmp = tmp,
+        .begin = begin,
+        .end = end,
+        .chunk_size = parallel_split_chunk_size(end - begin),
+        .axis = axis,
+        .pivot = parallel_partition_estimate_pivot(a, begin, end, n, axis),
+        .chunk_counts = chunk_counts,
+    };
+    const int chunks_num = (end - begin + data.chunk_size - 1) / data.chunk_size;
+
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 1;
+
+    BLI_task_parallel_range(0, chunks_num, &data, parallel_partition_count_task_cb, &settings);
+
+    /* Turn the counts into offsets, elements of each category stay in the same order. */
+    int totals[3] = {0, 0, 0};
+    for (int chunk = 0; chunk < chunks_num; chunk++) {
+      for (int k = 0; k < 3; k++) {
+        const int count = chunk_counts[chunk][k];
+        chunk_counts[chunk][k] = totals[k];
+        totals[k] += count;
+      }
+    }
+    const int equal_begin = begin + totals[0];
+    const int greater_begin = equal_begin + totals[1];
+    for (int chunk = 0; chunk < chunks_num; chunk++) {
+      chunk_counts[chunk][0] += begin;
+      chunk_counts[chunk][1] += equal_begin;
+      chunk_counts[chunk][2] += greater_begin;
+    }
+
+    BLI_task_parallel_range(0, chunks_num, &data, parallel_partition_scatter_task_cb, &settings);
+    BLI_task_parallel_range(0, chunks_num, &data, parallel_partition_copy_task_cb, &settings);
+
+    if (n < equal_begin) {
+      end = equal_begin;
+    }
+    else if (n >= greater_begin) {
+      begin = greater_begin;
+    }
+    else {
+      /* The n-th element is equal to the pivot, so the range is partitioned already. */
+      return;
+    }
+  }
+  partition_nth_element(a, begin, end, n, axis);
+}
+
 /**
  * Only supports x,y,z axis in the moment
  * but we should use a plain and simple function here for speed sake.
@@ -665,8 +877,12 @@ static int implicit_needed_branches(int tree_type, int leafs)
  * partition P is described as the elements in the range ( nth[P], nth[P+1] ]
  *
  * TODO: This can be optimized a bit by doing a specialized nth_element instead of K nth_elements
+ *
+ * \param leafs_tmp: Buffer with the same size as \a leafs_array, used to partition large ranges
+ * using multiple threads. May be null.
  */
 static void split_leafs(BVHNode **leafs_array,
+                        BVHNode **leafs_tmp,
                         const int nth[],
                         const int partitions,
                         const int split_axis)
@@ -677,7 +893,13 @@ static void split_leafs(BVHNode **leafs_array,
       break;
     }
 
-    partition_nth_element(leafs_array, nth[i], nth[partitions], nth[i + 1], split_axis);
+    if (leafs_tmp && (nth[partitions] - nth[i] > KDOPBVH_PARALLEL_SPLIT_THRESHOLD)) {
+      parallel_partition_nth_element(
+          leafs_array, leafs_tmp, nth[i], nth[partitions], nth[i + 1], split_axis);
+    }
+    else {
+      partition_nth_element(leafs_array, nth[i], nth[partitions], nth[i + 1], split_axis);
+    }
   }
 }
 
@@ -685,6 +907,7 @@ typedef struct BVHDivNodesData {
   const BVHTree *tree;
   BVHNode *branches_array;
   BVHNode **leafs_array;
+  BVHNode **leafs_tmp;
 
   int tree_type;
   int tree_offset;
@@ -732,7 +955,7 @@ static void non_recursive_bvh_div_nodes_task_cb(void *__restrict userdata,
     nth_positions[k] = implicit_leafs_index(data->data, data->depth + 1, child_level_index);
   }
 
-  split_leafs(data->leafs_array, nth_positions, data->tree_type, split_axis);
+  split_leafs(data->leafs_array, data->leafs_tmp, nth_positions, data->tree_type, split_axis);
 
   /* Setup `children` and `node_num` counters
    * Not really needed but currently most of BVH code
@@ -815,10 +1038,16 @@ static void non_recursive_bvh_div_nodes(const BVHTree *tree,
 
   build_implicit_tree_helper(tree, &data);
 
+  BVHNode **leafs_tmp = NULL;
+  if (leafs_num > KDOPBVH_PARALLEL_SPLIT_THRESHOLD) {
+    leafs_tmp = MEM_mallocN(sizeof(*leafs_tmp) * (size_t)leafs_num, __func__);
+  }
+
   BVHDivNodesData cb_data = {
       .tree = tree,
       .branches_array = branches_array,
       .leafs_array = leafs_array,
+      .leafs_tmp = leafs_tmp,
       .tree_type = tree_type,
       .tree_offset = tree_offset,
       .data = &data,
@@ -852,6 +1081,8 @@ static void non_recursive_bvh_div_nodes(const BVHTree *tree,
       }
     }
   }
+
+  MEM_SAFE_FREE(leafs_tmp);
 }
 
 /** \} */
@@ -36,6 +36,20 @@ static int64_t memory_read_raw(FileReader *reader, void *buffer, size_t size)
   return readsize;
 }
 
+static int64_t memory_read_at_raw(FileReader *reader, void *buffer, size_t size, off64_t offset)
+{
+  MemoryReader *mem = (MemoryReader *)reader;
+
+  if (offset < 0 || (size_t)offset > mem->length) {
+    return -1;
+  }
+  size_t readsize = MIN2(size, (size_t)(mem->length - offset));
+
+  memcpy(buffer, mem->data + offset, readsize);
+
+  return readsize;
+}
+
 static off64_t memory_seek(FileReader *reader, off64_t offset, int whence)
 {
   MemoryReader *mem = (MemoryReader *)reader;
@@ -77,6 +91,7 @@ FileReader *BLI_filereader_new_memory(const void *data, size_t len)
   mem->reader.read = memory_read_raw;
   mem->reader.seek = memory_seek;
   mem->reader.close = memory_close_raw;
+  mem->reader.read_at = memory_read_at_raw;
 
   return (FileReader *)mem;
 }
@@ -103,6 +118,23 @@ static int64_t memory_read_mmap(FileReader *reader, void *buffer, size_t size)
   return readsize;
 }
 
+static int64_t memory_read_at_mmap(FileReader *reader, void *buffer, size_t size, off64_t offset)
+{
+  MemoryReader *mem = (MemoryReader *)reader;
+
+  if (offset < 0 || (size_t)offset > mem->length) {
+    return -1;
+  }
+  size_t readsize = MIN2(size, (size_t)(mem->length - offset));
+
+  /* Only reads from the mapping, so this is safe to call from multiple threads. */
+  if (!BLI_mmap_read(mem->mmap, buffer, (size_t)offset, readsize)) {
+    return 0;
+  }
+
+  return readsize;
+}
+
 static void memory_close_mmap(FileReader *reader)
 {
   MemoryReader *mem = (MemoryReader *)reader;
@@ -125,6 +157,7 @@ FileReader *BLI_filereader_new_mmap(int filedes)
   mem->reader.read = memory_read_mmap;
   mem->reader.seek = memory_seek;
   mem->reader.close = memory_close_mmap;
+  mem->reader.read_at = memory_read_at_mmap;
 
   return (FileReader *)mem;
 }
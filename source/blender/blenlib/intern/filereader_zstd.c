@@ -11,9 +11,19 @@
 
 #include "BLI_filereader.h"
 #include "BLI_math_base.h"
+#include "BLI_threads.h"
 
 #include "MEM_guardedalloc.h"
 
+/** A decompressed frame of a seekable file. */
+typedef struct {
+  /** Index of the frame, -1 when the slot is unused. */
+  int frame;
+  /** Value of #ZstdReader.seek.cache_clock when last used, to evict the oldest frame. */
+  uint64_t last_used;
+  char *content;
+} ZstdCachedFrame;
+
 typedef struct {
   FileReader reader;
 
@@ -28,8 +38,15 @@ typedef struct {
     size_t *compressed_ofs;
     size_t *uncompressed_ofs;
 
-    char *cached_content;
-    int cached_frame;
+    /**
+     * Frames decompressed most recently. There is a slot for every thread, so that
+     * blocks can be read in parallel (see #FileReader.read_at) without evicting each other.
+     */
+    ZstdCachedFrame *cache;
+    int cache_size;
+    uint64_t cache_clock;
+    /** Protects the cache and access to the base reader. */
+    ThreadMutex mutex;
   } seek;
 } ZstdReader;
 
@@ -125,7 +142,15 @@ static bool zstd_read_seek_table(ZstdReader *zstd)
     return false;
   }
 
-  zstd->seek.cached_frame = -1;
+  zstd->seek.cache_size = max_ii(2, BLI_system_thread_count());
+  zstd->seek.cache = MEM_malloc_arrayN(
+      zstd->seek.cache_size, sizeof(ZstdCachedFrame), "zstd frame cache");
+  for (int i = 0; i < zstd->seek.cache_size; i++) {
+    zstd->seek.cache[i].frame = -1;
+    zstd->seek.cache[i].last_used = 0;
+    zstd->seek.cache[i].content = NULL;
+  }
+  BLI_mutex_init(&zstd->seek.mutex);
 
   return true;
 }
@@ -153,74 +178,136 @@ static int zstd_frame_from_pos(ZstdReader *zstd, size_t pos)
   return low;
 }
 
-/* Ensure that the currently loaded frame is the correct one. */
-static const char *zstd_ensure_cache(ZstdReader *zstd, int frame)
+/* Find the frame in the cache, must be called with the mutex locked. */
+static ZstdCachedFrame *zstd_cache_lookup(ZstdReader *zstd, int frame)
 {
-  if (zstd->seek.cached_frame == frame) {
-    /* Cached frame matches, so just return it. */
-    return zstd->seek.cached_content;
+  for (int i = 0; i < zstd->seek.cache_size; i++) {
+    if (zstd->seek.cache[i].frame == frame) {
+      zstd->seek.cache[i].last_used = ++zstd->seek.cache_clock;
+      return &zstd->seek.cache[i];
+    }
   }
+  return NULL;
+}
 
-  /* Cached frame doesn't match, so discard it and cache the wanted one instead. */
-  MEM_SAFE_FREE(zstd->seek.cached_content);
+/* Add the decompressed frame to the cache (taking ownership of `content`),
+ * replacing the least recently used one. Must be called with the mutex locked. */
+static ZstdCachedFrame *zstd_cache_add(ZstdReader *zstd, int frame, char *content)
+{
+  ZstdCachedFrame *slot = &zstd->seek.cache[0];
+  for (int i = 1; i < zstd->seek.cache_size; i++) {
+    if (zstd->seek.cache[i].last_used < slot->last_used) {
+      slot = &zstd->seek.cache[i];
+    }
+  }
+  MEM_SAFE_FREE(slot->content);
+  slot->frame = frame;
+  slot->content = content;
+  slot->last_used = ++zstd->seek.cache_clock;
+  return slot;
+}
 
+/* Read and decompress the given frame. Only reading the compressed data needs the mutex,
+ * so multiple frames can be decompressed in parallel. */
+static char *zstd_decompress_frame(ZstdReader *zstd, int frame)
+{
   size_t compressed_size = zstd->seek.compressed_ofs[frame + 1] - zstd->seek.compressed_ofs[frame];
   size_t uncompressed_size = zstd->seek.uncompressed_ofs[frame + 1] -
                              zstd->seek.uncompressed_ofs[frame];
 
-  char *uncompressed_data = MEM_mallocN(uncompressed_size, __func__);
   char *compressed_data = MEM_mallocN(compressed_size, __func__);
-  if (zstd->base->seek(zstd->base, zstd->seek.compressed_ofs[frame], SEEK_SET) < 0 ||
-      zstd->base->read(zstd->base, compressed_data, compressed_size) < compressed_size)
-  {
+  BLI_mutex_lock(&zstd->seek.mutex);
+  bool read_ok = zstd->base->seek(zstd->base, zstd->seek.compressed_ofs[frame], SEEK_SET) >= 0 &&
+                 zstd->base->read(zstd->base, compressed_data, compressed_size) >=
+                     compressed_size;
+  BLI_mutex_unlock(&zstd->seek.mutex);
+  if (!read_ok) {
     MEM_freeN(compressed_data);
-    MEM_freeN(uncompressed_data);
     return NULL;
   }
 
-  size_t res = ZSTD_decompressDCtx(
-      zstd->ctx, uncompressed_data, uncompressed_size, compressed_data, compressed_size);
+  char *uncompressed_data = MEM_mallocN(uncompressed_size, __func__);
+  /* The reader's own context can't be shared between threads, use a temporary one. */
+  size_t res = ZSTD_decompress(
+      uncompressed_data, uncompressed_size, compressed_data, compressed_size);
   MEM_freeN(compressed_data);
   if (ZSTD_isError(res) || res < uncompressed_size) {
     MEM_freeN(uncompressed_data);
     return NULL;
   }
 
-  zstd->seek.cached_frame = frame;
-  zstd->seek.cached_content = uncompressed_data;
   return uncompressed_data;
 }
 
-static int64_t zstd_read_seekable(FileReader *reader, void *buffer, size_t size)
+/* Copy uncompressed data starting at `offset` into `buffer`, decompressing the frames that
+ * are not cached yet. Safe to call from multiple threads. */
+static size_t zstd_read_frames(ZstdReader *zstd, void *buffer, size_t size, size_t offset)
 {
-  ZstdReader *zstd = (ZstdReader *)reader;
-
-  size_t end_offset = zstd->reader.offset + size, read_len = 0;
-  while (zstd->reader.offset < end_offset) {
-    int frame = zstd_frame_from_pos(zstd, zstd->reader.offset);
+  size_t end_offset = offset + size, read_len = 0;
+  while (offset < end_offset) {
+    int frame = zstd_frame_from_pos(zstd, offset);
     if (frame < 0) {
       /* EOF is reached, so return as much as we can. */
       break;
     }
 
-    const char *framedata = zstd_ensure_cache(zstd, frame);
-    if (framedata == NULL) {
-      /* Error while reading the frame, so return as much as we can. */
-      break;
-    }
-
     size_t frame_end_offset = min_zz(zstd->seek.uncompressed_ofs[frame + 1], end_offset);
-    size_t frame_read_len = frame_end_offset - zstd->reader.offset;
+    size_t frame_read_len = frame_end_offset - offset;
+    size_t offset_in_frame = offset - zstd->seek.uncompressed_ofs[frame];
+
+    BLI_mutex_lock(&zstd->seek.mutex);
+    ZstdCachedFrame *cached = zstd_cache_lookup(zstd, frame);
+    if (cached == NULL) {
+      BLI_mutex_unlock(&zstd->seek.mutex);
+      char *framedata = zstd_decompress_frame(zstd, frame);
+      if (framedata == NULL) {
+        /* Error while reading the frame, so return as much as we can. */
+        break;
+      }
+      BLI_mutex_lock(&zstd->seek.mutex);
+      /* Another thread may have decompressed the same frame in the meantime. */
+      cached = zstd_cache_lookup(zstd, frame);
+      if (cached == NULL) {
+        cached = zstd_cache_add(zstd, frame, framedata);
+      }
+      else {
+        MEM_freeN(framedata);
+      }
+    }
+    memcpy((char *)buffer + read_len, cached->content + offset_in_frame, frame_read_len);
+    BLI_mutex_unlock(&zstd->seek.mutex);
 
-    size_t offset_in_frame = zstd->reader.offset - zstd->seek.uncompressed_ofs[frame];
-    memcpy((char *)buffer + read_len, framedata + offset_in_frame, frame_read_len);
     read_len += frame_read_len;
-    zstd->reader.offset = frame_end_offset;
+    offset = frame_end_offset;
   }
 
   return read_len;
 }
 
+static int64_t zstd_read_seekable(FileReader *reader, void *buffer, size_t size)
+{
+  ZstdReader *zstd = (ZstdReader *)reader;
+
+  size_t read_len = zstd_read_frames(zstd, buffer, size, zstd->reader.offset);
+  zstd->reader.offset += read_len;
+
+  return read_len;
+}
+
+static int64_t zstd_read_at_seekable(FileReader *reader,
+                                     void *buffer,
+                                     size_t size,
+                                     off64_t offset)
+{
+  ZstdReader *zstd = (ZstdReader *)reader;
+
+  if (offset < 0) {
+    return -1;
+  }
+
+  return zstd_read_frames(zstd, buffer, size, offset);
+}
+
 static off64_t zstd_seek(FileReader *reader, off64_t offset, int whence)
 {
   ZstdReader *zstd = (ZstdReader *)reader;
@@ -281,10 +368,12 @@ static void zstd_close(FileReader *reader)
   if (zstd->reader.seek) {
     MEM_freeN(zstd->seek.uncompressed_ofs);
     MEM_freeN(zstd->seek.compressed_ofs);
-    /* When an error has occurred this may be NULL, see: #99744. */
-    if (zstd->seek.cached_content) {
-      MEM_freeN(zstd->seek.cached_content);
+    for (int i = 0; i < zstd->seek.cache_size; i++) {
+      /* When an error has occurred this may be NULL, see: #99744. */
+      MEM_SAFE_FREE(zstd->seek.cache[i].content);
     }
+    MEM_freeN(zstd->seek.cache);
+    BLI_mutex_end(&zstd->seek.mutex);
   }
   else {
     MEM_freeN((void *)zstd->in_buf.src);
@@ -304,6 +393,7 @@ FileReader *BLI_filereader_new_zstd(FileReader *base)
   if (zstd_read_seek_table(zstd)) {
     zstd->reader.read = zstd_read_seekable;
     zstd->reader.seek = zstd_seek;
+    zstd->reader.read_at = zstd_read_at_seekable;
   }
   else {
     zstd->reader.read = zstd_read;
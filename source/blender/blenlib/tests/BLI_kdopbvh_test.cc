@@ -121,6 +121,11 @@ TEST(kdopbvh, FindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12);
 }
+/* Large enough to split the top-level nodes using multiple threads. */
+TEST(kdopbvh, FindNearest_100000)
+{
+  find_nearest_points_test(100000, 1.0, 100000, 42);
+}
 
 TEST(kdopbvh, OptimalFindNearest_1)
 {
@@ -134,3 +139,7 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+TEST(kdopbvh, OptimalFindNearest_100000)
+{
+  find_nearest_points_test(100000, 1.0, 100000, 42, true);
+}
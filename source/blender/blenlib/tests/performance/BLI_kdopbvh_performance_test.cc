@@ -0,0 +1,71 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_kdopbvh.h"
+#include "BLI_rand.h"
+#include "BLI_timeit.hh"
+
+/* Run the longest tests! */
+// #define USE_BIG_TESTS
+
+static void bvhtree_balance_test(const int points_len, const char tree_type, const char axis)
+{
+  RNG *rng = BLI_rng_new(points_len);
+  BVHTree *tree = BLI_bvhtree_new(points_len, 0.0f, tree_type, axis);
+
+  float(*points)[3] = static_cast<float(*)[3]>(
+      MEM_mallocN(sizeof(float[3]) * size_t(points_len), __func__));
+  for (int i = 0; i < points_len; i++) {
+    BLI_rng_get_float_unit_v3(rng, points[i]);
+    BLI_bvhtree_insert(tree, i, points[i], 1);
+  }
+
+  printf("%d points, tree type %d, %d axes:\n", points_len, int(tree_type), int(axis));
+  {
+    SCOPED_TIMER("  balance");
+    BLI_bvhtree_balance(tree);
+  }
+
+  /* Query time shows whether the quality of the tree is affected by changes to the builder. */
+  const int queries_num = 100000;
+  int found_num = 0;
+  {
+    SCOPED_TIMER("  find nearest");
+    for (int i = 0; i < queries_num; i++) {
+      float co[3];
+      BLI_rng_get_float_unit_v3(rng, co);
+      found_num += BLI_bvhtree_find_nearest(tree, co, nullptr, nullptr, nullptr) != -1;
+    }
+  }
+  EXPECT_EQ(found_num, queries_num);
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+}
+
+TEST(kdopbvh, Balance_100000)
+{
+  bvhtree_balance_test(100000, 2, 6);
+  bvhtree_balance_test(100000, 4, 6);
+}
+
+TEST(kdopbvh, Balance_1000000)
+{
+  bvhtree_balance_test(1000000, 2, 6);
+  bvhtree_balance_test(1000000, 4, 6);
+  bvhtree_balance_test(1000000, 8, 26);
+}
+
+#ifdef USE_BIG_TESTS
+TEST(kdopbvh, Balance_20000000)
+{
+  bvhtree_balance_test(20000000, 2, 6);
+  bvhtree_balance_test(20000000, 4, 6);
+}
+#endif
@@ -29,12 +29,18 @@ struct MemFileSharedStorage {
   ~MemFileSharedStorage();
 };
 
+/**
+ * Content of a #MemFileChunk. Shared by all chunks with the same content, in any undo step, and
+ * compressed in the background once it is only used by older undo steps.
+ */
+struct MemFileChunkData;
+
 struct MemFileChunk {
   void *next, *prev;
-  const char *buf;
+  MemFileChunkData *data;
   /** Size in bytes. */
   size_t size;
-  /** When true, this chunk doesn't own the memory, it's shared with a previous #MemFileChunk */
+  /** When true, this chunk is identical to the matching #MemFileChunk in the previous step. */
   bool is_identical;
   /** When true, this chunk is also identical to the one in the next step (used by undo code to
    * detect unchanged IDs).
@@ -47,6 +53,11 @@ struct MemFileChunk {
 
 struct MemFile {
   ListBase chunks;
+  /**
+   * Size in bytes of the chunk data first stored by this memfile. This is the uncompressed size,
+   * also after the data is compressed in the background: it is used for the undo memory limit
+   * when the step is pushed, before compression happens, and keeps the limit conservative.
+   */
   size_t size;
   /**
    * Some data is not serialized into a new buffer because the undo-step can take ownership of it
@@ -80,6 +91,10 @@ struct UndoReader {
   int undo_direction;
 
   bool memchunk_identical;
+
+  /** Decompressed content of the last read compressed chunk data. */
+  const MemFileChunkData *decompressed_data;
+  char *decompressed_buf;
 };
 
 /* Actually only used `writefile.cc`. */
@@ -100,7 +115,7 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
 
 void BLO_memfile_free(MemFile *memfile);
 /**
- * Result is that 'first' is being freed.
+ * Result is that 'first' is being freed, the chunk data it shares with 'second' is kept.
  * To keep the #MemFile linked list of consistent, `first` is always first in list.
  */
 void BLO_memfile_merge(MemFile *first, MemFile *second);
@@ -114,3 +129,10 @@ void BLO_memfile_clear_future(MemFile *memfile);
 Main *BLO_memfile_main_get(MemFile *memfile, Main *bmain, Scene **r_scene);
 
 FileReader *BLO_memfile_new_filereader(MemFile *memfile, int undo_direction);
+
+/**
+ * Wait for the background compression of chunk data that is only used by older steps, instead of
+ * cancelling it on the next access.
+ */
+void BLO_memfile_compress_wait();
+bool BLO_memfile_chunk_is_compressed(const MemFileChunk *chunk);
@@ -6,14 +6,18 @@
  * \ingroup blenloader
  */
 
+#include <algorithm>
+#include <atomic>
 #include <cctype> /* for isdigit. */
 #include <cerrno>
+#include <cinttypes>
 #include <climits>
 #include <cstdarg> /* for va_start/end. */
 #include <cstddef> /* for offsetof. */
 #include <cstdlib> /* for atoi. */
 #include <ctime>   /* for gmtime. */
 #include <fcntl.h> /* for open flags (O_BINARY, O_RDONLY). */
+#include <xxhash.h>
 
 #include "BLI_utildefines.h"
 #ifndef WIN32
@@ -47,6 +51,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_array.hh"
 #include "BLI_blenlib.h"
 #include "BLI_endian_defines.h"
 #include "BLI_endian_switch.h"
@@ -55,13 +60,17 @@
 #include "BLI_map.hh"
 #include "BLI_memarena.h"
 #include "BLI_mempool.h"
+#include "BLI_system.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
 #include "BLI_time.h"
+#include "BLI_vector.hh"
 
 #include "BLT_translation.hh"
 
 #include "BKE_anim_data.hh"
 #include "BKE_animsys.h"
+#include "BKE_appdir.hh"
 #include "BKE_asset.hh"
 #include "BKE_blender_version.h"
 #include "BKE_collection.hh"
@@ -106,6 +115,8 @@
 
 #include "readfile.hh"
 
+#include BLI_SYSTEM_PID_H
+
 /* Make preferences read-only. */
 #define U (*((const UserDef *)&U))
 
@@ -168,6 +179,13 @@
  */
 #define USE_BHEAD_READ_ON_DEMAND
 
+/**
+ * Store the list of #BHead's of library files in the user cache directory,
+ * so opening them again to link data doesn't need to scan the whole file.
+ * Requires #USE_BHEAD_READ_ON_DEMAND.
+ */
+#define USE_BHEAD_INDEX_CACHE
+
 /** Use #GHash for #BHead name-based lookups (speeds up linking). */
 #define USE_GHASH_BHEAD
 
@@ -183,10 +201,17 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname);
 static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const char *name);
 static BHead *find_bhead_from_idname(FileData *fd, const char *idname);
 
+#if defined(USE_BHEAD_INDEX_CACHE) && !defined(USE_BHEAD_READ_ON_DEMAND)
+#  error "USE_BHEAD_INDEX_CACHE requires USE_BHEAD_READ_ON_DEMAND"
+#endif
+
 struct BHeadN {
   BHeadN *next, *prev;
 #ifdef USE_BHEAD_READ_ON_DEMAND
-  /** Use to read the data from the file directly into memory as needed. */
+  /**
+   * Use to read the data from the file directly into memory as needed.
+   * Also set when the data has been read, for the #BHeadIndex.
+   */
   off64_t file_offset;
   /** When set, the remainder of this allocation is the data, otherwise it needs to be read. */
   bool has_data;
@@ -678,11 +703,398 @@ static void bh8_from_bh4(BHead *bhead, BHead4 *bhead4)
   }
 }
 
+#ifdef USE_BHEAD_INDEX_CACHE
+
+/* -------------------------------------------------------------------- */
+/** \name BHead Index Cache
+ *
+ * Opening a library file needs the list of its #BHead's, to find the #BLO_CODE_DNA1 block at the
+ * end of the file and to look up IDs by name. Building that list reads the header of every block,
+ * touching the whole file (or decompressing all of it).
+ *
+ * Once data has been linked or appended from a library file and the file has been listed
+ * completely, the headers and the file offsets of their data are stored in the user cache
+ * directory. The index is keyed by a hash of the file path and validated with the path, size and
+ * modification time of the file, in nanoseconds where the platform provides them. A checksum of
+ * the entries detects indices that were not written completely. When opening the file again, only
+ * the data of the blocks that are actually used is read.
+ *
+ * Indices that were not used recently are removed when the cache grows beyond
+ * #BHEAD_INDEX_CACHE_SIZE_MAX.
+ * \{ */
+
+#  define BHEAD_INDEX_MAGIC "BLOBHIX2"
+#  define BHEAD_INDEX_DIRNAME "blend_index"
+#  define BHEAD_INDEX_EXTENSION ".bhidx"
+#  define BHEAD_INDEX_CACHE_SIZE_MAX (64 * 1024 * 1024)
+
+struct BHeadIndexHeader {
+  char magic[8];
+  /** The header at the start of the blend-file. */
+  char file_header[SIZEOFBLENDERHEADER];
+  /** Size of #BHead in memory, as the index stores them after conversion. */
+  int32_t bhead_size;
+  /** Size of a block header in the file, depends on its pointer size. */
+  int32_t file_bhead_size;
+  int64_t file_size;
+  /** Modification time in nanoseconds. */
+  int64_t file_mtime;
+  int64_t entries_num;
+  /** Hash of all #BHeadIndexEntry following the header. */
+  uint64_t entries_hash;
+  char filepath[FILE_MAX];
+};
+
+struct BHeadIndexEntry {
+  /** Offset of the block data in the (uncompressed) file. */
+  int64_t file_offset;
+  BHead bhead;
+};
+
+struct BHeadIndex {
+  char cache_filepath[FILE_MAX];
+  /** Header expected for the current file, read or written with the entries. */
+  BHeadIndexHeader header;
+  /** Entries read from the cache, empty when the file has to be scanned. */
+  blender::Vector<BHeadIndexEntry> entries;
+  int64_t next_entry = 0;
+  /** Data is linked from the file, so the index is worth storing when it isn't cached yet. */
+  bool use_write = false;
+};
+
+/** Overrides the directory indices are stored in, for tests. */
+static char bhead_index_dir_override[FILE_MAX] = "";
+
+static bool bhead_index_dir_get(char *r_dirpath, const size_t dirpath_maxncpy)
+{
+  if (bhead_index_dir_override[0] != '\0') {
+    BLI_strncpy(r_dirpath, bhead_index_dir_override, dirpath_maxncpy);
+    return true;
+  }
+  char cache_dir[FILE_MAX];
+  if (!BKE_appdir_folder_caches(cache_dir, sizeof(cache_dir))) {
+    return false;
+  }
+  BLI_path_join(r_dirpath, dirpath_maxncpy, cache_dir, BHEAD_INDEX_DIRNAME);
+  return true;
+}
+
+static bool bhead_index_filepath_get(const char *filepath,
+                                     char *r_index_filepath,
+                                     const size_t index_filepath_maxncpy)
+{
+  char index_dir[FILE_MAX];
+  if (!bhead_index_dir_get(index_dir, sizeof(index_dir))) {
+    return false;
+  }
+  /* The path is stored in the index as well, so the rare collisions are detected. */
+  char index_filename[32];
+  SNPRINTF(index_filename,
+           "%016" PRIx64 BHEAD_INDEX_EXTENSION,
+           uint64_t(XXH3_64bits(filepath, strlen(filepath))));
+  BLI_path_join(r_index_filepath, index_filepath_maxncpy, index_dir, index_filename);
+  return true;
+}
+
+static bool bhead_index_is_loaded(const BHeadIndex *index)
+{
+  return !index->entries.is_empty();
+}
+
+static bool bhead_index_read_entries(BHeadIndex *index, FileReader *file)
+{
+  FILE *fp = BLI_fopen(index->cache_filepath, "rb");
+  if (fp == nullptr) {
+    return false;
+  }
+
+  BHeadIndexHeader header;
+  bool ok = fread(&header, sizeof(header), 1, fp) == 1;
+  /* Everything but the size of the block headers has to match the current file. */
+  ok = ok && (header.file_bhead_size == sizeof(BHead4) || header.file_bhead_size == sizeof(BHead8));
+  index->header.file_bhead_size = header.file_bhead_size;
+  index->header.entries_num = header.entries_num;
+  index->header.entries_hash = header.entries_hash;
+  ok = ok && memcmp(&header, &index->header, sizeof(header)) == 0;
+  ok = ok && header.entries_num > 0 && header.entries_num <= header.file_size / sizeof(BHead4);
+  if (ok) {
+    index->entries.resize(header.entries_num);
+    ok = fread(index->entries.data(), sizeof(BHeadIndexEntry), header.entries_num, fp) ==
+             size_t(header.entries_num) &&
+         XXH3_64bits(index->entries.data(), index->entries.as_span().size_in_bytes()) ==
+             header.entries_hash;
+  }
+  fclose(fp);
+
+  if (ok) {
+    /* Modification time and size can match for a different file in rare cases. Check that the
+     * last block is where the index expects it to be. */
+    const BHeadIndexEntry &endb = index->entries.last();
+    char code[4];
+    ok = endb.bhead.code == BLO_CODE_ENDB &&
+         file->seek(file, endb.file_offset - header.file_bhead_size, SEEK_SET) != -1 &&
+         file->read(file, code, sizeof(code)) == sizeof(code) && memcmp(code, "ENDB", 4) == 0;
+  }
+  file->seek(file, 0, SEEK_SET);
+
+  if (!ok) {
+    index->entries.clear_and_shrink();
+    return false;
+  }
+
+  /* Keep recently used indices when cleaning up the cache. */
+  BLI_file_touch(index->cache_filepath);
+  return true;
+}
+
+/**
+ * Modification time of the file in nanoseconds. A file that is saved again within the same second
+ * usually has a different time then, even when its size didn't change.
+ */
+static int64_t bhead_index_file_mtime(const BLI_stat_t &st)
+{
+#  if defined(WIN32)
+  /* Only whole seconds are available from #BLI_stat on Windows. */
+  return int64_t(st.st_mtime) * 1000000000;
+#  elif defined(__APPLE__)
+  return int64_t(st.st_mtimespec.tv_sec) * 1000000000 + int64_t(st.st_mtimespec.tv_nsec);
+#  else
+  return int64_t(st.st_mtim.tv_sec) * 1000000000 + int64_t(st.st_mtim.tv_nsec);
+#  endif
+}
+
+/**
+ * Create the index for a library file, reading its entries from the cache when they are valid.
+ * \return nullptr when the file can't use an index.
+ */
+static BHeadIndex *bhead_index_open(FileData *fd, const char *filepath)
+{
+  if (fd->file->seek == nullptr) {
+    /* Data can't be read on demand, no need for an index. */
+    return nullptr;
+  }
+
+  BLI_stat_t st;
+  char cache_filepath[FILE_MAX];
+  if (BLI_stat(filepath, &st) == -1 ||
+      !bhead_index_filepath_get(filepath, cache_filepath, sizeof(cache_filepath)))
+  {
+    return nullptr;
+  }
+
+  BHeadIndex *index = MEM_new<BHeadIndex>(__func__);
+  STRNCPY(index->cache_filepath, cache_filepath);
+  memset(&index->header, 0, sizeof(index->header));
+  memcpy(index->header.magic, BHEAD_INDEX_MAGIC, sizeof(index->header.magic));
+  if (fd->file->read(fd->file, index->header.file_header, SIZEOFBLENDERHEADER) !=
+          SIZEOFBLENDERHEADER ||
+      fd->file->seek(fd->file, 0, SEEK_SET) == -1)
+  {
+    MEM_delete(index);
+    return nullptr;
+  }
+  index->header.bhead_size = sizeof(BHead);
+  index->header.file_size = int64_t(st.st_size);
+  index->header.file_mtime = bhead_index_file_mtime(st);
+  STRNCPY(index->header.filepath, filepath);
+
+  bhead_index_read_entries(index, fd->file);
+  return index;
+}
+
+/**
+ * Remove the least recently used indices until the cache fits in #BHEAD_INDEX_CACHE_SIZE_MAX.
+ */
+static void bhead_index_cache_cleanup(const char *index_dir)
+{
+  direntry *entries;
+  const uint entries_num = BLI_filelist_dir_contents(index_dir, &entries);
+
+  blender::Vector<const direntry *> index_files;
+  int64_t size_total = 0;
+  const int64_t time_now = int64_t(time(nullptr));
+  for (const direntry &entry : blender::Span(entries, entries_num)) {
+    if (!S_ISREG(entry.s.st_mode)) {
+      continue;
+    }
+    if (BLI_path_extension_check(entry.relname, BHEAD_INDEX_EXTENSION)) {
+      index_files.append(&entry);
+      size_total += int64_t(entry.s.st_size);
+    }
+    else if (BLI_path_extension_check(entry.relname, ".tmp") &&
+             int64_t(entry.s.st_mtime) < time_now - 60 * 60)
+    {
+      /* Left behind by a process that didn't finish writing, others may still be writing. */
+      BLI_delete(entry.path, false, false);
+    }
+  }
+
+  if (size_total > BHEAD_INDEX_CACHE_SIZE_MAX) {
+    std::sort(index_files.begin(), index_files.end(), [](const direntry *a, const direntry *b) {
+      return a->s.st_mtime < b->s.st_mtime;
+    });
+    for (const direntry *entry : index_files) {
+      if (size_total <= BHEAD_INDEX_CACHE_SIZE_MAX) {
+        break;
+      }
+      BLI_delete(entry->path, false, false);
+      size_total -= int64_t(entry->s.st_size);
+    }
+  }
+
+  BLI_filelist_free(entries, entries_num);
+}
+
+/**
+ * Store the index when data was linked from the file and all its blocks have been listed.
+ */
+static void bhead_index_write(FileData *fd)
+{
+  BHeadIndex *index = fd->bhead_index;
+  const BHeadN *last = static_cast<const BHeadN *>(fd->bhead_list.last);
+  if (!index->use_write || bhead_index_is_loaded(index) || !(fd->flags & FD_FLAGS_FILE_OK) ||
+      last == nullptr || last->bhead.code != BLO_CODE_ENDB)
+  {
+    return;
+  }
+
+  index->header.file_bhead_size = (fd->flags & FD_FLAGS_FILE_POINTSIZE_IS_4) ? sizeof(BHead4) :
+                                                                               sizeof(BHead8);
+  blender::Vector<BHeadIndexEntry> entries;
+  LISTBASE_FOREACH (const BHeadN *, bheadn, &fd->bhead_list) {
+    BHeadIndexEntry entry;
+    /* Padding is hashed as well. */
+    memset(&entry, 0, sizeof(entry));
+    entry.file_offset = bheadn->file_offset;
+    entry.bhead = bheadn->bhead;
+    entries.append(entry);
+  }
+  index->header.entries_num = entries.size();
+  index->header.entries_hash = XXH3_64bits(entries.data(), entries.as_span().size_in_bytes());
+
+  if (!BLI_file_ensure_parent_dir_exists(index->cache_filepath)) {
+    return;
+  }
+  /* Other processes may write the index of the same file at the same time. Each writes its own
+   * temporary file, the last one to finish replaces the index. */
+  static std::atomic<uint32_t> tmp_file_counter = 0;
+  char tmp_filepath[FILE_MAX + 32];
+  SNPRINTF(tmp_filepath,
+           "%s.%d.%u.tmp",
+           index->cache_filepath,
+           int(getpid()),
+           uint(tmp_file_counter.fetch_add(1)));
+  FILE *fp = BLI_fopen(tmp_filepath, "wb");
+  if (fp == nullptr) {
+    return;
+  }
+  bool ok = fwrite(&index->header, sizeof(index->header), 1, fp) == 1 &&
+            fwrite(entries.data(), sizeof(BHeadIndexEntry), entries.size(), fp) ==
+                size_t(entries.size());
+  ok = (fclose(fp) == 0) && ok;
+
+  if (!ok || BLI_rename_overwrite(tmp_filepath, index->cache_filepath) != 0) {
+    BLI_delete(tmp_filepath, false, false);
+    return;
+  }
+
+  char index_dir[FILE_MAX];
+  BLI_path_split_dir_part(index->cache_filepath, index_dir, sizeof(index_dir));
+  bhead_index_cache_cleanup(index_dir);
+}
+
+/**
+ * Data is linked from the file, store its index when the file is closed.
+ */
+static void bhead_index_tag_use_write(FileData *fd)
+{
+  if (fd->bhead_index) {
+    fd->bhead_index->use_write = true;
+  }
+}
+
+static BHeadN *get_bhead_from_index(FileData *fd)
+{
+  BHeadIndex *index = fd->bhead_index;
+  if (index->next_entry == index->entries.size()) {
+    fd->is_eof = true;
+    return nullptr;
+  }
+  const BHeadIndexEntry &entry = index->entries[index->next_entry++];
+
+  BHeadN *new_bhead;
+  if (BHEAD_USE_READ_ON_DEMAND(&entry.bhead)) {
+    new_bhead = static_cast<BHeadN *>(MEM_mallocN(sizeof(BHeadN), "new_bhead"));
+    new_bhead->has_data = false;
+  }
+  else {
+    new_bhead = static_cast<BHeadN *>(
+        MEM_mallocN(sizeof(BHeadN) + size_t(entry.bhead.len), "new_bhead"));
+    new_bhead->has_data = true;
+    if (entry.bhead.len > 0 &&
+        (fd->file->seek(fd->file, entry.file_offset, SEEK_SET) == -1 ||
+         fd->file->read(fd->file, new_bhead + 1, size_t(entry.bhead.len)) != entry.bhead.len))
+    {
+      fd->is_eof = true;
+      MEM_freeN(new_bhead);
+      return nullptr;
+    }
+  }
+  new_bhead->next = new_bhead->prev = nullptr;
+  new_bhead->file_offset = entry.file_offset;
+  new_bhead->is_memchunk_identical = false;
+  new_bhead->bhead = entry.bhead;
+
+  BLI_addtail(&fd->bhead_list, new_bhead);
+  return new_bhead;
+}
+
+/** \} */
+
+#endif /* USE_BHEAD_INDEX_CACHE */
+
+void blo_bhead_index_dir_override_set(const char *dirpath)
+{
+#ifdef USE_BHEAD_INDEX_CACHE
+  STRNCPY(bhead_index_dir_override, dirpath ? dirpath : "");
+#else
+  UNUSED_VARS(dirpath);
+#endif
+}
+
+bool blo_bhead_index_filepath_get(const char *filepath,
+                                  char *r_index_filepath,
+                                  const size_t index_filepath_maxncpy)
+{
+#ifdef USE_BHEAD_INDEX_CACHE
+  return bhead_index_filepath_get(filepath, r_index_filepath, index_filepath_maxncpy);
+#else
+  UNUSED_VARS(filepath, r_index_filepath, index_filepath_maxncpy);
+  return false;
+#endif
+}
+
+bool blo_filedata_uses_bhead_index(const FileData *fd)
+{
+#ifdef USE_BHEAD_INDEX_CACHE
+  return fd->bhead_index && bhead_index_is_loaded(fd->bhead_index);
+#else
+  UNUSED_VARS(fd);
+  return false;
+#endif
+}
+
 static BHeadN *get_bhead(FileData *fd)
 {
   BHeadN *new_bhead = nullptr;
   int64_t readsize;
 
+#ifdef USE_BHEAD_INDEX_CACHE
+  if (fd && !fd->is_eof && fd->bhead_index && bhead_index_is_loaded(fd->bhead_index)) {
+    return get_bhead_from_index(fd);
+  }
+#endif
+
   if (fd) {
     if (!fd->is_eof) {
       /* initializing to zero isn't strictly needed but shuts valgrind up
@@ -787,7 +1199,7 @@ static BHeadN *get_bhead(FileData *fd)
         if (new_bhead) {
           new_bhead->next = new_bhead->prev = nullptr;
 #ifdef USE_BHEAD_READ_ON_DEMAND
-          new_bhead->file_offset = 0; /* don't seek. */
+          new_bhead->file_offset = fd->file->offset;
           new_bhead->has_data = true;
 #endif
           new_bhead->is_memchunk_identical = false;
@@ -882,6 +1294,11 @@ static bool blo_bhead_read_data(FileData *fd, BHead *thisblock, void *buf)
   bool success = true;
   BHeadN *new_bhead = BHEADN_FROM_BHEAD(thisblock);
   BLI_assert(new_bhead->has_data == false && new_bhead->file_offset != 0);
+  if (fd->file->read_at != nullptr) {
+    /* Reading at an absolute position leaves the file offset untouched, no need to seek. */
+    return fd->file->read_at(fd->file, buf, size_t(new_bhead->bhead.len), new_bhead->file_offset) ==
+           new_bhead->bhead.len;
+  }
   off64_t offset_backup = fd->file->offset;
   if (UNLIKELY(fd->file->seek(fd->file, new_bhead->file_offset, SEEK_SET) == -1)) {
     success = false;
@@ -1262,6 +1679,22 @@ FileData *blo_filedata_from_file(const char *filepath, BlendFileReadReport *repo
   return nullptr;
 }
 
+FileData *blo_filedata_from_library_file(const char *filepath, BlendFileReadReport *reports)
+{
+  FileData *fd = blo_filedata_from_file_open(filepath, reports);
+  if (fd != nullptr) {
+    /* needed for library_append and read_libraries */
+    STRNCPY(fd->relabase, filepath);
+
+#ifdef USE_BHEAD_INDEX_CACHE
+    fd->bhead_index = bhead_index_open(fd, filepath);
+#endif
+
+    return blo_decode_and_check(fd, reports->reports);
+  }
+  return nullptr;
+}
+
 /**
  * Same as blo_filedata_from_file(), but does not reads DNA data, only header.
  * Use it for light access (e.g. thumbnail reading).
@@ -1329,6 +1762,13 @@ FileData *blo_filedata_from_memfile(MemFile *memfile,
 
 void blo_filedata_free(FileData *fd)
 {
+#ifdef USE_BHEAD_INDEX_CACHE
+  if (fd->bhead_index) {
+    bhead_index_write(fd);
+    MEM_delete(fd->bhead_index);
+  }
+#endif
+
   /* Free all BHeadN data blocks */
 #ifdef NDEBUG
   BLI_freelistN(&fd->bhead_list);
@@ -1690,7 +2130,14 @@ static void switch_endian_structs(const SDNA *filesdna, BHead *bhead)
   }
 }
 
-static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
+/**
+ * Read and convert the data of \a bh to the current DNA.
+ *
+ * Unlike #read_struct this doesn't modify \a fd, failing to read the data is reported
+ * in \a r_read_error instead. When #read_struct_is_threadsafe is true, this can be called
+ * for different blocks from multiple threads at once.
+ */
+static void *read_struct_ex(FileData *fd, BHead *bh, const char *blockname, bool *r_read_error)
 {
   void *temp = nullptr;
 
@@ -1705,7 +2152,7 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
       if (BHEADN_FROM_BHEAD(bh)->has_data == false) {
         bh = blo_bhead_read_full(fd, bh);
         if (UNLIKELY(bh == nullptr)) {
-          fd->flags &= ~FD_FLAGS_FILE_OK;
+          *r_read_error = true;
           return nullptr;
         }
       }
@@ -1719,7 +2166,7 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
         if (BHEADN_FROM_BHEAD(bh)->has_data == false) {
           bh = blo_bhead_read_full(fd, bh);
           if (UNLIKELY(bh == nullptr)) {
-            fd->flags &= ~FD_FLAGS_FILE_OK;
+            *r_read_error = true;
             return nullptr;
           }
         }
@@ -1738,7 +2185,7 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
           /* Instead of allocating the bhead, then copying it,
            * read the data from the file directly into the memory. */
           if (UNLIKELY(!blo_bhead_read_data(fd, bh, temp))) {
-            fd->flags &= ~FD_FLAGS_FILE_OK;
+            *r_read_error = true;
             MEM_freeN(temp);
             temp = nullptr;
           }
@@ -1759,6 +2206,30 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
   return temp;
 }
 
+static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
+{
+  bool read_error = false;
+  void *temp = read_struct_ex(fd, bh, blockname, &read_error);
+  if (UNLIKELY(read_error)) {
+    fd->flags &= ~FD_FLAGS_FILE_OK;
+  }
+  return temp;
+}
+
+/**
+ * Whether #read_struct_ex can run for multiple blocks in parallel: either all data is already
+ * in memory, or delayed data can be read without going through the shared file offset.
+ */
+static bool read_struct_is_threadsafe(const FileData *fd)
+{
+#ifdef USE_BHEAD_READ_ON_DEMAND
+  return fd->file->seek == nullptr || fd->file->read_at != nullptr;
+#else
+  UNUSED_VARS(fd);
+  return true;
+#endif
+}
+
 /* Like read_struct, but gets a pointer without allocating. Only works for
  * undo since DNA must match. */
 static const void *peek_struct_undo(FileData *fd, BHead *bhead)
@@ -2384,35 +2855,74 @@ static bool direct_link_id(FileData *fd, Main *main, const int tag, ID *id, ID *
 /* Read all data associated with a datablock into datamap. */
 static BHead *read_data_into_datamap(FileData *fd, BHead *bhead, const char *allocname)
 {
-  bhead = blo_bhead_next(fd, bhead);
+  /* Converting the data blocks to the current DNA is independent per block, so for large
+   * data-blocks (e.g. high resolution meshes) it is done in parallel when the file allows it.
+   * Inserting into the map is kept in file order. */
+  blender::Vector<BHead *, 64> data_bheads;
+  int64_t data_len_total = 0;
 
+  bhead = blo_bhead_next(fd, bhead);
   while (bhead && bhead->code == BLO_CODE_DATA) {
+    data_bheads.append(bhead);
+    data_len_total += bhead->len;
+    bhead = blo_bhead_next(fd, bhead);
+  }
+
+  auto data_allocname = [&](const BHead *data_bhead) -> const char * {
     /* The code below is useful for debugging leaks in data read from the blend file.
      * Without this the messages only tell us what ID-type the memory came from,
      * eg: `Data from OB len 64`, see #dataname.
      * With the code below we get the struct-name to help tracking down the leak.
      * This is kept disabled as the #malloc for the text always leaks memory. */
 #if 0
-    if (bhead->SDNAnr == 0) {
+    if (data_bhead->SDNAnr == 0) {
       /* The data type here is unclear because #writedata sets SDNAnr to 0. */
-      allocname = "likely raw data";
+      return "likely raw data";
+    }
+    SDNA_Struct *sp = fd->filesdna->structs[data_bhead->SDNAnr];
+    const char *type_name = fd->filesdna->types[sp->type];
+    size_t allocname_size = strlen(type_name) + 1;
+    char *allocname_buf = static_cast<char *>(malloc(allocname_size));
+    memcpy(allocname_buf, type_name, allocname_size);
+    return allocname_buf;
+#else
+    UNUSED_VARS(data_bhead);
+    return allocname;
+#endif
+  };
+
+  blender::Array<void *, 64> data_blocks(data_bheads.size(), nullptr);
+  if (read_struct_is_threadsafe(fd)) {
+    std::atomic<bool> read_error = false;
+    blender::threading::parallel_for(
+        data_bheads.index_range(),
+        256 * 1024,
+        [&](const blender::IndexRange range) {
+          for (const int64_t i : range) {
+            bool block_read_error = false;
+            data_blocks[i] = read_struct_ex(
+                fd, data_bheads[i], data_allocname(data_bheads[i]), &block_read_error);
+            if (UNLIKELY(block_read_error)) {
+              read_error = true;
+            }
+          }
+        },
+        blender::threading::individual_task_sizes(
+            [&](const int64_t i) { return int64_t(data_bheads[i]->len); }, data_len_total));
+    if (read_error) {
+      fd->flags &= ~FD_FLAGS_FILE_OK;
     }
-    else {
-      SDNA_Struct *sp = fd->filesdna->structs[bhead->SDNAnr];
-      allocname = fd->filesdna->types[sp->type];
-      size_t allocname_size = strlen(allocname) + 1;
-      char *allocname_buf = static_cast<char *>(malloc(allocname_size));
-      memcpy(allocname_buf, allocname, allocname_size);
-      allocname = allocname_buf;
+  }
+  else {
+    for (const int64_t i : data_bheads.index_range()) {
+      data_blocks[i] = read_struct(fd, data_bheads[i], data_allocname(data_bheads[i]));
     }
-#endif
+  }
 
-    void *data = read_struct(fd, bhead, allocname);
-    if (data) {
-      oldnewmap_insert(fd->datamap, bhead->old, data, 0);
+  for (const int64_t i : data_bheads.index_range()) {
+    if (data_blocks[i]) {
+      oldnewmap_insert(fd->datamap, data_bheads[i]->old, data_blocks[i], 0);
     }
-
-    bhead = blo_bhead_next(fd, bhead);
   }
 
   return bhead;
@@ -4139,6 +4649,10 @@ static Main *library_link_begin(Main *mainvar,
 
   fd->id_tag_extra = id_tag_extra;
 
+#ifdef USE_BHEAD_INDEX_CACHE
+  bhead_index_tag_use_write(fd);
+#endif
+
   fd->mainlist = static_cast<ListBase *>(MEM_callocN(sizeof(ListBase), "FileData.mainlist"));
 
   /* make mains */
@@ -4554,7 +5068,12 @@ static FileData *read_library_file_data(FileData *basefd,
                      mainptr->curlib->runtime.filepath_abs,
                      mainptr->curlib->filepath,
                      library_parent_filepath(mainptr->curlib));
-    fd = blo_filedata_from_file(mainptr->curlib->runtime.filepath_abs, basefd->reports);
+    fd = blo_filedata_from_library_file(mainptr->curlib->runtime.filepath_abs, basefd->reports);
+#ifdef USE_BHEAD_INDEX_CACHE
+    if (fd) {
+      bhead_index_tag_use_write(fd);
+    }
+#endif
   }
 
   if (fd) {
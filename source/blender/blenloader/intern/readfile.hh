@@ -26,6 +26,7 @@ struct BlendFileData;
 struct BlendFileReadParams;
 struct BlendFileReadReport;
 struct BLOCacheStorage;
+struct BHeadIndex;
 struct BHeadSort;
 struct DNA_ReconstructInfo;
 struct IDNameLib_Map;
@@ -119,6 +120,9 @@ struct FileData {
   /** See: #USE_GHASH_BHEAD. */
   GHash *bhead_idname_hash;
 
+  /** Cached list of blocks of library files, see: #USE_BHEAD_INDEX_CACHE. */
+  BHeadIndex *bhead_index;
+
   ListBase *mainlist;
   /** Used for undo. */
   ListBase *old_mainlist;
@@ -154,6 +158,27 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath) ATTR_N
  * cannot be called with relative paths anymore!
  */
 FileData *blo_filedata_from_file(const char *filepath, BlendFileReadReport *reports);
+/**
+ * Same as #blo_filedata_from_file, for files that data is linked or appended from.
+ * These use a cached index of the blocks in the file, so that opening them again doesn't need
+ * to read the whole file.
+ */
+FileData *blo_filedata_from_library_file(const char *filepath, BlendFileReadReport *reports);
+/**
+ * Directory the block indices of library files are stored in, instead of the user cache
+ * directory. Null restores the default. Used by tests.
+ */
+void blo_bhead_index_dir_override_set(const char *dirpath);
+/**
+ * Path of the cached block index for the given library file.
+ */
+bool blo_bhead_index_filepath_get(const char *filepath,
+                                  char *r_index_filepath,
+                                  size_t index_filepath_maxncpy);
+/**
+ * Whether the blocks of the file were listed from a cached index instead of reading the file.
+ */
+bool blo_filedata_uses_bhead_index(const FileData *fd);
 FileData *blo_filedata_from_memory(const void *mem, int memsize, BlendFileReadReport *reports);
 FileData *blo_filedata_from_memfile(MemFile *memfile,
                                     const BlendFileReadParams *params,
@@ -26,6 +26,10 @@
 
 #include "BLI_blenlib.h"
 #include "BLI_implicit_sharing.hh"
+#include "BLI_map.hh"
+#include "BLI_set.hh"
+#include "BLI_task.h"
+#include "BLI_vector.hh"
 
 #include "BLO_readfile.hh"
 #include "BLO_undofile.hh"
@@ -34,16 +38,222 @@
 #include "BKE_main.hh"
 #include "BKE_undo_system.hh"
 
+#include <xxhash.h>
+#include <zstd.h>
+
 #include "BLI_strict_flags.h" /* Keep last. */
 
 /* **************** support for memory-write, for undo buffers *************** */
 
+/* -------------------------------------------------------------------- */
+/** \name Chunk Data Storage
+ *
+ * Chunk data is shared between all chunks with the same content, in all undo steps. This is
+ * similar to #BLI_array_store, but on the level of whole chunks: the content is found by its hash
+ * in a global map, so data that changes back to a previous state, or is stored again by another
+ * undo step after undoing, is still only stored once.
+ *
+ * Data that is not used by the most recent undo steps is compressed in a background task. All
+ * functions accessing chunk data stop that task first, so the data is never accessed from
+ * multiple threads at the same time.
+ * \{ */
+
+struct MemFileChunkData {
+  /** Raw content, or compressed content when #compressed_size is not zero. */
+  void *buf;
+  size_t size;
+  size_t compressed_size;
+  uint64_t hash;
+  /** Number of chunks using this data. */
+  int users;
+  /** Compression was tried already, but did not save enough memory. */
+  bool skip_compress;
+  /** Value of #MemFileChunkStore::write_count when the data was last used by a written step. */
+  uint64_t last_write;
+};
+
+struct MemFileChunkStore {
+  /** Chunk data by the hash of its content. Data with colliding hashes is not in the map. */
+  blender::Map<uint64_t, MemFileChunkData *> data_by_hash;
+  /** Number of started memfile writes. */
+  uint64_t write_count = 0;
+  /** Background compression of chunk data that is no longer used by recent steps. */
+  TaskPool *compress_pool = nullptr;
+};
+
+static MemFileChunkStore chunk_store;
+
+/** Data last used by one of this many most recent steps is not compressed. */
+#define MEMFILE_COMPRESS_KEEP_STEPS 2
+/** Compressing smaller chunks is not worth the overhead. */
+#define MEMFILE_COMPRESS_MIN_SIZE 1024
+#define MEMFILE_COMPRESS_LEVEL 1
+
+static void memfile_compress_cancel()
+{
+  if (chunk_store.compress_pool == nullptr) {
+    return;
+  }
+  BLI_task_pool_cancel(chunk_store.compress_pool);
+  BLI_task_pool_free(chunk_store.compress_pool);
+  chunk_store.compress_pool = nullptr;
+}
+
+void BLO_memfile_compress_wait()
+{
+  if (chunk_store.compress_pool == nullptr) {
+    return;
+  }
+  BLI_task_pool_work_and_wait(chunk_store.compress_pool);
+  BLI_task_pool_free(chunk_store.compress_pool);
+  chunk_store.compress_pool = nullptr;
+}
+
+bool BLO_memfile_chunk_is_compressed(const MemFileChunk *chunk)
+{
+  memfile_compress_cancel();
+  return chunk->data->compressed_size != 0;
+}
+
+static void memfile_compress_task(TaskPool *__restrict pool, void *taskdata)
+{
+  blender::Vector<MemFileChunkData *> &chunk_datas =
+      *static_cast<blender::Vector<MemFileChunkData *> *>(taskdata);
+
+  for (MemFileChunkData *chunk_data : chunk_datas) {
+    if (BLI_task_pool_current_canceled(pool)) {
+      break;
+    }
+    const size_t bound_size = ZSTD_compressBound(chunk_data->size);
+    void *compressed_buf = MEM_mallocN(bound_size, __func__);
+    const size_t compressed_size = ZSTD_compress(
+        compressed_buf, bound_size, chunk_data->buf, chunk_data->size, MEMFILE_COMPRESS_LEVEL);
+    /* Keep the raw data when compression fails or barely saves memory. */
+    if (ZSTD_isError(compressed_size) || compressed_size > chunk_data->size - chunk_data->size / 8)
+    {
+      MEM_freeN(compressed_buf);
+      chunk_data->skip_compress = true;
+      continue;
+    }
+    MEM_freeN(chunk_data->buf);
+    chunk_data->buf = MEM_reallocN(compressed_buf, compressed_size);
+    chunk_data->compressed_size = compressed_size;
+  }
+}
+
+static void memfile_compress_task_free(TaskPool * /*pool*/, void *taskdata)
+{
+  MEM_delete(static_cast<blender::Vector<MemFileChunkData *> *>(taskdata));
+}
+
+static void memfile_compress_begin()
+{
+  BLI_assert(chunk_store.compress_pool == nullptr);
+
+  blender::Vector<MemFileChunkData *> *chunk_datas =
+      MEM_new<blender::Vector<MemFileChunkData *>>(__func__);
+  for (MemFileChunkData *chunk_data : chunk_store.data_by_hash.values()) {
+    if (chunk_data->compressed_size == 0 && !chunk_data->skip_compress &&
+        chunk_data->size >= MEMFILE_COMPRESS_MIN_SIZE &&
+        chunk_data->last_write + MEMFILE_COMPRESS_KEEP_STEPS <= chunk_store.write_count)
+    {
+      chunk_datas->append(chunk_data);
+    }
+  }
+  if (chunk_datas->is_empty()) {
+    MEM_delete(chunk_datas);
+    return;
+  }
+
+  chunk_store.compress_pool = BLI_task_pool_create_background(nullptr, TASK_PRIORITY_LOW);
+  BLI_task_pool_push(chunk_store.compress_pool,
+                     memfile_compress_task,
+                     chunk_datas,
+                     true,
+                     memfile_compress_task_free);
+}
+
+static bool memfile_chunk_data_decompress(const MemFileChunkData *chunk_data, void *r_buf)
+{
+  const size_t size = ZSTD_decompress(
+      r_buf, chunk_data->size, chunk_data->buf, chunk_data->compressed_size);
+  return !ZSTD_isError(size) && size == chunk_data->size;
+}
+
+/** Make the data uncompressed again, when it is used by a new undo step. */
+static void memfile_chunk_data_ensure_raw(MemFileChunkData *chunk_data)
+{
+  if (chunk_data->compressed_size == 0) {
+    return;
+  }
+  void *buf = MEM_mallocN(chunk_data->size, "Chunk buffer");
+  if (!memfile_chunk_data_decompress(chunk_data, buf)) {
+    BLI_assert_unreachable();
+    memset(buf, 0, chunk_data->size);
+  }
+  MEM_freeN(chunk_data->buf);
+  chunk_data->buf = buf;
+  chunk_data->compressed_size = 0;
+}
+
+/** Use existing chunk data if it has the given content. */
+static bool memfile_chunk_data_try_share(MemFileChunkData *chunk_data,
+                                         const char *buf,
+                                         const size_t size,
+                                         const uint64_t hash)
+{
+  if (chunk_data->size != size || chunk_data->hash != hash) {
+    return false;
+  }
+  memfile_chunk_data_ensure_raw(chunk_data);
+  if (memcmp(chunk_data->buf, buf, size) != 0) {
+    return false;
+  }
+  chunk_data->users++;
+  chunk_data->last_write = chunk_store.write_count;
+  return true;
+}
+
+static MemFileChunkData *memfile_chunk_data_new(const char *buf,
+                                                const size_t size,
+                                                const uint64_t hash)
+{
+  MemFileChunkData *chunk_data = MEM_cnew<MemFileChunkData>(__func__);
+  chunk_data->buf = MEM_mallocN(size, "Chunk buffer");
+  memcpy(chunk_data->buf, buf, size);
+  chunk_data->size = size;
+  chunk_data->hash = hash;
+  chunk_data->users = 1;
+  chunk_data->last_write = chunk_store.write_count;
+  /* On hash collisions the existing data stays in the map, and the new data is not shared. */
+  chunk_store.data_by_hash.add(hash, chunk_data);
+  return chunk_data;
+}
+
+static void memfile_chunk_data_free(MemFileChunkData *chunk_data)
+{
+  BLI_assert(chunk_data->users > 0);
+  if (--chunk_data->users > 0) {
+    return;
+  }
+  if (chunk_store.data_by_hash.lookup_default(chunk_data->hash, nullptr) == chunk_data) {
+    chunk_store.data_by_hash.remove(chunk_data->hash);
+    if (chunk_store.data_by_hash.is_empty()) {
+      chunk_store.data_by_hash.clear_and_shrink();
+    }
+  }
+  MEM_freeN(chunk_data->buf);
+  MEM_freeN(chunk_data);
+}
+
+/** \} */
+
 void BLO_memfile_free(MemFile *memfile)
 {
+  memfile_compress_cancel();
+
   while (MemFileChunk *chunk = static_cast<MemFileChunk *>(BLI_pophead(&memfile->chunks))) {
-    if (chunk->is_identical == false) {
-      MEM_freeN((void *)chunk->buf);
-    }
+    memfile_chunk_data_free(chunk->data);
     MEM_freeN(chunk);
   }
   MEM_delete(memfile->shared_storage);
@@ -61,29 +271,18 @@ MemFileSharedStorage::~MemFileSharedStorage()
 
 void BLO_memfile_merge(MemFile *first, MemFile *second)
 {
-  /* We use this mapping to store the memory buffers from second memfile chunks which are not owned
-   * by it (i.e. shared with some previous memory steps). */
-  blender::Map<const char *, MemFileChunk *> buffer_to_second_memchunk;
-
-  /* First, detect all memchunks in second memfile that are not owned by it. */
-  LISTBASE_FOREACH (MemFileChunk *, sc, &second->chunks) {
-    if (sc->is_identical) {
-      buffer_to_second_memchunk.add(sc->buf, sc);
-    }
-  }
-
-  /* Now, check all chunks from first memfile (the one we are removing), and if a memchunk owned by
-   * it is also used by the second memfile, transfer the ownership. */
+  /* Chunk data is reference counted, so the data shared with the second memfile is kept alive by
+   * its chunks. Chunks of the second memfile that were identical to data first stored in the
+   * first memfile are not identical to a previous step anymore. */
+  blender::Set<const MemFileChunkData *> first_stored_data;
   LISTBASE_FOREACH (MemFileChunk *, fc, &first->chunks) {
     if (!fc->is_identical) {
-      if (MemFileChunk *sc = buffer_to_second_memchunk.lookup_default(fc->buf, nullptr)) {
-        BLI_assert(sc->is_identical);
-        sc->is_identical = false;
-        fc->is_identical = true;
-      }
-      /* Note that if the second memfile does not use that chunk, we assume that the first one
-       * fully owns it without sharing it with any other memfile, and hence it should be freed with
-       * it. */
+      first_stored_data.add(fc->data);
+    }
+  }
+  LISTBASE_FOREACH (MemFileChunk *, sc, &second->chunks) {
+    if (sc->is_identical && first_stored_data.contains(sc->data)) {
+      sc->is_identical = false;
     }
   }
 
@@ -101,6 +300,9 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
                             MemFile *written_memfile,
                             MemFile *reference_memfile)
 {
+  memfile_compress_cancel();
+  chunk_store.write_count++;
+
   mem_data->written_memfile = written_memfile;
   mem_data->reference_memfile = reference_memfile;
   mem_data->reference_current_chunk = reference_memfile ? static_cast<MemFileChunk *>(
@@ -126,6 +328,9 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
 void BLO_memfile_write_finalize(MemFileWriteData *mem_data)
 {
   mem_data->id_session_uid_mapping.clear_and_shrink();
+
+  /* Older steps are not used until the next undo or undo push, compress them meanwhile. */
+  memfile_compress_begin();
 }
 
 void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t size)
@@ -136,7 +341,7 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
   MemFileChunk *curchunk = static_cast<MemFileChunk *>(
       MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk"));
   curchunk->size = size;
-  curchunk->buf = nullptr;
+  curchunk->data = nullptr;
   curchunk->is_identical = false;
   /* This is unsafe in the sense that an app handler or other code that does not
    * perform an undo push may make changes after the last undo push that
@@ -145,24 +350,30 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
   curchunk->id_session_uid = mem_data->current_id_session_uid;
   BLI_addtail(&memfile->chunks, curchunk);
 
+  const uint64_t hash = XXH3_64bits(buf, size);
+
   /* we compare compchunk with buf */
   if (*compchunk_step != nullptr) {
     MemFileChunk *compchunk = *compchunk_step;
-    if (compchunk->size == curchunk->size) {
-      if (memcmp(compchunk->buf, buf, size) == 0) {
-        curchunk->buf = compchunk->buf;
-        curchunk->is_identical = true;
-        compchunk->is_identical_future = true;
-      }
+    if (memfile_chunk_data_try_share(compchunk->data, buf, size, hash)) {
+      curchunk->data = compchunk->data;
+      curchunk->is_identical = true;
+      compchunk->is_identical_future = true;
     }
     *compchunk_step = static_cast<MemFileChunk *>(compchunk->next);
   }
 
+  /* not equal to the previous step, but possibly to data from another step... */
+  if (curchunk->data == nullptr) {
+    MemFileChunkData *chunk_data = chunk_store.data_by_hash.lookup_default(hash, nullptr);
+    if (chunk_data && memfile_chunk_data_try_share(chunk_data, buf, size, hash)) {
+      curchunk->data = chunk_data;
+    }
+  }
+
   /* not equal... */
-  if (curchunk->buf == nullptr) {
-    char *buf_new = static_cast<char *>(MEM_mallocN(size, "Chunk buffer"));
-    memcpy(buf_new, buf, size);
-    curchunk->buf = buf_new;
+  if (curchunk->data == nullptr) {
+    curchunk->data = memfile_chunk_data_new(buf, size, hash);
     memfile->size += size;
   }
 }
@@ -186,6 +397,25 @@ Main *BLO_memfile_main_get(MemFile *memfile, Main *bmain, Scene **r_scene)
   return bmain_undo;
 }
 
+/** Get the raw content of a chunk, decompressing it on demand. */
+static const char *undo_chunk_buf(UndoReader *undo, const MemFileChunk *chunk)
+{
+  const MemFileChunkData *chunk_data = chunk->data;
+  if (chunk_data->compressed_size == 0) {
+    return static_cast<const char *>(chunk_data->buf);
+  }
+  if (undo->decompressed_data != chunk_data) {
+    MEM_SAFE_FREE(undo->decompressed_buf);
+    undo->decompressed_buf = static_cast<char *>(MEM_mallocN(chunk_data->size, __func__));
+    undo->decompressed_data = chunk_data;
+    if (!memfile_chunk_data_decompress(chunk_data, undo->decompressed_buf)) {
+      BLI_assert_unreachable();
+      memset(undo->decompressed_buf, 0, chunk_data->size);
+    }
+  }
+  return undo->decompressed_buf;
+}
+
 static int64_t undo_read(FileReader *reader, void *buffer, size_t size)
 {
   UndoReader *undo = (UndoReader *)reader;
@@ -242,7 +472,7 @@ static int64_t undo_read(FileReader *reader, void *buffer, size_t size)
         readsize = chunk->size - chunkoffset;
       }
 
-      memcpy(POINTER_OFFSET(buffer, totread), chunk->buf + chunkoffset, readsize);
+      memcpy(POINTER_OFFSET(buffer, totread), undo_chunk_buf(undo, chunk) + chunkoffset, readsize);
       totread += readsize;
       undo->reader.offset += (off64_t)readsize;
       seek += readsize;
@@ -263,11 +493,15 @@ static int64_t undo_read(FileReader *reader, void *buffer, size_t size)
 
 static void undo_close(FileReader *reader)
 {
+  UndoReader *undo = (UndoReader *)reader;
+  MEM_SAFE_FREE(undo->decompressed_buf);
   MEM_freeN(reader);
 }
 
 FileReader *BLO_memfile_new_filereader(MemFile *memfile, int undo_direction)
 {
+  memfile_compress_cancel();
+
   UndoReader *undo = static_cast<UndoReader *>(MEM_callocN(sizeof(UndoReader), __func__));
 
   undo->memfile = memfile;
@@ -87,6 +87,7 @@
 #include "DNA_key_types.h"
 #include "DNA_sdna_types.h"
 
+#include "BLI_array.hh"
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
 #include "BLI_endian_defines.h"
@@ -96,7 +97,9 @@
 #include "BLI_linklist.h"
 #include "BLI_math_base.h"
 #include "BLI_mempool.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
+#include "BLI_vector.hh"
 
 #include "MEM_guardedalloc.h" /* MEM_freeN */
 
@@ -396,6 +399,20 @@ bool ZstdWriteWrap::write(const void *buf, size_t buf_len)
 /** \name Write Data Type & Functions
  * \{ */
 
+/**
+ * Data written for a single ID when serializing IDs in parallel,
+ * see #IDTYPE_FLAGS_THREADSAFE_BLEND_WRITE.
+ */
+struct WriteIDCapture {
+  /** Data of all #mywrite calls, one after the other. */
+  blender::Vector<uchar, 0> data;
+  /**
+   * Length of each #mywrite call. Replaying the same calls keeps the buffering (and with it the
+   * compressed frames and undo chunks) exactly the same as when writing the ID directly.
+   */
+  blender::Vector<size_t> write_lens;
+};
+
 struct WriteData {
   const SDNA *sdna;
 
@@ -430,6 +447,9 @@ struct WriteData {
    * Will be nullptr for UNDO.
    */
   WriteWrap *ww;
+
+  /** When set, #mywrite stores the data here instead of writing it (see #WriteIDCapture). */
+  WriteIDCapture *id_capture = nullptr;
 };
 
 struct BlendWriter {
@@ -459,6 +479,17 @@ static WriteData *writedata_new(WriteWrap *ww)
   return wd;
 }
 
+static WriteData *writedata_new_for_id_capture(WriteIDCapture *id_capture)
+{
+  WriteData *wd = MEM_new<WriteData>(__func__);
+
+  wd->sdna = DNA_sdna_current_get();
+
+  wd->id_capture = id_capture;
+
+  return wd;
+}
+
 static void writedata_do_write(WriteData *wd, const void *mem, size_t memlen)
 {
   if ((wd == nullptr) || wd->error || (mem == nullptr) || memlen < 1) {
@@ -527,6 +558,12 @@ static void mywrite(WriteData *wd, const void *adr, size_t len)
     return;
   }
 
+  if (wd->id_capture != nullptr) {
+    wd->id_capture->data.extend(blender::Span(static_cast<const uchar *>(adr), int64_t(len)));
+    wd->id_capture->write_lens.append(len);
+    return;
+  }
+
 #ifdef USE_WRITE_DATA_LEN
   wd->write_len += len;
 #endif
@@ -565,6 +602,18 @@ static void mywrite(WriteData *wd, const void *adr, size_t len)
   }
 }
 
+/**
+ * Write data of an ID serialized on its own, see #WriteIDCapture.
+ */
+static void mywrite_id_capture(WriteData *wd, const WriteIDCapture &id_capture)
+{
+  const uchar *data = id_capture.data.data();
+  for (const size_t len : id_capture.write_lens) {
+    mywrite(wd, data, len);
+    data += len;
+  }
+}
+
 /**
  * BeGiN initializer for mywrite
  * \param ww: File write wrapper.
@@ -1212,6 +1261,39 @@ static int write_id_direct_linked_data_process_cb(LibraryIDLinkCallbackData *cb_
   return IDWALK_RET_NOP;
 }
 
+/**
+ * Serialize IDs of the given type in parallel, then write them in the given order.
+ * The result is identical to writing them one after the other.
+ */
+static void write_ids_parallel(WriteData *wd,
+                               const IDTypeInfo *id_type,
+                               const blender::Span<ID *> ids)
+{
+  using namespace blender;
+  BLI_assert(!wd->use_memfile);
+  BLI_assert(id_type->flags & IDTYPE_FLAGS_THREADSAFE_BLEND_WRITE);
+
+  Array<WriteIDCapture> id_captures(ids.size());
+  threading::parallel_for(ids.index_range(), 1, [&](const IndexRange range) {
+    BLO_Write_IDBuffer *id_buffer = BLO_write_allocate_id_buffer();
+    id_buffer_init_for_id_type(id_buffer, id_type);
+    for (const int64_t i : range) {
+      WriteData *id_wd = writedata_new_for_id_capture(&id_captures[i]);
+      BlendWriter id_writer = {id_wd};
+      id_buffer_init_from_id(id_buffer, ids[i], false);
+      id_type->blend_write(&id_writer, id_buffer->temp_id, ids[i]);
+      writedata_free(id_wd);
+    }
+    BLO_write_destroy_id_buffer(&id_buffer);
+  });
+
+  for (const int64_t i : ids.index_range()) {
+    mywrite_id_capture(wd, id_captures[i]);
+    /* Free the data early, it can be large. */
+    id_captures[i] = {};
+  }
+}
+
 /**
  * When #MemFile arguments are non-null, this is a file-safe to memory.
  *
@@ -1311,6 +1393,14 @@ static bool write_file_handle(Main *mainvar,
       const IDTypeInfo *id_type = BKE_idtype_get_info_from_id(id);
       id_buffer_init_for_id_type(id_buffer, id_type);
 
+      /* Serialize IDs in parallel when their type allows it, in batches to limit the memory used
+       * by the intermediate data. */
+      const bool use_threads = !wd->use_memfile && id_type->blend_write != nullptr &&
+                               (id_type->flags & IDTYPE_FLAGS_THREADSAFE_BLEND_WRITE) &&
+                               BLI_system_thread_count() > 1;
+      const int64_t id_batch_size = int64_t(BLI_system_thread_count()) * 2;
+      blender::Vector<ID *> id_batch;
+
       for (; id; id = static_cast<ID *>(id->next)) {
         /* We should never attempt to write non-regular IDs
          * (i.e. all kind of temp/runtime ones). */
@@ -1363,6 +1453,20 @@ static bool write_file_handle(Main *mainvar,
                                       IDWALK_READONLY | IDWALK_INCLUDE_UI);
         }
 
+        if (use_threads) {
+          if (!do_override) {
+            id_batch.append(id);
+            if (id_batch.size() >= id_batch_size) {
+              write_ids_parallel(wd, id_type, id_batch);
+              id_batch.clear();
+            }
+            continue;
+          }
+          /* Keep the order of IDs, overrides are written directly below. */
+          write_ids_parallel(wd, id_type, id_batch);
+          id_batch.clear();
+        }
+
         if (do_override) {
           BKE_lib_override_library_operations_store_start(bmain, override_storage, id);
         }
@@ -1382,6 +1486,10 @@ static bool write_file_handle(Main *mainvar,
         mywrite_id_end(wd, id);
       }
 
+      if (!id_batch.is_empty()) {
+        write_ids_parallel(wd, id_type, id_batch);
+      }
+
       mywrite_flush(wd);
     }
   } while ((bmain != override_storage) && (bmain = override_storage));
@@ -0,0 +1,227 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+#include "blendfile_loading_base_test.h"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+
+#include "BKE_lib_id.hh"
+#include "BKE_main.hh"
+
+#include "BLI_fileops.h"
+#include "BLI_fileops_types.h"
+#include "BLI_linklist.h"
+#include "BLI_path_util.h"
+#include "BLI_system.h"
+#include "BLI_tempfile.h"
+
+#include "BLO_readfile.hh"
+#include "BLO_writefile.hh"
+
+#include "DNA_ID.h"
+
+#include "intern/readfile.hh"
+
+#include BLI_SYSTEM_PID_H
+
+class BlendfileBHeadIndexTest : public BlendfileLoadingBaseTest {
+ public:
+  std::string temp_dir;
+
+  void SetUp() override
+  {
+    BlendfileLoadingBaseTest::SetUp();
+
+    char temp_dir_c[FILE_MAX];
+    BLI_temp_directory_path_get(temp_dir_c, sizeof(temp_dir_c));
+    temp_dir = std::string(temp_dir_c) + SEP_STR + "blender_bhead_index_test_" +
+               std::to_string(getpid());
+    BLI_dir_create_recursive(temp_dir.c_str());
+    /* Don't touch the user cache directory. */
+    blo_bhead_index_dir_override_set((temp_dir + SEP_STR + "index").c_str());
+  }
+
+  void TearDown() override
+  {
+    blo_bhead_index_dir_override_set(nullptr);
+    BLI_delete(temp_dir.c_str(), true, true);
+
+    BlendfileLoadingBaseTest::TearDown();
+  }
+
+  /** Write a library file with the given number of meshes, named "Mesh0", "Mesh1", etc. */
+  std::string write_library(const char *filename, const int meshes_num)
+  {
+    const std::string filepath = temp_dir + SEP_STR + filename;
+    Main *bmain = BKE_main_new();
+    for (int i = 0; i < meshes_num; i++) {
+      ID *mesh = static_cast<ID *>(BKE_id_new(bmain, ID_ME, ("Mesh" + std::to_string(i)).c_str()));
+      id_fake_user_set(mesh);
+    }
+    BlendFileWriteParams params{};
+    EXPECT_TRUE(BLO_write_file(bmain, filepath.c_str(), 0, &params, nullptr));
+    BKE_main_free(bmain);
+    return filepath;
+  }
+
+  /** Temporary files left in the index directory. */
+  int tmp_files_num()
+  {
+    direntry *entries;
+    const std::string index_dir = temp_dir + SEP_STR + "index";
+    const uint entries_num = BLI_filelist_dir_contents(index_dir.c_str(), &entries);
+    int num = 0;
+    for (const uint i : blender::IndexRange(entries_num)) {
+      num += BLI_path_extension_check(entries[i].relname, ".tmp");
+    }
+    BLI_filelist_free(entries, entries_num);
+    return num;
+  }
+
+  std::string index_filepath(const std::string &filepath)
+  {
+    char index_filepath[FILE_MAX];
+    EXPECT_TRUE(blo_bhead_index_filepath_get(
+        filepath.c_str(), index_filepath, sizeof(index_filepath)));
+    return index_filepath;
+  }
+
+  /**
+   * List the meshes of the library and link the first one, like linking from the file browser.
+   * \return The number of meshes in the library.
+   */
+  int link_from_library(const std::string &filepath, bool *r_uses_index)
+  {
+    BlendFileReadReport reports{};
+    BlendHandle *bh = BLO_blendhandle_from_file(filepath.c_str(), &reports);
+    if (bh == nullptr) {
+      ADD_FAILURE() << "Unable to open library '" << filepath << "'";
+      return 0;
+    }
+    *r_uses_index = blo_filedata_uses_bhead_index(reinterpret_cast<FileData *>(bh));
+
+    int names_num = 0;
+    LinkNode *names = BLO_blendhandle_get_datablock_names(bh, ID_ME, false, &names_num);
+    BLI_linklist_freeN(names);
+
+    Main *bmain = BKE_main_new();
+    LibraryLink_Params params;
+    BLO_library_link_params_init(&params, bmain, 0, 0);
+    Main *mainl = BLO_library_link_begin(&bh, filepath.c_str(), &params);
+    EXPECT_NE(BLO_library_link_named_part(mainl, &bh, ID_ME, "Mesh0", &params), nullptr);
+    BLO_library_link_end(mainl, &bh, &params);
+    BLO_blendhandle_close(bh);
+
+    EXPECT_EQ(BLI_listbase_count(&bmain->meshes), 1);
+    BKE_main_free(bmain);
+    return names_num;
+  }
+};
+
+TEST_F(BlendfileBHeadIndexTest, ListingDoesNotWriteIndex)
+{
+  const std::string filepath = write_library("library.blend", 3);
+
+  BlendFileReadReport reports{};
+  BlendHandle *bh = BLO_blendhandle_from_file(filepath.c_str(), &reports);
+  ASSERT_NE(bh, nullptr);
+  int names_num = 0;
+  LinkNode *names = BLO_blendhandle_get_datablock_names(bh, ID_ME, false, &names_num);
+  BLI_linklist_freeN(names);
+  BLO_blendhandle_close(bh);
+
+  EXPECT_EQ(names_num, 3);
+  EXPECT_FALSE(BLI_exists(index_filepath(filepath).c_str()));
+}
+
+TEST_F(BlendfileBHeadIndexTest, Hit)
+{
+  const std::string filepath = write_library("library.blend", 3);
+
+  bool uses_index = true;
+  EXPECT_EQ(link_from_library(filepath, &uses_index), 3);
+  EXPECT_FALSE(uses_index);
+  EXPECT_TRUE(BLI_exists(index_filepath(filepath).c_str()));
+  EXPECT_EQ(tmp_files_num(), 0);
+
+  EXPECT_EQ(link_from_library(filepath, &uses_index), 3);
+  EXPECT_TRUE(uses_index);
+}
+
+TEST_F(BlendfileBHeadIndexTest, Stale)
+{
+  const std::string filepath = write_library("library.blend", 3);
+  bool uses_index = false;
+  link_from_library(filepath, &uses_index);
+
+  /* The library changed since the index was written. */
+  write_library("library.blend", 5);
+  EXPECT_EQ(link_from_library(filepath, &uses_index), 5);
+  EXPECT_FALSE(uses_index);
+
+  /* The index is updated for the new file. */
+  EXPECT_EQ(link_from_library(filepath, &uses_index), 5);
+  EXPECT_TRUE(uses_index);
+}
+
+TEST_F(BlendfileBHeadIndexTest, Collision)
+{
+  const std::string filepath_a = write_library("library_a.blend", 3);
+  const std::string filepath_b = write_library("library_b.blend", 3);
+  bool uses_index = false;
+  link_from_library(filepath_a, &uses_index);
+
+  /* Simulate a collision of the path hashes, by putting the index of one file where the index of
+   * the other is expected. Both files have the same size, so only the stored path differs. */
+  const std::string index_b = index_filepath(filepath_b);
+  ASSERT_EQ(BLI_copy(index_filepath(filepath_a).c_str(), index_b.c_str()), 0);
+  EXPECT_EQ(link_from_library(filepath_b, &uses_index), 3);
+  EXPECT_FALSE(uses_index);
+}
+
+#ifndef WIN32
+TEST_F(BlendfileBHeadIndexTest, StaleWithinSecond)
+{
+  namespace fs = std::filesystem;
+  const std::string filepath = write_library("library.blend", 3);
+  const int64_t size = BLI_file_size(filepath.c_str());
+  const fs::file_time_type second = std::chrono::floor<std::chrono::seconds>(
+      fs::last_write_time(filepath));
+  fs::last_write_time(filepath, second + std::chrono::nanoseconds(100));
+  bool uses_index = false;
+  link_from_library(filepath, &uses_index);
+
+  /* Saved again within the same second, with the same size. */
+  write_library("library.blend", 3);
+  ASSERT_EQ(BLI_file_size(filepath.c_str()), size);
+  fs::last_write_time(filepath, second + std::chrono::nanoseconds(200));
+  EXPECT_EQ(link_from_library(filepath, &uses_index), 3);
+  EXPECT_FALSE(uses_index);
+}
+#endif
+
+TEST_F(BlendfileBHeadIndexTest, CorruptEntries)
+{
+  const std::string filepath = write_library("library.blend", 3);
+  bool uses_index = false;
+  link_from_library(filepath, &uses_index);
+
+  /* Change the file offset or header of one of the last blocks, which can't be detected by
+   * checking the end block. */
+  const std::string index = index_filepath(filepath);
+  FILE *fp = BLI_fopen(index.c_str(), "rb+");
+  ASSERT_NE(fp, nullptr);
+  ASSERT_EQ(fseek(fp, -60, SEEK_END), 0);
+  const int byte = fgetc(fp);
+  ASSERT_EQ(fseek(fp, -60, SEEK_END), 0);
+  fputc(byte ^ 0x10, fp);
+  fclose(fp);
+
+  EXPECT_EQ(link_from_library(filepath, &uses_index), 3);
+  EXPECT_FALSE(uses_index);
+  /* The index is written again. */
+  EXPECT_EQ(link_from_library(filepath, &uses_index), 3);
+  EXPECT_TRUE(uses_index);
+}
@@ -0,0 +1,104 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+#include "blendfile_loading_base_test.h"
+
+#include <string>
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_global.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_main.hh"
+
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_system.h"
+#include "BLI_tempfile.h"
+#include "BLI_threads.h"
+
+#include "BLO_readfile.hh"
+#include "BLO_writefile.hh"
+
+#include BLI_SYSTEM_PID_H
+
+class BlendfileWriteTest : public BlendfileLoadingBaseTest {
+ public:
+  std::string temp_dir;
+
+  void SetUp() override
+  {
+    BlendfileLoadingBaseTest::SetUp();
+
+    char temp_dir_c[FILE_MAX];
+    BLI_temp_directory_path_get(temp_dir_c, sizeof(temp_dir_c));
+    temp_dir = std::string(temp_dir_c) + SEP_STR + "blender_blendfile_write_test_" +
+               std::to_string(getpid());
+    BLI_dir_create_recursive(temp_dir.c_str());
+  }
+
+  void TearDown() override
+  {
+    BLI_delete(temp_dir.c_str(), true, true);
+    BLI_system_num_threads_override_set(0);
+
+    BlendfileLoadingBaseTest::TearDown();
+  }
+
+  /** Write the loaded file with the given number of threads and return its content. */
+  std::string write_file(const char *filename, const int num_threads, const int write_flags)
+  {
+    const std::string filepath = temp_dir + SEP_STR + filename;
+    BlendFileWriteParams params{};
+    BLI_system_num_threads_override_set(num_threads);
+    const bool success = BLO_write_file(
+        bfile->main, filepath.c_str(), write_flags, &params, nullptr);
+    BLI_system_num_threads_override_set(0);
+    if (!success) {
+      ADD_FAILURE() << "Unable to write file '" << filepath << "'";
+      return {};
+    }
+
+    size_t size = 0;
+    void *data = BLI_file_read_binary_as_mem(filepath.c_str(), 0, &size);
+    if (data == nullptr) {
+      ADD_FAILURE() << "Unable to read file '" << filepath << "'";
+      return {};
+    }
+    std::string content(static_cast<const char *>(data), size);
+    MEM_freeN(data);
+    return content;
+  }
+
+  void add_mesh_copies(const int num)
+  {
+    const ID *mesh = static_cast<const ID *>(bfile->main->meshes.first);
+    ASSERT_NE(mesh, nullptr);
+    for (int i = 0; i < num; i++) {
+      BKE_id_copy(bfile->main, mesh);
+    }
+  }
+};
+
+/* Meshes are serialized in parallel when more than one thread is used, the written file must be
+ * the same as when they are written one after the other. */
+TEST_F(BlendfileWriteTest, ParallelWriteMatchesSerial)
+{
+  if (!blendfile_load("modifier_stack" SEP_STR "array_test.blend")) {
+    return;
+  }
+  /* More meshes than fit in a single batch of IDs serialized together. */
+  add_mesh_copies(40);
+
+  const std::string serial = write_file("serial.blend", 1, 0);
+  const std::string parallel = write_file("parallel.blend", 8, 0);
+  ASSERT_FALSE(serial.empty());
+  EXPECT_EQ(serial.size(), parallel.size());
+  EXPECT_TRUE(serial == parallel);
+
+  /* Compressed frames depend on the buffering of the written data. */
+  const std::string serial_compressed = write_file("serial_zstd.blend", 1, G_FILE_COMPRESS);
+  const std::string parallel_compressed = write_file("parallel_zstd.blend", 8, G_FILE_COMPRESS);
+  ASSERT_FALSE(serial_compressed.empty());
+  EXPECT_TRUE(serial_compressed == parallel_compressed);
+}
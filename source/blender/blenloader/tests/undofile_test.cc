@@ -0,0 +1,135 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <string>
+
+#include "BLI_listbase.h"
+
+#include "BKE_lib_id.hh"
+
+#include "BLO_undofile.hh"
+
+namespace blender::blo::tests {
+
+static void memfile_write(MemFile *memfile, MemFile *reference, Span<std::string> chunks)
+{
+  MemFileWriteData mem_data;
+  BLO_memfile_write_init(&mem_data, memfile, reference);
+  mem_data.current_id_session_uid = MAIN_ID_SESSION_UID_UNSET;
+  for (const std::string &chunk : chunks) {
+    BLO_memfile_chunk_add(&mem_data, chunk.data(), chunk.size());
+  }
+  BLO_memfile_write_finalize(&mem_data);
+}
+
+static std::string memfile_read(MemFile *memfile)
+{
+  size_t size = 0;
+  LISTBASE_FOREACH (const MemFileChunk *, chunk, &memfile->chunks) {
+    size += chunk->size;
+  }
+  std::string result(size, '\0');
+  FileReader *reader = BLO_memfile_new_filereader(memfile, 0);
+  EXPECT_EQ(reader->read(reader, result.data(), size), int64_t(size));
+  reader->close(reader);
+  return result;
+}
+
+static MemFileChunk *memfile_chunk(MemFile *memfile, const int index)
+{
+  return static_cast<MemFileChunk *>(BLI_findlink(&memfile->chunks, index));
+}
+
+TEST(undofile, ChunkDeduplication)
+{
+  const std::string a(4000, 'a');
+  const std::string b(3000, 'b');
+  const std::string c(2000, 'c');
+
+  MemFile memfile_1{};
+  MemFile memfile_2{};
+  MemFile memfile_3{};
+  memfile_write(&memfile_1, nullptr, {a, b});
+  memfile_write(&memfile_2, &memfile_1, {c, b});
+  memfile_write(&memfile_3, &memfile_2, {a, b});
+
+  /* Chunks identical to the previous step. */
+  EXPECT_TRUE(memfile_chunk(&memfile_2, 1)->is_identical);
+  EXPECT_TRUE(memfile_chunk(&memfile_3, 1)->is_identical);
+  EXPECT_EQ(memfile_chunk(&memfile_1, 1)->data, memfile_chunk(&memfile_3, 1)->data);
+
+  /* Chunk identical to an older step is shared, but not identical to the previous step. */
+  EXPECT_FALSE(memfile_chunk(&memfile_3, 0)->is_identical);
+  EXPECT_EQ(memfile_chunk(&memfile_1, 0)->data, memfile_chunk(&memfile_3, 0)->data);
+  EXPECT_EQ(memfile_1.size, a.size() + b.size());
+  EXPECT_EQ(memfile_2.size, c.size());
+  EXPECT_EQ(memfile_3.size, size_t(0));
+
+  /* Data of older steps may be compressed in the meantime. */
+  EXPECT_EQ(memfile_read(&memfile_1), a + b);
+  EXPECT_EQ(memfile_read(&memfile_2), c + b);
+
+  BLO_memfile_merge(&memfile_1, &memfile_2);
+  EXPECT_FALSE(memfile_chunk(&memfile_2, 1)->is_identical);
+  EXPECT_EQ(memfile_read(&memfile_2), c + b);
+  EXPECT_EQ(memfile_read(&memfile_3), a + b);
+
+  BLO_memfile_merge(&memfile_2, &memfile_3);
+  EXPECT_EQ(memfile_read(&memfile_3), a + b);
+  BLO_memfile_free(&memfile_3);
+}
+
+TEST(undofile, ChunkCompression)
+{
+  const std::string a(4000, 'a');
+  const std::string b(3000, 'b');
+  const std::string c(2000, 'c');
+  const std::string d(5000, 'd');
+  /* Below the size which is worth compressing. */
+  const std::string e(100, 'e');
+
+  MemFile memfile_1{};
+  MemFile memfile_2{};
+  MemFile memfile_3{};
+  memfile_write(&memfile_1, nullptr, {a, e, b});
+  memfile_write(&memfile_2, &memfile_1, {c, e, b});
+  memfile_write(&memfile_3, &memfile_2, {d, e, b});
+  BLO_memfile_compress_wait();
+
+  /* Only data which is not used by the two most recent steps is compressed. */
+  EXPECT_TRUE(BLO_memfile_chunk_is_compressed(memfile_chunk(&memfile_1, 0)));
+  EXPECT_FALSE(BLO_memfile_chunk_is_compressed(memfile_chunk(&memfile_1, 1)));
+  EXPECT_FALSE(BLO_memfile_chunk_is_compressed(memfile_chunk(&memfile_1, 2)));
+  EXPECT_FALSE(BLO_memfile_chunk_is_compressed(memfile_chunk(&memfile_2, 0)));
+  EXPECT_FALSE(BLO_memfile_chunk_is_compressed(memfile_chunk(&memfile_3, 0)));
+  /* The size is not changed by compression. */
+  EXPECT_EQ(memfile_1.size, a.size() + e.size() + b.size());
+
+  /* Reading decompresses the data on demand, without changing the stored data. */
+  EXPECT_EQ(memfile_read(&memfile_1), a + e + b);
+  EXPECT_TRUE(BLO_memfile_chunk_is_compressed(memfile_chunk(&memfile_1, 0)));
+
+  /* Compressed data used by a new step is shared, and stored uncompressed again. */
+  MemFile memfile_4{};
+  memfile_write(&memfile_4, &memfile_3, {a, e, b});
+  BLO_memfile_compress_wait();
+  EXPECT_EQ(memfile_chunk(&memfile_1, 0)->data, memfile_chunk(&memfile_4, 0)->data);
+  EXPECT_FALSE(BLO_memfile_chunk_is_compressed(memfile_chunk(&memfile_4, 0)));
+  EXPECT_EQ(memfile_4.size, size_t(0));
+  EXPECT_EQ(memfile_read(&memfile_4), a + e + b);
+
+  /* Data of the second step is not used by the two most recent steps anymore. */
+  EXPECT_TRUE(BLO_memfile_chunk_is_compressed(memfile_chunk(&memfile_2, 0)));
+  EXPECT_EQ(memfile_read(&memfile_2), c + e + b);
+
+  BLO_memfile_merge(&memfile_1, &memfile_2);
+  BLO_memfile_merge(&memfile_2, &memfile_3);
+  BLO_memfile_merge(&memfile_3, &memfile_4);
+  EXPECT_EQ(memfile_read(&memfile_4), a + e + b);
+  BLO_memfile_free(&memfile_4);
+}
+
+}  // namespace blender::blo::tests
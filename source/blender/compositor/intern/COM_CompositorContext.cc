@@ -11,6 +11,7 @@ CompositorContext::CompositorContext()
   scene_ = nullptr;
   rd_ = nullptr;
   bnodetree_ = nullptr;
+  operation_cache_ = nullptr;
 }
 
 int CompositorContext::get_framenumber() const
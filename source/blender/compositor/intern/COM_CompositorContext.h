@@ -21,6 +21,8 @@ class Profiler;
 
 namespace blender::compositor {
 
+class OperationCache;
+
 /**
  * \brief Overall context of the compositor
  */
@@ -72,6 +74,11 @@ class CompositorContext {
    */
   realtime_compositor::Profiler *profiler_;
 
+  /**
+   * \brief Cache of operation buffers kept across executions. Can be null if caching is disabled.
+   */
+  OperationCache *operation_cache_;
+
  public:
   /**
    * \brief constructor initializes the context with default values.
@@ -194,6 +201,22 @@ class CompositorContext {
     profiler_ = profiler;
   }
 
+  /**
+   * \brief get the operation cache
+   */
+  OperationCache *get_operation_cache() const
+  {
+    return operation_cache_;
+  }
+
+  /**
+   * \brief set the operation cache
+   */
+  void set_operation_cache(OperationCache *operation_cache)
+  {
+    operation_cache_ = operation_cache;
+  }
+
   /**
    * \brief get the active rendering view
    */
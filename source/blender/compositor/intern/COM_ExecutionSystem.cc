@@ -25,11 +25,13 @@ ExecutionSystem::ExecutionSystem(RenderData *rd,
                                  bool rendering,
                                  const char *view_name,
                                  realtime_compositor::RenderContext *render_context,
-                                 realtime_compositor::Profiler *profiler)
+                                 realtime_compositor::Profiler *profiler,
+                                 OperationCache *operation_cache)
 {
   num_work_threads_ = WorkScheduler::get_num_cpu_threads();
   context_.set_render_context(render_context);
   context_.set_profiler(profiler);
+  context_.set_operation_cache(operation_cache);
   context_.set_view_name(view_name);
   context_.set_scene(scene);
   context_.set_bnodetree(editingtree);
@@ -128,6 +128,7 @@ class ExecutionSystem {
    *
    * \param editingtree: [bNodeTree *]
    * \param rendering: [true false]
+   * \param operation_cache: buffers kept across executions, can be null.
    */
   ExecutionSystem(RenderData *rd,
                   Scene *scene,
@@ -135,7 +136,8 @@ class ExecutionSystem {
                   bool rendering,
                   const char *view_name,
                   realtime_compositor::RenderContext *render_context,
-                  realtime_compositor::Profiler *profiler);
+                  realtime_compositor::Profiler *profiler,
+                  OperationCache *operation_cache = nullptr);
 
   /**
    * Destructor
@@ -4,11 +4,23 @@
 
 #include "COM_FullFrameExecutionModel.h"
 
+#include "BLI_array.hh"
+#include "BLI_enumerable_thread_specific.hh"
 #include "BLI_string.h"
+#include "BLI_task.hh"
 
 #include "BLT_translation.hh"
 
+#include "CLG_log.h"
+
+#include "DNA_userdef_types.h"
+
+#include <xxhash.h>
+
+#include "COM_ConstantOperation.h"
 #include "COM_Debug.h"
+#include "COM_MultiThreadedOperation.h"
+#include "COM_OperationCache.h"
 #include "COM_ViewerOperation.h"
 #include "COM_WorkScheduler.h"
 
@@ -20,14 +32,28 @@
 #  include "MEM_guardedalloc.h"
 #endif
 
+static CLG_LogRef LOG = {"compositor.full_frame"};
+
 namespace blender::compositor {
 
+/**
+ * Tiles of a group are sized so that the tiles of all its operations fit in the L2 cache.
+ */
+static constexpr int64_t TILE_BYTES = 256 * 1024;
+static constexpr int TILE_MAX_WIDTH = 256;
+
 FullFrameExecutionModel::FullFrameExecutionModel(CompositorContext &context,
                                                  SharedOperationBuffers &shared_buffers,
                                                  Span<NodeOperation *> operations)
     : ExecutionModel(context, operations),
       active_buffers_(shared_buffers),
-      num_operations_finished_(0)
+      num_operations_finished_(0),
+      use_tiled_execution_(USER_EXPERIMENTAL_TEST(&U, use_tiled_compositor)),
+      num_tiled_groups_(0),
+      num_tiled_operations_(0),
+      operation_cache_(context.get_operation_cache()),
+      context_hash_(0),
+      num_cached_operations_(0)
 {
   priorities_.append(eCompositorPriority::High);
   priorities_.append(eCompositorPriority::Medium);
@@ -42,8 +68,39 @@ void FullFrameExecutionModel::execute(ExecutionSystem &exec_system)
 
   DebugInfo::graphviz(&exec_system, "compositor_prior_rendering");
 
+  const timeit::TimePoint start_time = timeit::Clock::now();
+
+  if (operation_cache_) {
+    operation_cache_->begin_execution();
+    context_hash_ = hash_context();
+  }
   determine_areas_to_render_and_reads();
+  if (use_tiled_execution_) {
+    determine_tiled_groups();
+  }
   render_operations();
+  if (operation_cache_) {
+    operation_cache_->end_execution(int64_t(U.memcachelimit) * 1024 * 1024);
+  }
+
+  const timeit::Nanoseconds duration = timeit::Clock::now() - start_time;
+  CLOG_INFO(&LOG,
+            1,
+            "%d operations (%d in %d tiled groups, %d from cache) rendered in %.2f ms, buffers "
+            "peak %.2f MiB",
+            num_operations_finished_,
+            num_tiled_operations_,
+            num_tiled_groups_,
+            num_cached_operations_,
+            double(duration.count()) / 1e6,
+            double(active_buffers_.get_memory_peak()) / (1024.0 * 1024.0));
+  if (operation_cache_) {
+    CLOG_INFO(&LOG,
+              2,
+              "Operation cache: %d buffers, %.2f MiB",
+              int(operation_cache_->size()),
+              double(operation_cache_->get_memory_used()) / (1024.0 * 1024.0));
+  }
 }
 
 void FullFrameExecutionModel::determine_areas_to_render_and_reads()
@@ -64,6 +121,22 @@ void FullFrameExecutionModel::determine_areas_to_render_and_reads()
   }
 }
 
+MemoryBuffer *FullFrameExecutionModel::get_input_buffer(NodeOperation *op,
+                                                        const int input_index,
+                                                        const int output_x,
+                                                        const int output_y)
+{
+  NodeOperation *input = op->get_input_operation(input_index);
+  const int offset_x = (input->get_canvas().xmin - op->get_canvas().xmin) + output_x;
+  const int offset_y = (input->get_canvas().ymin - op->get_canvas().ymin) + output_y;
+  MemoryBuffer *buf = active_buffers_.get_rendered_buffer(input);
+
+  rcti rect = buf->get_rect();
+  BLI_rcti_translate(&rect, offset_x, offset_y);
+  return new MemoryBuffer(
+      buf->get_buffer(), buf->get_num_channels(), rect, buf->is_a_single_elem());
+}
+
 Vector<MemoryBuffer *> FullFrameExecutionModel::get_input_buffers(NodeOperation *op,
                                                                   const int output_x,
                                                                   const int output_y)
@@ -71,15 +144,7 @@ Vector<MemoryBuffer *> FullFrameExecutionModel::get_input_buffers(NodeOperation
   const int num_inputs = op->get_number_of_input_sockets();
   Vector<MemoryBuffer *> inputs_buffers(num_inputs);
   for (int i = 0; i < num_inputs; i++) {
-    NodeOperation *input = op->get_input_operation(i);
-    const int offset_x = (input->get_canvas().xmin - op->get_canvas().xmin) + output_x;
-    const int offset_y = (input->get_canvas().ymin - op->get_canvas().ymin) + output_y;
-    MemoryBuffer *buf = active_buffers_.get_rendered_buffer(input);
-
-    rcti rect = buf->get_rect();
-    BLI_rcti_translate(&rect, offset_x, offset_y);
-    inputs_buffers[i] = new MemoryBuffer(
-        buf->get_buffer(), buf->get_num_channels(), rect, buf->is_a_single_elem());
+    inputs_buffers[i] = get_input_buffer(op, i, output_x, output_y);
   }
   return inputs_buffers;
 }
@@ -107,11 +172,11 @@ void FullFrameExecutionModel::render_operation(NodeOperation *op)
 
   const bool has_outputs = op->get_number_of_output_sockets() > 0;
   MemoryBuffer *op_buf = has_outputs ? create_operation_buffer(op, output_x, output_y) : nullptr;
+  const int op_offset_x = output_x - op->get_canvas().xmin;
+  const int op_offset_y = output_y - op->get_canvas().ymin;
+  const Vector<rcti> areas = active_buffers_.get_areas_to_render(op, op_offset_x, op_offset_y);
   if (op->get_width() > 0 && op->get_height() > 0) {
     Vector<MemoryBuffer *> input_bufs = get_input_buffers(op, output_x, output_y);
-    const int op_offset_x = output_x - op->get_canvas().xmin;
-    const int op_offset_y = output_y - op->get_canvas().ymin;
-    Vector<rcti> areas = active_buffers_.get_areas_to_render(op, op_offset_x, op_offset_y);
     op->render(op_buf, areas, input_bufs);
     DebugInfo::operation_rendered(op, op_buf);
 
@@ -119,15 +184,21 @@ void FullFrameExecutionModel::render_operation(NodeOperation *op)
       delete buf;
     }
   }
+  const timeit::TimePoint after_time = timeit::Clock::now();
+
   /* Even if operation has no resolution set the empty buffer. It will be clipped with a
    * TranslateOperation from convert resolutions if linked to an operation with resolution. */
-  active_buffers_.set_rendered_buffer(op, std::unique_ptr<MemoryBuffer>(op_buf));
+  active_buffers_.set_rendered_buffer(
+      op,
+      cache_rendered_buffer(op,
+                            std::unique_ptr<MemoryBuffer>(op_buf),
+                            areas,
+                            double((after_time - before_time).count())));
 
   operation_finished(op);
 
   /* The operation may not come from any node. For example, it may have been added to convert data
    * type. Do not accumulate time from its execution. */
-  const timeit::TimePoint after_time = timeit::Clock::now();
   const bNodeInstanceKey node_instance_key = op->get_node_instance_key();
   if (context_.get_profiler() && node_instance_key != bke::NODE_INSTANCE_KEY_NONE) {
     context_.get_profiler()->set_node_evaluation_time(node_instance_key, after_time - before_time);
@@ -186,14 +257,237 @@ static Vector<NodeOperation *> get_operation_dependencies(NodeOperation *operati
 void FullFrameExecutionModel::render_output_dependencies(NodeOperation *output_op)
 {
   BLI_assert(output_op->is_output_operation(context_.is_rendering()));
-  Vector<NodeOperation *> dependencies = get_operation_dependencies(output_op);
+  render_dependencies(output_op);
+}
+
+void FullFrameExecutionModel::render_dependencies(NodeOperation *operation)
+{
+  if (operation_cache_) {
+    find_cached_buffers(operation);
+  }
+
+  Vector<NodeOperation *> dependencies = get_operation_dependencies(operation);
   for (NodeOperation *op : dependencies) {
-    if (!active_buffers_.is_operation_rendered(op)) {
+    /* Operations of a tiled group are rendered together with the last one of the group. Inputs of
+     * operations taken from the cache have no reads left. */
+    if (active_buffers_.is_operation_rendered(op) || tiled_readers_.contains(op) ||
+        active_buffers_.get_registered_reads_num(op) == 0)
+    {
+      continue;
+    }
+    Vector<NodeOperation *> group;
+    collect_tiled_group(op, group);
+    if (group.size() > 1) {
+      render_tiled_group(group);
+    }
+    else {
       render_operation(op);
     }
   }
 }
 
+bool FullFrameExecutionModel::is_tileable(NodeOperation *op) const
+{
+  /* Operations using external data need their own buffer to compute their cache key. */
+  if (operation_cache_ && uses_external_data(op)) {
+    return false;
+  }
+  return op->get_flags().is_pixel_local && !op->get_flags().is_constant_operation &&
+         op->get_number_of_output_sockets() > 0 && op->get_width() > 0 && op->get_height() > 0;
+}
+
+void FullFrameExecutionModel::determine_tiled_groups()
+{
+  const bool is_rendering = context_.is_rendering();
+
+  /* Readers within all operations, including the ones not rendered for the current outputs. */
+  Map<NodeOperation *, int> readers_num;
+  Map<NodeOperation *, NodeOperation *> last_reader;
+  for (NodeOperation *op : operations_) {
+    for (int i = 0; i < op->get_number_of_input_sockets(); i++) {
+      NodeOperation *input_op = op->get_input_operation(i);
+      readers_num.add_or_modify(
+          input_op, [](int *num) { *num = 1; }, [](int *num) { (*num)++; });
+      last_reader.add_overwrite(input_op, op);
+    }
+  }
+
+  for (const auto item : last_reader.items()) {
+    NodeOperation *op = item.key;
+    NodeOperation *reader = item.value;
+    if (readers_num.lookup(op) != 1 || active_buffers_.get_registered_reads_num(op) != 1) {
+      continue;
+    }
+    if (op->is_output_operation(is_rendering) || !is_tileable(op) || !is_tileable(reader)) {
+      continue;
+    }
+    /* Pixels are only shared between operations when they have the same coordinates. */
+    if (!BLI_rcti_compare(&op->get_canvas(), &reader->get_canvas())) {
+      continue;
+    }
+    tiled_readers_.add(op, reader);
+  }
+}
+
+void FullFrameExecutionModel::collect_tiled_group(NodeOperation *op,
+                                                  Vector<NodeOperation *> &r_group)
+{
+  for (int i = 0; i < op->get_number_of_input_sockets(); i++) {
+    NodeOperation *input_op = op->get_input_operation(i);
+    if (tiled_readers_.lookup_default(input_op, nullptr) == op) {
+      collect_tiled_group(input_op, r_group);
+    }
+  }
+  r_group.append(op);
+}
+
+int64_t FullFrameExecutionModel::render_group_tiles(const Span<NodeOperation *> group,
+                                                    const Span<Vector<MemoryBuffer *>> inputs_bufs,
+                                                    MemoryBuffer *output,
+                                                    const Span<rcti> areas,
+                                                    const int64_t tile_bytes,
+                                                    const FunctionRef<bool()> is_break_requested)
+{
+  NodeOperation *last_op = group.last();
+  Map<NodeOperation *, int> group_indices;
+  Array<int> tile_channels(group.size());
+  int pixel_channels = 0;
+  for (const int i : group.index_range()) {
+    group_indices.add_new(group[i], i);
+    tile_channels[i] = COM_data_type_num_channels(group[i]->get_output_socket()->get_data_type());
+    pixel_channels += tile_channels[i];
+  }
+
+  /* Tiles are never larger than this, whatever the width of the rendered area. */
+  const int64_t tile_pixels = std::max<int64_t>(
+      tile_bytes / (pixel_channels * int64_t(sizeof(float))), TILE_MAX_WIDTH);
+  threading::EnumerableThreadSpecific<Array<float>> tiles_memory;
+
+  for (const rcti &area : areas) {
+    if (BLI_rcti_is_empty(&area)) {
+      continue;
+    }
+    /* All operations have the same canvas, so tiles share coordinates. */
+    const int tile_width = std::min(BLI_rcti_size_x(&area), TILE_MAX_WIDTH);
+    const int tile_height = std::max<int>(1, tile_pixels / tile_width);
+    const int tiles_x = (BLI_rcti_size_x(&area) + tile_width - 1) / tile_width;
+    const int tiles_y = (BLI_rcti_size_y(&area) + tile_height - 1) / tile_height;
+
+    threading::parallel_for(IndexRange(tiles_x * tiles_y), 1, [&](const IndexRange tiles) {
+      Array<float> &memory = tiles_memory.local();
+      if (memory.is_empty()) {
+        memory.reinitialize(tile_pixels * pixel_channels);
+      }
+      for (const int tile_index : tiles) {
+        if (is_break_requested()) {
+          return;
+        }
+        rcti tile;
+        tile.xmin = area.xmin + (tile_index % tiles_x) * tile_width;
+        tile.ymin = area.ymin + (tile_index / tiles_x) * tile_height;
+        tile.xmax = std::min(tile.xmin + tile_width, area.xmax);
+        tile.ymax = std::min(tile.ymin + tile_height, area.ymax);
+
+        Array<std::unique_ptr<MemoryBuffer>> tile_bufs(group.size());
+        float *tile_memory = memory.data();
+        for (const int i : group.index_range().drop_back(1)) {
+          tile_bufs[i] = std::make_unique<MemoryBuffer>(tile_memory, tile_channels[i], tile);
+          tile_memory += int64_t(tile_width) * tile_height * tile_channels[i];
+        }
+
+        for (const int i : group.index_range()) {
+          NodeOperation *op = group[i];
+          Vector<MemoryBuffer *, 4> tile_inputs(inputs_bufs[i]);
+          for (const int input : tile_inputs.index_range()) {
+            if (tile_inputs[input] == nullptr) {
+              tile_inputs[input] =
+                  tile_bufs[group_indices.lookup(op->get_input_operation(input))].get();
+            }
+          }
+          MemoryBuffer *tile_output = (op == last_op) ? output : tile_bufs[i].get();
+          static_cast<MultiThreadedOperation *>(op)->render_tile(tile_output, tile, tile_inputs);
+        }
+      }
+    });
+  }
+
+  int64_t tiles_memory_size = 0;
+  for (const Array<float> &memory : tiles_memory) {
+    tiles_memory_size += memory.size() * int64_t(sizeof(float));
+  }
+  return tiles_memory_size;
+}
+
+void FullFrameExecutionModel::render_tiled_group(Span<NodeOperation *> group)
+{
+  /* Output has no offset for easier image algorithms implementation on operations. */
+  constexpr int output_x = 0;
+  constexpr int output_y = 0;
+
+  const timeit::TimePoint before_time = timeit::Clock::now();
+
+  NodeOperation *last_op = group.last();
+  MemoryBuffer *op_buf = create_operation_buffer(last_op, output_x, output_y);
+  const int op_offset_x = output_x - last_op->get_canvas().xmin;
+  const int op_offset_y = output_y - last_op->get_canvas().ymin;
+  const Vector<rcti> areas = active_buffers_.get_areas_to_render(
+      last_op, op_offset_x, op_offset_y);
+
+  /* Inputs of every operation, inputs within the group are null and are replaced by the tiles of
+   * the input operations. */
+  Array<Vector<MemoryBuffer *>> inputs_bufs(group.size());
+  for (const int i : group.index_range()) {
+    NodeOperation *op = group[i];
+    for (int input = 0; input < op->get_number_of_input_sockets(); input++) {
+      const bool is_group_input = group.take_front(i).contains(op->get_input_operation(input));
+      inputs_bufs[i].append(is_group_input ? nullptr :
+                                             get_input_buffer(op, input, output_x, output_y));
+    }
+    op->init_execution();
+  }
+
+  const bNodeTree *node_tree = context_.get_bnodetree();
+  const int64_t tiles_memory_size = render_group_tiles(
+      group, inputs_bufs, op_buf, areas, TILE_BYTES, [&]() {
+        return node_tree->runtime->test_break(node_tree->runtime->tbh);
+      });
+
+  for (const int i : group.index_range()) {
+    group[i]->deinit_execution();
+    for (MemoryBuffer *buf : inputs_bufs[i]) {
+      delete buf;
+    }
+  }
+  DebugInfo::operation_rendered(last_op, op_buf);
+
+  const timeit::Nanoseconds group_time = timeit::Clock::now() - before_time;
+  active_buffers_.set_rendered_buffer(
+      last_op,
+      cache_rendered_buffer(
+          last_op, std::unique_ptr<MemoryBuffer>(op_buf), areas, double(group_time.count())));
+  active_buffers_.register_temporary_memory(tiles_memory_size);
+  for (NodeOperation *op : group) {
+    if (op != last_op) {
+      active_buffers_.set_rendered_buffer(op, nullptr);
+    }
+    operation_finished(op);
+  }
+  num_tiled_groups_++;
+  num_tiled_operations_ += group.size();
+
+  /* Operations are interleaved, so the group time is distributed evenly between the nodes of the
+   * operations in the group. */
+  if (context_.get_profiler()) {
+    for (NodeOperation *op : group) {
+      const bNodeInstanceKey node_instance_key = op->get_node_instance_key();
+      if (node_instance_key != bke::NODE_INSTANCE_KEY_NONE) {
+        context_.get_profiler()->set_node_evaluation_time(node_instance_key,
+                                                          group_time / group.size());
+      }
+    }
+  }
+}
+
 void FullFrameExecutionModel::determine_areas_to_render(NodeOperation *output_op,
                                                         const rcti &output_area)
 {
@@ -284,6 +578,147 @@ void FullFrameExecutionModel::operation_finished(NodeOperation *operation)
   update_progress_bar();
 }
 
+bool FullFrameExecutionModel::uses_external_data(NodeOperation *op) const
+{
+  return !op->get_node_hash().has_value() ||
+         (op->get_number_of_input_sockets() == 0 && !op->get_flags().is_constant_operation);
+}
+
+bool FullFrameExecutionModel::is_cacheable(NodeOperation *op) const
+{
+  /* Only operations with their own full buffer are cached, operations with external data are
+   * rendered anyway to compute their key. */
+  return op->get_number_of_output_sockets() > 0 && op->get_width() > 0 &&
+         op->get_height() > 0 && !op->get_flags().is_constant_operation &&
+         !op->is_output_operation(context_.is_rendering()) && !tiled_readers_.contains(op) &&
+         !uses_external_data(op);
+}
+
+uint64_t FullFrameExecutionModel::hash_context() const
+{
+  const RenderData *rd = context_.get_render_data();
+  const char *view_name = context_.get_view_name();
+  const uint64_t values[] = {get_default_hash(context_.get_scene()),
+                             get_default_hash(rd->cfra),
+                             get_default_hash(rd->subframe),
+                             get_default_hash(rd->size),
+                             get_default_hash(rd->xsch, rd->ysch),
+                             get_default_hash(context_.is_rendering()),
+                             get_default_hash(StringRef(view_name ? view_name : ""))};
+  return XXH3_64bits(values, sizeof(values));
+}
+
+uint64_t FullFrameExecutionModel::ensure_operation_key(NodeOperation *op)
+{
+  if (const uint64_t *key = operation_keys_.lookup_ptr(op)) {
+    return *key;
+  }
+
+  if (uses_external_data(op)) {
+    /* The key is the hash of the rendered buffer, which is added once the operation is rendered.
+     * It is not rendered yet, otherwise its key would exist already. */
+    BLI_assert(!active_buffers_.is_operation_rendered(op));
+    render_dependencies(op);
+    render_operation(op);
+    return operation_keys_.lookup(op);
+  }
+
+  Vector<uint64_t, 16> values;
+  values.append(context_hash_);
+  values.append(typeid(*op).hash_code());
+  values.append(*op->get_node_hash());
+  const rcti &canvas = op->get_canvas();
+  values.append(get_default_hash(canvas.xmin, canvas.xmax, canvas.ymin, canvas.ymax));
+  if (op->get_number_of_output_sockets() > 0) {
+    const DataType data_type = op->get_output_socket()->get_data_type();
+    values.append(uint64_t(data_type));
+    if (op->get_flags().is_constant_operation) {
+      const float *elem = static_cast<ConstantOperation *>(op)->get_constant_elem();
+      for (const int i : IndexRange(COM_data_type_num_channels(data_type))) {
+        values.append(get_default_hash(elem[i]));
+      }
+    }
+    /* Parameters of operations that are not created by nodes. */
+    if (std::optional<NodeOperationHash> hash = op->generate_hash()) {
+      values.append(hash->get_params_hash());
+    }
+  }
+  for (int i = 0; i < op->get_number_of_input_sockets(); i++) {
+    values.append(ensure_operation_key(op->get_input_operation(i)));
+  }
+
+  const uint64_t key = XXH3_64bits(values.data(), values.size() * sizeof(uint64_t));
+  operation_keys_.add_new(op, key);
+  return key;
+}
+
+void FullFrameExecutionModel::find_cached_buffers(NodeOperation *op)
+{
+  for (int i = 0; i < op->get_number_of_input_sockets(); i++) {
+    NodeOperation *input_op = op->get_input_operation(i);
+    if (active_buffers_.is_operation_rendered(input_op) ||
+        !cache_checked_operations_.add(input_op))
+    {
+      continue;
+    }
+    if (!use_cached_buffer(input_op)) {
+      find_cached_buffers(input_op);
+    }
+  }
+}
+
+bool FullFrameExecutionModel::use_cached_buffer(NodeOperation *op)
+{
+  if (!is_cacheable(op)) {
+    return false;
+  }
+
+  const uint64_t key = ensure_operation_key(op);
+  const Vector<rcti> areas = active_buffers_.get_areas_to_render(
+      op, -op->get_canvas().xmin, -op->get_canvas().ymin);
+  std::unique_ptr<MemoryBuffer> buffer = operation_cache_->lookup(key, areas);
+  if (buffer == nullptr) {
+    return false;
+  }
+
+  active_buffers_.set_rendered_buffer(op, std::move(buffer));
+  prune_operation_inputs(op);
+  num_cached_operations_++;
+  num_operations_finished_++;
+  update_progress_bar();
+  return true;
+}
+
+void FullFrameExecutionModel::prune_operation_inputs(NodeOperation *op)
+{
+  for (int i = 0; i < op->get_number_of_input_sockets(); i++) {
+    NodeOperation *input_op = op->get_input_operation(i);
+    const int reads_left = active_buffers_.unregister_read(input_op);
+    if (reads_left == 0 && !active_buffers_.is_operation_rendered(input_op)) {
+      prune_operation_inputs(input_op);
+    }
+  }
+}
+
+std::unique_ptr<MemoryBuffer> FullFrameExecutionModel::cache_rendered_buffer(
+    NodeOperation *op,
+    std::unique_ptr<MemoryBuffer> buffer,
+    Span<rcti> areas,
+    const double render_time)
+{
+  if (operation_cache_ == nullptr || buffer == nullptr) {
+    return buffer;
+  }
+  if (uses_external_data(op)) {
+    operation_keys_.add_new(op, OperationCache::hash_buffer(*buffer, areas));
+    return buffer;
+  }
+  if (!is_cacheable(op)) {
+    return buffer;
+  }
+  return operation_cache_->store(ensure_operation_key(op), std::move(buffer), areas, render_time);
+}
+
 void FullFrameExecutionModel::update_progress_bar()
 {
   const bNodeTree *tree = context_.get_bnodetree();
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include "BLI_function_ref.hh"
+#include "BLI_map.hh"
+#include "BLI_set.hh"
 #include "BLI_vector.hh"
 
 #include "COM_Enums.h"
@@ -20,10 +23,20 @@ class CompositorContext;
 class ExecutionSystem;
 class MemoryBuffer;
 class NodeOperation;
+class OperationCache;
 class SharedOperationBuffers;
 
 /**
  * Fully renders operations in order from inputs to outputs.
+ *
+ * With tiled execution, groups of pixel local operations (see
+ * #NodeOperationFlags::is_pixel_local) whose intermediate results are only read within the group
+ * are rendered together tile by tile. Only the last operation of a group gets a full buffer, the
+ * others write to small tiles that stay in the CPU cache.
+ *
+ * With an #OperationCache, operations whose result is identified by a key that was rendered in a
+ * previous execution take the cached buffer and their inputs are not rendered, as long as no other
+ * operation reads them.
  */
 class FullFrameExecutionModel : public ExecutionModel {
  private:
@@ -43,6 +56,41 @@ class FullFrameExecutionModel : public ExecutionModel {
    */
   Vector<eCompositorPriority> priorities_;
 
+  /**
+   * Render groups of pixel local operations tile by tile.
+   */
+  bool use_tiled_execution_;
+
+  /**
+   * Operations rendered as part of a tiled group, mapped to the only operation reading them.
+   */
+  Map<NodeOperation *, NodeOperation *> tiled_readers_;
+
+  int num_tiled_groups_;
+  int num_tiled_operations_;
+
+  /**
+   * Buffers kept across executions, null when caching is disabled.
+   */
+  OperationCache *operation_cache_;
+
+  /**
+   * Keys that identify operation results in the #operation_cache_, see #ensure_operation_key.
+   */
+  Map<NodeOperation *, uint64_t> operation_keys_;
+
+  /**
+   * Operations already looked up in the #operation_cache_.
+   */
+  Set<NodeOperation *> cache_checked_operations_;
+
+  /**
+   * Hash of the execution settings operations may depend on besides their node settings.
+   */
+  uint64_t context_hash_;
+
+  int num_cached_operations_;
+
  public:
   FullFrameExecutionModel(CompositorContext &context,
                           SharedOperationBuffers &shared_buffers,
@@ -50,6 +98,19 @@ class FullFrameExecutionModel : public ExecutionModel {
 
   void execute(ExecutionSystem &exec_system) override;
 
+  /**
+   * Renders \a areas of a group of pixel local operations tile by tile. The group is ordered from
+   * inputs to outputs, inputs within the group are null in \a inputs_bufs. Only the last operation
+   * is written to \a output, the others are written to tiles of about \a tile_bytes per thread.
+   * Returns the memory used by tiles.
+   */
+  static int64_t render_group_tiles(Span<NodeOperation *> group,
+                                    Span<Vector<MemoryBuffer *>> inputs_bufs,
+                                    MemoryBuffer *output,
+                                    Span<rcti> areas,
+                                    int64_t tile_bytes,
+                                    FunctionRef<bool()> is_break_requested);
+
  private:
   void determine_areas_to_render_and_reads();
   /**
@@ -57,16 +118,62 @@ class FullFrameExecutionModel : public ExecutionModel {
    */
   void render_operations();
   void render_output_dependencies(NodeOperation *output_op);
+  /**
+   * Render all operations given operation depends on.
+   */
+  void render_dependencies(NodeOperation *op);
   /**
    * Returns input buffers with an offset relative to given output coordinates.
    * Returned memory buffers must be deleted.
    */
   Vector<MemoryBuffer *> get_input_buffers(NodeOperation *op, int output_x, int output_y);
+  MemoryBuffer *get_input_buffer(NodeOperation *op, int input_index, int output_x, int output_y);
   MemoryBuffer *create_operation_buffer(NodeOperation *op, int output_x, int output_y);
   void render_operation(NodeOperation *op);
 
+  /**
+   * Finds operations that can be rendered in tiles as part of the group of their reader.
+   */
+  void determine_tiled_groups();
+  bool is_tileable(NodeOperation *op) const;
+  /**
+   * Collects the tiled group ending at given operation, ordered from inputs to outputs.
+   */
+  void collect_tiled_group(NodeOperation *op, Vector<NodeOperation *> &r_group);
+  void render_tiled_group(Span<NodeOperation *> group);
+
   void operation_finished(NodeOperation *operation);
 
+  /**
+   * Whether the operation result is identified by its pixels instead of its settings, because it
+   * depends on data outside of the node tree or it has no inputs.
+   */
+  bool uses_external_data(NodeOperation *op) const;
+  bool is_cacheable(NodeOperation *op) const;
+  uint64_t hash_context() const;
+  /**
+   * Key that identifies the operation result across executions. Operations using external data
+   * are rendered to compute their key.
+   */
+  uint64_t ensure_operation_key(NodeOperation *op);
+  /**
+   * Takes cached buffers for the operations given operation depends on, where possible.
+   */
+  void find_cached_buffers(NodeOperation *op);
+  bool use_cached_buffer(NodeOperation *op);
+  /**
+   * Unregister the reads of an operation that was taken from the cache, recursively for inputs
+   * no other operation reads.
+   */
+  void prune_operation_inputs(NodeOperation *op);
+  /**
+   * Store a rendered buffer in the cache, returning the buffer to set as rendered.
+   */
+  std::unique_ptr<MemoryBuffer> cache_rendered_buffer(NodeOperation *op,
+                                                      std::unique_ptr<MemoryBuffer> buffer,
+                                                      Span<rcti> areas,
+                                                      double render_time);
+
   /**
    * Calculates given output operation area to be rendered taking into account viewer and render
    * borders.
@@ -383,6 +383,12 @@ class MemoryBuffer {
     return num_channels_;
   }
 
+  /** Size of the buffer data in bytes. */
+  int64_t get_memory_size() const
+  {
+    return buffer_len() * num_channels_ * int64_t(sizeof(float));
+  }
+
   uint8_t get_elem_bytes_len() const
   {
     return num_channels_ * sizeof(float);
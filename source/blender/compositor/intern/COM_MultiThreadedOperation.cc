@@ -26,4 +26,12 @@ void MultiThreadedOperation::update_memory_buffer(MemoryBuffer *output,
   }
 }
 
+void MultiThreadedOperation::render_tile(MemoryBuffer *output,
+                                         const rcti &area,
+                                         Span<MemoryBuffer *> inputs)
+{
+  BLI_assert(flags_.is_pixel_local && num_passes_ == 1);
+  update_memory_buffer_partial(output, area, inputs);
+}
+
 }  // namespace blender::compositor
@@ -22,6 +22,14 @@ class MultiThreadedOperation : public NodeOperation {
  protected:
   MultiThreadedOperation();
 
+ public:
+  /**
+   * Render \a area of a pixel local operation in the calling thread, outside of
+   * #update_memory_buffer. Only valid when #NodeOperationFlags::is_pixel_local is set.
+   */
+  void render_tile(MemoryBuffer *output, const rcti &area, Span<MemoryBuffer *> inputs);
+
+ protected:
   /**
    * Called before an update memory buffer pass is executed. Single-threaded calls.
    */
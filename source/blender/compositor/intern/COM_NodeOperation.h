@@ -6,6 +6,7 @@
 
 #include <functional>
 #include <list>
+#include <optional>
 
 #include "BLI_ghash.h"
 #include "BLI_hash.hh"
@@ -206,6 +207,13 @@ struct NodeOperationFlags {
    */
   bool can_be_constant : 1;
 
+  /**
+   * Whether output pixels only depend on the input pixels at the same coordinates and the
+   * operation renders in a single #MultiThreadedOperation pass without started/finished steps.
+   * Chains of such operations may be rendered tile by tile, see #FullFrameExecutionModel.
+   */
+  bool is_pixel_local : 1;
+
   NodeOperationFlags()
   {
     use_render_border = false;
@@ -217,6 +225,7 @@ struct NodeOperationFlags {
     use_datatype_conversion = true;
     is_constant_operation = false;
     can_be_constant = false;
+    is_pixel_local = false;
   }
 };
 
@@ -236,6 +245,11 @@ struct NodeOperationHash {
     return operation_;
   }
 
+  size_t get_params_hash() const
+  {
+    return params_hash_;
+  }
+
   bool operator==(const NodeOperationHash &other) const
   {
     return type_hash_ == other.type_hash_ && parents_hash_ == other.parents_hash_ &&
@@ -267,6 +281,12 @@ class NodeOperation {
   int id_;
   std::string name_;
   bNodeInstanceKey node_instance_key_{bke::NODE_INSTANCE_KEY_NONE};
+  /**
+   * Hash of the settings of the node the operation was created from, see
+   * #NodeOperationBuilder::add_operation. Zero for operations that weren't created by a node, and
+   * none for operations of nodes that use data outside of the node tree.
+   */
+  std::optional<uint64_t> node_hash_ = 0;
 
   Vector<NodeOperationInput> inputs_;
   Vector<NodeOperationOutput> outputs_;
@@ -328,6 +348,15 @@ class NodeOperation {
     return node_instance_key_;
   }
 
+  void set_node_hash(const std::optional<uint64_t> node_hash)
+  {
+    node_hash_ = node_hash;
+  }
+  std::optional<uint64_t> get_node_hash() const
+  {
+    return node_hash_;
+  }
+
   /** Get constant value when operation is constant, otherwise return default_value. */
   float get_constant_value_default(float default_value);
   /** Get constant elem when operation is constant, otherwise return default_elem. */
@@ -2,12 +2,25 @@
  *
  * SPDX-License-Identifier: GPL-2.0-or-later */
 
+#include <algorithm>
 #include <set>
 
+#include <xxhash.h>
+
+#include "BLI_array.hh"
+#include "BLI_listbase.h"
 #include "BLI_multi_value_map.hh"
+#include "BLI_set.hh"
 
 #include "BKE_node_runtime.hh"
 
+#include "DNA_color_types.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "RNA_access.hh"
+#include "RNA_prototypes.h"
+
 #include "COM_Converter.h"
 #include "COM_Debug.h"
 
@@ -25,11 +38,223 @@ namespace blender::compositor {
 NodeOperationBuilder::NodeOperationBuilder(const CompositorContext *context,
                                            bNodeTree *b_nodetree,
                                            ExecutionSystem *system)
-    : context_(context), exec_system_(system), current_node_(nullptr), active_viewer_(nullptr)
+    : context_(context),
+      exec_system_(system),
+      current_node_(nullptr),
+      current_node_operations_num_(0),
+      active_viewer_(nullptr)
 {
   graph_.from_bNodeTree(*context, b_nodetree);
 }
 
+static void hash_curve_mapping(XXH3_state_t *state, const CurveMapping &curve_mapping)
+{
+  XXH3_64bits_update(state, &curve_mapping.flag, sizeof(curve_mapping.flag));
+  XXH3_64bits_update(state, &curve_mapping.preset, sizeof(curve_mapping.preset));
+  XXH3_64bits_update(state, &curve_mapping.clipr, sizeof(curve_mapping.clipr));
+  XXH3_64bits_update(state, curve_mapping.black, sizeof(curve_mapping.black));
+  XXH3_64bits_update(state, curve_mapping.white, sizeof(curve_mapping.white));
+  XXH3_64bits_update(state, &curve_mapping.tone, sizeof(curve_mapping.tone));
+  for (const CurveMap &curve_map : curve_mapping.cm) {
+    XXH3_64bits_update(state, curve_map.ext_in, sizeof(curve_map.ext_in));
+    XXH3_64bits_update(state, curve_map.ext_out, sizeof(curve_map.ext_out));
+    for (const int i : IndexRange(curve_map.totpoint)) {
+      const CurveMapPoint &point = curve_map.curve[i];
+      const short flag = point.flag & ~CUMA_SELECT;
+      XXH3_64bits_update(state, &point.x, sizeof(point.x));
+      XXH3_64bits_update(state, &point.y, sizeof(point.y));
+      XXH3_64bits_update(state, &flag, sizeof(flag));
+    }
+  }
+}
+
+static bool hash_rna_struct(XXH3_state_t *state,
+                            PointerRNA &ptr,
+                            StructRNA *skip_base,
+                            Set<const void *> &hashed_structs);
+
+/**
+ * Hash the value of an RNA property. Values are hashed rather than the DNA data, which may
+ * contain pointers and padding. Returns false for properties referencing an ID, whose data may
+ * change without the node changing.
+ */
+static bool hash_rna_property(XXH3_state_t *state,
+                              PointerRNA &ptr,
+                              PropertyRNA *prop,
+                              Set<const void *> &hashed_structs)
+{
+  const PropertyType type = RNA_property_type(prop);
+  const int array_len = ELEM(type, PROP_BOOLEAN, PROP_INT, PROP_FLOAT) ?
+                            RNA_property_array_length(&ptr, prop) :
+                            0;
+  switch (type) {
+    case PROP_BOOLEAN: {
+      Array<bool, 16> values(std::max(array_len, 1));
+      if (array_len > 0) {
+        RNA_property_boolean_get_array(&ptr, prop, values.data());
+      }
+      else {
+        values[0] = RNA_property_boolean_get(&ptr, prop);
+      }
+      XXH3_64bits_update(state, values.data(), values.as_span().size_in_bytes());
+      return true;
+    }
+    case PROP_INT: {
+      Array<int, 16> values(std::max(array_len, 1));
+      if (array_len > 0) {
+        RNA_property_int_get_array(&ptr, prop, values.data());
+      }
+      else {
+        values[0] = RNA_property_int_get(&ptr, prop);
+      }
+      XXH3_64bits_update(state, values.data(), values.as_span().size_in_bytes());
+      return true;
+    }
+    case PROP_FLOAT: {
+      Array<float, 16> values(std::max(array_len, 1));
+      if (array_len > 0) {
+        RNA_property_float_get_array(&ptr, prop, values.data());
+      }
+      else {
+        values[0] = RNA_property_float_get(&ptr, prop);
+      }
+      XXH3_64bits_update(state, values.data(), values.as_span().size_in_bytes());
+      return true;
+    }
+    case PROP_ENUM: {
+      const int value = RNA_property_enum_get(&ptr, prop);
+      XXH3_64bits_update(state, &value, sizeof(value));
+      return true;
+    }
+    case PROP_STRING: {
+      char fixed_buf[256];
+      int len;
+      char *value = RNA_property_string_get_alloc(&ptr, prop, fixed_buf, sizeof(fixed_buf), &len);
+      XXH3_64bits_update(state, &len, sizeof(len));
+      XXH3_64bits_update(state, value, len);
+      if (value != fixed_buf) {
+        MEM_freeN(value);
+      }
+      return true;
+    }
+    case PROP_POINTER: {
+      PointerRNA value = RNA_property_pointer_get(&ptr, prop);
+      const bool is_null = value.data == nullptr;
+      XXH3_64bits_update(state, &is_null, sizeof(is_null));
+      if (is_null) {
+        return true;
+      }
+      if (RNA_struct_is_ID(value.type)) {
+        return false;
+      }
+      if (RNA_struct_is_a(value.type, &RNA_CurveMapping)) {
+        /* Only hash the curves, not the selection or the cached table. */
+        hash_curve_mapping(state, *static_cast<const CurveMapping *>(value.data));
+        return true;
+      }
+      return hash_rna_struct(state, value, nullptr, hashed_structs);
+    }
+    case PROP_COLLECTION: {
+      bool success = true;
+      RNA_PROP_BEGIN (&ptr, item, prop) {
+        if (!hash_rna_struct(state, item, nullptr, hashed_structs)) {
+          success = false;
+          break;
+        }
+      }
+      RNA_PROP_END;
+      return success;
+    }
+  }
+  return true;
+}
+
+/**
+ * Hash the values of the RNA properties of a struct.
+ * \param skip_base: Properties of this base type are skipped.
+ */
+static bool hash_rna_struct(XXH3_state_t *state,
+                            PointerRNA &ptr,
+                            StructRNA *skip_base,
+                            Set<const void *> &hashed_structs)
+{
+  if (!hashed_structs.add(ptr.data)) {
+    return true;
+  }
+  bool success = true;
+  RNA_STRUCT_BEGIN_SKIP_RNA_TYPE (&ptr, prop) {
+    const char *identifier = RNA_property_identifier(prop);
+    if (skip_base && RNA_struct_type_find_property(skip_base, identifier)) {
+      continue;
+    }
+    XXH3_64bits_update(state, identifier, strlen(identifier));
+    if (!hash_rna_property(state, ptr, prop, hashed_structs)) {
+      success = false;
+      break;
+    }
+  }
+  RNA_STRUCT_END;
+  return success;
+}
+
+/**
+ * Whether the operations of the node read scene data that isn't part of the execution context,
+ * like the camera read by the Defocus node.
+ */
+static bool node_uses_scene_data(const bNode &node)
+{
+  return ELEM(node.type,
+              CMP_NODE_DEFOCUS,
+              CMP_NODE_SCENE_TIME,
+              CMP_NODE_CRYPTOMATTE,
+              CMP_NODE_CRYPTOMATTE_LEGACY);
+}
+
+/**
+ * Hash the node settings that operations are created from, used to identify operation results
+ * across executions, see #OperationCache. Returns none for nodes using data outside of the node
+ * tree, like images, movie clips or the scene camera, which may change without the node changing.
+ */
+static std::optional<uint64_t> hash_node_settings(const bNodeTree &tree, const bNode &node)
+{
+  if (node.id != nullptr || node_uses_scene_data(node)) {
+    return std::nullopt;
+  }
+
+  XXH3_state_t *state = XXH3_createState();
+  XXH3_64bits_reset(state);
+  XXH3_64bits_update(state, &node.type, sizeof(node.type));
+  XXH3_64bits_update(state, &node.custom1, sizeof(node.custom1));
+  XXH3_64bits_update(state, &node.custom2, sizeof(node.custom2));
+  XXH3_64bits_update(state, &node.custom3, sizeof(node.custom3));
+  XXH3_64bits_update(state, &node.custom4, sizeof(node.custom4));
+
+  /* The settings of the node type, e.g. the values in #bNode::storage. Properties of all nodes
+   * like the name, location and sockets don't affect the result or are hashed separately. */
+  ID *tree_id = const_cast<ID *>(&tree.id);
+  Set<const void *> hashed_structs;
+  PointerRNA node_ptr = RNA_pointer_create(tree_id, &RNA_Node, const_cast<bNode *>(&node));
+  bool success = hash_rna_struct(state, node_ptr, &RNA_Node, hashed_structs);
+
+  /* Values of unlinked inputs are usually added as constant operations, but some nodes read them
+   * directly, as well as values stored in outputs like the ones of the RGB and Value nodes. */
+  for (const ListBase *sockets : {&node.inputs, &node.outputs}) {
+    LISTBASE_FOREACH (bNodeSocket *, socket, sockets) {
+      PointerRNA socket_ptr = RNA_pointer_create(tree_id, &RNA_NodeSocket, socket);
+      if (PropertyRNA *prop = RNA_struct_find_property(&socket_ptr, "default_value")) {
+        success &= hash_rna_property(state, socket_ptr, prop, hashed_structs);
+      }
+    }
+  }
+
+  const uint64_t hash = XXH3_64bits_digest(state);
+  XXH3_freeState(state);
+  if (!success) {
+    return std::nullopt;
+  }
+  return hash;
+}
+
 void NodeOperationBuilder::convert_to_operations(ExecutionSystem *system)
 {
   /* interface handle for nodes */
@@ -37,6 +262,8 @@ void NodeOperationBuilder::convert_to_operations(ExecutionSystem *system)
 
   for (Node *node : graph_.nodes()) {
     current_node_ = node;
+    current_node_hash_ = hash_node_settings(*node->get_bnodetree(), *node->get_bnode());
+    current_node_operations_num_ = 0;
 
     DebugInfo::node_to_operations(node);
     node->convert_to_operations(converter, *context_);
@@ -110,6 +337,15 @@ void NodeOperationBuilder::add_operation(NodeOperation *operation)
   if (current_node_) {
     operation->set_name(current_node_->get_bnode()->name);
     operation->set_node_instance_key(current_node_->get_instance_key());
+    /* Operations of a node are told apart by their order, which only depends on the node. */
+    if (current_node_hash_) {
+      operation->set_node_hash(BLI_ghashutil_combine_hash(*current_node_hash_,
+                                                          current_node_operations_num_));
+    }
+    else {
+      operation->set_node_hash(std::nullopt);
+    }
+    current_node_operations_num_++;
   }
   operation->set_execution_system(exec_system_);
 }
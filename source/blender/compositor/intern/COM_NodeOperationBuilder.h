@@ -60,6 +60,10 @@ class NodeOperationBuilder {
   Map<NodeOutput *, NodeOperationOutput *> output_map_;
 
   Node *current_node_;
+  /** Hash of the settings of #current_node_, none if they don't identify its result. */
+  std::optional<uint64_t> current_node_hash_;
+  /** Number of operations added by #current_node_. */
+  int current_node_operations_num_;
 
   /**
    * Operation that will be writing to the viewer image
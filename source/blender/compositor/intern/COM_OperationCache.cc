@@ -0,0 +1,167 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include <xxhash.h>
+
+#include "BLI_array.hh"
+#include "BLI_rect.h"
+#include "BLI_task.hh"
+
+#include "COM_MemoryBuffer.h"
+#include "COM_OperationCache.h"
+
+namespace blender::compositor {
+
+static std::unique_ptr<MemoryBuffer> create_view(MemoryBuffer &buffer)
+{
+  return std::make_unique<MemoryBuffer>(buffer.get_buffer(),
+                                        buffer.get_num_channels(),
+                                        buffer.get_rect(),
+                                        buffer.is_a_single_elem());
+}
+
+static bool areas_contain(Span<rcti> areas, Span<rcti> other_areas)
+{
+  for (const rcti &other : other_areas) {
+    if (BLI_rcti_is_empty(&other)) {
+      continue;
+    }
+    bool is_contained = false;
+    for (const rcti &area : areas) {
+      if (BLI_rcti_inside_rcti(&area, &other)) {
+        is_contained = true;
+        break;
+      }
+    }
+    if (!is_contained) {
+      return false;
+    }
+  }
+  return true;
+}
+
+OperationCache::OperationCache() = default;
+
+OperationCache::~OperationCache()
+{
+  clear();
+}
+
+void OperationCache::begin_execution()
+{
+  execution_++;
+}
+
+void OperationCache::end_execution(const int64_t memory_budget)
+{
+  if (memory_used_ <= memory_budget) {
+    return;
+  }
+
+  /* Evict least recently used entries first, and of the ones used at the same time, the ones that
+   * are the cheapest to render again for their size. */
+  Vector<std::pair<uint64_t, const Entry *>> candidates;
+  for (const auto item : entries_.items()) {
+    candidates.append({item.key, &item.value});
+  }
+  std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+    if (a.second->last_used != b.second->last_used) {
+      return a.second->last_used < b.second->last_used;
+    }
+    return a.second->render_time / a.second->memory_size <
+           b.second->render_time / b.second->memory_size;
+  });
+
+  for (const auto &candidate : candidates) {
+    if (memory_used_ <= memory_budget) {
+      break;
+    }
+    remove(candidate.first);
+  }
+}
+
+std::unique_ptr<MemoryBuffer> OperationCache::lookup(const uint64_t key, Span<rcti> areas)
+{
+  Entry *entry = entries_.lookup_ptr(key);
+  if (entry == nullptr || !areas_contain(entry->areas, areas)) {
+    return nullptr;
+  }
+  entry->last_used = execution_;
+  return create_view(*entry->buffer);
+}
+
+std::unique_ptr<MemoryBuffer> OperationCache::store(const uint64_t key,
+                                                    std::unique_ptr<MemoryBuffer> buffer,
+                                                    Span<rcti> areas,
+                                                    const double render_time)
+{
+  if (buffer == nullptr || buffer->is_a_single_elem()) {
+    return buffer;
+  }
+
+  if (const Entry *entry = entries_.lookup_ptr(key)) {
+    /* An equal result with other areas may still be read in this execution. */
+    if (entry->last_used == execution_) {
+      return buffer;
+    }
+    remove(key);
+  }
+
+  std::unique_ptr<MemoryBuffer> view = create_view(*buffer);
+  Entry entry;
+  entry.memory_size = buffer->get_memory_size();
+  entry.buffer = std::move(buffer);
+  entry.areas = areas;
+  entry.render_time = render_time;
+  entry.last_used = execution_;
+  memory_used_ += entry.memory_size;
+  entries_.add_new(key, std::move(entry));
+  return view;
+}
+
+void OperationCache::remove(const uint64_t key)
+{
+  memory_used_ -= entries_.lookup(key).memory_size;
+  entries_.remove(key);
+}
+
+void OperationCache::clear()
+{
+  entries_.clear();
+  memory_used_ = 0;
+}
+
+uint64_t OperationCache::hash_buffer(MemoryBuffer &buffer, Span<rcti> areas)
+{
+  const int num_channels = buffer.get_num_channels();
+  if (buffer.is_a_single_elem()) {
+    return XXH3_64bits(buffer.get_buffer(), num_channels * sizeof(float));
+  }
+
+  /* Rows are hashed in parallel, the result is the hash of the row hashes and the buffer layout.
+   * Only the rendered areas are hashed, the rest of the buffer is not initialized. */
+  Vector<uint64_t> hashes;
+  hashes.append(num_channels);
+  hashes.append(uint64_t(buffer.get_width()) << 32 | uint64_t(buffer.get_height()));
+  for (const rcti &area : areas) {
+    const int width = BLI_rcti_size_x(&area);
+    const int height = BLI_rcti_size_y(&area);
+    if (width <= 0 || height <= 0) {
+      continue;
+    }
+    Array<uint64_t> row_hashes(height);
+    threading::parallel_for(IndexRange(height), 64, [&](const IndexRange rows) {
+      for (const int64_t y : rows) {
+        const float *row = buffer.get_buffer() +
+                           buffer.get_coords_offset(area.xmin, area.ymin + int(y));
+        row_hashes[y] = XXH3_64bits(row, size_t(width) * num_channels * sizeof(float));
+      }
+    });
+    hashes.append(uint64_t(area.xmin) << 32 | uint64_t(uint32_t(area.ymin)));
+    hashes.extend(row_hashes.as_span());
+  }
+  return XXH3_64bits(hashes.data(), hashes.size() * sizeof(uint64_t));
+}
+
+}  // namespace blender::compositor
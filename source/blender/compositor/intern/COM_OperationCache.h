@@ -0,0 +1,104 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+#include <memory>
+
+#include "BLI_map.hh"
+#include "BLI_span.hh"
+#include "BLI_vector.hh"
+
+#include "DNA_vec_types.h"
+
+#ifdef WITH_CXX_GUARDEDALLOC
+#  include "MEM_guardedalloc.h"
+#endif
+
+namespace blender::compositor {
+
+class MemoryBuffer;
+
+/**
+ * Keeps rendered operation buffers across compositor executions, so that interactive edits only
+ * render the operations whose result changed.
+ *
+ * Buffers are identified by a key that hashes everything the result depends on: the operation
+ * type, its canvas, the settings of the node it was created from and the keys of its inputs, see
+ * #FullFrameExecutionModel. Results that depend on data outside of the node tree, like images and
+ * render results, are identified by the hash of their rendered pixels instead. So entries never
+ * need to be invalidated, outdated entries are not used anymore and get evicted once the memory
+ * budget is exceeded.
+ */
+class OperationCache {
+ private:
+  struct Entry {
+    /** Buffer owned by the cache, rendered operations only get a view of it. */
+    std::unique_ptr<MemoryBuffer> buffer;
+    /** Areas of the buffer that were rendered, in buffer coordinates. */
+    Vector<rcti> areas;
+    int64_t memory_size;
+    /** Time it took to render the buffer, cheaper entries are evicted first. */
+    double render_time;
+    /** Execution that used the entry last, entries used in the current one are never evicted. */
+    int64_t last_used;
+  };
+  Map<uint64_t, Entry> entries_;
+
+  int64_t memory_used_ = 0;
+  int64_t execution_ = 0;
+
+ public:
+  OperationCache();
+  ~OperationCache();
+
+  /**
+   * Starts a new compositor execution, entries used during it are kept until it ends.
+   */
+  void begin_execution();
+  /**
+   * Evicts least recently used entries until the stored buffers fit in the given budget.
+   */
+  void end_execution(int64_t memory_budget);
+
+  /**
+   * Get a view of the cached buffer with the given key, or null if there is none or if it is
+   * missing any of the given areas.
+   */
+  std::unique_ptr<MemoryBuffer> lookup(uint64_t key, Span<rcti> areas);
+  /**
+   * Take ownership of a rendered buffer, returning a view of it to be used in its place. Buffers
+   * that can't be stored are returned unchanged.
+   */
+  std::unique_ptr<MemoryBuffer> store(uint64_t key,
+                                      std::unique_ptr<MemoryBuffer> buffer,
+                                      Span<rcti> areas,
+                                      double render_time);
+
+  void clear();
+
+  int64_t get_memory_used() const
+  {
+    return memory_used_;
+  }
+  int64_t size() const
+  {
+    return entries_.size();
+  }
+
+  /**
+   * Hash the pixels of the given areas of a buffer, used as key for results that can't be
+   * identified by their operation settings.
+   */
+  static uint64_t hash_buffer(MemoryBuffer &buffer, Span<rcti> areas);
+
+ private:
+  void remove(uint64_t key);
+
+#ifdef WITH_CXX_GUARDEDALLOC
+  MEM_CXX_CLASS_ALLOC_FUNCS("COM:OperationCache")
+#endif
+};
+
+}  // namespace blender::compositor
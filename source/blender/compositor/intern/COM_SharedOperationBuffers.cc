@@ -7,6 +7,11 @@
 
 namespace blender::compositor {
 
+static int64_t buffer_memory_size(const MemoryBuffer *buffer)
+{
+  return buffer ? buffer->get_memory_size() : 0;
+}
+
 SharedOperationBuffers::BufferData::BufferData()
     : buffer(nullptr), registered_reads(0), received_reads(0), is_rendered(false)
 {
@@ -46,6 +51,24 @@ void SharedOperationBuffers::register_read(NodeOperation *read_op)
   get_buffer_data(read_op).registered_reads++;
 }
 
+int SharedOperationBuffers::unregister_read(NodeOperation *read_op)
+{
+  BufferData &buf_data = get_buffer_data(read_op);
+  BLI_assert(buf_data.registered_reads > buf_data.received_reads);
+  buf_data.registered_reads--;
+  if (buf_data.is_rendered && buf_data.received_reads == buf_data.registered_reads) {
+    /* Dispose buffer. */
+    memory_used_ -= buffer_memory_size(buf_data.buffer.get());
+    buf_data.buffer = nullptr;
+  }
+  return buf_data.registered_reads;
+}
+
+int SharedOperationBuffers::get_registered_reads_num(NodeOperation *op)
+{
+  return get_buffer_data(op).registered_reads;
+}
+
 Vector<rcti> SharedOperationBuffers::get_areas_to_render(NodeOperation *op,
                                                          const int offset_x,
                                                          const int offset_y)
@@ -72,6 +95,9 @@ void SharedOperationBuffers::set_rendered_buffer(NodeOperation *op,
   BLI_assert(buf_data.buffer == nullptr);
   buf_data.buffer = std::move(buffer);
   buf_data.is_rendered = true;
+
+  memory_used_ += buffer_memory_size(buf_data.buffer.get());
+  memory_peak_ = std::max(memory_peak_, memory_used_);
 }
 
 MemoryBuffer *SharedOperationBuffers::get_rendered_buffer(NodeOperation *op)
@@ -87,8 +113,14 @@ void SharedOperationBuffers::read_finished(NodeOperation *read_op)
   BLI_assert(buf_data.received_reads > 0 && buf_data.received_reads <= buf_data.registered_reads);
   if (buf_data.received_reads == buf_data.registered_reads) {
     /* Dispose buffer. */
+    memory_used_ -= buffer_memory_size(buf_data.buffer.get());
     buf_data.buffer = nullptr;
   }
 }
 
+void SharedOperationBuffers::register_temporary_memory(const int64_t bytes)
+{
+  memory_peak_ = std::max(memory_peak_, memory_used_ + bytes);
+}
+
 }  // namespace blender::compositor
@@ -35,6 +35,11 @@ class SharedOperationBuffers {
   } BufferData;
   blender::Map<NodeOperation *, BufferData> buffers_;
 
+  /** Size in bytes of the stored buffers. */
+  int64_t memory_used_ = 0;
+  /** Largest #memory_used_ plus temporary memory during the execution. */
+  int64_t memory_peak_ = 0;
+
  public:
   /**
    * Whether given operation area to render is already registered.
@@ -54,6 +59,15 @@ class SharedOperationBuffers {
    * Registers an operation read (other operation depends on given operation).
    */
   void register_read(NodeOperation *read_op);
+  /**
+   * Removes a registered read of an operation that won't read given operation anymore, because
+   * its buffer was taken from the #OperationCache. Returns the number of reads left.
+   */
+  int unregister_read(NodeOperation *read_op);
+  /**
+   * Number of registered reads of given operation.
+   */
+  int get_registered_reads_num(NodeOperation *op);
 
   /**
    * Get registered areas given operation needs to render.
@@ -78,6 +92,19 @@ class SharedOperationBuffers {
    */
   void read_finished(NodeOperation *read_op);
 
+  /**
+   * Account memory allocated outside of the stored buffers, alive in addition to them, for the
+   * memory peak.
+   */
+  void register_temporary_memory(int64_t bytes);
+  /**
+   * Peak memory in bytes of all stored buffers and registered temporary memory.
+   */
+  int64_t get_memory_peak() const
+  {
+    return memory_peak_;
+  }
+
  private:
   BufferData &get_buffer_data(NodeOperation *op);
 
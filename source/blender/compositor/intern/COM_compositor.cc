@@ -10,7 +10,10 @@
 #include "BKE_node_runtime.hh"
 #include "BKE_scene.hh"
 
+#include "DNA_userdef_types.h"
+
 #include "COM_ExecutionSystem.h"
+#include "COM_OperationCache.h"
 #include "COM_WorkScheduler.h"
 #include "COM_compositor.hh"
 
@@ -19,6 +22,8 @@
 static struct {
   bool is_initialized = false;
   ThreadMutex mutex;
+  /** Operation buffers kept between executions of the CPU compositor. */
+  std::unique_ptr<blender::compositor::OperationCache> operation_cache;
 } g_compositor;
 
 /* Make sure node tree has previews.
@@ -88,10 +93,26 @@ void COM_execute(Render *render,
     /* Initialize workscheduler. */
     blender::compositor::WorkScheduler::initialize(BKE_render_num_threads(render_data));
 
+    /* Interactive edits mostly change a few nodes, keep buffers to only render what changed. */
+    if (USER_EXPERIMENTAL_TEST(&U, use_compositor_cache)) {
+      if (!g_compositor.operation_cache) {
+        g_compositor.operation_cache = std::make_unique<blender::compositor::OperationCache>();
+      }
+    }
+    else {
+      g_compositor.operation_cache.reset();
+    }
+
     /* Execute. */
     const bool is_rendering = render_context != nullptr;
-    blender::compositor::ExecutionSystem system(
-        render_data, scene, node_tree, is_rendering, view_name, render_context, profiler);
+    blender::compositor::ExecutionSystem system(render_data,
+                                                scene,
+                                                node_tree,
+                                                is_rendering,
+                                                view_name,
+                                                render_context,
+                                                profiler,
+                                                g_compositor.operation_cache.get());
     system.execute();
   }
 
@@ -103,6 +124,7 @@ void COM_deinitialize()
   if (g_compositor.is_initialized) {
     BLI_mutex_lock(&g_compositor.mutex);
     blender::compositor::WorkScheduler::deinitialize();
+    g_compositor.operation_cache.reset();
     g_compositor.is_initialized = false;
     BLI_mutex_unlock(&g_compositor.mutex);
     BLI_mutex_end(&g_compositor.mutex);
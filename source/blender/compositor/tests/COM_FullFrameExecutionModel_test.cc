@@ -0,0 +1,92 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "COM_ConvertOperation.h"
+#include "COM_FullFrameExecutionModel.h"
+#include "COM_MathBaseOperation.h"
+#include "COM_MixOperation.h"
+
+namespace blender::compositor::tests {
+
+static void fill_gradient(MemoryBuffer &buffer, const float scale)
+{
+  const rcti &rect = buffer.get_rect();
+  for (int y = rect.ymin; y < rect.ymax; y++) {
+    for (int x = rect.xmin; x < rect.xmax; x++) {
+      float *elem = buffer.get_elem(x, y);
+      for (int channel = 0; channel < buffer.get_num_channels(); channel++) {
+        elem[channel] = scale * float(x * 3 + y * 7 + channel) / 100.0f;
+      }
+    }
+  }
+}
+
+static void link(NodeOperation &from, NodeOperation &to, const int input_index)
+{
+  to.get_input_socket(input_index)->set_link(from.get_output_socket());
+}
+
+/* Tiled rendering of a group of pixel local operations gives the same result as rendering every
+ * operation to a full buffer. */
+TEST(FullFrameExecutionModel, TiledGroupMatchesFullFrame)
+{
+  /* Not a multiple of the tile size, so there are partial tiles. */
+  const rcti canvas = {0, 301, 0, 23};
+  /* Areas with an offset, as when a render border is used. */
+  const Vector<rcti> areas = {{5, 290, 2, 15}, {5, 290, 15, 21}};
+
+  MathMultiplyOperation multiply;
+  ConvertValueToColorOperation convert;
+  MixAddOperation mix;
+  link(multiply, convert, 0);
+  link(convert, mix, 1);
+  for (NodeOperation *op : Span<NodeOperation *>{&multiply, &convert, &mix}) {
+    op->set_canvas(canvas);
+  }
+
+  MemoryBuffer value_a(DataType::Value, canvas);
+  MemoryBuffer value_b(DataType::Value, canvas);
+  MemoryBuffer value_unused(DataType::Value, canvas);
+  MemoryBuffer factor(DataType::Value, canvas);
+  MemoryBuffer color(DataType::Color, canvas);
+  fill_gradient(value_a, 1.0f);
+  fill_gradient(value_b, -0.5f);
+  value_unused.clear();
+  fill_gradient(factor, 0.1f);
+  fill_gradient(color, 2.0f);
+
+  /* Reference: every operation renders to a full buffer. */
+  MemoryBuffer multiply_full(DataType::Value, canvas);
+  MemoryBuffer convert_full(DataType::Color, canvas);
+  MemoryBuffer expected(DataType::Color, canvas);
+  expected.clear();
+  for (const rcti &area : areas) {
+    multiply.render_tile(&multiply_full, area, {&value_a, &value_b, &value_unused});
+    convert.render_tile(&convert_full, area, {&multiply_full});
+    mix.render_tile(&expected, area, {&factor, &convert_full, &color});
+  }
+
+  /* Small tiles, so that every area is split in multiple tiles. */
+  MemoryBuffer result(DataType::Color, canvas);
+  result.clear();
+  const Vector<NodeOperation *> group = {&multiply, &convert, &mix};
+  const Vector<Vector<MemoryBuffer *>> inputs_bufs = {
+      {&value_a, &value_b, &value_unused}, {nullptr}, {&factor, nullptr, &color}};
+  const int64_t tiles_memory = FullFrameExecutionModel::render_group_tiles(
+      group, inputs_bufs, &result, areas, 1024, []() { return false; });
+  EXPECT_GT(tiles_memory, 0);
+
+  for (int y = canvas.ymin; y < canvas.ymax; y++) {
+    for (int x = canvas.xmin; x < canvas.xmax; x++) {
+      for (int channel = 0; channel < 4; channel++) {
+        ASSERT_EQ(result.get_elem(x, y)[channel], expected.get_elem(x, y)[channel])
+            << "x=" << x << " y=" << y << " channel=" << channel;
+      }
+    }
+  }
+}
+
+}  // namespace blender::compositor::tests
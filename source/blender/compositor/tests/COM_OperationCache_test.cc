@@ -0,0 +1,111 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "COM_MemoryBuffer.h"
+#include "COM_OperationCache.h"
+
+namespace blender::compositor::tests {
+
+static constexpr int64_t BUFFER_SIZE = 8 * 8 * 4 * sizeof(float);
+
+static rcti create_rect(int xmin, int xmax, int ymin, int ymax)
+{
+  rcti rect;
+  BLI_rcti_init(&rect, xmin, xmax, ymin, ymax);
+  return rect;
+}
+
+static std::unique_ptr<MemoryBuffer> create_buffer(const float value)
+{
+  std::unique_ptr<MemoryBuffer> buffer = std::make_unique<MemoryBuffer>(
+      DataType::Color, create_rect(0, 8, 0, 8));
+  const float color[4] = {value, value, value, 1.0f};
+  buffer->fill(buffer->get_rect(), color);
+  return buffer;
+}
+
+TEST(OperationCache, StoreAndLookup)
+{
+  OperationCache cache;
+  const rcti full = create_rect(0, 8, 0, 8);
+  const rcti half = create_rect(0, 8, 0, 4);
+
+  cache.begin_execution();
+  std::unique_ptr<MemoryBuffer> buffer = create_buffer(0.5f);
+  const float *data = buffer->get_buffer();
+  std::unique_ptr<MemoryBuffer> view = cache.store(1, std::move(buffer), {half}, 1.0);
+  /* The cache owns the data, the returned buffer is a view of it. */
+  EXPECT_EQ(view->get_buffer(), data);
+  EXPECT_EQ(cache.get_memory_used(), BUFFER_SIZE);
+  view.reset();
+  cache.end_execution(BUFFER_SIZE);
+
+  cache.begin_execution();
+  EXPECT_EQ(cache.lookup(2, {half}), nullptr);
+  /* Areas that were not rendered can't be taken from the cache. */
+  EXPECT_EQ(cache.lookup(1, {full}), nullptr);
+  std::unique_ptr<MemoryBuffer> cached = cache.lookup(1, {create_rect(2, 6, 1, 3)});
+  ASSERT_NE(cached, nullptr);
+  EXPECT_EQ(cached->get_buffer(), data);
+  EXPECT_EQ(*cached->get_elem(3, 2), 0.5f);
+  cached.reset();
+  cache.end_execution(BUFFER_SIZE);
+}
+
+TEST(OperationCache, Eviction)
+{
+  OperationCache cache;
+  const rcti full = create_rect(0, 8, 0, 8);
+
+  cache.begin_execution();
+  cache.store(1, create_buffer(1.0f), {full}, 1.0);
+  cache.end_execution(BUFFER_SIZE * 2);
+
+  cache.begin_execution();
+  cache.store(2, create_buffer(2.0f), {full}, 1.0);
+  cache.store(3, create_buffer(3.0f), {full}, 5.0);
+  EXPECT_EQ(cache.size(), 3);
+  /* Entries used in the execution are not evicted until it ends. */
+  EXPECT_EQ(cache.get_memory_used(), BUFFER_SIZE * 3);
+  cache.end_execution(BUFFER_SIZE * 2);
+
+  /* The least recently used entry is evicted first. */
+  EXPECT_EQ(cache.size(), 2);
+  cache.begin_execution();
+  EXPECT_EQ(cache.lookup(1, {full}), nullptr);
+  EXPECT_NE(cache.lookup(2, {full}), nullptr);
+  EXPECT_NE(cache.lookup(3, {full}), nullptr);
+  cache.end_execution(BUFFER_SIZE);
+
+  /* Of entries used at the same time, the cheapest to render is evicted first. */
+  EXPECT_EQ(cache.size(), 1);
+  cache.begin_execution();
+  EXPECT_NE(cache.lookup(3, {full}), nullptr);
+  cache.end_execution(0);
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(cache.get_memory_used(), 0);
+}
+
+TEST(OperationCache, HashBuffer)
+{
+  const rcti full = create_rect(0, 8, 0, 8);
+  const rcti half = create_rect(0, 8, 0, 4);
+
+  std::unique_ptr<MemoryBuffer> a = create_buffer(0.5f);
+  std::unique_ptr<MemoryBuffer> b = create_buffer(0.5f);
+  EXPECT_EQ(OperationCache::hash_buffer(*a, {full}), OperationCache::hash_buffer(*b, {full}));
+
+  /* Pixels outside of the rendered areas are ignored. */
+  const float color[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+  b->fill(create_rect(0, 8, 4, 8), color);
+  EXPECT_EQ(OperationCache::hash_buffer(*a, {half}), OperationCache::hash_buffer(*b, {half}));
+  EXPECT_NE(OperationCache::hash_buffer(*a, {full}), OperationCache::hash_buffer(*b, {full}));
+
+  b->get_elem(7, 0)[2] = 0.25f;
+  EXPECT_NE(OperationCache::hash_buffer(*a, {half}), OperationCache::hash_buffer(*b, {half}));
+}
+
+}  // namespace blender::compositor::tests
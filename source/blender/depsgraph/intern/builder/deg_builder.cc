@@ -17,11 +17,14 @@
 #include "DNA_modifier_types.h"
 #include "DNA_object_types.h"
 
+#include "BLI_array.hh"
 #include "BLI_stack.h"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
 
 #include "BKE_action.h"
 #include "BKE_collection.hh"
+#include "BKE_global.hh"
 #include "BKE_lib_id.hh"
 
 #include "RNA_prototypes.h"
@@ -182,8 +185,10 @@ void deg_graph_build_finalize(Main *bmain, Depsgraph *graph)
   deg_graph_remove_unused_noops(graph);
 
   /* Re-tag IDs for update if it was tagged before the relations
-   * update tag. */
-  for (IDNode *id_node : graph->id_nodes) {
+   * update tag. The flags only depend on the ID itself, so they are computed in parallel, while
+   * tagging modifies the graph and happens afterwards. */
+  Array<int> id_flags(graph->id_nodes.size());
+  deg_foreach_id_node_parallel(graph, [&](const int64_t id_node_index, IDNode *id_node) {
     const ID_Type id_type = id_node->id_type;
     ID *id_orig = id_node->id_orig;
     id_node->finalize_build(graph);
@@ -209,13 +214,7 @@ void deg_graph_build_finalize(Main *bmain, Depsgraph *graph)
       }
     }
     else {
-      if (id_type == ID_GR) {
-        /* Collection content might have changed (children collection might have been added or
-         * removed from the graph based on their inclusion and visibility flags). */
-        BKE_collection_object_cache_free(
-            nullptr, reinterpret_cast<Collection *>(id_node->id_cow), LIB_ID_CREATE_NO_DEG_TAG);
-      }
-      else if (id_type == ID_SCE) {
+      if (id_type == ID_SCE) {
         /* During undo the sequence strips might obtain a new session ID, which will disallow the
          * audio handles to be re-used. Tag for the audio and sequence update to ensure the audio
          * handles are open.
@@ -238,12 +237,35 @@ void deg_graph_build_finalize(Main *bmain, Depsgraph *graph)
     if (graph->is_active || !is_expanded) {
       flag |= id_orig->recalc;
     }
-    if (flag != 0) {
-      graph_id_tag_update(bmain, graph, id_node->id_orig, flag, DEG_UPDATE_SOURCE_RELATIONS);
+    id_flags[id_node_index] = flag;
+  });
+
+  for (const int64_t i : graph->id_nodes.index_range()) {
+    IDNode *id_node = graph->id_nodes[i];
+    if (id_node->id_type == ID_GR && deg_eval_copy_is_expanded(id_node->id_cow)) {
+      /* Collection content might have changed (children collection might have been added or
+       * removed from the graph based on their inclusion and visibility flags). */
+      BKE_collection_object_cache_free(
+          nullptr, reinterpret_cast<Collection *>(id_node->id_cow), LIB_ID_CREATE_NO_DEG_TAG);
+    }
+    if (id_flags[i] != 0) {
+      graph_id_tag_update(bmain, graph, id_node->id_orig, id_flags[i], DEG_UPDATE_SOURCE_RELATIONS);
     }
   }
 }
 
+void deg_foreach_id_node_parallel(const Depsgraph *graph,
+                                  const FunctionRef<void(int64_t id_node_index, IDNode *id_node)> fn)
+{
+  const int64_t num_id_nodes = graph->id_nodes.size();
+  const int64_t grain_size = (G.debug & G_DEBUG_DEPSGRAPH_NO_THREADS) ? num_id_nodes : 256;
+  threading::parallel_for(IndexRange(num_id_nodes), grain_size, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      fn(i, graph->id_nodes[i]);
+    }
+  });
+}
+
 /** \} */
 
 }  // namespace blender::deg
@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include "BLI_function_ref.hh"
+
 struct Base;
 struct ID;
 struct Main;
@@ -20,6 +22,7 @@ struct bPoseChannel;
 namespace blender::deg {
 
 struct Depsgraph;
+struct IDNode;
 class DepsgraphBuilderCache;
 
 class DepsgraphBuilder {
@@ -57,4 +60,13 @@ bool deg_check_id_in_depsgraph(const Depsgraph *graph, ID *id_orig);
 bool deg_check_base_in_depsgraph(const Depsgraph *graph, Base *base);
 void deg_graph_build_finalize(Main *bmain, Depsgraph *graph);
 
+/**
+ * Call the function for every ID node of the graph, from multiple threads unless threading is
+ * disabled with `--debug-depsgraph-no-threads`. Used for passes of the builders which only access
+ * data of a single ID: results are stored per ID node index and applied to the graph afterwards,
+ * in the order of ID nodes, so the graph is the same as when it is built on a single thread.
+ */
+void deg_foreach_id_node_parallel(const Depsgraph *graph,
+                                  FunctionRef<void(int64_t id_node_index, IDNode *id_node)> fn);
+
 }  // namespace blender::deg
@@ -15,6 +15,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_array.hh"
 #include "BLI_blenlib.h"
 #include "BLI_span.hh"
 #include "BLI_string.h"
@@ -428,20 +429,14 @@ void DepsgraphNodeBuilder::begin_build()
  * NOTE: This is split in two, a static function and a public method of the node builder, to allow
  * the code to access the builder's data more easily. */
 
-int DepsgraphNodeBuilder::foreach_id_cow_detect_need_for_update_callback(ID *id_cow_self,
-                                                                         ID *id_pointer)
+bool DepsgraphNodeBuilder::foreach_id_cow_detect_need_for_update_callback(ID *id_pointer)
 {
   if (id_pointer->orig_id == nullptr) {
     /* `id_cow_self` uses a non-cow ID, if that ID has an evaluated copy in current depsgraph its
      * owner needs to be remapped, i.e. copy-on-eval-flushed. */
     IDNode *id_node = find_id_node(id_pointer);
     if (id_node != nullptr && id_node->id_cow != nullptr) {
-      graph_id_tag_update(bmain_,
-                          graph_,
-                          id_cow_self->orig_id,
-                          ID_RECALC_SYNC_TO_EVAL,
-                          DEG_UPDATE_SOURCE_RELATIONS);
-      return IDWALK_RET_STOP_ITER;
+      return true;
     }
   }
   else {
@@ -452,17 +447,21 @@ int DepsgraphNodeBuilder::foreach_id_cow_detect_need_for_update_callback(ID *id_
      * destruction of the builder itself). */
     IDNode *id_node = find_id_node(id_pointer->orig_id);
     if (id_node == nullptr) {
-      graph_id_tag_update(bmain_,
-                          graph_,
-                          id_cow_self->orig_id,
-                          ID_RECALC_SYNC_TO_EVAL,
-                          DEG_UPDATE_SOURCE_RELATIONS);
-      return IDWALK_RET_STOP_ITER;
+      return true;
     }
   }
-  return IDWALK_RET_NOP;
+  return false;
 }
 
+namespace {
+
+struct DetectNeedForUpdateUserData {
+  DepsgraphNodeBuilder *builder;
+  bool need_update;
+};
+
+}  // namespace
+
 static int foreach_id_cow_detect_need_for_update_callback(LibraryIDLinkCallbackData *cb_data)
 {
   ID *id = *cb_data->id_pointer;
@@ -475,10 +474,13 @@ static int foreach_id_cow_detect_need_for_update_callback(LibraryIDLinkCallbackD
     return IDWALK_RET_NOP;
   }
 
-  DepsgraphNodeBuilder *builder = static_cast<DepsgraphNodeBuilder *>(cb_data->user_data);
-  ID *id_cow_self = cb_data->self_id;
-
-  return builder->foreach_id_cow_detect_need_for_update_callback(id_cow_self, id);
+  DetectNeedForUpdateUserData *data = static_cast<DetectNeedForUpdateUserData *>(
+      cb_data->user_data);
+  if (data->builder->foreach_id_cow_detect_need_for_update_callback(id)) {
+    data->need_update = true;
+    return IDWALK_RET_STOP_ITER;
+  }
+  return IDWALK_RET_NOP;
 }
 
 void DepsgraphNodeBuilder::update_invalid_cow_pointers()
@@ -493,18 +495,21 @@ void DepsgraphNodeBuilder::update_invalid_cow_pointers()
    * some cases. This is slightly unfortunate (as it may hide issues in other parts of Blender
    * code), but cannot really be avoided currently. */
 
-  for (const IDNode *id_node : graph_->id_nodes) {
+  /* Only lookups in the graph are done while walking the ID pointers, so the IDs are checked in
+   * parallel, and tagged for update afterwards. */
+  Array<bool> id_need_update(graph_->id_nodes.size(), false);
+  deg_foreach_id_node_parallel(graph_, [&](const int64_t id_node_index, IDNode *id_node) {
     if (id_node->previously_visible_components_mask == 0) {
       /* Newly added node/ID, no need to check it. */
-      continue;
+      return;
     }
     if (ELEM(id_node->id_cow, id_node->id_orig, nullptr)) {
       /* Node/ID with no copy-on-eval data, no need to check it. */
-      continue;
+      return;
     }
     if ((id_node->id_cow->recalc & ID_RECALC_SYNC_TO_EVAL) != 0) {
       /* Node/ID already tagged for copy-on-eval flush, no need to check it. */
-      continue;
+      return;
     }
     if ((id_node->id_cow->flag & LIB_EMBEDDED_DATA) != 0) {
       /* For now, we assume embedded data are managed by their owner IDs and do not need to be
@@ -521,13 +526,25 @@ void DepsgraphNodeBuilder::update_invalid_cow_pointers()
        * completely new different pointer, and the existing copy-on-eval of the old master
        * collection in the matching deg node is therefore pointing to fully invalid (freed) memory.
        */
-      continue;
+      return;
     }
+    DetectNeedForUpdateUserData data = {this, false};
     BKE_library_foreach_ID_link(nullptr,
                                 id_node->id_cow,
                                 deg::foreach_id_cow_detect_need_for_update_callback,
-                                this,
+                                &data,
                                 IDWALK_IGNORE_EMBEDDED_ID | IDWALK_READONLY);
+    id_need_update[id_node_index] = data.need_update;
+  });
+
+  for (const int64_t i : graph_->id_nodes.index_range()) {
+    if (id_need_update[i]) {
+      graph_id_tag_update(bmain_,
+                          graph_,
+                          graph_->id_nodes[i]->id_orig,
+                          ID_RECALC_SYNC_TO_EVAL,
+                          DEG_UPDATE_SOURCE_RELATIONS);
+    }
   }
 }
 
@@ -90,10 +90,11 @@ class DepsgraphNodeBuilder : public DepsgraphBuilder {
   virtual void end_build();
 
   /**
-   * `id_cow_self` is the user of `id_pointer`,
-   * see also `LibraryIDLinkCallbackData` struct definition.
+   * Check whether the user of `id_pointer` needs to be flushed (copy-on-eval-updated), see also
+   * `LibraryIDLinkCallbackData` struct definition. Only does lookups in the graph, so it is safe
+   * to be called for different users in parallel.
    */
-  int foreach_id_cow_detect_need_for_update_callback(ID *id_cow_self, ID *id_pointer);
+  bool foreach_id_cow_detect_need_for_update_callback(ID *id_pointer);
 
   IDNode *add_id_node(ID *id);
   IDNode *find_id_node(const ID *id);
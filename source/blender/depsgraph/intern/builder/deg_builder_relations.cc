@@ -16,6 +16,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_array.hh"
 #include "BLI_blenlib.h"
 #include "BLI_span.hh"
 #include "BLI_utildefines.h"
@@ -3458,8 +3459,15 @@ void DepsgraphRelationBuilder::build_vfont(VFont *vfont)
 
 void DepsgraphRelationBuilder::build_copy_on_write_relations()
 {
-  for (IDNode *id_node : graph_->id_nodes) {
-    build_copy_on_write_relations(id_node);
+  /* Relations of an ID only depend on its own operations, so they are collected in parallel for
+   * scenes with many IDs. Adding them to the graph happens in the order of ID nodes, which keeps
+   * the resulting graph the same as when building it on a single thread. */
+  Array<Vector<PendingRelation>> id_relations(graph_->id_nodes.size());
+  deg_foreach_id_node_parallel(graph_, [&](const int64_t id_node_index, IDNode *id_node) {
+    collect_copy_on_write_relations(id_node, id_relations[id_node_index]);
+  });
+  for (const int64_t i : graph_->id_nodes.index_range()) {
+    build_copy_on_write_relations(graph_->id_nodes[i], id_relations[i]);
   }
 }
 
@@ -3500,6 +3508,14 @@ void DepsgraphRelationBuilder::build_nested_shapekey(ID *owner, Key *key)
 }
 
 void DepsgraphRelationBuilder::build_copy_on_write_relations(IDNode *id_node)
+{
+  Vector<PendingRelation> relations;
+  collect_copy_on_write_relations(id_node, relations);
+  build_copy_on_write_relations(id_node, relations);
+}
+
+void DepsgraphRelationBuilder::collect_copy_on_write_relations(
+    const IDNode *id_node, Vector<PendingRelation> &r_relations) const
 {
   ID *id_orig = id_node->id_orig;
 
@@ -3563,8 +3579,7 @@ void DepsgraphRelationBuilder::build_copy_on_write_relations(IDNode *id_node)
      * copy of ID. */
     OperationNode *op_entry = comp_node->get_entry_operation();
     if (op_entry != nullptr) {
-      Relation *rel = graph_->add_new_relation(op_cow, op_entry, "Copy-on-Eval Dependency");
-      rel->flag |= rel_flag;
+      r_relations.append({op_cow, op_entry, "Copy-on-Eval Dependency", rel_flag});
     }
     /* All dangling operations should also be executed after copy-on-evaluation. */
     for (OperationNode *op_node : comp_node->operations_map->values()) {
@@ -3572,8 +3587,7 @@ void DepsgraphRelationBuilder::build_copy_on_write_relations(IDNode *id_node)
         continue;
       }
       if (op_node->inlinks.is_empty()) {
-        Relation *rel = graph_->add_new_relation(op_cow, op_node, "Copy-on-Eval Dependency");
-        rel->flag |= rel_flag;
+        r_relations.append({op_cow, op_node, "Copy-on-Eval Dependency", rel_flag});
       }
       else {
         bool has_same_comp_dependency = false;
@@ -3588,8 +3602,7 @@ void DepsgraphRelationBuilder::build_copy_on_write_relations(IDNode *id_node)
           }
         }
         if (!has_same_comp_dependency) {
-          Relation *rel = graph_->add_new_relation(op_cow, op_node, "Copy-on-Eval Dependency");
-          rel->flag |= rel_flag;
+          r_relations.append({op_cow, op_node, "Copy-on-Eval Dependency", rel_flag});
         }
       }
     }
@@ -3601,6 +3614,22 @@ void DepsgraphRelationBuilder::build_copy_on_write_relations(IDNode *id_node)
      * evaluation step needs geometry, it will have transitive dependency
      * to Mesh copy-on-evaluation already. */
   }
+}
+
+void DepsgraphRelationBuilder::build_copy_on_write_relations(IDNode *id_node,
+                                                             Span<PendingRelation> relations)
+{
+  for (const PendingRelation &relation : relations) {
+    Relation *rel = graph_->add_new_relation(relation.from, relation.to, relation.description);
+    rel->flag |= relation.flags;
+  }
+
+  ID *id_orig = id_node->id_orig;
+  if (!deg_eval_copy_is_needed(GS(id_orig->name))) {
+    return;
+  }
+
+  OperationKey copy_on_write_key(id_orig, NodeType::COPY_ON_EVAL, OperationCode::COPY_ON_EVAL);
   /* TODO(sergey): This solves crash for now, but causes too many
    * updates potentially. */
   if (GS(id_orig->name) == ID_OB) {
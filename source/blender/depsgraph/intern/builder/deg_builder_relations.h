@@ -20,6 +20,7 @@
 #include "BLI_span.hh"
 #include "BLI_string.h"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "intern/builder/deg_builder.h"
 #include "intern/builder/deg_builder_key.h"
@@ -328,6 +329,21 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
   template<typename KeyFrom, typename KeyTo>
   bool is_same_nodetree_node_dependency(const KeyFrom &key_from, const KeyTo &key_to);
 
+  /* Relation which is collected first and added to the graph later. Allows to collect relations
+   * of different IDs from multiple threads, while keeping modifications of the graph sequential. */
+  struct PendingRelation {
+    OperationNode *from;
+    OperationNode *to;
+    const char *description;
+    int flags;
+  };
+
+  /* Collect copy-on-evaluation relations between the operations of the given ID. Only reads the
+   * graph, so it is safe to be called for different IDs in parallel. */
+  void collect_copy_on_write_relations(const IDNode *id_node,
+                                       Vector<PendingRelation> &r_relations) const;
+  void build_copy_on_write_relations(IDNode *id_node, Span<PendingRelation> relations);
+
  private:
   struct BuilderWalkUserData {
     DepsgraphRelationBuilder *builder;
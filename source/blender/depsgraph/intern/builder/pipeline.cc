@@ -6,6 +6,7 @@
 
 #include "BLI_time.h"
 
+#include "BKE_animsys.h"
 #include "BKE_global.hh"
 
 #include "DNA_scene_types.h"
@@ -90,6 +91,10 @@ void AbstractBuilderPipeline::build_step_finalize()
     abort();
   }
 #endif
+  /* Operations are new, and have no timings to schedule them by yet. */
+  deg_graph_->need_update_critical_path = true;
+  /* Animation evaluation plans may have resolved paths to data that no longer exists. */
+  BKE_animsys_eval_plans_invalidate();
   /* Relations are up to date. */
   deg_graph_->need_update_relations = false;
 }
@@ -101,6 +101,10 @@ struct Depsgraph {
   /* Indicates whether indirect effect of nodes on a directly visible ones needs to be updated. */
   bool need_update_nodes_visibility;
 
+  /* Indicates whether the critical path of operations is to be estimated after the next
+   * evaluation, regardless of how many evaluations ago it was last estimated. */
+  bool need_update_critical_path;
+
   /* Indicated whether IDs in this graph are to be tagged as if they first appear visible, with
    * an optional tag for their animation (time) update. */
   bool need_tag_id_on_graph_visibility_update;
@@ -10,12 +10,15 @@
 
 #include "intern/eval/deg_eval.h"
 
+#include <algorithm>
+
 #include "BLI_compiler_attrs.h"
 #include "BLI_function_ref.hh"
 #include "BLI_gsqueue.h"
 #include "BLI_task.h"
 #include "BLI_time.h"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BKE_global.hh"
 
@@ -47,6 +50,9 @@
 
 namespace blender::deg {
 
+/* Number of evaluations after which the critical path of operations is estimated again. */
+static constexpr int CRITICAL_PATH_UPDATE_INTERVAL = 16;
+
 namespace {
 
 struct DepsgraphEvalState;
@@ -91,14 +97,13 @@ void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_nod
 
   /* Sanity checks. */
   BLI_assert_msg(!operation_node->is_noop(), "NOOP nodes should not actually be scheduled");
-  /* Perform operation. */
+  /* Perform operation. The timing is always gathered, as it is used for scheduling. */
+  const double start_time = BLI_time_now_seconds();
+  operation_node->evaluate(depsgraph);
+  const double time = BLI_time_now_seconds() - start_time;
+  operation_node->stats.add_to_average(time);
   if (state->do_stats) {
-    const double start_time = BLI_time_now_seconds();
-    operation_node->evaluate(depsgraph);
-    operation_node->stats.current_time += BLI_time_now_seconds() - start_time;
-  }
-  else {
-    operation_node->evaluate(depsgraph);
+    operation_node->stats.current_time += time;
   }
 
   /* Clear the flag early on, allowing partial updates without re-evaluating the same node multiple
@@ -113,14 +118,26 @@ void deg_task_run_func(TaskPool *pool, void *taskdata)
   void *userdata_v = BLI_task_pool_user_data(pool);
   DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
 
-  /* Evaluate node. */
   OperationNode *operation_node = reinterpret_cast<OperationNode *>(taskdata);
-  evaluate_node(state, operation_node);
+  while (operation_node != nullptr) {
+    /* Evaluate node. */
+    evaluate_node(state, operation_node);
 
-  /* Schedule children. */
-  schedule_children(state, operation_node, [&](OperationNode *node) {
-    BLI_task_pool_push(pool, deg_task_run_func, node, false, nullptr);
-  });
+    /* Schedule children. The child with the longest critical path is evaluated next by this
+     * thread, so long chains of operations do not wait behind other tasks in the pool. */
+    OperationNode *next_operation_node = nullptr;
+    schedule_children(state, operation_node, [&](OperationNode *node) {
+      if (next_operation_node == nullptr) {
+        next_operation_node = node;
+        return;
+      }
+      if (node->critical_path_time > next_operation_node->critical_path_time) {
+        std::swap(node, next_operation_node);
+      }
+      BLI_task_pool_push(pool, deg_task_run_func, node, false, nullptr);
+    });
+    operation_node = next_operation_node;
+  }
 }
 
 bool check_operation_node_visible(const DepsgraphEvalState *state, OperationNode *op_node)
@@ -317,9 +334,16 @@ void evaluate_graph_threaded_stage(DepsgraphEvalState *state,
 
   calculate_pending_parents_if_needed(state);
 
-  schedule_graph(state, [&](OperationNode *node) {
-    BLI_task_pool_push(task_pool, deg_task_run_func, node, false, nullptr);
+  /* Start with the operations with the longest critical path, so they do not end up being the
+   * last ones to finish. */
+  Vector<OperationNode *> nodes;
+  schedule_graph(state, [&](OperationNode *node) { nodes.append(node); });
+  std::stable_sort(nodes.begin(), nodes.end(), [](const OperationNode *a, const OperationNode *b) {
+    return a->critical_path_time > b->critical_path_time;
   });
+  for (OperationNode *node : nodes) {
+    BLI_task_pool_push(task_pool, deg_task_run_func, node, false, nullptr);
+  }
   BLI_task_pool_work_and_wait(task_pool);
 }
 
@@ -457,6 +481,15 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
     deg_eval_stats_aggregate(graph);
   }
 
+  /* Estimate the critical paths for scheduling the next evaluations. Operation timings change
+   * slowly, so this is only done every few evaluations. */
+  if (graph->need_update_critical_path || state.do_stats ||
+      graph->update_count % CRITICAL_PATH_UPDATE_INTERVAL == 0)
+  {
+    deg_eval_stats_critical_path_update(graph);
+    graph->need_update_critical_path = false;
+  }
+
   /* Clear any uncleared tags. */
   deg_graph_clear_tags(graph);
   graph->is_evaluating = false;
@@ -466,6 +499,10 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
 #endif
 
   graph->debug.end_graph_evaluation();
+
+  if (state.do_stats) {
+    deg_eval_stats_critical_path_print(graph);
+  }
 }
 
 }  // namespace blender::deg
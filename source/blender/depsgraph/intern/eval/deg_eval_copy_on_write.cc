@@ -728,6 +728,11 @@ void update_id_after_copy(const Depsgraph *depsgraph,
       scene_setup_view_layers_after_remap(depsgraph, id_node, reinterpret_cast<Scene *>(id_cow));
       break;
     }
+    case ID_AC: {
+      /* Evaluation plans of the data-blocks using this action point to its old F-Curves. */
+      BKE_animsys_eval_plans_invalidate();
+      break;
+    }
     /* FIXME: This is a temporary fix to update the runtime pointers properly, see #96216. Should
      * be removed at some point. */
     case ID_GD_LEGACY: {
@@ -8,9 +8,15 @@
 
 #include "intern/eval/deg_eval_stats.h"
 
+#include <cstdio>
+
+#include "BLI_math_base.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "intern/depsgraph.hh"
+#include "intern/depsgraph_relation.hh"
 
 #include "intern/node/deg_node.hh"
 #include "intern/node/deg_node_component.hh"
@@ -39,4 +45,92 @@ void deg_eval_stats_aggregate(Depsgraph *graph)
   }
 }
 
+void deg_eval_stats_critical_path_update(Depsgraph *graph)
+{
+  /* Visit operations in reverse topological order, so the critical path of all children is known
+   * when visiting an operation. Cyclic relations are ignored, the same as the evaluation does.
+   * The number of children which are not visited yet is stored in the custom flags. */
+  Vector<OperationNode *> queue;
+  for (OperationNode *op_node : graph->operations) {
+    op_node->critical_path_time = op_node->stats.average_time;
+    op_node->custom_flags = 0;
+    for (Relation *rel : op_node->outlinks) {
+      if ((rel->flag & RELATION_FLAG_CYCLIC) == 0) {
+        op_node->custom_flags++;
+      }
+    }
+    if (op_node->custom_flags == 0) {
+      queue.append(op_node);
+    }
+  }
+
+  while (!queue.is_empty()) {
+    OperationNode *op_node = queue.pop_last();
+
+    double children_time = 0.0;
+    for (Relation *rel : op_node->outlinks) {
+      if ((rel->flag & RELATION_FLAG_CYCLIC) == 0) {
+        const OperationNode *child = (OperationNode *)rel->to;
+        children_time = max_dd(children_time, child->critical_path_time);
+      }
+    }
+    op_node->critical_path_time = op_node->stats.average_time + children_time;
+
+    for (Relation *rel : op_node->inlinks) {
+      if (rel->from->type == NodeType::OPERATION && (rel->flag & RELATION_FLAG_CYCLIC) == 0) {
+        OperationNode *parent = (OperationNode *)rel->from;
+        if (--parent->custom_flags == 0) {
+          queue.append(parent);
+        }
+      }
+    }
+  }
+}
+
+void deg_eval_stats_critical_path_print(const Depsgraph *graph)
+{
+  const OperationNode *critical_op_node = nullptr;
+  double total_time = 0.0;
+  for (const OperationNode *op_node : graph->operations) {
+    total_time += op_node->stats.average_time;
+    if (critical_op_node == nullptr ||
+        op_node->critical_path_time > critical_op_node->critical_path_time)
+    {
+      critical_op_node = op_node;
+    }
+  }
+  if (critical_op_node == nullptr) {
+    return;
+  }
+
+  /* Follow the path down to its end, to report how long it is. */
+  int num_operations = 0;
+  for (const OperationNode *op_node = critical_op_node; op_node != nullptr; num_operations++) {
+    const OperationNode *next_op_node = nullptr;
+    for (const Relation *rel : op_node->outlinks) {
+      const OperationNode *child = (const OperationNode *)rel->to;
+      if ((rel->flag & RELATION_FLAG_CYCLIC) == 0 &&
+          (next_op_node == nullptr || child->critical_path_time > next_op_node->critical_path_time))
+      {
+        next_op_node = child;
+      }
+    }
+    op_node = next_op_node;
+  }
+
+  const double critical_path_time = critical_op_node->critical_path_time;
+  printf(
+      "Depsgraph%s%s%s critical path is %f seconds over %d operations, starting at %s. "
+      "All operations take %f seconds, parallelism is %.2f on %d threads.\n",
+      graph->debug.name.empty() ? "" : " [",
+      graph->debug.name.c_str(),
+      graph->debug.name.empty() ? "" : "]",
+      critical_path_time,
+      num_operations,
+      critical_op_node->full_identifier().c_str(),
+      total_time,
+      (critical_path_time > 0.0) ? total_time / critical_path_time : 1.0,
+      BLI_system_thread_count());
+}
+
 }  // namespace blender::deg
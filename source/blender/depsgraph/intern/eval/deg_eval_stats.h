@@ -15,4 +15,11 @@ struct Depsgraph;
 /* Aggregate operation timings to overall component and ID nodes timing. */
 void deg_eval_stats_aggregate(Depsgraph *graph);
 
+/* Estimate the critical path time of every operation from the average operation timings. */
+void deg_eval_stats_critical_path_update(Depsgraph *graph);
+
+/* Print the estimated critical path of the graph, which is the lower bound of the evaluation time
+ * regardless of the number of threads, to compare against the actual evaluation time. */
+void deg_eval_stats_critical_path_print(const Depsgraph *graph);
+
 }  // namespace blender::deg
@@ -274,6 +274,7 @@ Node::Stats::Stats()
 void Node::Stats::reset()
 {
   current_time = 0.0;
+  average_time = 0.0;
 }
 
 void Node::Stats::reset_current()
@@ -281,6 +282,12 @@ void Node::Stats::reset_current()
   current_time = 0.0;
 }
 
+void Node::Stats::add_to_average(const double time)
+{
+  /* Weigh recent evaluations more, so the average follows changes in the scene. */
+  average_time = (average_time == 0.0) ? time : average_time * 0.75 + time * 0.25;
+}
+
 /*******************************************************************************
  * Node itself.
  */
@@ -166,8 +166,12 @@ struct Node {
     /* Reset counters needed for the current graph evaluation, does not
      * touch averaging accumulators. */
     void reset_current();
+    /* Accumulate the time of an evaluation of this node into the average. */
+    void add_to_average(double time);
     /* Time spent on this node during current graph evaluation. */
     double current_time;
+    /* Moving average of the time spent on this node in the graph evaluations it was part of. */
+    double average_time;
   };
   /* Relationships between nodes
    * The reason why all depsgraph nodes are descended from this type (apart
@@ -281,6 +281,11 @@ struct OperationNode : public Node {
   uint32_t num_links_pending;
   bool scheduled;
 
+  /* Estimated time from the start of this operation until all operations depending on it are
+   * evaluated, based on timings of previous evaluations. Operations with the longest remaining
+   * path are scheduled first. See #deg_eval_stats_critical_path_update. */
+  double critical_path_time;
+
   /* Identifier for the operation being performed. */
   OperationCode opcode;
   int name_tag;
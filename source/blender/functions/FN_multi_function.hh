@@ -138,6 +138,16 @@ class MultiFunction : NonCopyable, NonMovable {
   virtual ExecutionHints get_execution_hints() const;
 };
 
+/**
+ * Add the part of the parameters in \a full_params that is in \a slice_range to
+ * \a r_sliced_params. This allows calling a multi-function with a shifted mask, so that smaller
+ * intermediate arrays can be used. Only single parameters are supported.
+ */
+void add_sliced_parameters(const Signature &signature,
+                           Params &full_params,
+                           IndexRange slice_range,
+                           ParamsBuilder &r_sliced_params);
+
 inline ParamsBuilder::ParamsBuilder(const MultiFunction &fn, const IndexMask *mask)
     : ParamsBuilder(fn.signature(), *mask)
 {
@@ -10,7 +10,10 @@
  * This file contains several utilities to create multi-functions with less redundant code.
  */
 
+#include <array>
+
 #include "FN_multi_function.hh"
+#include "FN_multi_function_float_lanes.hh"
 
 namespace blender::fn::multi_function::build {
 
@@ -116,6 +119,27 @@ template<size_t... Indices> struct SomeSpanOrSingle {
   }
 };
 
+/**
+ * Base class of #ComponentWiseSimd, used to detect the preset at compile time.
+ */
+struct ComponentWiseSimdTag {};
+
+/**
+ * Same as the wrapped preset, but additionally tells the builder that the element function treats
+ * every float component independently and that it is generic, i.e. it can be called with `float`,
+ * `float3` (if that is the parameter type) and #FloatLanes arguments. All parameters must have the
+ * same type, which has to consist of floats only.
+ *
+ * When the mask is a range and all inputs are spans or single values, the function is then
+ * executed on #FloatLanes::size float components at once using explicit SIMD instructions. This
+ * does not depend on the compiler being able to auto-vectorize the element function, which often
+ * fails for functions with branches (e.g. #safe_divide) or for `float3` parameters. In all other
+ * cases the wrapped preset is used.
+ */
+template<typename FallbackPreset = AllSpanOrSingle>
+struct ComponentWiseSimd : public FallbackPreset, public ComponentWiseSimdTag {
+};
+
 }  // namespace exec_presets
 
 namespace detail {
@@ -525,6 +549,113 @@ template<typename CallFn, typename... ParamTags> class CustomMF : public MultiFu
   }
 };
 
+/**
+ * Input of #execute_component_wise_lanes. Either points to a span of floats or contains the
+ * components of a single value, repeated so that they can be loaded into #FloatLanes directly.
+ */
+struct ComponentWiseInput {
+  /** Number of floats after which the pattern of a single value repeats in #FloatLanes. */
+  static constexpr int64_t PatternSize = 3 * FloatLanes::size;
+
+  const float *span = nullptr;
+  float pattern[PatternSize];
+  FloatLanes pattern_lanes[3];
+
+  FloatLanes load(const int64_t i, const int lanes_index) const
+  {
+    if (span != nullptr) {
+      return FloatLanes::load(span + i + lanes_index * FloatLanes::size);
+    }
+    return pattern_lanes[lanes_index];
+  }
+
+  float load_scalar(const int64_t i) const
+  {
+    if (span != nullptr) {
+      return span[i];
+    }
+    return pattern[i % PatternSize];
+  }
+};
+
+/**
+ * Evaluate a component-wise #element_fn for #floats_num float components. The main loop processes
+ * #ComponentWiseInput::PatternSize floats per iteration, which is a multiple of the number of
+ * components of `float` and `float3`. Therefore, the pattern of single inputs does not have to be
+ * rotated and the remaining components can be processed as scalars.
+ */
+template<typename ElementFn, typename... Inputs>
+#if (defined(__GNUC__) && !defined(__clang__))
+[[gnu::optimize("-funroll-loops")]] [[gnu::optimize("O3")]]
+#endif
+inline void
+execute_component_wise_lanes(const ElementFn &element_fn,
+                             const int64_t floats_num,
+                             float *__restrict dst,
+                             const Inputs &...inputs)
+{
+  constexpr int64_t step = ComponentWiseInput::PatternSize;
+  int64_t i = 0;
+  for (; i + step <= floats_num; i += step) {
+    for (int lanes_index = 0; lanes_index < 3; lanes_index++) {
+      const FloatLanes result = element_fn(inputs.load(i, lanes_index)...);
+      result.store(dst + i + lanes_index * FloatLanes::size);
+    }
+  }
+  for (; i < floats_num; i++) {
+    dst[i] = element_fn(inputs.load_scalar(i)...);
+  }
+}
+
+/**
+ * Try to execute the function with #FloatLanes, see #exec_presets::ComponentWiseSimd.
+ * \return False if the mask or the inputs don't allow it, in which case nothing has been done.
+ */
+template<typename T, typename ElementFn, size_t... I>
+inline bool execute_component_wise_simd(const ElementFn &element_fn,
+                                        const IndexMask &mask,
+                                        Params params,
+                                        std::index_sequence<I...> /*indices*/)
+{
+  static_assert(std::is_trivially_copyable_v<T> && sizeof(T) % sizeof(float) == 0);
+  constexpr int64_t components_num = sizeof(T) / sizeof(float);
+  static_assert(ComponentWiseInput::PatternSize % components_num == 0);
+
+  const std::optional<IndexRange> range = mask.to_range();
+  if (!range.has_value() || range->is_empty()) {
+    return false;
+  }
+  const int64_t start = range->start() * components_num;
+
+  std::array<ComponentWiseInput, sizeof...(I)> inputs;
+  for (const int64_t input_index : IndexRange(sizeof...(I))) {
+    const CommonVArrayInfo info = params.readonly_single_input(input_index).common_info();
+    ComponentWiseInput &input = inputs[input_index];
+    if (info.type == CommonVArrayInfo::Type::Span) {
+      input.span = static_cast<const float *>(info.data) + start;
+    }
+    else if (info.type == CommonVArrayInfo::Type::Single) {
+      const float *components = static_cast<const float *>(info.data);
+      for (const int64_t i : IndexRange(ComponentWiseInput::PatternSize)) {
+        input.pattern[i] = components[i % components_num];
+      }
+      for (const int lanes_index : IndexRange(3)) {
+        input.pattern_lanes[lanes_index] = FloatLanes::load(input.pattern +
+                                                            lanes_index * FloatLanes::size);
+      }
+    }
+    else {
+      return false;
+    }
+  }
+
+  float *dst = static_cast<float *>(params.uninitialized_single_output(sizeof...(I)).data()) +
+               start;
+  execute_component_wise_lanes(
+      element_fn, range->size() * components_num, dst, std::get<I>(inputs)...);
+  return true;
+}
+
 template<typename Out, typename... In, typename ElementFn, typename ExecPreset>
 inline auto build_multi_function_with_n_inputs_one_output(const char *name,
                                                           const ElementFn element_fn,
@@ -537,7 +668,21 @@ inline auto build_multi_function_with_n_inputs_one_output(const char *name,
       [element_fn](const In &...in, Out &out) { new (&out) Out(element_fn(in...)); },
       exec_preset,
       param_tags);
-  return CustomMF(name, call_fn, param_tags);
+  if constexpr (std::is_base_of_v<exec_presets::ComponentWiseSimdTag, ExecPreset>) {
+    static_assert((std::is_same_v<In, Out> && ...),
+                  "Component-wise functions must have the same type for all parameters");
+    auto simd_call_fn = [element_fn, call_fn](const IndexMask &mask, Params params) {
+      if (!execute_component_wise_simd<Out>(
+              element_fn, mask, params, std::make_index_sequence<sizeof...(In)>()))
+      {
+        call_fn(mask, params);
+      }
+    };
+    return CustomMF(name, simd_call_fn, param_tags);
+  }
+  else {
+    return CustomMF(name, call_fn, param_tags);
+  }
 }
 
 }  // namespace detail
@@ -0,0 +1,189 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup fn
+ *
+ * A small SIMD float type that is used to evaluate component-wise multi-functions on multiple
+ * values at once. See #exec_presets::ComponentWiseSimd.
+ *
+ * The type intentionally only supports the operations that are needed by element functions which
+ * are written generically, so that the same function can be called with `float`, `float3` and
+ * #FloatLanes arguments.
+ */
+
+#include <algorithm>
+
+#include "BLI_math_base.hh"
+#include "BLI_simd.hh"
+
+namespace blender::fn::multi_function::build {
+
+/**
+ * Four floats that are processed together. When SSE2 (or its emulation on ARM) is not available,
+ * a plain array is used instead, which the compiler can usually still vectorize.
+ */
+struct FloatLanes {
+  static constexpr int64_t size = 4;
+
+#if BLI_HAVE_SSE2
+  __m128 v;
+
+  FloatLanes() = default;
+  FloatLanes(const __m128 v) : v(v) {}
+  /** Implicit, so that scalar constants can be used in generic element functions. */
+  FloatLanes(const float value) : v(_mm_set1_ps(value)) {}
+
+  static FloatLanes load(const float *ptr)
+  {
+    return _mm_loadu_ps(ptr);
+  }
+
+  void store(float *ptr) const
+  {
+    _mm_storeu_ps(ptr, v);
+  }
+
+  friend FloatLanes operator+(const FloatLanes &a, const FloatLanes &b)
+  {
+    return _mm_add_ps(a.v, b.v);
+  }
+
+  friend FloatLanes operator-(const FloatLanes &a, const FloatLanes &b)
+  {
+    return _mm_sub_ps(a.v, b.v);
+  }
+
+  friend FloatLanes operator*(const FloatLanes &a, const FloatLanes &b)
+  {
+    return _mm_mul_ps(a.v, b.v);
+  }
+
+  friend FloatLanes operator/(const FloatLanes &a, const FloatLanes &b)
+  {
+    return _mm_div_ps(a.v, b.v);
+  }
+
+  friend FloatLanes operator-(const FloatLanes &a)
+  {
+    return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f));
+  }
+#else
+  float v[4];
+
+  FloatLanes() = default;
+  FloatLanes(const float value) : v{value, value, value, value} {}
+
+  static FloatLanes load(const float *ptr)
+  {
+    FloatLanes result;
+    std::copy_n(ptr, size, result.v);
+    return result;
+  }
+
+  void store(float *ptr) const
+  {
+    std::copy_n(v, size, ptr);
+  }
+
+  template<typename Fn> static FloatLanes map(const FloatLanes &a, const FloatLanes &b, Fn fn)
+  {
+    FloatLanes result;
+    for (int i = 0; i < size; i++) {
+      result.v[i] = fn(a.v[i], b.v[i]);
+    }
+    return result;
+  }
+
+  friend FloatLanes operator+(const FloatLanes &a, const FloatLanes &b)
+  {
+    return map(a, b, [](const float a, const float b) { return a + b; });
+  }
+
+  friend FloatLanes operator-(const FloatLanes &a, const FloatLanes &b)
+  {
+    return map(a, b, [](const float a, const float b) { return a - b; });
+  }
+
+  friend FloatLanes operator*(const FloatLanes &a, const FloatLanes &b)
+  {
+    return map(a, b, [](const float a, const float b) { return a * b; });
+  }
+
+  friend FloatLanes operator/(const FloatLanes &a, const FloatLanes &b)
+  {
+    return map(a, b, [](const float a, const float b) { return a / b; });
+  }
+
+  friend FloatLanes operator-(const FloatLanes &a)
+  {
+    return map(a, a, [](const float a, const float /*b*/) { return -a; });
+  }
+#endif
+};
+
+}  // namespace blender::fn::multi_function::build
+
+namespace blender::math {
+
+/* Overloads of the generic math functions, so that element functions can use e.g. `math::min`
+ * independent of whether they are called with scalars or with #FloatLanes. */
+
+inline fn::multi_function::build::FloatLanes min(const fn::multi_function::build::FloatLanes &a,
+                                                 const fn::multi_function::build::FloatLanes &b)
+{
+#if BLI_HAVE_SSE2
+  /* The second operand is returned when a lane is NaN. Swap them to match `std::min(a, b)`,
+   * which returns `a` in that case. */
+  return _mm_min_ps(b.v, a.v);
+#else
+  return fn::multi_function::build::FloatLanes::map(
+      a, b, [](const float a, const float b) { return std::min(a, b); });
+#endif
+}
+
+inline fn::multi_function::build::FloatLanes max(const fn::multi_function::build::FloatLanes &a,
+                                                 const fn::multi_function::build::FloatLanes &b)
+{
+#if BLI_HAVE_SSE2
+  /* Swapped operands to match `std::max(a, b)` for NaN, see #min. */
+  return _mm_max_ps(b.v, a.v);
+#else
+  return fn::multi_function::build::FloatLanes::map(
+      a, b, [](const float a, const float b) { return std::max(a, b); });
+#endif
+}
+
+inline fn::multi_function::build::FloatLanes clamp(
+    const fn::multi_function::build::FloatLanes &a,
+    const fn::multi_function::build::FloatLanes &min,
+    const fn::multi_function::build::FloatLanes &max)
+{
+  return math::min(math::max(a, min), max);
+}
+
+inline fn::multi_function::build::FloatLanes safe_divide(
+    const fn::multi_function::build::FloatLanes &a, const fn::multi_function::build::FloatLanes &b)
+{
+#if BLI_HAVE_SSE2
+  /* Lanes with a zero divisor are masked to zero, matching the scalar #safe_divide. */
+  const __m128 is_nonzero = _mm_cmpneq_ps(b.v, _mm_setzero_ps());
+  return _mm_and_ps(_mm_div_ps(a.v, b.v), is_nonzero);
+#else
+  return fn::multi_function::build::FloatLanes::map(
+      a, b, [](const float a, const float b) { return math::safe_divide(a, b); });
+#endif
+}
+
+inline fn::multi_function::build::FloatLanes interpolate(
+    const fn::multi_function::build::FloatLanes &a,
+    const fn::multi_function::build::FloatLanes &b,
+    const fn::multi_function::build::FloatLanes &t)
+{
+  return a * (1.0f - t) + b * t;
+}
+
+}  // namespace blender::math
@@ -17,6 +17,12 @@ class ProcedureExecutor : public MultiFunction {
  private:
   Signature signature_;
   const Procedure &procedure_;
+  /**
+   * Large masks are split into chunks with this number of elements, which are executed one after
+   * another so that intermediate buffers stay in the CPU cache. Zero when the procedure should not
+   * be executed in chunks. See #procedure_optimization::find_fused_chunk_size.
+   */
+  int64_t chunk_size_;
 
  public:
   ProcedureExecutor(const Procedure &procedure);
@@ -46,4 +46,23 @@ namespace blender::fn::multi_function::procedure_optimization {
  */
 void move_destructs_up(Procedure &procedure, Instruction &block_end_instr);
 
+/**
+ * When a procedure is executed on many elements at once, every intermediate variable needs a
+ * buffer that is large enough for all elements. If these buffers don't fit into the CPU cache,
+ * execution becomes memory-bandwidth bound, because every called function reads its inputs from
+ * and writes its outputs to main memory. Executing the procedure on smaller chunks of elements
+ * one after another fuses the function calls, in the sense that intermediate values computed by
+ * one function are still in the cache when the next function uses them.
+ *
+ * This finds the number of elements per chunk, so that the buffers of all intermediate variables
+ * that are alive at the same time fit into \a cache_size bytes. The liveness of variables is only
+ * taken into account for a single chain of instructions (see #move_destructs_up), otherwise all
+ * variables are assumed to be alive at the same time.
+ *
+ * \return The number of elements per chunk, or zero when the procedure should not be executed in
+ * chunks. This is the case when it has no intermediate variables or when it has vector
+ * parameters, which can't be sliced.
+ */
+int64_t find_fused_chunk_size(const Procedure &procedure, int64_t cache_size);
+
 }  // namespace blender::fn::multi_function::procedure_optimization
@@ -3,6 +3,7 @@
  * SPDX-License-Identifier: GPL-2.0-or-later */
 
 #include "FN_multi_function_procedure_executor.hh"
+#include "FN_multi_function_procedure_optimization.hh"
 
 #include "BLI_stack.hh"
 
@@ -17,6 +18,10 @@ ProcedureExecutor::ProcedureExecutor(const Procedure &procedure) : procedure_(pr
   }
 
   this->set_signature(&signature_);
+
+  /* Aim for the intermediate buffers to fit into a typical per-core L2 cache. */
+  const int64_t cache_size = 256 * 1024;
+  chunk_size_ = procedure_optimization::find_fused_chunk_size(procedure, cache_size);
 }
 
 using IndicesSplitVectors = std::array<Vector<int64_t>, 2>;
@@ -148,8 +153,17 @@ class ValueAllocator : NonCopyable, NonMovable {
   Stack<void *> small_single_value_free_list_;
   Map<const CPPType *, Stack<void *>> single_value_free_lists_;
 
+  /**
+   * Number of elements in every owned span buffer. The same buffers are reused for all chunks
+   * when a procedure is executed in chunks, so they have to be large enough for every chunk.
+   */
+  int64_t span_buffer_size_;
+
  public:
-  ValueAllocator(LinearAllocator<> &linear_allocator) : linear_allocator_(linear_allocator) {}
+  ValueAllocator(LinearAllocator<> &linear_allocator, const int64_t span_buffer_size)
+      : linear_allocator_(linear_allocator), span_buffer_size_(span_buffer_size)
+  {
+  }
 
   VariableValue_GVArray *obtain_GVArray(const GVArray &varray)
   {
@@ -166,8 +180,10 @@ class ValueAllocator : NonCopyable, NonMovable {
     return this->obtain<VariableValue_Span>(buffer, false);
   }
 
-  VariableValue_Span *obtain_Span(const CPPType &type, int size)
+  VariableValue_Span *obtain_Span(const CPPType &type, const int64_t size)
   {
+    BLI_assert(size <= span_buffer_size_);
+    UNUSED_VARS_NDEBUG(size);
     void *buffer = nullptr;
 
     const int64_t element_size = type.size();
@@ -175,7 +191,7 @@ class ValueAllocator : NonCopyable, NonMovable {
 
     if (alignment > min_alignment) {
       /* In this rare case we fallback to not reusing existing buffers. */
-      buffer = linear_allocator_.allocate(element_size * size, alignment);
+      buffer = linear_allocator_.allocate(element_size * span_buffer_size_, alignment);
     }
     else {
       Stack<void *> *stack = type.can_exist_in_buffer(small_value_max_size,
@@ -184,7 +200,8 @@ class ValueAllocator : NonCopyable, NonMovable {
                                  span_buffers_free_lists_.lookup_ptr(element_size);
       if (stack == nullptr || stack->is_empty()) {
         buffer = linear_allocator_.allocate(
-            std::max<int64_t>(element_size, small_value_max_size) * size, min_alignment);
+            std::max<int64_t>(element_size, small_value_max_size) * span_buffer_size_,
+            min_alignment);
       }
       else {
         /* Reuse existing buffer. */
@@ -813,17 +830,17 @@ class VariableState : NonCopyable, NonMovable {
 /** Keeps track of the states of all variables during evaluation. */
 class VariableStates {
  private:
-  ValueAllocator value_allocator_;
+  ValueAllocator &value_allocator_;
   const Procedure &procedure_;
   /** The state of every variable, indexed by #Variable::index_in_procedure(). */
   Array<VariableState> variable_states_;
   const IndexMask &full_mask_;
 
  public:
-  VariableStates(LinearAllocator<> &linear_allocator,
+  VariableStates(ValueAllocator &value_allocator,
                  const Procedure &procedure,
                  const IndexMask &full_mask)
-      : value_allocator_(linear_allocator),
+      : value_allocator_(value_allocator),
         procedure_(procedure),
         variable_states_(procedure.variables().size()),
         full_mask_(full_mask)
@@ -1157,19 +1174,23 @@ class InstructionScheduler {
   }
 };
 
-void ProcedureExecutor::call(const IndexMask &full_mask, Params params, Context context) const
+/**
+ * Execute the procedure for all indices in the mask. Buffers for intermediate values are allocated
+ * with the given #ValueAllocator, so that they can be reused when the procedure is executed
+ * multiple times.
+ */
+static void execute_procedure(const ProcedureExecutor &fn,
+                              const Procedure &procedure,
+                              const IndexMask &full_mask,
+                              Params &params,
+                              const Context &context,
+                              ValueAllocator &value_allocator)
 {
-  BLI_assert(procedure_.validate());
-
-  AlignedBuffer<512, 64> local_buffer;
-  LinearAllocator<> linear_allocator;
-  linear_allocator.provide_buffer(local_buffer);
-
-  VariableStates variable_states{linear_allocator, procedure_, full_mask};
-  variable_states.add_initial_variable_states(*this, procedure_, params);
+  VariableStates variable_states{value_allocator, procedure, full_mask};
+  variable_states.add_initial_variable_states(fn, procedure, params);
 
   InstructionScheduler scheduler;
-  scheduler.add_referenced_indices(*procedure_.entry(), full_mask);
+  scheduler.add_referenced_indices(*procedure.entry(), full_mask);
 
   /* Loop until all indices got to a return instruction. */
   while (!scheduler.is_done()) {
@@ -1218,9 +1239,9 @@ void ProcedureExecutor::call(const IndexMask &full_mask, Params params, Context
     }
   }
 
-  for (const int param_index : this->param_indices()) {
-    const ParamType param_type = this->param_type(param_index);
-    const Variable *variable = procedure_.params()[param_index].variable;
+  for (const int param_index : fn.param_indices()) {
+    const ParamType param_type = fn.param_type(param_index);
+    const Variable *variable = procedure.params()[param_index].variable;
     VariableState &variable_state = variable_states.get_variable_state(*variable);
     switch (param_type.interface_type()) {
       case ParamType::Input: {
@@ -1241,6 +1262,43 @@ void ProcedureExecutor::call(const IndexMask &full_mask, Params params, Context
   }
 }
 
+void ProcedureExecutor::call(const IndexMask &full_mask, Params params, Context context) const
+{
+  BLI_assert(procedure_.validate());
+
+  AlignedBuffer<512, 64> local_buffer;
+  LinearAllocator<> linear_allocator;
+  linear_allocator.provide_buffer(local_buffer);
+
+  if (chunk_size_ == 0 || full_mask.is_empty() || full_mask.bounds().size() <= chunk_size_) {
+    ValueAllocator value_allocator{linear_allocator, full_mask.min_array_size()};
+    execute_procedure(*this, procedure_, full_mask, params, context, value_allocator);
+    return;
+  }
+
+  /* Execute the procedure on chunks of the index space one after another. The indices of every
+   * chunk are shifted to start at zero, so that the intermediate buffers only have to be as large
+   * as a chunk and can be reused for all chunks while they are still in the cache. */
+  const IndexRange bounds = full_mask.bounds();
+  ValueAllocator value_allocator{linear_allocator, chunk_size_};
+  for (int64_t chunk_start = bounds.start(); chunk_start < bounds.one_after_last();
+       chunk_start += chunk_size_)
+  {
+    const IndexRange chunk_range = IndexRange::from_begin_end(
+        chunk_start, std::min(chunk_start + chunk_size_, bounds.one_after_last()));
+    const IndexMask chunk_mask = full_mask.slice_content(chunk_range);
+    if (chunk_mask.is_empty()) {
+      continue;
+    }
+    IndexMaskMemory memory;
+    const IndexMask shifted_mask = chunk_mask.shift(-chunk_range.start(), memory);
+    ParamsBuilder sliced_params{*this, &shifted_mask};
+    add_sliced_parameters(signature_, params, chunk_range, sliced_params);
+    Params chunk_params{sliced_params};
+    execute_procedure(*this, procedure_, shifted_mask, chunk_params, context, value_allocator);
+  }
+}
+
 MultiFunction::ExecutionHints ProcedureExecutor::get_execution_hints() const
 {
   ExecutionHints hints;
@@ -2,6 +2,8 @@
  *
  * SPDX-License-Identifier: GPL-2.0-or-later */
 
+#include "BLI_set.hh"
+
 #include "FN_multi_function_procedure_optimization.hh"
 
 namespace blender::fn::multi_function::procedure_optimization {
@@ -74,4 +76,96 @@ void move_destructs_up(Procedure &procedure, Instruction &block_end_instr)
   }
 }
 
+static int64_t variable_size_per_element(const Variable &variable)
+{
+  const DataType data_type = variable.data_type();
+  if (data_type.is_single()) {
+    return data_type.single_type().size();
+  }
+  /* Vectors have a variable size, just take the size of a single element into account. */
+  return data_type.vector_base_type().size();
+}
+
+/**
+ * Find the maximum number of bytes per element that are used by intermediate variables at the
+ * same time.
+ */
+static int64_t find_peak_intermediate_size_per_element(const Procedure &procedure,
+                                                       const Set<const Variable *> &param_variables)
+{
+  int64_t total_size = 0;
+  for (const Variable *variable : procedure.variables()) {
+    if (!param_variables.contains(variable)) {
+      total_size += variable_size_per_element(*variable);
+    }
+  }
+
+  Set<const Variable *> alive_variables;
+  int64_t alive_size = 0;
+  int64_t peak_size = 0;
+  const Instruction *current_instr = procedure.entry();
+  while (current_instr != nullptr) {
+    switch (current_instr->type()) {
+      case InstructionType::Call: {
+        const CallInstruction &call_instr = static_cast<const CallInstruction &>(*current_instr);
+        for (const Variable *variable : call_instr.params()) {
+          if (variable == nullptr || param_variables.contains(variable)) {
+            continue;
+          }
+          if (alive_variables.add(variable)) {
+            alive_size += variable_size_per_element(*variable);
+          }
+        }
+        peak_size = std::max(peak_size, alive_size);
+        current_instr = call_instr.next();
+        break;
+      }
+      case InstructionType::Destruct: {
+        const DestructInstruction &destruct_instr = static_cast<const DestructInstruction &>(
+            *current_instr);
+        const Variable *variable = destruct_instr.variable();
+        if (alive_variables.remove(variable)) {
+          alive_size -= variable_size_per_element(*variable);
+        }
+        current_instr = destruct_instr.next();
+        break;
+      }
+      case InstructionType::Dummy: {
+        current_instr = static_cast<const DummyInstruction &>(*current_instr).next();
+        break;
+      }
+      case InstructionType::Return: {
+        return peak_size;
+      }
+      case InstructionType::Branch: {
+        /* Assume that all variables are used at the same time when there are branches. */
+        return total_size;
+      }
+    }
+  }
+  return peak_size;
+}
+
+int64_t find_fused_chunk_size(const Procedure &procedure, const int64_t cache_size)
+{
+  Set<const Variable *> param_variables;
+  for (const ConstParameter &param : procedure.params()) {
+    if (param.variable->data_type().is_vector()) {
+      return 0;
+    }
+    param_variables.add(param.variable);
+  }
+
+  const int64_t peak_size = find_peak_intermediate_size_per_element(procedure, param_variables);
+  if (peak_size == 0) {
+    return 0;
+  }
+  /* Avoid very small chunks, because then the overhead of executing the procedure for every chunk
+   * becomes significant. */
+  const int64_t min_chunk_size = 512;
+  const int64_t chunk_size = std::max(cache_size / peak_size, min_chunk_size);
+  /* Use a multiple of a larger power of two to keep chunk boundaries aligned. */
+  return chunk_size & ~int64_t(63);
+}
+
 }  // namespace blender::fn::multi_function::procedure_optimization
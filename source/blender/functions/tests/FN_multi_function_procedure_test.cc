@@ -7,6 +7,7 @@
 #include "FN_multi_function_builder.hh"
 #include "FN_multi_function_procedure_builder.hh"
 #include "FN_multi_function_procedure_executor.hh"
+#include "FN_multi_function_procedure_optimization.hh"
 #include "FN_multi_function_test_common.hh"
 
 namespace blender::fn::multi_function::tests {
@@ -423,4 +424,101 @@ TEST(multi_function_procedure, OutputBufferReplaced)
   EXPECT_EQ(output[2], output_value);
 }
 
+TEST(multi_function_procedure, FusedChunkSize)
+{
+  auto add_fn = build::SI2_SO<int, int, int>("add", [](int a, int b) { return a + b; });
+
+  {
+    /* Without intermediate variables, there is no benefit in executing in chunks. */
+    Procedure procedure;
+    ProcedureBuilder builder{procedure};
+    Variable *var_a = &builder.add_single_input_parameter<int>();
+    auto [var_out] = builder.add_call<1>(add_fn, {var_a, var_a});
+    builder.add_destruct(*var_a);
+    builder.add_return();
+    builder.add_output_parameter(*var_out);
+    EXPECT_TRUE(procedure.validate());
+
+    EXPECT_EQ(procedure_optimization::find_fused_chunk_size(procedure, 1024 * 1024), 0);
+  }
+  {
+    /* Two intermediate integers are alive at the same time at most. */
+    Procedure procedure;
+    ProcedureBuilder builder{procedure};
+    Variable *var_a = &builder.add_single_input_parameter<int>();
+    auto [var_b] = builder.add_call<1>(add_fn, {var_a, var_a});
+    auto [var_c] = builder.add_call<1>(add_fn, {var_b, var_a});
+    builder.add_destruct(*var_b);
+    auto [var_d] = builder.add_call<1>(add_fn, {var_c, var_a});
+    builder.add_destruct(*var_c);
+    auto [var_out] = builder.add_call<1>(add_fn, {var_d, var_a});
+    builder.add_destruct({var_a, var_d});
+    builder.add_return();
+    builder.add_output_parameter(*var_out);
+    EXPECT_TRUE(procedure.validate());
+
+    EXPECT_EQ(procedure_optimization::find_fused_chunk_size(procedure, 1024 * 1024),
+              1024 * 1024 / (2 * sizeof(int)));
+  }
+}
+
+TEST(multi_function_procedure, ChunkedExecution)
+{
+  /**
+   * procedure(int a, int *out) {
+   *   int b = a + a;
+   *   int c = b + a;
+   *   out = c + 1;
+   * }
+   */
+
+  auto add_fn = build::SI2_SO<int, int, int>("add", [](int a, int b) { return a + b; });
+  auto add_1_fn = build::SI1_SO<int, int>("add 1", [](int a) { return a + 1; });
+
+  Procedure procedure;
+  ProcedureBuilder builder{procedure};
+
+  Variable *var_a = &builder.add_single_input_parameter<int>();
+  auto [var_b] = builder.add_call<1>(add_fn, {var_a, var_a});
+  auto [var_c] = builder.add_call<1>(add_fn, {var_b, var_a});
+  builder.add_destruct(*var_b);
+  auto [var_out] = builder.add_call<1>(add_1_fn, {var_c});
+  builder.add_destruct({var_a, var_c});
+  builder.add_return();
+  builder.add_output_parameter(*var_out);
+
+  EXPECT_TRUE(procedure.validate());
+
+  ProcedureExecutor procedure_fn{procedure};
+
+  /* Use enough elements so that the procedure is executed in multiple chunks. */
+  const int size = 1'000'000;
+  Array<int> inputs(size);
+  for (const int i : inputs.index_range()) {
+    inputs[i] = i;
+  }
+  Array<int> results(size, -1);
+
+  IndexMaskMemory memory;
+  const IndexMask mask = IndexMask::from_predicate(
+      IndexRange(5, size - 10), GrainSize(4096), memory, [](const int64_t i) {
+        return i % 3 != 0;
+      });
+  ParamsBuilder params{procedure_fn, &mask};
+  params.add_readonly_single_input(inputs.as_span());
+  params.add_uninitialized_single_output(results.as_mutable_span());
+
+  ContextBuilder context;
+  procedure_fn.call(mask, params, context);
+
+  for (const int i : results.index_range()) {
+    if (i >= 5 && i < size - 5 && i % 3 != 0) {
+      EXPECT_EQ(results[i], 3 * i + 1);
+    }
+    else {
+      EXPECT_EQ(results[i], -1);
+    }
+  }
+}
+
 }  // namespace blender::fn::multi_function::tests
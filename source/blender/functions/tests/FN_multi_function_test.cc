@@ -4,6 +4,9 @@
 
 #include "testing/testing.h"
 
+#include "BLI_math_base_safe.h"
+#include "BLI_math_vector.hh"
+
 #include "FN_multi_function.hh"
 #include "FN_multi_function_builder.hh"
 #include "FN_multi_function_test_common.hh"
@@ -255,5 +258,140 @@ TEST(multi_function, IgnoredOutputs)
   }
 }
 
+TEST(multi_function, CustomMF_ComponentWiseSimd)
+{
+  auto fn = build::SI2_SO<float, float, float>(
+      "Safe Divide",
+      [](auto a, auto b) { return math::safe_divide(a, b) + 1.0f; },
+      build::exec_presets::ComponentWiseSimd());
+
+  /* Use a size that is not a multiple of the number of lanes to also test the remainder. */
+  const int size = 31;
+  Array<float> input1(size);
+  Array<float> input2(size);
+  for (const int i : IndexRange(size)) {
+    input1[i] = float(i);
+    input2[i] = float(i % 3);
+  }
+
+  {
+    Array<float> output(size, -1.0f);
+    const IndexMask mask(size);
+    ParamsBuilder params(fn, &mask);
+    params.add_readonly_single_input(input1.as_span());
+    params.add_readonly_single_input(input2.as_span());
+    params.add_uninitialized_single_output(output.as_mutable_span());
+    ContextBuilder context;
+    fn.call(mask, params, context);
+    for (const int i : IndexRange(size)) {
+      EXPECT_FLOAT_EQ(output[i], safe_divide(input1[i], input2[i]) + 1.0f);
+    }
+  }
+  {
+    Array<float> output(size, -1.0f);
+    const IndexMask mask(IndexRange(5, 20));
+    ParamsBuilder params(fn, &mask);
+    params.add_readonly_single_input(input1.as_span());
+    params.add_readonly_single_input_value(4.0f);
+    params.add_uninitialized_single_output(output.as_mutable_span());
+    ContextBuilder context;
+    fn.call(mask, params, context);
+    EXPECT_EQ(output[4], -1.0f);
+    for (const int i : mask.index_range()) {
+      EXPECT_FLOAT_EQ(output[5 + i], input1[5 + i] / 4.0f + 1.0f);
+    }
+    EXPECT_EQ(output[25], -1.0f);
+  }
+  {
+    /* Masks that are not a range use the fallback. */
+    Array<float> output(size, -1.0f);
+    IndexMaskMemory memory;
+    const IndexMask mask = IndexMask::from_indices<int>({1, 2, 6}, memory);
+    ParamsBuilder params(fn, &mask);
+    params.add_readonly_single_input_value(6.0f);
+    params.add_readonly_single_input(input2.as_span());
+    params.add_uninitialized_single_output(output.as_mutable_span());
+    ContextBuilder context;
+    fn.call(mask, params, context);
+    EXPECT_EQ(output[0], -1.0f);
+    EXPECT_FLOAT_EQ(output[1], 7.0f);
+    EXPECT_FLOAT_EQ(output[2], 4.0f);
+    EXPECT_FLOAT_EQ(output[6], 1.0f);
+  }
+}
+
+void expect_component_wise_nan_eq(const MultiFunction &fn,
+                                  const FunctionRef<float(float, float)> expected_fn)
+{
+  /* NaN in either operand, in both, and in none of them. */
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const Array<float> input1 = {nan, 1.0f, nan, 2.0f, -3.0f, nan, 4.0f, nan};
+  const Array<float> input2 = {1.0f, nan, nan, -2.0f, 3.0f, -1.0f, nan, nan};
+
+  Array<float> output(input1.size());
+  const IndexMask mask(input1.size());
+  ParamsBuilder params(fn, &mask);
+  params.add_readonly_single_input(input1.as_span());
+  params.add_readonly_single_input(input2.as_span());
+  params.add_uninitialized_single_output(output.as_mutable_span());
+  ContextBuilder context;
+  fn.call(mask, params, context);
+  for (const int i : input1.index_range()) {
+    const float expected = expected_fn(input1[i], input2[i]);
+    if (std::isnan(expected)) {
+      EXPECT_TRUE(std::isnan(output[i])) << "index " << i;
+    }
+    else {
+      EXPECT_EQ(output[i], expected) << "index " << i;
+    }
+  }
+}
+
+TEST(multi_function, CustomMF_ComponentWiseSimdMinMaxNaN)
+{
+  /* The SIMD path has to handle NaN like the scalar functions. */
+  auto min_fn = build::SI2_SO<float, float, float>(
+      "Min",
+      [](auto a, auto b) { return math::min(a, b); },
+      build::exec_presets::ComponentWiseSimd());
+  auto max_fn = build::SI2_SO<float, float, float>(
+      "Max",
+      [](auto a, auto b) { return math::max(a, b); },
+      build::exec_presets::ComponentWiseSimd());
+  expect_component_wise_nan_eq(min_fn, [](float a, float b) { return std::min(a, b); });
+  expect_component_wise_nan_eq(max_fn, [](float a, float b) { return std::max(a, b); });
+}
+
+TEST(multi_function, CustomMF_ComponentWiseSimdFloat3)
+{
+  auto fn = build::SI3_SO<float3, float3, float3, float3>(
+      "Multiply Add",
+      [](auto a, auto b, auto c) { return math::min(a * b + c, a); },
+      build::exec_presets::ComponentWiseSimd());
+
+  const int size = 11;
+  Array<float3> input1(size);
+  for (const int i : IndexRange(size)) {
+    input1[i] = float3(i, -i, i * 2);
+  }
+  const float3 single(2.0f, 3.0f, -4.0f);
+
+  Array<float3> output(size);
+  const IndexMask mask(size);
+  ParamsBuilder params(fn, &mask);
+  params.add_readonly_single_input(input1.as_span());
+  params.add_readonly_single_input_value(single);
+  params.add_readonly_single_input(input1.as_span());
+  params.add_uninitialized_single_output(output.as_mutable_span());
+  ContextBuilder context;
+  fn.call(mask, params, context);
+  for (const int i : IndexRange(size)) {
+    const float3 expected = math::min(input1[i] * single + input1[i], input1[i]);
+    EXPECT_FLOAT_EQ(output[i].x, expected.x);
+    EXPECT_FLOAT_EQ(output[i].y, expected.y);
+    EXPECT_FLOAT_EQ(output[i].z, expected.z);
+  }
+}
+
 }  // namespace
 }  // namespace blender::fn::multi_function::tests
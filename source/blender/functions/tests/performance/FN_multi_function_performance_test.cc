@@ -0,0 +1,129 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <iostream>
+
+#include "BLI_array.hh"
+#include "BLI_math_vector.hh"
+#include "BLI_timeit.hh"
+
+#include "FN_multi_function_builder.hh"
+
+/**
+ * Compares the throughput of element functions evaluated with #exec_presets::ComponentWiseSimd
+ * with the same functions evaluated with #exec_presets::AllSpanOrSingle, which relies on the
+ * compiler to vectorize the loop.
+ */
+
+namespace blender::fn::multi_function::tests {
+
+static constexpr int64_t ELEMENTS_NUM = 1'000'000;
+static constexpr int RUNS_NUM = 20;
+
+template<typename T> static Array<T> create_test_values(const int64_t size, const float offset)
+{
+  Array<T> values(size);
+  for (const int64_t i : values.index_range()) {
+    /* Include some zeros, so that safe division has to handle them. */
+    values[i] = T(float(i % 100) + offset);
+  }
+  return values;
+}
+
+template<typename T>
+static void run_benchmark(const char *name,
+                          const MultiFunction &fn_simd,
+                          const MultiFunction &fn_reference,
+                          const bool second_input_is_single)
+{
+  const Array<T> a = create_test_values<T>(ELEMENTS_NUM, 0.5f);
+  const Array<T> b = create_test_values<T>(ELEMENTS_NUM, -20.0f);
+  Array<T> result_simd(ELEMENTS_NUM);
+  Array<T> result_reference(ELEMENTS_NUM);
+
+  const IndexMask mask(ELEMENTS_NUM);
+  auto execute = [&](const MultiFunction &fn, MutableSpan<T> result) {
+    ParamsBuilder params(fn, &mask);
+    params.add_readonly_single_input(a.as_span());
+    if (second_input_is_single) {
+      params.add_readonly_single_input_value(T(3.0f));
+    }
+    else {
+      params.add_readonly_single_input(b.as_span());
+    }
+    params.add_uninitialized_single_output(result);
+    ContextBuilder context;
+    fn.call(mask, params, context);
+  };
+
+  /* Use the fastest of multiple runs to reduce the noise. */
+  auto measure = [&](const MultiFunction &fn, MutableSpan<T> result) {
+    timeit::Nanoseconds min_duration = timeit::Nanoseconds::max();
+    for ([[maybe_unused]] const int run : IndexRange(RUNS_NUM)) {
+      const timeit::TimePoint start = timeit::Clock::now();
+      execute(fn, result);
+      min_duration = std::min(min_duration, timeit::Clock::now() - start);
+    }
+    return double(min_duration.count()) / double(ELEMENTS_NUM);
+  };
+
+  const double simd_ns = measure(fn_simd, result_simd);
+  const double reference_ns = measure(fn_reference, result_reference);
+  std::cout << name << (second_input_is_single ? " (span, single)" : " (span, span)") << ":\n";
+  std::cout << "  SIMD:      " << simd_ns << " ns per element\n";
+  std::cout << "  Reference: " << reference_ns << " ns per element\n";
+
+  for (const int64_t i : IndexRange(ELEMENTS_NUM)) {
+    EXPECT_EQ(result_simd[i], result_reference[i]);
+  }
+}
+
+template<typename T, typename ElementFn>
+static void benchmark_element_fn(const char *name, const ElementFn element_fn)
+{
+  const auto fn_simd = build::SI2_SO<T, T, T>(
+      name, element_fn, build::exec_presets::ComponentWiseSimd());
+  const auto fn_reference = build::SI2_SO<T, T, T>(
+      name, element_fn, build::exec_presets::AllSpanOrSingle());
+  run_benchmark<T>(name, fn_simd, fn_reference, false);
+  run_benchmark<T>(name, fn_simd, fn_reference, true);
+}
+
+TEST(multi_function_performance, FloatAdd)
+{
+  benchmark_element_fn<float>("Float Add", [](auto a, auto b) { return a + b; });
+}
+
+TEST(multi_function_performance, FloatSafeDivide)
+{
+  benchmark_element_fn<float>("Float Safe Divide",
+                              [](auto a, auto b) { return math::safe_divide(a, b); });
+}
+
+TEST(multi_function_performance, FloatMix)
+{
+  benchmark_element_fn<float>("Float Mix", [](auto a, auto b) {
+    return math::interpolate(a, b, math::clamp(b, 0.0f, 1.0f));
+  });
+}
+
+TEST(multi_function_performance, VectorAdd)
+{
+  benchmark_element_fn<float3>("Vector Add", [](auto a, auto b) { return a + b; });
+}
+
+TEST(multi_function_performance, VectorSafeDivide)
+{
+  benchmark_element_fn<float3>("Vector Safe Divide",
+                               [](auto a, auto b) { return math::safe_divide(a, b); });
+}
+
+TEST(multi_function_performance, VectorMinimum)
+{
+  benchmark_element_fn<float3>("Vector Minimum", [](auto a, auto b) { return math::min(a, b); });
+}
+
+}  // namespace blender::fn::multi_function::tests
@@ -160,6 +160,13 @@ ImBuf *IMB_makeSingleUser(ImBuf *ibuf);
 
 ImBuf *IMB_dupImBuf(const ImBuf *ibuf1);
 
+/**
+ * Guard calls to #BLI_mmap_open and #BLI_mmap_free, which are not thread-safe,
+ * when memory-mapping files outside of ImBuf.
+ */
+void IMB_mmap_lock();
+void IMB_mmap_unlock();
+
 /**
  * Approximate size of ImBuf in memory
  */
@@ -348,6 +355,13 @@ void IMB_close_anim(ImBufAnim *anim);
 void IMB_close_anim_proxies(ImBufAnim *anim);
 bool IMB_anim_can_produce_frames(const ImBufAnim *anim);
 
+/**
+ * Decode up to \a frames_num frames that follow the last requested one in a background thread,
+ * so that sequential playback does not have to wait for the decoder. The thread is only started
+ * once frames are requested in order. Zero disables decoding ahead.
+ */
+void IMB_anim_set_read_ahead(ImBufAnim *anim, int frames_num);
+
 int IMB_anim_get_image_width(ImBufAnim *anim);
 int IMB_anim_get_image_height(ImBufAnim *anim);
 bool IMB_get_gop_decode_time(ImBufAnim *anim);
@@ -402,8 +416,36 @@ bool IMB_scaleImBuf(ImBuf *ibuf, unsigned int newx, unsigned int newy);
  */
 bool IMB_scalefastImBuf(ImBuf *ibuf, unsigned int newx, unsigned int newy);
 
+/**
+ * Bilinear scaling using all threads, see #IMB_scale.
+ */
 void IMB_scaleImBuf_threaded(ImBuf *ibuf, unsigned int newx, unsigned int newy);
 
+enum class IMBScaleFilter {
+  /**
+   * Source pixels weighted by how much of them is covered by the destination pixel, in both
+   * directions. When scaling up this only blends across the edges between source pixels.
+   */
+  Box,
+  Bilinear,
+  /** Catmull-Rom spline, sharper than bilinear. */
+  Bicubic,
+  /** Three lobed Lanczos, sharpest but may ring around hard edges. */
+  Lanczos,
+};
+
+/**
+ * Resample byte and float buffers with a separable filter. Scaling down filters over all the
+ * covered source pixels, so there is no aliasing at any scale factor.
+ *
+ * Return true if \a ibuf is modified.
+ */
+bool IMB_scale(ImBuf *ibuf,
+               unsigned int newx,
+               unsigned int newy,
+               IMBScaleFilter filter,
+               bool threaded = true);
+
 bool IMB_saveiff(ImBuf *ibuf, const char *filepath, int flags);
 
 bool IMB_ispic(const char *filepath);
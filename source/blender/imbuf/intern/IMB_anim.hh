@@ -23,6 +23,7 @@ struct SwsContext;
 
 struct IDProperty;
 struct ImBufAnimIndex;
+struct ImBufAnimReadAhead;
 
 struct ImBufAnim {
   enum class State { Uninitialized, Failed, Valid };
@@ -59,8 +60,14 @@ struct ImBufAnim {
   AVPacket *cur_packet;
 
   bool seek_before_decode;
+
+  /** Background decoding of the following frames, see #IMB_anim_set_read_ahead. */
+  ImBufAnimReadAhead *read_ahead;
 #endif
 
+  /** Maximum number of frames that are decoded ahead of time, zero when disabled. */
+  int read_ahead_frames_max;
+
   char index_dir[768];
 
   int proxies_tried;
@@ -75,3 +82,15 @@ struct ImBufAnim {
 
   IDProperty *metadata;
 };
+
+/**
+ * The read-ahead thread opens and uses the indices of the animation while decoding. Stop it
+ * before the indices are freed.
+ */
+void imb_anim_read_ahead_stop(ImBufAnim *anim);
+/**
+ * Lock the decoder state that is shared with the read-ahead thread, to access the indices from
+ * another thread while it is running.
+ */
+void imb_anim_decode_lock(ImBufAnim *anim);
+void imb_anim_decode_unlock(ImBufAnim *anim);
@@ -64,6 +64,16 @@ void imb_mmap_unlock()
 }
 #endif
 
+void IMB_mmap_lock()
+{
+  imb_mmap_lock();
+}
+
+void IMB_mmap_unlock()
+{
+  imb_mmap_unlock();
+}
+
 /* Free the specified buffer storage, freeing memory when needed and restoring the state of the
  * buffer to its defaults. */
 template<class BufferType> static void imb_free_buffer(BufferType &buffer)
@@ -54,6 +54,7 @@ extern "C" {
 
 #ifdef WITH_FFMPEG
 static void free_anim_ffmpeg(ImBufAnim *anim);
+static void ffmpeg_read_ahead_stop(ImBufAnim *anim);
 #endif
 
 void IMB_free_anim(ImBufAnim *anim)
@@ -159,6 +160,18 @@ void IMB_suffix_anim(ImBufAnim *anim, const char *suffix)
   STRNCPY(anim->suffix, suffix);
 }
 
+void IMB_anim_set_read_ahead(ImBufAnim *anim, const int frames_num)
+{
+  if (anim->read_ahead_frames_max == frames_num) {
+    return;
+  }
+#ifdef WITH_FFMPEG
+  /* The thread is started again with the new buffer size on the next sequential access. */
+  ffmpeg_read_ahead_stop(anim);
+#endif
+  anim->read_ahead_frames_max = frames_num;
+}
+
 #ifdef WITH_FFMPEG
 
 static int startffmpeg(ImBufAnim *anim)
@@ -1168,12 +1181,258 @@ static ImBuf *ffmpeg_fetchibuf(ImBufAnim *anim, int position, IMB_Timecode_Type
   return cur_frame_final;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Read-Ahead
+ *
+ * During playback frames are requested one after another. Instead of decoding every frame when
+ * it is requested, a background thread decodes the following frames into a ring buffer, so that
+ * fetching the next frame only has to take it from the buffer. When a frame that is not in the
+ * buffer is requested (e.g. after seeking), the buffer is discarded and the thread continues after
+ * the new position.
+ * \{ */
+
+struct ImBufAnimReadAheadFrame {
+  int position;
+  IMB_Timecode_Type tc;
+  ImBuf *ibuf;
+};
+
+struct ImBufAnimReadAhead {
+  ListBase threads;
+
+  /** Protects all members below. */
+  ThreadMutex mutex;
+  /** Notified when a frame was decoded or taken from the buffer, or when the thread must stop. */
+  ThreadCondition cond;
+  /** Protects the decoder state of the #ImBufAnim, which is used by both threads. */
+  ThreadMutex decode_mutex;
+
+  /** Ring buffer of decoded frames, in presentation order. */
+  ImBufAnimReadAheadFrame *frames;
+  int frames_max;
+  int frames_start;
+  int frames_num;
+
+  /** Next frame that the thread decodes, -1 to pause decoding. */
+  int next_position;
+  IMB_Timecode_Type tc;
+  /** Frame that the thread is decoding right now, -1 if none. */
+  int decoding_position;
+  /** Incremented when the buffer is discarded, frames decoded before that are not used. */
+  int generation;
+
+  bool stop;
+};
+
+static ImBufAnimReadAheadFrame &ffmpeg_read_ahead_front(ImBufAnimReadAhead *read_ahead)
+{
+  return read_ahead->frames[read_ahead->frames_start];
+}
+
+static ImBuf *ffmpeg_read_ahead_pop(ImBufAnimReadAhead *read_ahead)
+{
+  ImBuf *ibuf = ffmpeg_read_ahead_front(read_ahead).ibuf;
+  read_ahead->frames_start = (read_ahead->frames_start + 1) % read_ahead->frames_max;
+  read_ahead->frames_num--;
+  return ibuf;
+}
+
+static void ffmpeg_read_ahead_push(ImBufAnimReadAhead *read_ahead,
+                                   const int position,
+                                   const IMB_Timecode_Type tc,
+                                   ImBuf *ibuf)
+{
+  BLI_assert(read_ahead->frames_num < read_ahead->frames_max);
+  const int index = (read_ahead->frames_start + read_ahead->frames_num) % read_ahead->frames_max;
+  read_ahead->frames[index] = {position, tc, ibuf};
+  read_ahead->frames_num++;
+}
+
+static void ffmpeg_read_ahead_clear(ImBufAnimReadAhead *read_ahead)
+{
+  while (read_ahead->frames_num > 0) {
+    IMB_freeImBuf(ffmpeg_read_ahead_pop(read_ahead));
+  }
+}
+
+static void *ffmpeg_read_ahead_thread(void *data)
+{
+  ImBufAnim *anim = static_cast<ImBufAnim *>(data);
+  ImBufAnimReadAhead *read_ahead = anim->read_ahead;
+
+  BLI_mutex_lock(&read_ahead->mutex);
+  while (!read_ahead->stop) {
+    const int position = read_ahead->next_position;
+    if (position < 0 || position >= anim->duration_in_frames ||
+        read_ahead->frames_num == read_ahead->frames_max)
+    {
+      BLI_condition_wait(&read_ahead->cond, &read_ahead->mutex);
+      continue;
+    }
+    const IMB_Timecode_Type tc = read_ahead->tc;
+    const int generation = read_ahead->generation;
+    read_ahead->decoding_position = position;
+    BLI_mutex_unlock(&read_ahead->mutex);
+
+    BLI_mutex_lock(&read_ahead->decode_mutex);
+    ImBuf *ibuf = ffmpeg_fetchibuf(anim, position, tc);
+    BLI_mutex_unlock(&read_ahead->decode_mutex);
+
+    BLI_mutex_lock(&read_ahead->mutex);
+    read_ahead->decoding_position = -1;
+    if (generation == read_ahead->generation) {
+      ffmpeg_read_ahead_push(read_ahead, position, tc, ibuf);
+      read_ahead->next_position = position + 1;
+    }
+    else {
+      IMB_freeImBuf(ibuf);
+    }
+    BLI_condition_notify_all(&read_ahead->cond);
+  }
+  BLI_mutex_unlock(&read_ahead->mutex);
+
+  return nullptr;
+}
+
+static void ffmpeg_read_ahead_start(ImBufAnim *anim)
+{
+  ImBufAnimReadAhead *read_ahead = MEM_cnew<ImBufAnimReadAhead>(__func__);
+  read_ahead->frames = MEM_cnew_array<ImBufAnimReadAheadFrame>(anim->read_ahead_frames_max,
+                                                               __func__);
+  read_ahead->frames_max = anim->read_ahead_frames_max;
+  read_ahead->next_position = -1;
+  read_ahead->decoding_position = -1;
+  BLI_mutex_init(&read_ahead->mutex);
+  BLI_mutex_init(&read_ahead->decode_mutex);
+  BLI_condition_init(&read_ahead->cond);
+  anim->read_ahead = read_ahead;
+
+  BLI_threadpool_init(&read_ahead->threads, ffmpeg_read_ahead_thread, 1);
+  BLI_threadpool_insert(&read_ahead->threads, anim);
+}
+
+static void ffmpeg_read_ahead_stop(ImBufAnim *anim)
+{
+  ImBufAnimReadAhead *read_ahead = anim->read_ahead;
+  if (read_ahead == nullptr) {
+    return;
+  }
+
+  BLI_mutex_lock(&read_ahead->mutex);
+  read_ahead->stop = true;
+  BLI_condition_notify_all(&read_ahead->cond);
+  BLI_mutex_unlock(&read_ahead->mutex);
+  BLI_threadpool_end(&read_ahead->threads);
+
+  ffmpeg_read_ahead_clear(read_ahead);
+  BLI_mutex_end(&read_ahead->mutex);
+  BLI_mutex_end(&read_ahead->decode_mutex);
+  BLI_condition_end(&read_ahead->cond);
+  MEM_freeN(read_ahead->frames);
+  MEM_freeN(read_ahead);
+  anim->read_ahead = nullptr;
+}
+
+static ImBuf *ffmpeg_read_ahead_fetchibuf(ImBufAnim *anim, int position, IMB_Timecode_Type tc)
+{
+  if (anim->read_ahead == nullptr) {
+    /* Don't start a thread for random access, e.g. when scrubbing or drawing thumbnails. */
+    if (position != anim->cur_position + 1 || ffmpeg_is_first_frame_decode(anim)) {
+      return ffmpeg_fetchibuf(anim, position, tc);
+    }
+    ffmpeg_read_ahead_start(anim);
+  }
+  ImBufAnimReadAhead *read_ahead = anim->read_ahead;
+
+  BLI_mutex_lock(&read_ahead->mutex);
+  while (true) {
+    /* Skip frames that were decoded but are not needed anymore. */
+    while (read_ahead->frames_num > 0 && ffmpeg_read_ahead_front(read_ahead).tc == tc &&
+           ffmpeg_read_ahead_front(read_ahead).position < position)
+    {
+      IMB_freeImBuf(ffmpeg_read_ahead_pop(read_ahead));
+      BLI_condition_notify_all(&read_ahead->cond);
+    }
+    if (read_ahead->frames_num > 0 && ffmpeg_read_ahead_front(read_ahead).tc == tc &&
+        ffmpeg_read_ahead_front(read_ahead).position == position)
+    {
+      ImBuf *ibuf = ffmpeg_read_ahead_pop(read_ahead);
+      BLI_condition_notify_all(&read_ahead->cond);
+      BLI_mutex_unlock(&read_ahead->mutex);
+      return ibuf;
+    }
+    if (read_ahead->decoding_position == position && read_ahead->tc == tc) {
+      /* The frame will be available soon. */
+      BLI_condition_wait(&read_ahead->cond, &read_ahead->mutex);
+      continue;
+    }
+    break;
+  }
+
+  /* The frame is not decoded yet, so decode it here and let the thread continue after it. */
+  ffmpeg_read_ahead_clear(read_ahead);
+  read_ahead->generation++;
+  read_ahead->next_position = -1;
+  BLI_mutex_unlock(&read_ahead->mutex);
+
+  BLI_mutex_lock(&read_ahead->decode_mutex);
+  ImBuf *ibuf = ffmpeg_fetchibuf(anim, position, tc);
+  BLI_mutex_unlock(&read_ahead->decode_mutex);
+
+  BLI_mutex_lock(&read_ahead->mutex);
+  read_ahead->next_position = position + 1;
+  read_ahead->tc = tc;
+  BLI_condition_notify_all(&read_ahead->cond);
+  BLI_mutex_unlock(&read_ahead->mutex);
+
+  return ibuf;
+}
+
+/** \} */
+
+#endif
+
+void imb_anim_read_ahead_stop(ImBufAnim *anim)
+{
+#ifdef WITH_FFMPEG
+  ffmpeg_read_ahead_stop(anim);
+#else
+  UNUSED_VARS(anim);
+#endif
+}
+
+void imb_anim_decode_lock(ImBufAnim *anim)
+{
+#ifdef WITH_FFMPEG
+  if (anim->read_ahead) {
+    BLI_mutex_lock(&anim->read_ahead->decode_mutex);
+  }
+#else
+  UNUSED_VARS(anim);
+#endif
+}
+
+void imb_anim_decode_unlock(ImBufAnim *anim)
+{
+#ifdef WITH_FFMPEG
+  if (anim->read_ahead) {
+    BLI_mutex_unlock(&anim->read_ahead->decode_mutex);
+  }
+#else
+  UNUSED_VARS(anim);
+#endif
+}
+
+#ifdef WITH_FFMPEG
+
 static void free_anim_ffmpeg(ImBufAnim *anim)
 {
   if (anim == nullptr) {
     return;
   }
 
+  ffmpeg_read_ahead_stop(anim);
+
   if (anim->pCodecCtx) {
     avcodec_free_context(&anim->pCodecCtx);
     avformat_close_input(&anim->pFormatCtx);
@@ -1288,15 +1547,21 @@ ImBuf *IMB_anim_absolute(ImBufAnim *anim,
 
 #ifdef WITH_FFMPEG
   if (anim->state == ImBufAnim::State::Valid) {
-    ibuf = ffmpeg_fetchibuf(anim, position, tc);
-    if (ibuf) {
-      anim->cur_position = position;
+    if (anim->read_ahead_frames_max > 0) {
+      /* The position of the decoder is managed by the read-ahead thread. */
+      ibuf = ffmpeg_read_ahead_fetchibuf(anim, position, tc);
+    }
+    else {
+      ibuf = ffmpeg_fetchibuf(anim, position, tc);
+      if (ibuf) {
+        anim->cur_position = position;
+      }
     }
   }
 #endif
 
   if (ibuf) {
-    SNPRINTF(ibuf->filepath, "%s.%04d", anim->filepath, anim->cur_position + 1);
+    SNPRINTF(ibuf->filepath, "%s.%04d", anim->filepath, position + 1);
   }
   return ibuf;
 }
@@ -1310,12 +1575,12 @@ int IMB_anim_get_duration(ImBufAnim *anim, IMB_Timecode_Type tc)
     return anim->duration_in_frames;
   }
 
+  imb_anim_decode_lock(anim);
   idx = IMB_anim_open_index(anim, tc);
-  if (!idx) {
-    return anim->duration_in_frames;
-  }
+  const int duration = idx ? IMB_indexer_get_duration(idx) : anim->duration_in_frames;
+  imb_anim_decode_unlock(anim);
 
-  return IMB_indexer_get_duration(idx);
+  return duration;
 }
 
 double IMD_anim_get_offset(ImBufAnim *anim)
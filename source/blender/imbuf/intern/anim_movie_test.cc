@@ -0,0 +1,172 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#ifdef WITH_FFMPEG
+
+#  include <string>
+
+#  include "BLI_fileops.h"
+#  include "BLI_path_util.h"
+#  include "BLI_system.h"
+#  include "BLI_tempfile.h"
+
+#  include "IMB_imbuf.hh"
+#  include "IMB_imbuf_types.hh"
+
+extern "C" {
+#  include <libavcodec/avcodec.h>
+#  include <libavformat/avformat.h>
+
+#  include "ffmpeg_compat.h"
+}
+
+#  include BLI_SYSTEM_PID_H
+
+namespace blender::imbuf::tests {
+
+static void write_packets(AVCodecContext *codec_ctx,
+                          AVFormatContext *format_ctx,
+                          AVStream *stream,
+                          AVPacket *packet)
+{
+  while (avcodec_receive_packet(codec_ctx, packet) == 0) {
+    av_packet_rescale_ts(packet, codec_ctx->time_base, stream->time_base);
+    packet->stream_index = stream->index;
+    av_interleaved_write_frame(format_ctx, packet);
+  }
+}
+
+/** Write a MJPEG movie where every frame has a different brightness. */
+static bool write_movie(const char *filepath, const int frames_num, const int width, const int height)
+{
+  const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+  AVFormatContext *format_ctx = nullptr;
+  if (codec == nullptr ||
+      avformat_alloc_output_context2(&format_ctx, nullptr, "avi", filepath) < 0)
+  {
+    return false;
+  }
+  AVStream *stream = avformat_new_stream(format_ctx, nullptr);
+  AVCodecContext *codec_ctx = avcodec_alloc_context3(codec);
+  codec_ctx->width = width;
+  codec_ctx->height = height;
+  codec_ctx->time_base = {1, 25};
+  codec_ctx->framerate = {25, 1};
+  codec_ctx->pix_fmt = AV_PIX_FMT_YUVJ420P;
+  AVFrame *frame = av_frame_alloc();
+  AVPacket *packet = av_packet_alloc();
+
+  bool success = false;
+  if (avcodec_open2(codec_ctx, codec, nullptr) >= 0 &&
+      avcodec_parameters_from_context(stream->codecpar, codec_ctx) >= 0 &&
+      avio_open(&format_ctx->pb, filepath, AVIO_FLAG_WRITE) >= 0)
+  {
+    stream->time_base = codec_ctx->time_base;
+    if (avformat_write_header(format_ctx, nullptr) >= 0) {
+      frame->format = codec_ctx->pix_fmt;
+      frame->width = width;
+      frame->height = height;
+      av_frame_get_buffer(frame, 0);
+      for (int i = 0; i < frames_num; i++) {
+        av_frame_make_writable(frame);
+        for (int plane = 0; plane < 3; plane++) {
+          const int plane_height = plane == 0 ? height : height / 2;
+          memset(frame->data[plane],
+                 plane == 0 ? (i * 8) % 256 : 128,
+                 size_t(frame->linesize[plane]) * plane_height);
+        }
+        frame->pts = i;
+        avcodec_send_frame(codec_ctx, frame);
+        write_packets(codec_ctx, format_ctx, stream, packet);
+      }
+      avcodec_send_frame(codec_ctx, nullptr);
+      write_packets(codec_ctx, format_ctx, stream, packet);
+      success = av_write_trailer(format_ctx) >= 0;
+    }
+    avio_closep(&format_ctx->pb);
+  }
+
+  av_packet_free(&packet);
+  av_frame_free(&frame);
+  avcodec_free_context(&codec_ctx);
+  avformat_free_context(format_ctx);
+  return success;
+}
+
+class AnimMovieTest : public testing::Test {
+ public:
+  std::string temp_dir;
+
+  static void SetUpTestSuite()
+  {
+    IMB_init();
+  }
+
+  static void TearDownTestSuite()
+  {
+    IMB_exit();
+  }
+
+  void SetUp() override
+  {
+    char temp_dir_c[FILE_MAX];
+    BLI_temp_directory_path_get(temp_dir_c, sizeof(temp_dir_c));
+    temp_dir = std::string(temp_dir_c) + SEP_STR + "blender_anim_movie_test_" +
+               std::to_string(getpid());
+    BLI_dir_create_recursive(temp_dir.c_str());
+  }
+
+  void TearDown() override
+  {
+    BLI_delete(temp_dir.c_str(), true, true);
+  }
+};
+
+/* Freeing the indices and proxies while the read-ahead thread decodes frames using them. */
+TEST_F(AnimMovieTest, ReadAheadCloseProxies)
+{
+  const int frames_num = 40;
+  const std::string filepath = temp_dir + SEP_STR + "movie.avi";
+  if (!write_movie(filepath.c_str(), frames_num, 64, 48)) {
+    GTEST_SKIP() << "Unable to write a MJPEG movie";
+  }
+
+  char colorspace[IM_MAX_SPACE] = "";
+  ImBufAnim *anim = IMB_open_anim(filepath.c_str(), IB_rect, 0, colorspace);
+  ASSERT_NE(anim, nullptr);
+  IMB_anim_set_index_dir(anim, temp_dir.c_str());
+  IMB_freeImBuf(IMB_anim_absolute(anim, 0, IMB_TC_NONE, IMB_PROXY_NONE));
+
+  IndexBuildContext *context = IMB_anim_index_rebuild_context(
+      anim, IMB_TC_RECORD_RUN, IMB_PROXY_25, 90, true, nullptr, false);
+  ASSERT_NE(context, nullptr);
+  bool stop = false;
+  bool do_update = false;
+  float progress = 0.0f;
+  IMB_anim_index_rebuild(context, &stop, &do_update, &progress);
+  IMB_anim_index_rebuild_finish(context, false);
+
+  IMB_anim_set_read_ahead(anim, 8);
+  for (int start = 0; start < frames_num - 3; start += 3) {
+    /* Sequential access starts the read-ahead threads, which keep decoding after the loop. */
+    for (int position = start; position < start + 3; position++) {
+      for (const IMB_Proxy_Size proxy_size : {IMB_PROXY_NONE, IMB_PROXY_25}) {
+        ImBuf *ibuf = IMB_anim_absolute(anim, position, IMB_TC_RECORD_RUN, proxy_size);
+        ASSERT_NE(ibuf, nullptr);
+        IMB_freeImBuf(ibuf);
+      }
+    }
+    IMB_close_anim_proxies(anim);
+    EXPECT_EQ(IMB_anim_get_duration(anim, IMB_TC_RECORD_RUN), frames_num);
+    EXPECT_EQ(IMB_anim_index_get_frame_index(anim, IMB_TC_RECORD_RUN, start), start);
+  }
+
+  IMB_close_anim(anim);
+}
+
+}  // namespace blender::imbuf::tests
+
+#endif
@@ -11,6 +11,7 @@
 
 #include <cmath>
 #include <cstring>
+#include <memory>
 
 #include "DNA_color_types.h"
 #include "DNA_image_types.h"
@@ -18,6 +19,7 @@
 #include "DNA_scene_types.h"
 #include "DNA_sequence_types.h"
 #include "DNA_space_types.h"
+#include "DNA_userdef_types.h"
 
 #include "IMB_filetype.hh"
 #include "IMB_filter.hh"
@@ -36,6 +38,7 @@
 #include "BLI_task.h"
 #include "BLI_task.hh"
 #include "BLI_threads.h"
+#include "BLI_vector.hh"
 
 #include "BKE_appdir.hh"
 #include "BKE_colortools.hh"
@@ -52,6 +55,8 @@
 
 #include <ocio_capi.h>
 
+#include "colormanagement_lut.hh"
+
 /* -------------------------------------------------------------------- */
 /** \name Global declarations
  * \{ */
@@ -118,6 +123,21 @@ static struct global_color_picking_state {
   bool failed;
 } global_color_picking_state = {nullptr};
 
+/* Baked display transforms, see #display_lut_acquire. */
+struct DisplayLUTCacheItem {
+  ColorManagedViewSettings view_settings;
+  ColorManagedDisplaySettings display_settings;
+  int curve_mapping_timestamp;
+  std::shared_ptr<const blender::imbuf::ColorLUT3D> lut;
+};
+
+/* Number of baked display transforms to keep, so switching between a few views is fast. */
+#define DISPLAY_LUT_CACHE_SIZE 4
+
+static ThreadMutex display_lut_cache_lock = BLI_MUTEX_INITIALIZER;
+/* Ordered from least to most recently used. */
+static blender::Vector<DisplayLUTCacheItem> display_lut_cache;
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -754,6 +774,8 @@ void colormanagement_exit()
   memset(&global_gpu_state, 0, sizeof(global_gpu_state));
   memset(&global_color_picking_state, 0, sizeof(global_color_picking_state));
 
+  display_lut_cache.clear_and_shrink();
+
   colormanage_free_config();
   OCIO_exit();
 }
@@ -1538,12 +1560,107 @@ bool IMB_colormanagement_set_view_whitepoint(ColorManagedViewSettings *view_sett
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Display Transform Lookup Tables
+ *
+ * Display transforms of large float buffers can use a baked 3D lookup table instead of running
+ * OpenColorIO and curve mapping for every pixel, see #USER_GPU_FLAG_DISPLAY_TRANSFORM_LUT.
+ * \{ */
+
+static bool display_lut_use(const ImBuf *ibuf, const ColorManagedViewSettings *view_settings)
+{
+  using namespace blender::imbuf;
+  if ((U.gpu_flag & USER_GPU_FLAG_DISPLAY_TRANSFORM_LUT) == 0 || view_settings == nullptr) {
+    return false;
+  }
+  if (ibuf->channels < 3 || (ibuf->colormanage_flag & IMB_COLORMANAGE_IS_DATA)) {
+    return false;
+  }
+  /* Baking costs about as much as transforming as many pixels as there are lattice points. */
+  return int64_t(ibuf->x) * ibuf->y >= int64_t(ColorLUT3D::size) * ColorLUT3D::size *
+                                           ColorLUT3D::size;
+}
+
+static bool display_lut_cache_item_matches(const DisplayLUTCacheItem &item,
+                                           const ColorManagedViewSettings *view_settings,
+                                           const ColorManagedDisplaySettings *display_settings,
+                                           const CurveMapping *curve_mapping)
+{
+  const ColorManagedViewSettings &cached = item.view_settings;
+  return cached.flag == view_settings->flag && STREQ(cached.look, view_settings->look) &&
+         STREQ(cached.view_transform, view_settings->view_transform) &&
+         cached.exposure == view_settings->exposure && cached.gamma == view_settings->gamma &&
+         cached.temperature == view_settings->temperature && cached.tint == view_settings->tint &&
+         cached.curve_mapping == curve_mapping &&
+         item.curve_mapping_timestamp ==
+             (curve_mapping ? curve_mapping->changed_timestamp : 0) &&
+         STREQ(item.display_settings.display_device, display_settings->display_device);
+}
+
+/**
+ * Get the display transform of \a cm_processor baked into a lookup table, from the cache when
+ * it was baked for the same settings before.
+ */
+static std::shared_ptr<const blender::imbuf::ColorLUT3D> display_lut_acquire(
+    ColormanageProcessor *cm_processor,
+    const ColorManagedViewSettings *view_settings,
+    const ColorManagedDisplaySettings *display_settings)
+{
+  using namespace blender;
+  const CurveMapping *curve_mapping = (view_settings->flag & COLORMANAGE_VIEW_USE_CURVES) ?
+                                          view_settings->curve_mapping :
+                                          nullptr;
+  std::shared_ptr<const imbuf::ColorLUT3D> lut;
+
+  BLI_mutex_lock(&display_lut_cache_lock);
+
+  for (const int64_t i : display_lut_cache.index_range()) {
+    if (display_lut_cache_item_matches(
+            display_lut_cache[i], view_settings, display_settings, curve_mapping))
+    {
+      DisplayLUTCacheItem item = std::move(display_lut_cache[i]);
+      display_lut_cache.remove(i);
+      lut = item.lut;
+      display_lut_cache.append(std::move(item));
+      break;
+    }
+  }
+
+  if (!lut) {
+    /* Bake while holding the lock, so the same table isn't baked by multiple threads. Isolate
+     * the task, so this thread doesn't pick up work that waits for the lock. */
+    threading::isolate_task([&]() {
+      lut = std::make_shared<const imbuf::ColorLUT3D>([&](float *rgba, const int64_t pixels_num) {
+        IMB_colormanagement_processor_apply(cm_processor, rgba, int(pixels_num), 1, 4, false);
+      });
+    });
+
+    if (display_lut_cache.size() >= DISPLAY_LUT_CACHE_SIZE) {
+      display_lut_cache.remove(0);
+    }
+    DisplayLUTCacheItem item;
+    item.view_settings = *view_settings;
+    item.view_settings.curve_mapping = const_cast<CurveMapping *>(curve_mapping);
+    item.display_settings = *display_settings;
+    item.curve_mapping_timestamp = curve_mapping ? curve_mapping->changed_timestamp : 0;
+    item.lut = lut;
+    display_lut_cache.append(std::move(item));
+  }
+
+  BLI_mutex_unlock(&display_lut_cache_lock);
+
+  return lut;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Threaded Display Buffer Transform Routines
  * \{ */
 
 struct DisplayBufferThread {
   ColormanageProcessor *cm_processor;
+  const blender::imbuf::ColorLUT3D *lut;
 
   const float *buffer;
   uchar *byte_buffer;
@@ -1567,6 +1684,7 @@ struct DisplayBufferThread {
 struct DisplayBufferInitData {
   ImBuf *ibuf;
   ColormanageProcessor *cm_processor;
+  const blender::imbuf::ColorLUT3D *lut;
   const float *buffer;
   uchar *byte_buffer;
 
@@ -1579,13 +1697,11 @@ struct DisplayBufferInitData {
   const char *float_colorspace;
 };
 
-static void display_buffer_init_handle(void *handle_v,
+static void display_buffer_init_handle(DisplayBufferThread *handle,
                                        int start_line,
                                        int tot_line,
-                                       void *init_data_v)
+                                       const DisplayBufferInitData *init_data)
 {
-  DisplayBufferThread *handle = (DisplayBufferThread *)handle_v;
-  DisplayBufferInitData *init_data = (DisplayBufferInitData *)init_data_v;
   ImBuf *ibuf = init_data->ibuf;
 
   int channels = ibuf->channels;
@@ -1598,6 +1714,7 @@ static void display_buffer_init_handle(void *handle_v,
   memset(handle, 0, sizeof(DisplayBufferThread));
 
   handle->cm_processor = init_data->cm_processor;
+  handle->lut = init_data->lut;
 
   if (init_data->buffer) {
     handle->buffer = init_data->buffer + offset;
@@ -1709,9 +1826,8 @@ static void display_buffer_apply_get_linear_buffer(DisplayBufferThread *handle,
   }
 }
 
-static void *do_display_buffer_apply_thread(void *handle_v)
+static void do_display_buffer_apply_thread(DisplayBufferThread *handle)
 {
-  DisplayBufferThread *handle = (DisplayBufferThread *)handle_v;
   ColormanageProcessor *cm_processor = handle->cm_processor;
   float *display_buffer = handle->display_buffer;
   uchar *display_buffer_byte = handle->display_buffer_byte;
@@ -1760,6 +1876,9 @@ static void *do_display_buffer_apply_thread(void *handle_v)
        * only generate byte buffers
        */
     }
+    else if (handle->lut) {
+      handle->lut->apply(linear_buffer, int64_t(width) * height, channels, predivide);
+    }
     else {
       /* apply processor */
       IMB_colormanagement_processor_apply(
@@ -1798,8 +1917,6 @@ static void *do_display_buffer_apply_thread(void *handle_v)
 
     MEM_freeN(linear_buffer);
   }
-
-  return nullptr;
 }
 
 static void display_buffer_apply_threaded(ImBuf *ibuf,
@@ -1807,12 +1924,15 @@ static void display_buffer_apply_threaded(ImBuf *ibuf,
                                           uchar *byte_buffer,
                                           float *display_buffer,
                                           uchar *display_buffer_byte,
-                                          ColormanageProcessor *cm_processor)
+                                          ColormanageProcessor *cm_processor,
+                                          const blender::imbuf::ColorLUT3D *lut)
 {
+  using namespace blender;
   DisplayBufferInitData init_data;
 
   init_data.ibuf = ibuf;
   init_data.cm_processor = cm_processor;
+  init_data.lut = lut;
   init_data.buffer = buffer;
   init_data.byte_buffer = byte_buffer;
   init_data.display_buffer = display_buffer;
@@ -1836,11 +1956,13 @@ static void display_buffer_apply_threaded(ImBuf *ibuf,
     init_data.float_colorspace = nullptr;
   }
 
-  IMB_processor_apply_threaded(ibuf->y,
-                               sizeof(DisplayBufferThread),
-                               &init_data,
-                               display_buffer_init_handle,
-                               do_display_buffer_apply_thread);
+  /* Rows are converted through a temporary float buffer, keep it small enough for the cache. */
+  const int64_t grain_size = std::max(int64_t(1), int64_t(64 * 1024) / std::max(ibuf->x, 1));
+  threading::parallel_for(IndexRange(ibuf->y), grain_size, [&](const IndexRange y_range) {
+    DisplayBufferThread handle;
+    display_buffer_init_handle(&handle, y_range.first(), y_range.size(), &init_data);
+    do_display_buffer_apply_thread(&handle);
+  });
 }
 
 static bool is_ibuf_rect_in_display_space(ImBuf *ibuf,
@@ -1884,8 +2006,12 @@ static void colormanage_display_buffer_process_ex(
     skip_transform = is_ibuf_rect_in_display_space(ibuf, view_settings, display_settings);
   }
 
+  std::shared_ptr<const blender::imbuf::ColorLUT3D> lut;
   if (skip_transform == false) {
     cm_processor = IMB_colormanagement_display_processor_new(view_settings, display_settings);
+    if (display_lut_use(ibuf, view_settings)) {
+      lut = display_lut_acquire(cm_processor, view_settings, display_settings);
+    }
   }
 
   display_buffer_apply_threaded(ibuf,
@@ -1893,7 +2019,8 @@ static void colormanage_display_buffer_process_ex(
                                 ibuf->byte_buffer.data,
                                 display_buffer,
                                 display_buffer_byte,
-                                cm_processor);
+                                cm_processor,
+                                lut.get());
 
   if (cm_processor) {
     IMB_colormanagement_processor_free(cm_processor);
@@ -1938,14 +2065,11 @@ struct ProcessorTransformInitData {
   bool float_from_byte;
 };
 
-static void processor_transform_init_handle(void *handle_v,
+static void processor_transform_init_handle(ProcessorTransformThread *handle,
                                             int start_line,
                                             int tot_line,
-                                            void *init_data_v)
+                                            const ProcessorTransformInitData *init_data)
 {
-  ProcessorTransformThread *handle = (ProcessorTransformThread *)handle_v;
-  ProcessorTransformInitData *init_data = (ProcessorTransformInitData *)init_data_v;
-
   const int channels = init_data->channels;
   const int width = init_data->width;
   const bool predivide = init_data->predivide;
@@ -1975,9 +2099,8 @@ static void processor_transform_init_handle(void *handle_v,
   handle->float_from_byte = float_from_byte;
 }
 
-static void *do_processor_transform_thread(void *handle_v)
+static void do_processor_transform_thread(ProcessorTransformThread *handle)
 {
-  ProcessorTransformThread *handle = (ProcessorTransformThread *)handle_v;
   uchar *byte_buffer = handle->byte_buffer;
   float *float_buffer = handle->float_buffer;
   const int channels = handle->channels;
@@ -2010,8 +2133,6 @@ static void *do_processor_transform_thread(void *handle_v)
           handle->cm_processor, float_buffer, width, height, channels, predivide);
     }
   }
-
-  return nullptr;
 }
 
 static void processor_transform_apply_threaded(uchar *byte_buffer,
@@ -2023,6 +2144,7 @@ static void processor_transform_apply_threaded(uchar *byte_buffer,
                                                const bool predivide,
                                                const bool float_from_byte)
 {
+  using namespace blender;
   ProcessorTransformInitData init_data;
 
   init_data.cm_processor = cm_processor;
@@ -2034,11 +2156,12 @@ static void processor_transform_apply_threaded(uchar *byte_buffer,
   init_data.predivide = predivide;
   init_data.float_from_byte = float_from_byte;
 
-  IMB_processor_apply_threaded(height,
-                               sizeof(ProcessorTransformThread),
-                               &init_data,
-                               processor_transform_init_handle,
-                               do_processor_transform_thread);
+  const int64_t grain_size = std::max(int64_t(1), int64_t(64 * 1024) / std::max(width, 1));
+  threading::parallel_for(IndexRange(height), grain_size, [&](const IndexRange y_range) {
+    ProcessorTransformThread handle;
+    processor_transform_init_handle(&handle, y_range.first(), y_range.size(), &init_data);
+    do_processor_transform_thread(&handle);
+  });
 }
 
 /** \} */
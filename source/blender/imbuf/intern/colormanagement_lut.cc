@@ -0,0 +1,223 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup imbuf
+ */
+
+#include <cmath>
+
+#include "BLI_math_base.h"
+#include "BLI_simd.hh"
+#include "BLI_task.hh"
+
+#include "colormanagement_lut.hh"
+
+namespace blender::imbuf {
+
+/* The lattice is uniform in `log2(x + offset)`, the offset makes zero land exactly on the first
+ * lattice point while the spacing is still logarithmic for brighter values. The range is chosen
+ * so that 1.0 lands exactly on the middle lattice point, where many view transforms clip. */
+static constexpr float shaper_offset = 1.0f / 1024.0f;
+static constexpr float shaper_log_min = -10.0f;
+static const float shaper_log_max = shaper_log_min +
+                                    2.0f * (std::log2(1.0f + shaper_offset) - shaper_log_min);
+static const float shaper_scale = (ColorLUT3D::size - 1) / (shaper_log_max - shaper_log_min);
+
+static float lattice_value(const int i)
+{
+  const float t = float(i) / (ColorLUT3D::size - 1);
+  return std::exp2(shaper_log_min + t * (shaper_log_max - shaper_log_min)) - shaper_offset;
+}
+
+ColorLUT3D::ColorLUT3D(FunctionRef<void(float *rgba, int64_t pixels_num)> fn)
+    : table_(size * size * size)
+{
+  threading::parallel_for(IndexRange(size), 1, [&](const IndexRange b_range) {
+    Array<float4> slice(size * size);
+    for (const int b : b_range) {
+      for (int g = 0; g < size; g++) {
+        for (int r = 0; r < size; r++) {
+          slice[g * size + r] = float4(lattice_value(r), lattice_value(g), lattice_value(b), 1.0f);
+        }
+      }
+      fn(&slice.first().x, slice.size());
+      for (const int i : slice.index_range()) {
+        table_[b * size * size + i] = float4(slice[i].xyz(), 0.0f);
+      }
+    }
+  });
+}
+
+/* Lattice point offsets of the tetrahedron that contains a color, and the weights of its four
+ * corners. The first corner is the lattice point at the lower bound, the last one the point at
+ * the upper bound in all axes. */
+struct Tetrahedron {
+  int offset1;
+  int offset2;
+  float4 weights;
+};
+
+BLI_INLINE Tetrahedron tetrahedron_find(const float fr, const float fg, const float fb)
+{
+  constexpr int sr = 1;
+  constexpr int sg = ColorLUT3D::size;
+  constexpr int sb = ColorLUT3D::size * ColorLUT3D::size;
+
+  if (fr > fg) {
+    if (fg > fb) {
+      return {sr, sr + sg, float4(1.0f - fr, fr - fg, fg - fb, fb)};
+    }
+    if (fr > fb) {
+      return {sr, sr + sb, float4(1.0f - fr, fr - fb, fb - fg, fg)};
+    }
+    return {sb, sr + sb, float4(1.0f - fb, fb - fr, fr - fg, fg)};
+  }
+  if (fb > fg) {
+    return {sb, sg + sb, float4(1.0f - fb, fb - fg, fg - fr, fr)};
+  }
+  if (fb > fr) {
+    return {sg, sg + sb, float4(1.0f - fg, fg - fb, fb - fr, fr)};
+  }
+  return {sg, sr + sg, float4(1.0f - fg, fg - fr, fr - fb, fb)};
+}
+
+#if BLI_HAVE_SSE2
+
+/* Approximate `log2(x)` for positive normal numbers, the error is below 1e-7. */
+BLI_INLINE __m128 log2_sse(const __m128 x)
+{
+  const __m128i bits = _mm_castps_si128(x);
+  __m128i exponent = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+  __m128 mantissa = _mm_castsi128_ps(
+      _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+
+  /* Move the mantissa into [sqrt(0.5), sqrt(2)), where the series below converges quickly. */
+  const __m128 is_large = _mm_cmpgt_ps(mantissa, _mm_set1_ps(float(M_SQRT2)));
+  mantissa = _mm_or_ps(_mm_and_ps(is_large, _mm_mul_ps(mantissa, _mm_set1_ps(0.5f))),
+                       _mm_andnot_ps(is_large, mantissa));
+  exponent = _mm_sub_epi32(exponent, _mm_castps_si128(is_large));
+
+  /* `log(m) = 2 * atanh((m - 1) / (m + 1))`. */
+  const __m128 z = _mm_div_ps(_mm_sub_ps(mantissa, _mm_set1_ps(1.0f)),
+                              _mm_add_ps(mantissa, _mm_set1_ps(1.0f)));
+  const __m128 z2 = _mm_mul_ps(z, z);
+  __m128 poly = _mm_add_ps(_mm_set1_ps(1.0f / 5.0f), _mm_mul_ps(z2, _mm_set1_ps(1.0f / 7.0f)));
+  poly = _mm_add_ps(_mm_set1_ps(1.0f / 3.0f), _mm_mul_ps(z2, poly));
+  poly = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(z2, poly));
+  poly = _mm_mul_ps(_mm_mul_ps(z, poly), _mm_set1_ps(float(2.0 / M_LN2)));
+
+  return _mm_add_ps(_mm_cvtepi32_ps(exponent), poly);
+}
+
+BLI_INLINE void lookup_rgb(const float4 *table, float rgb[3])
+{
+  const __m128 color = _mm_min_ps(_mm_max_ps(_mm_set_ps(0.0f, rgb[2], rgb[1], rgb[0]),
+                                             _mm_setzero_ps()),
+                                  _mm_set1_ps(ColorLUT3D::range_max));
+  __m128 pos = _mm_mul_ps(_mm_sub_ps(log2_sse(_mm_add_ps(color, _mm_set1_ps(shaper_offset))),
+                                     _mm_set1_ps(shaper_log_min)),
+                          _mm_set1_ps(shaper_scale));
+  pos = _mm_min_ps(_mm_max_ps(pos, _mm_setzero_ps()), _mm_set1_ps(ColorLUT3D::size - 1));
+  const __m128 floor = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(pos)),
+                                  _mm_set1_ps(ColorLUT3D::size - 2));
+
+  alignas(16) int index[4];
+  alignas(16) float frac[4];
+  _mm_store_si128(reinterpret_cast<__m128i *>(index), _mm_cvttps_epi32(floor));
+  _mm_store_ps(frac, _mm_sub_ps(pos, floor));
+
+  const float4 *base = table + (index[2] * ColorLUT3D::size + index[1]) * ColorLUT3D::size +
+                       index[0];
+  const Tetrahedron tetra = tetrahedron_find(frac[0], frac[1], frac[2]);
+  constexpr int offset_last = 1 + ColorLUT3D::size + ColorLUT3D::size * ColorLUT3D::size;
+
+  __m128 result = _mm_mul_ps(_mm_loadu_ps(&base->x), _mm_set1_ps(tetra.weights.x));
+  result = _mm_add_ps(result,
+                      _mm_mul_ps(_mm_loadu_ps(&base[tetra.offset1].x),
+                                 _mm_set1_ps(tetra.weights.y)));
+  result = _mm_add_ps(result,
+                      _mm_mul_ps(_mm_loadu_ps(&base[tetra.offset2].x),
+                                 _mm_set1_ps(tetra.weights.z)));
+  result = _mm_add_ps(result,
+                      _mm_mul_ps(_mm_loadu_ps(&base[offset_last].x),
+                                 _mm_set1_ps(tetra.weights.w)));
+
+  alignas(16) float out[4];
+  _mm_store_ps(out, result);
+  rgb[0] = out[0];
+  rgb[1] = out[1];
+  rgb[2] = out[2];
+}
+
+#else
+
+BLI_INLINE void lookup_rgb(const float4 *table, float rgb[3])
+{
+  int index[3];
+  float frac[3];
+  for (int i = 0; i < 3; i++) {
+    const float color = clamp_f(rgb[i], 0.0f, ColorLUT3D::range_max);
+    const float pos = clamp_f((std::log2(color + shaper_offset) - shaper_log_min) * shaper_scale,
+                              0.0f,
+                              ColorLUT3D::size - 1);
+    const float floor = min_ff(float(int(pos)), ColorLUT3D::size - 2);
+    index[i] = int(floor);
+    frac[i] = pos - floor;
+  }
+
+  const float4 *base = table + (index[2] * ColorLUT3D::size + index[1]) * ColorLUT3D::size +
+                       index[0];
+  const Tetrahedron tetra = tetrahedron_find(frac[0], frac[1], frac[2]);
+  constexpr int offset_last = 1 + ColorLUT3D::size + ColorLUT3D::size * ColorLUT3D::size;
+
+  const float4 result = base[0] * tetra.weights.x + base[tetra.offset1] * tetra.weights.y +
+                        base[tetra.offset2] * tetra.weights.z +
+                        base[offset_last] * tetra.weights.w;
+  rgb[0] = result.x;
+  rgb[1] = result.y;
+  rgb[2] = result.z;
+}
+
+#endif
+
+void ColorLUT3D::apply_rgb(float rgb[3]) const
+{
+  lookup_rgb(table_.data(), rgb);
+}
+
+void ColorLUT3D::apply(float *buffer,
+                       const int64_t pixels_num,
+                       const int channels,
+                       const bool predivide) const
+{
+  BLI_assert(ELEM(channels, 3, 4));
+  const float4 *table = table_.data();
+
+  if (channels == 4 && predivide) {
+    for (int64_t i = 0; i < pixels_num; i++) {
+      float *pixel = buffer + i * 4;
+      const float alpha = pixel[3];
+      if (ELEM(alpha, 0.0f, 1.0f)) {
+        lookup_rgb(table, pixel);
+        continue;
+      }
+      const float alpha_inv = 1.0f / alpha;
+      pixel[0] *= alpha_inv;
+      pixel[1] *= alpha_inv;
+      pixel[2] *= alpha_inv;
+      lookup_rgb(table, pixel);
+      pixel[0] *= alpha;
+      pixel[1] *= alpha;
+      pixel[2] *= alpha;
+    }
+    return;
+  }
+
+  for (int64_t i = 0; i < pixels_num; i++) {
+    lookup_rgb(table, buffer + i * channels);
+  }
+}
+
+}  // namespace blender::imbuf
@@ -0,0 +1,53 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup imbuf
+ */
+
+#pragma once
+
+#include "BLI_array.hh"
+#include "BLI_function_ref.hh"
+#include "BLI_math_vector_types.hh"
+
+namespace blender::imbuf {
+
+/**
+ * RGB transform baked into a 3D lookup table, used to apply display transforms to large float
+ * buffers without evaluating OpenColorIO and curve mapping for every pixel.
+ *
+ * The lattice is spaced logarithmically, so that scene linear values with a high dynamic range
+ * keep enough precision in the shadows. Zero and one map exactly to lattice points, negative
+ * values and values above #range_max are clamped. Lookups use tetrahedral interpolation.
+ */
+class ColorLUT3D {
+ public:
+  /** Number of lattice points along each axis. */
+  static constexpr int size = 65;
+  /** Largest scene linear value that is not clamped. */
+  static constexpr float range_max = 1024.0f;
+
+ private:
+  /** RGB of every lattice point, red varies fastest. The fourth component is padding. */
+  Array<float4> table_;
+
+ public:
+  /**
+   * Bake the table by evaluating \a fn on the lattice points. The function transforms
+   * \a pixels_num RGBA pixels in place, alpha is always 1.
+   */
+  ColorLUT3D(FunctionRef<void(float *rgba, int64_t pixels_num)> fn);
+
+  /**
+   * Transform pixels of a buffer with 3 or 4 channels in place. With \a predivide, colors are
+   * divided by alpha before the lookup and multiplied by it afterwards.
+   */
+  void apply(float *buffer, int64_t pixels_num, int channels, bool predivide) const;
+
+  /** Transform a single RGB color. */
+  void apply_rgb(float rgb[3]) const;
+};
+
+}  // namespace blender::imbuf
@@ -0,0 +1,96 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <cmath>
+
+#include "colormanagement_lut.hh"
+
+namespace blender::imbuf::tests {
+
+static void transform_identity(float * /*rgba*/, int64_t /*pixels_num*/) {}
+
+/* Display-like transform: clamp and the sRGB transfer function. */
+static void transform_display(float *rgba, const int64_t pixels_num)
+{
+  for (int64_t i = 0; i < pixels_num; i++) {
+    for (int c = 0; c < 3; c++) {
+      const float v = std::min(std::max(rgba[i * 4 + c], 0.0f), 1.0f);
+      rgba[i * 4 + c] = (v <= 0.0031308f) ? v * 12.92f :
+                                            1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+    }
+  }
+}
+
+TEST(imbuf_colormanagement_lut, identity)
+{
+  const ColorLUT3D lut(transform_identity);
+
+  const float colors[][3] = {
+      {0.0f, 0.0f, 0.0f},
+      {1.0f, 1.0f, 1.0f},
+      {0.18f, 0.5f, 0.9f},
+      {0.01f, 2.5f, 100.0f},
+  };
+  for (const auto &color : colors) {
+    float result[3] = {color[0], color[1], color[2]};
+    lut.apply_rgb(result);
+    for (int c = 0; c < 3; c++) {
+      EXPECT_NEAR(result[c], color[c], color[c] * 0.02f + 1e-6f);
+    }
+  }
+}
+
+TEST(imbuf_colormanagement_lut, clamp)
+{
+  const ColorLUT3D lut(transform_identity);
+
+  float result[3] = {-1.0f, ColorLUT3D::range_max * 2.0f, 0.0f};
+  lut.apply_rgb(result);
+  EXPECT_NEAR(result[0], 0.0f, 1e-6f);
+  EXPECT_NEAR(result[1], ColorLUT3D::range_max, ColorLUT3D::range_max * 1e-3f);
+  EXPECT_NEAR(result[2], 0.0f, 1e-6f);
+}
+
+TEST(imbuf_colormanagement_lut, display)
+{
+  const ColorLUT3D lut(transform_display);
+
+  float max_error = 0.0f;
+  for (int i = 0; i <= 100; i++) {
+    const float value = float(i) / 100.0f;
+    float expected[4] = {value, value * 0.5f, 1.0f - value, 1.0f};
+    float result[3] = {expected[0], expected[1], expected[2]};
+    transform_display(expected, 1);
+    lut.apply_rgb(result);
+    for (int c = 0; c < 3; c++) {
+      max_error = std::max(max_error, std::abs(result[c] - expected[c]));
+    }
+  }
+  /* Less than half a step of an 8 bit display buffer. */
+  EXPECT_LT(max_error, 0.5f / 255.0f);
+}
+
+TEST(imbuf_colormanagement_lut, apply_predivide)
+{
+  const ColorLUT3D lut(transform_display);
+
+  float buffer[3][4] = {
+      {0.1f, 0.2f, 0.3f, 1.0f},
+      {0.05f, 0.1f, 0.15f, 0.5f},
+      {0.0f, 0.0f, 0.0f, 0.0f},
+  };
+  lut.apply(&buffer[0][0], 3, 4, true);
+
+  for (int c = 0; c < 3; c++) {
+    EXPECT_NEAR(buffer[1][c], buffer[0][c] * 0.5f, 1e-3f);
+    EXPECT_NEAR(buffer[2][c], 0.0f, 1e-6f);
+  }
+  EXPECT_EQ(buffer[0][3], 1.0f);
+  EXPECT_EQ(buffer[1][3], 0.5f);
+  EXPECT_EQ(buffer[2][3], 0.0f);
+}
+
+}  // namespace blender::imbuf::tests
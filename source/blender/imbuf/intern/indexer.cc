@@ -1328,6 +1328,9 @@ void IMB_free_indices(ImBufAnim *anim)
 {
   int i;
 
+  /* It is started again on the next sequential access. */
+  imb_anim_read_ahead_stop(anim);
+
   for (i = 0; i < IMB_PROXY_MAX_SLOT; i++) {
     if (anim->proxy_anim[i]) {
       IMB_close_anim(anim->proxy_anim[i]);
@@ -1379,6 +1382,9 @@ ImBufAnim *IMB_anim_open_proxy(ImBufAnim *anim, IMB_Proxy_Size preview_size)
 
   /* proxies are generated in the same color space as animation itself */
   anim->proxy_anim[i] = IMB_open_anim(filepath, 0, 0, anim->colorspace);
+  if (anim->proxy_anim[i]) {
+    IMB_anim_set_read_ahead(anim->proxy_anim[i], anim->read_ahead_frames_max);
+  }
 
   anim->proxies_tried |= preview_size;
 
@@ -1416,13 +1422,12 @@ ImBufAnimIndex *IMB_anim_open_index(ImBufAnim *anim, IMB_Timecode_Type tc)
 
 int IMB_anim_index_get_frame_index(ImBufAnim *anim, IMB_Timecode_Type tc, int position)
 {
+  imb_anim_decode_lock(anim);
   ImBufAnimIndex *idx = IMB_anim_open_index(anim, tc);
+  const int frame_index = idx ? IMB_indexer_get_frame_index(idx, position) : position;
+  imb_anim_decode_unlock(anim);
 
-  if (!idx) {
-    return position;
-  }
-
-  return IMB_indexer_get_frame_index(idx, position);
+  return frame_index;
 }
 
 int IMB_anim_proxy_get_existing(ImBufAnim *anim)
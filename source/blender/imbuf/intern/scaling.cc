@@ -8,13 +8,17 @@
 
 #include <cmath>
 
+#include "BLI_array.hh"
+#include "BLI_math_vector.h"
+#include "BLI_math_vector_types.hh"
+#include "BLI_simd.hh"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
 #include "MEM_guardedalloc.h"
 
 #include "IMB_filter.hh"
 #include "IMB_imbuf.hh"
 #include "IMB_imbuf_types.hh"
-#include "IMB_interp.hh"
 
 #include "BLI_sys_types.h" /* for intptr_t support */
 
@@ -1572,118 +1576,384 @@ bool IMB_scalefastImBuf(ImBuf *ibuf, uint newx, uint newy)
   return true;
 }
 
-/* ******** threaded scaling ******** */
+/* ******** separable filter scaling ******** */
 
-struct ScaleTreadInitData {
-  ImBuf *ibuf;
+namespace blender::imbuf {
 
-  uint newx;
-  uint newy;
-
-  uchar *byte_buffer;
-  float *float_buffer;
+/**
+ * Filter weights along one axis: every destination pixel is a weighted sum of #taps consecutive
+ * source pixels starting at #first. Edge pixels are extended, the weights of samples outside of
+ * the image are folded into the closest pixel inside of it.
+ */
+struct ScaleFilterWeights {
+  int taps;
+  Array<int> first;
+  /** #taps weights per destination pixel, normalized to sum up to one. */
+  Array<float> weights;
 };
 
-struct ScaleThreadData {
-  ImBuf *ibuf;
+static float scale_filter_radius(const IMBScaleFilter filter)
+{
+  switch (filter) {
+    case IMBScaleFilter::Box:
+      return 0.5f;
+    case IMBScaleFilter::Bilinear:
+      return 1.0f;
+    case IMBScaleFilter::Bicubic:
+      return 2.0f;
+    case IMBScaleFilter::Lanczos:
+      return 3.0f;
+  }
+  BLI_assert_unreachable();
+  return 1.0f;
+}
 
-  uint newx;
-  uint newy;
+static float sinc(const float x)
+{
+  if (x == 0.0f) {
+    return 1.0f;
+  }
+  return std::sin(float(M_PI) * x) / (float(M_PI) * x);
+}
 
-  int start_line;
-  int tot_line;
+static float scale_filter_eval(const IMBScaleFilter filter, float x)
+{
+  x = std::abs(x);
+  switch (filter) {
+    case IMBScaleFilter::Box:
+      return x <= 0.5f ? 1.0f : 0.0f;
+    case IMBScaleFilter::Bilinear:
+      return std::max(1.0f - x, 0.0f);
+    case IMBScaleFilter::Bicubic: {
+      /* Catmull-Rom spline. */
+      constexpr float a = -0.5f;
+      if (x < 1.0f) {
+        return ((a + 2.0f) * x - (a + 3.0f)) * x * x + 1.0f;
+      }
+      if (x < 2.0f) {
+        return ((a * x - 5.0f * a) * x + 8.0f * a) * x - 4.0f * a;
+      }
+      return 0.0f;
+    }
+    case IMBScaleFilter::Lanczos:
+      return x < 3.0f ? sinc(x) * sinc(x / 3.0f) : 0.0f;
+  }
+  BLI_assert_unreachable();
+  return 0.0f;
+}
 
-  uchar *byte_buffer;
-  float *float_buffer;
-};
+static ScaleFilterWeights scale_filter_weights(const int src_size,
+                                               const int dst_size,
+                                               const IMBScaleFilter filter)
+{
+  ScaleFilterWeights result;
+  result.first.reinitialize(dst_size);
+
+  if (src_size == dst_size) {
+    result.taps = 1;
+    result.weights = Array<float>(dst_size, 1.0f);
+    for (const int i : IndexRange(dst_size)) {
+      result.first[i] = i;
+    }
+    return result;
+  }
+
+  /* When scaling down the filter is stretched, so that every source pixel contributes. */
+  const float scale = float(src_size) / float(dst_size);
+  const float filter_scale = std::max(scale, 1.0f);
+  const float support = scale_filter_radius(filter) * filter_scale;
+  const int taps = std::min(int(std::ceil(support * 2.0f)) + 2, src_size);
+
+  result.taps = taps;
+  result.weights = Array<float>(int64_t(dst_size) * taps, 0.0f);
+
+  for (const int i : IndexRange(dst_size)) {
+    /* Positions are in source pixel units, pixel `j` covers `[j, j + 1)`. */
+    const float center = (float(i) + 0.5f) * scale;
+    const int start = int(std::floor(center - support - 0.5f));
+    const int end = int(std::ceil(center + support - 0.5f));
+    const int first = std::clamp(start, 0, src_size - taps);
+    float *weights = &result.weights[int64_t(i) * taps];
+
+    float weight_sum = 0.0f;
+    for (int j = start; j <= end; j++) {
+      float weight;
+      if (filter == IMBScaleFilter::Box) {
+        /* Exact area coverage, point sampling a box misses pixels at fractional scales. */
+        const float overlap = std::min(float(j + 1), center + support) -
+                              std::max(float(j), center - support);
+        weight = std::max(overlap, 0.0f);
+      }
+      else {
+        weight = scale_filter_eval(filter, (float(j) + 0.5f - center) / filter_scale);
+      }
+      if (weight == 0.0f) {
+        continue;
+      }
+      const int tap = std::clamp(j, 0, src_size - 1) - first;
+      BLI_assert(tap >= 0 && tap < taps);
+      weights[tap] += weight;
+      weight_sum += weight;
+    }
+
+    if (weight_sum != 0.0f) {
+      for (const int tap : IndexRange(taps)) {
+        weights[tap] /= weight_sum;
+      }
+    }
+    else {
+      weights[std::clamp(int(center), first, first + taps - 1) - first] = 1.0f;
+    }
+    result.first[i] = first;
+  }
+  return result;
+}
+
+/* Four channel pixels are processed with one SIMD register each. Byte pixels are converted to
+ * float for filtering, intermediate results are never quantized. */
+#if BLI_HAVE_SSE2
+
+using ScalePixel = __m128;
 
-static void scale_thread_init(void *data_v, int start_line, int tot_line, void *init_data_v)
+BLI_INLINE __m128 scale_pixel_zero()
 {
-  ScaleThreadData *data = (ScaleThreadData *)data_v;
-  ScaleTreadInitData *init_data = (ScaleTreadInitData *)init_data_v;
+  return _mm_setzero_ps();
+}
 
-  data->ibuf = init_data->ibuf;
+BLI_INLINE __m128 scale_pixel_load(const float *src)
+{
+  return _mm_loadu_ps(src);
+}
 
-  data->newx = init_data->newx;
-  data->newy = init_data->newy;
+BLI_INLINE __m128 scale_pixel_load(const uchar *src)
+{
+  int32_t packed;
+  memcpy(&packed, src, sizeof(packed));
+  const __m128i zero = _mm_setzero_si128();
+  __m128i value = _mm_cvtsi32_si128(packed);
+  value = _mm_unpacklo_epi16(_mm_unpacklo_epi8(value, zero), zero);
+  return _mm_cvtepi32_ps(value);
+}
+
+BLI_INLINE __m128 scale_pixel_madd(const __m128 accum, const __m128 value, const float weight)
+{
+  return _mm_add_ps(accum, _mm_mul_ps(value, _mm_set1_ps(weight)));
+}
 
-  data->start_line = start_line;
-  data->tot_line = tot_line;
+BLI_INLINE void scale_pixel_store(float *dst, const __m128 value)
+{
+  _mm_storeu_ps(dst, value);
+}
 
-  data->byte_buffer = init_data->byte_buffer;
-  data->float_buffer = init_data->float_buffer;
+BLI_INLINE void scale_pixel_store(uchar *dst, const __m128 value)
+{
+  const __m128 clamped = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+  __m128i packed = _mm_cvtps_epi32(clamped);
+  packed = _mm_packus_epi16(_mm_packs_epi32(packed, packed), packed);
+  const int32_t result = _mm_cvtsi128_si32(packed);
+  memcpy(dst, &result, sizeof(result));
 }
 
-static void *do_scale_thread(void *data_v)
+#else
+
+using ScalePixel = float4;
+
+BLI_INLINE float4 scale_pixel_zero()
 {
-  using namespace blender::imbuf;
-  ScaleThreadData *data = (ScaleThreadData *)data_v;
-  ImBuf *ibuf = data->ibuf;
-  int i;
-  float factor_x = float(ibuf->x) / data->newx;
-  float factor_y = float(ibuf->y) / data->newy;
-
-  for (i = 0; i < data->tot_line; i++) {
-    int y = data->start_line + i;
-    int x;
-
-    for (x = 0; x < data->newx; x++) {
-      float u = float(x) * factor_x;
-      float v = float(y) * factor_y;
-      int offset = y * data->newx + x;
-
-      if (data->byte_buffer) {
-        interpolate_bilinear_border_byte(ibuf, data->byte_buffer + 4 * offset, u, v);
+  return float4(0.0f);
+}
+
+BLI_INLINE float4 scale_pixel_load(const float *src)
+{
+  return float4(src);
+}
+
+BLI_INLINE float4 scale_pixel_load(const uchar *src)
+{
+  return float4(src[0], src[1], src[2], src[3]);
+}
+
+BLI_INLINE float4 scale_pixel_madd(const float4 accum, const float4 value, const float weight)
+{
+  return accum + value * weight;
+}
+
+BLI_INLINE void scale_pixel_store(float *dst, const float4 value)
+{
+  copy_v4_v4(dst, value);
+}
+
+BLI_INLINE void scale_pixel_store(uchar *dst, const float4 value)
+{
+  for (int i = 0; i < 4; i++) {
+    dst[i] = uchar(clamp_f(value[i], 0.0f, 255.0f) + 0.5f);
+  }
+}
+
+#endif
+
+/** Filter one row horizontally into \a dst. */
+template<typename T>
+static void scale_row_x(const T *src, float *dst, const int channels, const ScaleFilterWeights &wx)
+{
+  const int taps = wx.taps;
+  const int dst_width = int(wx.first.size());
+
+  if (channels == 4) {
+    for (const int x : IndexRange(dst_width)) {
+      const float *weights = &wx.weights[int64_t(x) * taps];
+      const T *src_pixel = src + int64_t(wx.first[x]) * 4;
+      ScalePixel accum = scale_pixel_zero();
+      for (int tap = 0; tap < taps; tap++) {
+        accum = scale_pixel_madd(accum, scale_pixel_load(src_pixel + tap * 4), weights[tap]);
       }
+      scale_pixel_store(dst + int64_t(x) * 4, accum);
+    }
+    return;
+  }
 
-      if (data->float_buffer) {
-        float *pixel = data->float_buffer + ibuf->channels * offset;
-        blender::math::interpolate_bilinear_border_fl(
-            ibuf->float_buffer.data, pixel, ibuf->x, ibuf->y, ibuf->channels, u, v);
+  for (const int x : IndexRange(dst_width)) {
+    const float *weights = &wx.weights[int64_t(x) * taps];
+    const T *src_pixel = src + int64_t(wx.first[x]) * channels;
+    for (int c = 0; c < channels; c++) {
+      float accum = 0.0f;
+      for (int tap = 0; tap < taps; tap++) {
+        accum += float(src_pixel[tap * channels + c]) * weights[tap];
       }
+      dst[int64_t(x) * channels + c] = accum;
     }
   }
+}
 
-  return nullptr;
+/** Add \a src multiplied by \a weight to \a dst, both rows have \a len floats. */
+static void scale_row_madd(float *dst, const float *src, const float weight, const int64_t len)
+{
+  int64_t i = 0;
+#if BLI_HAVE_SSE2
+  const __m128 weight4 = _mm_set1_ps(weight);
+  for (; i + 4 <= len; i += 4) {
+    _mm_storeu_ps(dst + i,
+                  _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), weight4)));
+  }
+#endif
+  for (; i < len; i++) {
+    dst[i] += src[i] * weight;
+  }
 }
 
-void IMB_scaleImBuf_threaded(ImBuf *ibuf, uint newx, uint newy)
+static void scale_row_store(float *dst, const float *src, const int64_t len)
 {
-  BLI_assert_msg(newx > 0 && newy > 0, "Images must be at least 1 on both dimensions!");
+  memcpy(dst, src, sizeof(float) * len);
+}
 
-  ScaleTreadInitData init_data = {nullptr};
+static void scale_row_store(uchar *dst, const float *src, const int64_t len)
+{
+  /* Byte buffers always have four channels. */
+  for (int64_t i = 0; i < len; i += 4) {
+    scale_pixel_store(dst + i, scale_pixel_load(src + i));
+  }
+}
 
-  /* prepare initialization data */
-  init_data.ibuf = ibuf;
+/**
+ * Resample \a src into \a dst, first horizontally then vertically. Destination rows are split
+ * into chunks, each chunk filters only the source rows it needs into a local buffer, which keeps
+ * the intermediate image small and in cache.
+ */
+template<typename T>
+static void scale_buffer(const T *src,
+                         T *dst,
+                         const int channels,
+                         const int src_width,
+                         const ScaleFilterWeights &wx,
+                         const ScaleFilterWeights &wy,
+                         const bool threaded)
+{
+  const int dst_width = int(wx.first.size());
+  const int dst_height = int(wy.first.size());
+  const int64_t src_row_len = int64_t(src_width) * channels;
+  const int64_t dst_row_len = int64_t(dst_width) * channels;
+
+  auto scale_rows = [&](const IndexRange dst_rows) {
+    const int src_row_first = wy.first[dst_rows.first()];
+    const int src_row_end = wy.first[dst_rows.last()] + wy.taps;
+    Array<float> rows_x(int64_t(src_row_end - src_row_first) * dst_row_len);
+    for (const int y : IndexRange(src_row_first, src_row_end - src_row_first)) {
+      scale_row_x(src + y * src_row_len,
+                  &rows_x[int64_t(y - src_row_first) * dst_row_len],
+                  channels,
+                  wx);
+    }
 
-  init_data.newx = newx;
-  init_data.newy = newy;
+    Array<float> row(dst_row_len);
+    for (const int y : dst_rows) {
+      const float *weights = &wy.weights[int64_t(y) * wy.taps];
+      row.fill(0.0f);
+      for (int tap = 0; tap < wy.taps; tap++) {
+        if (weights[tap] == 0.0f) {
+          continue;
+        }
+        const int src_y = wy.first[y] + tap - src_row_first;
+        scale_row_madd(row.data(), &rows_x[src_y * dst_row_len], weights[tap], dst_row_len);
+      }
+      scale_row_store(dst + y * dst_row_len, row.data(), dst_row_len);
+    }
+  };
 
-  if (ibuf->byte_buffer.data) {
-    init_data.byte_buffer = static_cast<uchar *>(
-        MEM_mallocN(4 * newx * newy * sizeof(char), "threaded scale byte buffer"));
+  const int64_t grain_size = std::max<int64_t>(1, 65536 / std::max(dst_width, 1));
+  if (threaded) {
+    threading::parallel_for(IndexRange(dst_height), grain_size, scale_rows);
   }
-
-  if (ibuf->float_buffer.data) {
-    init_data.float_buffer = static_cast<float *>(
-        MEM_mallocN(ibuf->channels * newx * newy * sizeof(float), "threaded scale float buffer"));
+  else {
+    for (int64_t y = 0; y < dst_height; y += grain_size) {
+      scale_rows(IndexRange(y, std::min<int64_t>(grain_size, dst_height - y)));
+    }
   }
+}
 
-  /* actual scaling threads */
-  IMB_processor_apply_threaded(
-      newy, sizeof(ScaleThreadData), &init_data, scale_thread_init, do_scale_thread);
+}  // namespace blender::imbuf
 
-  /* alter image buffer */
-  ibuf->x = newx;
-  ibuf->y = newy;
+bool IMB_scale(
+    ImBuf *ibuf, const uint newx, const uint newy, const IMBScaleFilter filter, const bool threaded)
+{
+  using namespace blender::imbuf;
+  BLI_assert_msg(newx > 0 && newy > 0, "Images must be at least 1 on both dimensions!");
+
+  if (ibuf == nullptr) {
+    return false;
+  }
+  if (ibuf->byte_buffer.data == nullptr && ibuf->float_buffer.data == nullptr) {
+    return false;
+  }
+  if (newx == ibuf->x && newy == ibuf->y) {
+    return false;
+  }
+
+  const ScaleFilterWeights wx = scale_filter_weights(ibuf->x, newx, filter);
+  const ScaleFilterWeights wy = scale_filter_weights(ibuf->y, newy, filter);
 
   if (ibuf->byte_buffer.data) {
+    uchar *byte_buffer = static_cast<uchar *>(
+        MEM_mallocN(size_t(4) * newx * newy * sizeof(uchar), "scale byte buffer"));
+    scale_buffer(ibuf->byte_buffer.data, byte_buffer, 4, ibuf->x, wx, wy, threaded);
     imb_freerectImBuf(ibuf);
-    IMB_assign_byte_buffer(ibuf, init_data.byte_buffer, IB_TAKE_OWNERSHIP);
+    IMB_assign_byte_buffer(ibuf, byte_buffer, IB_TAKE_OWNERSHIP);
   }
 
   if (ibuf->float_buffer.data) {
+    float *float_buffer = static_cast<float *>(
+        MEM_mallocN(size_t(ibuf->channels) * newx * newy * sizeof(float), "scale float buffer"));
+    scale_buffer(
+        ibuf->float_buffer.data, float_buffer, ibuf->channels, ibuf->x, wx, wy, threaded);
     imb_freerectfloatImBuf(ibuf);
-    IMB_assign_float_buffer(ibuf, init_data.float_buffer, IB_TAKE_OWNERSHIP);
+    IMB_assign_float_buffer(ibuf, float_buffer, IB_TAKE_OWNERSHIP);
   }
+
+  ibuf->x = newx;
+  ibuf->y = newy;
+  return true;
+}
+
+void IMB_scaleImBuf_threaded(ImBuf *ibuf, uint newx, uint newy)
+{
+  IMB_scale(ibuf, newx, newy, IMBScaleFilter::Bilinear, true);
 }
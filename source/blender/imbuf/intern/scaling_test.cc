@@ -0,0 +1,123 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "IMB_imbuf.hh"
+#include "IMB_imbuf_types.hh"
+
+namespace blender::imbuf::tests {
+
+static ImBuf *create_gradient_image(const int width, const int height, const bool use_float)
+{
+  ImBuf *img = IMB_allocImBuf(width, height, 32, use_float ? IB_rectfloat : IB_rect);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      const int64_t offset = (int64_t(y) * width + x) * 4;
+      const float value = float(x) / float(width - 1);
+      if (use_float) {
+        float *pixel = img->float_buffer.data + offset;
+        pixel[0] = value;
+        pixel[1] = 1.0f - value;
+        pixel[2] = 0.5f;
+        pixel[3] = 1.0f;
+      }
+      else {
+        uchar *pixel = img->byte_buffer.data + offset;
+        pixel[0] = uchar(value * 255.0f + 0.5f);
+        pixel[1] = uchar((1.0f - value) * 255.0f + 0.5f);
+        pixel[2] = 128;
+        pixel[3] = 255;
+      }
+    }
+  }
+  return img;
+}
+
+TEST(imbuf_scaling, box_2x_smaller_byte)
+{
+  ImBuf *img = IMB_allocImBuf(4, 2, 32, IB_rect);
+  const uchar src[2][4] = {{0, 100, 10, 20}, {50, 150, 30, 40}};
+  for (int y = 0; y < 2; y++) {
+    for (int x = 0; x < 4; x++) {
+      uchar *pixel = img->byte_buffer.data + (y * 4 + x) * 4;
+      pixel[0] = pixel[1] = pixel[2] = src[y][x];
+      pixel[3] = 255;
+    }
+  }
+
+  EXPECT_TRUE(IMB_scale(img, 2, 1, IMBScaleFilter::Box, false));
+  EXPECT_EQ(img->x, 2);
+  EXPECT_EQ(img->y, 1);
+  const uchar *res = img->byte_buffer.data;
+  EXPECT_EQ(res[0], 75);
+  EXPECT_EQ(res[3], 255);
+  EXPECT_EQ(res[4], 25);
+  EXPECT_EQ(res[7], 255);
+  IMB_freeImBuf(img);
+}
+
+TEST(imbuf_scaling, same_size)
+{
+  ImBuf *img = create_gradient_image(8, 8, false);
+  EXPECT_FALSE(IMB_scale(img, 8, 8, IMBScaleFilter::Lanczos));
+  IMB_freeImBuf(img);
+}
+
+/* Scaling a gradient with any filter should keep it a gradient, with the edges extended. */
+static void test_gradient(const IMBScaleFilter filter,
+                          const bool use_float,
+                          const int newx,
+                          const int newy)
+{
+  constexpr int width = 67;
+  constexpr int height = 13;
+  ImBuf *img = create_gradient_image(width, height, use_float);
+  EXPECT_TRUE(IMB_scale(img, newx, newy, filter));
+
+  const float tolerance = use_float ? 0.02f : 0.02f * 255.0f;
+  for (int y = 0; y < newy; y++) {
+    for (int x = 0; x < newx; x++) {
+      const float src_x = (float(x) + 0.5f) * width / newx - 0.5f;
+      const float value = std::clamp(src_x / float(width - 1), 0.0f, 1.0f);
+      const int64_t offset = (int64_t(y) * newx + x) * 4;
+      if (use_float) {
+        const float *pixel = img->float_buffer.data + offset;
+        EXPECT_NEAR(pixel[0], value, tolerance);
+        EXPECT_NEAR(pixel[1], 1.0f - value, tolerance);
+        EXPECT_NEAR(pixel[2], 0.5f, 1e-5f);
+        EXPECT_NEAR(pixel[3], 1.0f, 1e-5f);
+      }
+      else {
+        const uchar *pixel = img->byte_buffer.data + offset;
+        EXPECT_NEAR(pixel[0], value * 255.0f, tolerance);
+        EXPECT_NEAR(pixel[1], (1.0f - value) * 255.0f, tolerance);
+        EXPECT_EQ(pixel[2], 128);
+        EXPECT_EQ(pixel[3], 255);
+      }
+    }
+  }
+  IMB_freeImBuf(img);
+}
+
+TEST(imbuf_scaling, gradient_smaller)
+{
+  for (const bool use_float : {false, true}) {
+    test_gradient(IMBScaleFilter::Box, use_float, 23, 5);
+    test_gradient(IMBScaleFilter::Bilinear, use_float, 23, 5);
+    test_gradient(IMBScaleFilter::Bicubic, use_float, 23, 5);
+    test_gradient(IMBScaleFilter::Lanczos, use_float, 23, 5);
+  }
+}
+
+TEST(imbuf_scaling, gradient_larger)
+{
+  for (const bool use_float : {false, true}) {
+    test_gradient(IMBScaleFilter::Bilinear, use_float, 150, 31);
+    test_gradient(IMBScaleFilter::Bicubic, use_float, 150, 31);
+    test_gradient(IMBScaleFilter::Lanczos, use_float, 150, 31);
+  }
+}
+
+}  // namespace blender::imbuf::tests
@@ -0,0 +1,107 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "BLI_function_ref.hh"
+#include "BLI_index_range.hh"
+#include "BLI_timeit.hh"
+
+#include "IMB_imbuf.hh"
+#include "IMB_imbuf_types.hh"
+
+/**
+ * Compares #IMB_scale with the box and bilinear scaling of #IMB_scaleImBuf, for sizes used by
+ * proxies, thumbnails and the sequencer.
+ */
+
+namespace blender::imbuf::tests {
+
+static constexpr int SRC_WIDTH = 3840;
+static constexpr int SRC_HEIGHT = 2160;
+static constexpr int RUNS_NUM = 5;
+
+static ImBuf *create_test_image(const bool use_float)
+{
+  ImBuf *ibuf = IMB_allocImBuf(SRC_WIDTH, SRC_HEIGHT, 32, use_float ? IB_rectfloat : IB_rect);
+  const int64_t pixels_num = int64_t(SRC_WIDTH) * SRC_HEIGHT;
+  for (const int64_t i : IndexRange(pixels_num * 4)) {
+    const int value = int((i * 7919) % 256);
+    if (use_float) {
+      ibuf->float_buffer.data[i] = float(value) / 255.0f;
+    }
+    else {
+      ibuf->byte_buffer.data[i] = uchar(value);
+    }
+  }
+  return ibuf;
+}
+
+/* Use the fastest of multiple runs to reduce the noise. */
+static double measure_ms(const ImBuf *src, const FunctionRef<void(ImBuf *ibuf)> fn)
+{
+  timeit::Nanoseconds min_duration = timeit::Nanoseconds::max();
+  for ([[maybe_unused]] const int run : IndexRange(RUNS_NUM)) {
+    ImBuf *ibuf = IMB_dupImBuf(src);
+    const timeit::TimePoint start = timeit::Clock::now();
+    fn(ibuf);
+    min_duration = std::min(min_duration, timeit::Clock::now() - start);
+    IMB_freeImBuf(ibuf);
+  }
+  return double(min_duration.count()) / 1e6;
+}
+
+static void run_benchmark(const bool use_float, const int newx, const int newy)
+{
+  ImBuf *src = create_test_image(use_float);
+  std::cout << (use_float ? "Float " : "Byte ") << SRC_WIDTH << "x" << SRC_HEIGHT << " -> "
+            << newx << "x" << newy << ":\n";
+
+  std::cout << "  IMB_scaleImBuf:          "
+            << measure_ms(src, [&](ImBuf *ibuf) { IMB_scaleImBuf(ibuf, newx, newy); }) << " ms\n";
+
+  const std::pair<IMBScaleFilter, const char *> filters[] = {
+      {IMBScaleFilter::Box, "Box"},
+      {IMBScaleFilter::Bilinear, "Bilinear"},
+      {IMBScaleFilter::Bicubic, "Bicubic"},
+      {IMBScaleFilter::Lanczos, "Lanczos"},
+  };
+  for (const auto &[filter, name] : filters) {
+    const double single_ms = measure_ms(
+        src, [&](ImBuf *ibuf) { IMB_scale(ibuf, newx, newy, filter, false); });
+    const double threaded_ms = measure_ms(
+        src, [&](ImBuf *ibuf) { IMB_scale(ibuf, newx, newy, filter, true); });
+    std::cout << "  IMB_scale " << name << ": " << single_ms << " ms, threaded " << threaded_ms
+              << " ms\n";
+  }
+
+  IMB_freeImBuf(src);
+}
+
+TEST(imbuf_scaling_performance, proxy)
+{
+  run_benchmark(false, SRC_WIDTH / 4, SRC_HEIGHT / 4);
+  run_benchmark(true, SRC_WIDTH / 4, SRC_HEIGHT / 4);
+}
+
+TEST(imbuf_scaling_performance, thumbnail)
+{
+  run_benchmark(false, 256, 144);
+}
+
+TEST(imbuf_scaling_performance, fractional)
+{
+  run_benchmark(false, 2560, 1440);
+  run_benchmark(true, 2560, 1440);
+}
+
+TEST(imbuf_scaling_performance, larger)
+{
+  run_benchmark(false, 5760, 3240);
+}
+
+}  // namespace blender::imbuf::tests
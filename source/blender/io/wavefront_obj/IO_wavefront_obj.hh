@@ -80,6 +80,11 @@ struct OBJImportParams {
   bool validate_meshes = true;
   bool relative_paths = true;
   bool clear_selection = true;
+  /**
+   * Number of parts each read buffer is split into to be tokenized in parallel.
+   * Value 0 uses the number of available threads, 1 parses on the calling thread only.
+   */
+  int threads_num = 0;
 
   ReportList *reports = nullptr;
 };
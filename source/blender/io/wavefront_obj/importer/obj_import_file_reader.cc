@@ -14,6 +14,8 @@
 #include "BLI_math_vector_types.hh"
 #include "BLI_string.h"
 #include "BLI_string_ref.hh"
+#include "BLI_task.hh"
+#include "BLI_threads.h"
 #include "BLI_vector.hh"
 
 #include "obj_export_mtl.hh"
@@ -71,6 +73,27 @@ static Geometry *create_geometry(Geometry *const prev_geometry,
   return new_geometry();
 }
 
+/**
+ * Add a color for the vertex at the given index, either extending the last vertex colors block
+ * or starting a new one.
+ */
+static void add_vertex_color(const int vertex_index,
+                             const float3 &color,
+                             GlobalVertices &r_global_vertices)
+{
+  auto &blocks = r_global_vertices.vertex_colors;
+  /* If we don't have vertex colors yet, or the previous vertex
+   * was without color, we need to start a new vertex colors block. */
+  if (blocks.is_empty() ||
+      (blocks.last().start_vertex_index + blocks.last().colors.size() != vertex_index))
+  {
+    GlobalVertices::VertexColorsBlock block;
+    block.start_vertex_index = vertex_index;
+    blocks.append(block);
+  }
+  blocks.last().colors.append(color);
+}
+
 static void geom_add_vertex(const char *p, const char *end, GlobalVertices &r_global_vertices)
 {
   float3 vert;
@@ -85,18 +108,7 @@ static void geom_add_vertex(const char *p, const char *end, GlobalVertices &r_gl
     if (srgb.x >= 0 && srgb.y >= 0 && srgb.z >= 0) {
       float3 linear;
       srgb_to_linearrgb_v3_v3(linear, srgb);
-
-      auto &blocks = r_global_vertices.vertex_colors;
-      /* If we don't have vertex colors yet, or the previous vertex
-       * was without color, we need to start a new vertex colors block. */
-      if (blocks.is_empty() || (blocks.last().start_vertex_index + blocks.last().colors.size() !=
-                                r_global_vertices.vertices.size() - 1))
-      {
-        GlobalVertices::VertexColorsBlock block;
-        block.start_vertex_index = r_global_vertices.vertices.size() - 1;
-        blocks.append(block);
-      }
-      blocks.last().colors.append(linear);
+      add_vertex_color(r_global_vertices.vertices.size() - 1, linear, r_global_vertices);
     }
   }
   UNUSED_VARS(p);
@@ -225,30 +237,27 @@ static void geom_add_polyline(Geometry *geom,
   }
 }
 
-static void geom_add_polygon(Geometry *geom,
-                             const char *p,
-                             const char *end,
-                             const GlobalVertices &global_vertices,
-                             const int material_index,
-                             const int group_index,
-                             const bool shaded_smooth)
-{
-  FaceElem curr_face;
-  curr_face.shaded_smooth = shaded_smooth;
-  curr_face.material_index = material_index;
-  if (group_index >= 0) {
-    curr_face.vertex_group_index = group_index;
-    geom->has_vertex_groups_ = true;
-  }
-
-  const int orig_corners_size = geom->face_corners_.size();
-  curr_face.start_index_ = orig_corners_size;
+/**
+ * Face corner indices as they are spelled out in the file, before being made zero-based
+ * and checked against the number of elements read so far.
+ */
+struct RawFaceCorner {
+  int vert_index;
+  int uv_vert_index = -1;
+  int vertex_normal_index = -1;
+  bool got_uv = false;
+  bool got_normal = false;
+};
 
-  bool face_valid = true;
+/**
+ * Tokenize the corners of a face line. This does not depend on any parser state,
+ * so it can be done for many lines in parallel.
+ */
+static void parse_face_corners(const char *p, const char *end, Vector<RawFaceCorner> &r_corners)
+{
   p = drop_whitespace(p, end);
-  while (p < end && face_valid) {
-    FaceCorner corner;
-    bool got_uv = false, got_normal = false;
+  while (p < end) {
+    RawFaceCorner corner;
     /* Parse vertex index. */
     p = parse_int(p, end, INT32_MAX, corner.vert_index, false);
 
@@ -257,21 +266,58 @@ static void geom_add_polygon(Geometry *geom,
       break;
     }
 
-    face_valid &= corner.vert_index != INT32_MAX;
     if (p < end && *p == '/') {
       /* Parse UV index. */
       ++p;
       if (p < end && *p != '/') {
         p = parse_int(p, end, INT32_MAX, corner.uv_vert_index, false);
-        got_uv = corner.uv_vert_index != INT32_MAX;
+        corner.got_uv = corner.uv_vert_index != INT32_MAX;
       }
       /* Parse normal index. */
       if (p < end && *p == '/') {
         ++p;
         p = parse_int(p, end, INT32_MAX, corner.vertex_normal_index, false);
-        got_normal = corner.vertex_normal_index != INT32_MAX;
+        corner.got_normal = corner.vertex_normal_index != INT32_MAX;
       }
     }
+    r_corners.append(corner);
+
+    /* Some files contain extra stuff per face (e.g. 4 indices); skip any remainder (#103441). */
+    p = drop_non_whitespace(p, end);
+    /* Skip whitespace to get to the next face corner. */
+    p = drop_whitespace(p, end);
+  }
+}
+
+static void geom_add_polygon(Geometry *geom,
+                             const Span<RawFaceCorner> raw_corners,
+                             const GlobalVertices &global_vertices,
+                             const int material_index,
+                             const int group_index,
+                             const bool shaded_smooth)
+{
+  FaceElem curr_face;
+  curr_face.shaded_smooth = shaded_smooth;
+  curr_face.material_index = material_index;
+  if (group_index >= 0) {
+    curr_face.vertex_group_index = group_index;
+    geom->has_vertex_groups_ = true;
+  }
+
+  const int orig_corners_size = geom->face_corners_.size();
+  curr_face.start_index_ = orig_corners_size;
+
+  bool face_valid = true;
+  for (const RawFaceCorner &raw_corner : raw_corners) {
+    if (!face_valid) {
+      break;
+    }
+    FaceCorner corner;
+    corner.vert_index = raw_corner.vert_index;
+    corner.uv_vert_index = raw_corner.uv_vert_index;
+    corner.vertex_normal_index = raw_corner.vertex_normal_index;
+
+    face_valid &= corner.vert_index != INT32_MAX;
     /* Always keep stored indices non-negative and zero-based. */
     corner.vert_index += corner.vert_index < 0 ? global_vertices.vertices.size() : -1;
     if (corner.vert_index < 0 || corner.vert_index >= global_vertices.vertices.size()) {
@@ -285,7 +331,7 @@ static void geom_add_polygon(Geometry *geom,
       geom->track_vertex_index(corner.vert_index);
     }
     /* Ignore UV index, if the geometry does not have any UVs (#103212). */
-    if (got_uv && !global_vertices.uv_vertices.is_empty()) {
+    if (raw_corner.got_uv && !global_vertices.uv_vertices.is_empty()) {
       corner.uv_vert_index += corner.uv_vert_index < 0 ? global_vertices.uv_vertices.size() : -1;
       if (corner.uv_vert_index < 0 || corner.uv_vert_index >= global_vertices.uv_vertices.size()) {
         fprintf(stderr,
@@ -298,7 +344,7 @@ static void geom_add_polygon(Geometry *geom,
     /* Ignore corner normal index, if the geometry does not have any normals.
      * Some obj files out there do have face definitions that refer to normal indices,
      * without any normals being present (#98782). */
-    if (got_normal && !global_vertices.vert_normals.is_empty()) {
+    if (raw_corner.got_normal && !global_vertices.vert_normals.is_empty()) {
       corner.vertex_normal_index += corner.vertex_normal_index < 0 ?
                                         global_vertices.vert_normals.size() :
                                         -1;
@@ -314,11 +360,6 @@ static void geom_add_polygon(Geometry *geom,
     }
     geom->face_corners_.append(corner);
     curr_face.corner_count_++;
-
-    /* Some files contain extra stuff per face (e.g. 4 indices); skip any remainder (#103441). */
-    p = drop_non_whitespace(p, end);
-    /* Skip whitespace to get to the next face corner. */
-    p = drop_whitespace(p, end);
   }
 
   if (face_valid) {
@@ -500,6 +541,156 @@ static void use_all_vertices_if_no_faces(Geometry *geom,
   }
 }
 
+/**
+ * Part of a read buffer that gets tokenized on its own thread when parsing in parallel.
+ * Vertex data is parsed into chunk-local arrays, faces are tokenized into raw corner indices,
+ * and every other line is recorded together with the amount of vertex data preceding it.
+ * Records are then handled in file order on the calling thread, which resolves relative
+ * indices and keeps track of objects, groups and materials exactly like serial parsing does.
+ */
+struct ParseChunk {
+  struct Record {
+    /** Line contents without the leading white-space; without the keyword for faces. */
+    StringRef line;
+    bool is_face = false;
+    IndexRange face_corners;
+    /** Number of chunk-local positions, UVs and normals that precede the line. */
+    int verts_num = 0;
+    int uvs_num = 0;
+    int normals_num = 0;
+  };
+
+  StringRef text;
+  size_t lines_num = 0;
+  GlobalVertices vertices;
+  Vector<RawFaceCorner> face_corners;
+  Vector<Record> records;
+
+  /* Amount of chunk-local data already appended to the global vertex arrays. */
+  int merged_verts_num = 0;
+  int merged_uvs_num = 0;
+  int merged_normals_num = 0;
+  int merged_color_blocks_num = 0;
+  int merged_colors_in_block_num = 0;
+};
+
+/**
+ * Split the buffer into (at most) the given number of parts of roughly equal size,
+ * at line boundaries.
+ */
+static Vector<ParseChunk> split_into_chunks(const StringRef buffer, const int chunks_num)
+{
+  Vector<ParseChunk> chunks;
+  const char *start = buffer.begin();
+  for (int i = 0; i < chunks_num && start < buffer.end(); i++) {
+    const char *end = buffer.end();
+    if (i < chunks_num - 1) {
+      end = std::max(start, buffer.begin() + buffer.size() * (i + 1) / chunks_num);
+      end = std::find(end, buffer.end(), '\n');
+      if (end < buffer.end()) {
+        ++end;
+      }
+    }
+    ParseChunk chunk;
+    chunk.text = StringRef(start, end);
+    chunks.append(std::move(chunk));
+    start = end;
+  }
+  return chunks;
+}
+
+static void tokenize_chunk(ParseChunk &chunk)
+{
+  StringRef buffer_str = chunk.text;
+  while (!buffer_str.is_empty()) {
+    StringRef line = read_next_line(buffer_str);
+    const char *p = line.begin(), *end = line.end();
+    p = drop_whitespace(p, end);
+    ++chunk.lines_num;
+    if (p == end) {
+      continue;
+    }
+    if (*p == 'v') {
+      if (parse_keyword(p, end, "v")) {
+        geom_add_vertex(p, end, chunk.vertices);
+      }
+      else if (parse_keyword(p, end, "vn")) {
+        geom_add_vertex_normal(p, end, chunk.vertices);
+      }
+      else if (parse_keyword(p, end, "vt")) {
+        geom_add_uv_vertex(p, end, chunk.vertices);
+      }
+      continue;
+    }
+    if (*p == '#') {
+      /* Comments can be dropped right away, except for the MRGB color extension. */
+      const char *keyword_end = p;
+      if (!parse_keyword(keyword_end, end, "#MRGB")) {
+        continue;
+      }
+    }
+
+    ParseChunk::Record record;
+    record.verts_num = chunk.vertices.vertices.size();
+    record.uvs_num = chunk.vertices.uv_vertices.size();
+    record.normals_num = chunk.vertices.vert_normals.size();
+    if (parse_keyword(p, end, "f")) {
+      const int corners_start = chunk.face_corners.size();
+      parse_face_corners(p, end, chunk.face_corners);
+      record.is_face = true;
+      record.face_corners = IndexRange(corners_start, chunk.face_corners.size() - corners_start);
+    }
+    else {
+      record.line = StringRef(p, end);
+    }
+    chunk.records.append(record);
+  }
+}
+
+/**
+ * Append chunk-local vertex data up to the given counts to the global vertex arrays.
+ */
+static void merge_chunk_vertices(ParseChunk &chunk,
+                                 const int verts_num,
+                                 const int uvs_num,
+                                 const int normals_num,
+                                 GlobalVertices &r_global_vertices)
+{
+  const GlobalVertices &src = chunk.vertices;
+  const int vertex_offset = r_global_vertices.vertices.size() - chunk.merged_verts_num;
+
+  r_global_vertices.vertices.extend(
+      src.vertices.as_span().slice(chunk.merged_verts_num, verts_num - chunk.merged_verts_num));
+  r_global_vertices.uv_vertices.extend(
+      src.uv_vertices.as_span().slice(chunk.merged_uvs_num, uvs_num - chunk.merged_uvs_num));
+  r_global_vertices.vert_normals.extend(src.vert_normals.as_span().slice(
+      chunk.merged_normals_num, normals_num - chunk.merged_normals_num));
+  chunk.merged_verts_num = verts_num;
+  chunk.merged_uvs_num = uvs_num;
+  chunk.merged_normals_num = normals_num;
+
+  /* Colors of the merged vertices; blocks can continue from the previous chunk,
+   * or get split between several merges. */
+  while (chunk.merged_color_blocks_num < src.vertex_colors.size()) {
+    const GlobalVertices::VertexColorsBlock &block =
+        src.vertex_colors[chunk.merged_color_blocks_num];
+    int &color_index = chunk.merged_colors_in_block_num;
+    while (color_index < block.colors.size() &&
+           block.start_vertex_index + color_index < verts_num)
+    {
+      add_vertex_color(vertex_offset + block.start_vertex_index + color_index,
+                       block.colors[color_index],
+                       r_global_vertices);
+      color_index++;
+    }
+    if (color_index < block.colors.size()) {
+      break;
+    }
+    chunk.merged_color_blocks_num++;
+    color_index = 0;
+  }
+}
+
 void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
                       GlobalVertices &r_global_vertices)
 {
@@ -522,26 +713,136 @@ void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
   string state_material_name;
   int state_material_index = -1;
 
+  auto add_face = [&](const Span<RawFaceCorner> corners) {
+    /* If we don't have a material index assigned yet, get one.
+     * It means "usemtl" state came from the previous object. */
+    if (state_material_index == -1 && !state_material_name.empty() &&
+        curr_geom->material_indices_.is_empty())
+    {
+      curr_geom->material_indices_.add_new(state_material_name, 0);
+      curr_geom->material_order_.append(state_material_name);
+      state_material_index = 0;
+    }
+
+    geom_add_polygon(curr_geom,
+                     corners,
+                     r_global_vertices,
+                     state_material_index,
+                     state_group_index,
+                     state_shaded_smooth);
+  };
+
+  /* Handle a line that is neither vertex data nor a face. */
+  auto parse_element_line = [&](const char *p, const char *end) {
+    /* Faces. */
+    if (parse_keyword(p, end, "l")) {
+      geom_add_polyline(curr_geom, p, end, r_global_vertices);
+    }
+    /* Objects. */
+    else if (parse_keyword(p, end, "o")) {
+      if (import_params_.use_split_objects) {
+        geom_new_object(p,
+                        end,
+                        state_shaded_smooth,
+                        state_group_name,
+                        state_material_index,
+                        curr_geom,
+                        r_all_geometries);
+      }
+    }
+    /* Groups. */
+    else if (parse_keyword(p, end, "g")) {
+      if (import_params_.use_split_groups) {
+        geom_new_object(p,
+                        end,
+                        state_shaded_smooth,
+                        state_group_name,
+                        state_material_index,
+                        curr_geom,
+                        r_all_geometries);
+      }
+      else {
+        geom_update_group(StringRef(p, end).trim(), state_group_name);
+        int new_index = curr_geom->group_indices_.size();
+        state_group_index = curr_geom->group_indices_.lookup_or_add(state_group_name, new_index);
+        if (new_index == state_group_index) {
+          curr_geom->group_order_.append(state_group_name);
+        }
+      }
+    }
+    /* Smoothing groups. */
+    else if (parse_keyword(p, end, "s")) {
+      geom_update_smooth_group(p, end, state_shaded_smooth);
+    }
+    /* Materials and their libraries. */
+    else if (parse_keyword(p, end, "usemtl")) {
+      state_material_name = StringRef(p, end).trim();
+      int new_mat_index = curr_geom->material_indices_.size();
+      state_material_index = curr_geom->material_indices_.lookup_or_add(state_material_name,
+                                                                        new_mat_index);
+      if (new_mat_index == state_material_index) {
+        curr_geom->material_order_.append(state_material_name);
+      }
+    }
+    else if (parse_keyword(p, end, "mtllib")) {
+      add_mtl_library(StringRef(p, end).trim());
+    }
+    else if (parse_keyword(p, end, "#MRGB")) {
+      geom_add_mrgb_colors(p, end, r_global_vertices);
+    }
+    /* Comments. */
+    else if (*p == '#') {
+      /* Nothing to do. */
+    }
+    /* Curve related things. */
+    else if (parse_keyword(p, end, "cstype")) {
+      curr_geom = geom_set_curve_type(curr_geom, p, end, state_group_name, r_all_geometries);
+    }
+    else if (parse_keyword(p, end, "deg")) {
+      geom_set_curve_degree(curr_geom, p, end);
+    }
+    else if (parse_keyword(p, end, "curv")) {
+      geom_add_curve_vertex_indices(curr_geom, p, end, r_global_vertices);
+    }
+    else if (parse_keyword(p, end, "parm")) {
+      geom_add_curve_parameters(curr_geom, p, end);
+    }
+    else if (StringRef(p, end).startswith("end")) {
+      /* End of curve definition, nothing else to do. */
+    }
+    else {
+      std::cout << "OBJ element not recognized: '" << std::string(p, end) << "'" << std::endl;
+    }
+  };
+
+  /* When parsing in parallel, every chunk that is read from the file gets split into
+   * this many parts, so read correspondingly more at once. */
+  const int chunks_num = import_params_.threads_num > 0 ? import_params_.threads_num :
+                                                          BLI_system_thread_count();
+  const size_t read_size = read_buffer_size_ * size_t(chunks_num);
+
   /* Read the input file in chunks. We need up to twice the possible chunk size,
    * to possibly store remainder of the previous input line that got broken mid-chunk. */
-  Array<char> buffer(read_buffer_size_ * 2);
+  Array<char> buffer(read_size * 2);
+  Vector<RawFaceCorner> face_corners;
 
   size_t buffer_offset = 0;
   size_t line_number = 0;
   while (true) {
     /* Read a chunk of input from the file. */
-    size_t bytes_read = fread(buffer.data() + buffer_offset, 1, read_buffer_size_, obj_file_);
+    size_t bytes_read = fread(buffer.data() + buffer_offset, 1, read_size, obj_file_);
     if (bytes_read == 0 && buffer_offset == 0) {
       break; /* No more data to read. */
     }
 
     /* Take care of line continuations now (turn them into spaces);
-     * the rest of the parsing code does not need to worry about them anymore. */
-    fixup_line_continuations(buffer.data() + buffer_offset,
-                             buffer.data() + buffer_offset + bytes_read);
+     * the rest of the parsing code does not need to worry about them anymore.
+     * Include the remainder of the previous chunk, its backslash might be followed
+     * by a newline that was only read now. */
+    fixup_line_continuations(buffer.data(), buffer.data() + buffer_offset + bytes_read);
 
     /* Ensure buffer ends in a newline. */
-    if (bytes_read < read_buffer_size_) {
+    if (bytes_read < read_size) {
       if (bytes_read == 0 || buffer[buffer_offset + bytes_read - 1] != '\n') {
         buffer[buffer_offset + bytes_read] = '\n';
         bytes_read++;
@@ -566,133 +867,73 @@ void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
       fprintf(stderr,
               "OBJ file contains a line #%zu that is too long (max. length %zu)\n",
               line_number,
-              read_buffer_size_);
+              read_size);
       break;
     }
     ++last_nl;
 
-    /* Parse the buffer (until last newline) that we have so far,
-     * line by line. */
     StringRef buffer_str{buffer.data(), int64_t(last_nl)};
-    while (!buffer_str.is_empty()) {
-      StringRef line = read_next_line(buffer_str);
-      const char *p = line.begin(), *end = line.end();
-      p = drop_whitespace(p, end);
-      ++line_number;
-      if (p == end) {
-        continue;
-      }
-      /* Most common things that start with 'v': vertices, normals, UVs. */
-      if (*p == 'v') {
-        if (parse_keyword(p, end, "v")) {
-          geom_add_vertex(p, end, r_global_vertices);
-        }
-        else if (parse_keyword(p, end, "vn")) {
-          geom_add_vertex_normal(p, end, r_global_vertices);
+    if (chunks_num > 1) {
+      /* Tokenize parts of the buffer in parallel, then handle everything that depends
+       * on the parser state in file order. */
+      Vector<ParseChunk> chunks = split_into_chunks(buffer_str, chunks_num);
+      threading::parallel_for(chunks.index_range(), 1, [&](const IndexRange range) {
+        for (const int i : range) {
+          tokenize_chunk(chunks[i]);
         }
-        else if (parse_keyword(p, end, "vt")) {
-          geom_add_uv_vertex(p, end, r_global_vertices);
+      });
+      for (ParseChunk &chunk : chunks) {
+        for (const ParseChunk::Record &record : chunk.records) {
+          merge_chunk_vertices(
+              chunk, record.verts_num, record.uvs_num, record.normals_num, r_global_vertices);
+          if (record.is_face) {
+            add_face(chunk.face_corners.as_span().slice(record.face_corners));
+          }
+          else {
+            parse_element_line(record.line.begin(), record.line.end());
+          }
         }
+        merge_chunk_vertices(chunk,
+                             chunk.vertices.vertices.size(),
+                             chunk.vertices.uv_vertices.size(),
+                             chunk.vertices.vert_normals.size(),
+                             r_global_vertices);
+        line_number += chunk.lines_num;
       }
-      /* Faces. */
-      else if (parse_keyword(p, end, "f")) {
-        /* If we don't have a material index assigned yet, get one.
-         * It means "usemtl" state came from the previous object. */
-        if (state_material_index == -1 && !state_material_name.empty() &&
-            curr_geom->material_indices_.is_empty())
-        {
-          curr_geom->material_indices_.add_new(state_material_name, 0);
-          curr_geom->material_order_.append(state_material_name);
-          state_material_index = 0;
+    }
+    else {
+      /* Parse the buffer (until last newline) that we have so far,
+       * line by line. */
+      while (!buffer_str.is_empty()) {
+        StringRef line = read_next_line(buffer_str);
+        const char *p = line.begin(), *end = line.end();
+        p = drop_whitespace(p, end);
+        ++line_number;
+        if (p == end) {
+          continue;
         }
-
-        geom_add_polygon(curr_geom,
-                         p,
-                         end,
-                         r_global_vertices,
-                         state_material_index,
-                         state_group_index,
-                         state_shaded_smooth);
-      }
-      /* Faces. */
-      else if (parse_keyword(p, end, "l")) {
-        geom_add_polyline(curr_geom, p, end, r_global_vertices);
-      }
-      /* Objects. */
-      else if (parse_keyword(p, end, "o")) {
-        if (import_params_.use_split_objects) {
-          geom_new_object(p,
-                          end,
-                          state_shaded_smooth,
-                          state_group_name,
-                          state_material_index,
-                          curr_geom,
-                          r_all_geometries);
+        /* Most common things that start with 'v': vertices, normals, UVs. */
+        if (*p == 'v') {
+          if (parse_keyword(p, end, "v")) {
+            geom_add_vertex(p, end, r_global_vertices);
+          }
+          else if (parse_keyword(p, end, "vn")) {
+            geom_add_vertex_normal(p, end, r_global_vertices);
+          }
+          else if (parse_keyword(p, end, "vt")) {
+            geom_add_uv_vertex(p, end, r_global_vertices);
+          }
         }
-      }
-      /* Groups. */
-      else if (parse_keyword(p, end, "g")) {
-        if (import_params_.use_split_groups) {
-          geom_new_object(p,
-                          end,
-                          state_shaded_smooth,
-                          state_group_name,
-                          state_material_index,
-                          curr_geom,
-                          r_all_geometries);
+        /* Faces. */
+        else if (parse_keyword(p, end, "f")) {
+          face_corners.clear();
+          parse_face_corners(p, end, face_corners);
+          add_face(face_corners);
         }
         else {
-          geom_update_group(StringRef(p, end).trim(), state_group_name);
-          int new_index = curr_geom->group_indices_.size();
-          state_group_index = curr_geom->group_indices_.lookup_or_add(state_group_name, new_index);
-          if (new_index == state_group_index) {
-            curr_geom->group_order_.append(state_group_name);
-          }
-        }
-      }
-      /* Smoothing groups. */
-      else if (parse_keyword(p, end, "s")) {
-        geom_update_smooth_group(p, end, state_shaded_smooth);
-      }
-      /* Materials and their libraries. */
-      else if (parse_keyword(p, end, "usemtl")) {
-        state_material_name = StringRef(p, end).trim();
-        int new_mat_index = curr_geom->material_indices_.size();
-        state_material_index = curr_geom->material_indices_.lookup_or_add(state_material_name,
-                                                                          new_mat_index);
-        if (new_mat_index == state_material_index) {
-          curr_geom->material_order_.append(state_material_name);
+          parse_element_line(p, end);
         }
       }
-      else if (parse_keyword(p, end, "mtllib")) {
-        add_mtl_library(StringRef(p, end).trim());
-      }
-      else if (parse_keyword(p, end, "#MRGB")) {
-        geom_add_mrgb_colors(p, end, r_global_vertices);
-      }
-      /* Comments. */
-      else if (*p == '#') {
-        /* Nothing to do. */
-      }
-      /* Curve related things. */
-      else if (parse_keyword(p, end, "cstype")) {
-        curr_geom = geom_set_curve_type(curr_geom, p, end, state_group_name, r_all_geometries);
-      }
-      else if (parse_keyword(p, end, "deg")) {
-        geom_set_curve_degree(curr_geom, p, end);
-      }
-      else if (parse_keyword(p, end, "curv")) {
-        geom_add_curve_vertex_indices(curr_geom, p, end, r_global_vertices);
-      }
-      else if (parse_keyword(p, end, "parm")) {
-        geom_add_curve_parameters(curr_geom, p, end);
-      }
-      else if (StringRef(p, end).startswith("end")) {
-        /* End of curve definition, nothing else to do. */
-      }
-      else {
-        std::cout << "OBJ element not recognized: '" << std::string(p, end) << "'" << std::endl;
-      }
     }
 
     /* We might have a line that was cut in the middle by the previous buffer;
@@ -0,0 +1,190 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include <gtest/gtest.h>
+
+#include "BLI_fileops.h"
+#include "BLI_string.h"
+
+#include "BKE_appdir.hh"
+
+#include "testing/testing.h"
+
+#include "obj_import_file_reader.hh"
+
+namespace blender::io::obj {
+
+/* Short lines, so that they fit into the small read buffers used below. The names contain
+ * multi-byte UTF-8 sequences and some faces are continued on the next line. */
+static const char *obj_text_block =
+    "# comment ß\n"
+    "mtllib test.mtl\n"
+    "o Würfel_%d\n"
+    "v 1.5 -2.25 3.125\n"
+    "v -4 5e-1 6\n"
+    "v 7 8 9 0.25 0.5 1\n"
+    "v 10 11 12 0.5 1 0\n"
+    "vt 0.5 0.25\n"
+    "vt 1 0\n"
+    "vn 0 0 -1\n"
+    "g gruppe_日本_%d\n"
+    "usemtl matériau_%d\n"
+    "s 1\n"
+    "f 1/1/1 2/2/1 \\\n"
+    "   3/1/1\n"
+    "f -1//1 -2//1 -4//1\n"
+    "s off\n"
+    "f 4 \\ \n"
+    " 3 \\\n"
+    " 2\n"
+    "l 1 2 3\n"
+    "g 🙂_%d\n"
+    "f 1 2 4\n"
+    "\n";
+
+static const char *obj_text_curve =
+    "o Kurve_€\n"
+    "v 0 0 0\n"
+    "v 1 0 0\n"
+    "v 1 1 0\n"
+    "v 0 1 0\n"
+    "cstype bspline\n"
+    "deg 3\n"
+    "curv 0 1 1 2 \\\n"
+    " 3 4\n"
+    "parm u 0 0 0 \\\n"
+    " 0 1 1 1 1\n"
+    "end\n";
+
+class OBJParserTest : public testing::Test {
+ public:
+  std::string tmp_file_path;
+
+  void SetUp() override
+  {
+    BKE_tempdir_init(nullptr);
+    tmp_file_path = std::string(BKE_tempdir_base()) + SEP_STR "obj_parser_test.obj";
+    FILE *tmp_file = BLI_fopen(tmp_file_path.c_str(), "wb");
+    for (int i = 0; i < 8; i++) {
+      fprintf(tmp_file, obj_text_block, i, i, i, i);
+    }
+    fputs(obj_text_curve, tmp_file);
+    fclose(tmp_file);
+  }
+
+  void TearDown() override
+  {
+    BLI_delete(tmp_file_path.c_str(), false, false);
+  }
+
+  void parse(const int threads_num,
+             const size_t read_buffer_size,
+             Vector<std::unique_ptr<Geometry>> &r_all_geometries,
+             GlobalVertices &r_global_vertices)
+  {
+    OBJImportParams params;
+    STRNCPY(params.filepath, tmp_file_path.c_str());
+    params.threads_num = threads_num;
+    OBJParser parser(params, read_buffer_size);
+    parser.parse(r_all_geometries, r_global_vertices);
+  }
+};
+
+static void expect_vertices_eq(const GlobalVertices &a, const GlobalVertices &b)
+{
+  EXPECT_TRUE(a.vertices == b.vertices);
+  EXPECT_TRUE(a.uv_vertices == b.uv_vertices);
+  EXPECT_TRUE(a.vert_normals == b.vert_normals);
+  ASSERT_EQ(a.vertex_colors.size(), b.vertex_colors.size());
+  for (const int i : a.vertex_colors.index_range()) {
+    EXPECT_EQ(a.vertex_colors[i].start_vertex_index, b.vertex_colors[i].start_vertex_index);
+    EXPECT_TRUE(a.vertex_colors[i].colors == b.vertex_colors[i].colors);
+  }
+}
+
+static void expect_geometry_eq(const Geometry &a, const Geometry &b)
+{
+  EXPECT_EQ(a.geom_type_, b.geom_type_);
+  EXPECT_EQ(a.geometry_name_, b.geometry_name_);
+  EXPECT_TRUE(a.group_order_ == b.group_order_);
+  EXPECT_TRUE(a.material_order_ == b.material_order_);
+  EXPECT_TRUE(a.vertices_ == b.vertices_);
+  EXPECT_TRUE(a.edges_ == b.edges_);
+  EXPECT_EQ(a.has_invalid_faces_, b.has_invalid_faces_);
+  EXPECT_EQ(a.total_corner_, b.total_corner_);
+
+  ASSERT_EQ(a.face_corners_.size(), b.face_corners_.size());
+  for (const int i : a.face_corners_.index_range()) {
+    EXPECT_EQ(a.face_corners_[i].vert_index, b.face_corners_[i].vert_index);
+    EXPECT_EQ(a.face_corners_[i].uv_vert_index, b.face_corners_[i].uv_vert_index);
+    EXPECT_EQ(a.face_corners_[i].vertex_normal_index, b.face_corners_[i].vertex_normal_index);
+  }
+  ASSERT_EQ(a.face_elements_.size(), b.face_elements_.size());
+  for (const int i : a.face_elements_.index_range()) {
+    EXPECT_EQ(a.face_elements_[i].vertex_group_index, b.face_elements_[i].vertex_group_index);
+    EXPECT_EQ(a.face_elements_[i].material_index, b.face_elements_[i].material_index);
+    EXPECT_EQ(a.face_elements_[i].shaded_smooth, b.face_elements_[i].shaded_smooth);
+    EXPECT_EQ(a.face_elements_[i].start_index_, b.face_elements_[i].start_index_);
+    EXPECT_EQ(a.face_elements_[i].corner_count_, b.face_elements_[i].corner_count_);
+  }
+
+  EXPECT_EQ(a.nurbs_element_.group_, b.nurbs_element_.group_);
+  EXPECT_EQ(a.nurbs_element_.degree, b.nurbs_element_.degree);
+  EXPECT_TRUE(a.nurbs_element_.curv_indices == b.nurbs_element_.curv_indices);
+  EXPECT_TRUE(a.nurbs_element_.parm == b.nurbs_element_.parm);
+}
+
+TEST_F(OBJParserTest, reference)
+{
+  Vector<std::unique_ptr<Geometry>> geometries;
+  GlobalVertices vertices;
+  parse(1, 64 * 1024, geometries, vertices);
+
+  ASSERT_EQ(geometries.size(), 9);
+  EXPECT_EQ(geometries[0]->geometry_name_, "Würfel_0");
+  EXPECT_EQ(geometries[0]->group_order_.size(), 2);
+  EXPECT_EQ(geometries[0]->group_order_[0], "gruppe_日本_0");
+  EXPECT_EQ(geometries[0]->group_order_[1], "🙂_0");
+  EXPECT_EQ(geometries[0]->material_order_.size(), 1);
+  EXPECT_EQ(geometries[0]->material_order_[0], "matériau_0");
+  /* Continued lines form a single face. */
+  EXPECT_EQ(geometries[0]->face_elements_.size(), 4);
+  EXPECT_EQ(geometries[0]->face_elements_[0].corner_count_, 3);
+  EXPECT_EQ(geometries[0]->face_elements_[2].corner_count_, 3);
+  EXPECT_EQ(geometries[0]->edges_.size(), 2);
+  EXPECT_EQ(geometries[8]->geom_type_, GEOM_CURVE);
+  EXPECT_EQ(geometries[8]->geometry_name_, "Kurve_€");
+  EXPECT_EQ(geometries[8]->nurbs_element_.curv_indices.size(), 4);
+  EXPECT_EQ(geometries[8]->nurbs_element_.parm.size(), 8);
+  EXPECT_EQ(vertices.vertices.size(), 8 * 4 + 4);
+  EXPECT_EQ(vertices.vertex_colors.size(), 8);
+}
+
+TEST_F(OBJParserTest, chunk_boundaries)
+{
+  /* Sweep the read buffer size byte by byte, so that every token, continued line and multi-byte
+   * sequence ends up straddling both the boundaries of the reads from the file and of the parts
+   * that are tokenized in parallel. The result must match parsing in one go. */
+  Vector<std::unique_ptr<Geometry>> ref_geometries;
+  GlobalVertices ref_vertices;
+  parse(1, 64 * 1024, ref_geometries, ref_vertices);
+
+  for (const int threads_num : {1, 2, 3, 4, 7}) {
+    for (size_t read_buffer_size = 48; read_buffer_size < 96; read_buffer_size++) {
+      SCOPED_TRACE("threads " + std::to_string(threads_num) + ", read buffer size " +
+                   std::to_string(read_buffer_size));
+      Vector<std::unique_ptr<Geometry>> geometries;
+      GlobalVertices vertices;
+      parse(threads_num, read_buffer_size, geometries, vertices);
+
+      expect_vertices_eq(vertices, ref_vertices);
+      ASSERT_EQ(geometries.size(), ref_geometries.size());
+      for (const int i : geometries.index_range()) {
+        expect_geometry_eq(*geometries[i], *ref_geometries[i]);
+      }
+    }
+  }
+}
+
+}  // namespace blender::io::obj
@@ -63,6 +63,9 @@ class OBJImportTest : public BlendfileLoadingBaseTest {
     params.import_vertex_groups = false;
     params.relative_paths = true;
     params.clear_selection = true;
+    /* Results must not depend on the number of threads of the machine running the tests,
+     * tests of parallel parsing set this explicitly. */
+    params.threads_num = 1;
   }
   void import_and_check(const char *path,
                         const Expectation *expect,
@@ -906,6 +909,25 @@ TEST_F(OBJImportTest, import_split_options_by_object_and_group)
   import_and_check("split_options.obj", expect, std::size(expect), 0);
 }
 
+TEST_F(OBJImportTest, import_split_options_by_object_and_group_parallel)
+{
+  /* Tokenize in several parts to check that objects and groups are
+   * stitched back together in file order. */
+  params.use_split_objects = true;
+  params.use_split_groups = true;
+  params.threads_num = 4;
+  Expectation expect[] = {
+      {"OBCube", OB_MESH, 8, 12, 6, 24, float3(1, 1, -1), float3(-1, 1, 1)},
+      {"OBBox", OB_MESH, 4, 4, 1, 4, float3(1, 1, -1), float3(-1, 1, 1)},
+      {"OBBoxOne", OB_MESH, 4, 4, 1, 4, float3(1, -1, -1), float3(-1, -1, 1)},
+      {"OBBoxTwo", OB_MESH, 6, 7, 2, 8, float3(1, 1, 1), float3(-1, -1, 1)},
+      {"OBBoxTwo.001", OB_MESH, 6, 7, 2, 8, float3(1, 1, -1), float3(-1, -1, -1)},
+      {"OBPyrBottom", OB_MESH, 4, 4, 1, 4, float3(3, 1, -1), float3(3, -1, -1)},
+      {"OBPyrSides", OB_MESH, 5, 8, 4, 12, float3(3, 1, -1), float3(4, 0, 2)},
+  };
+  import_and_check("split_options.obj", expect, std::size(expect), 0);
+}
+
 TEST_F(OBJImportTest, import_split_options_none)
 {
   params.use_split_objects = false;
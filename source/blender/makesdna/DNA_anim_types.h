@@ -21,6 +21,15 @@
 #  include <type_traits>
 #endif
 
+#ifdef __cplusplus
+namespace blender::bke {
+struct AnimDataEvalPlan;
+}
+using AnimDataEvalPlanHandle = blender::bke::AnimDataEvalPlan;
+#else
+typedef struct AnimDataEvalPlanHandle AnimDataEvalPlanHandle;
+#endif
+
 /* ************************************************ */
 /* F-Curve DataTypes */
 
@@ -1164,6 +1173,8 @@ typedef struct AnimData {
 
   /** Runtime data, for depsgraph evaluation. */
   FCurve **driver_array;
+  /** Runtime data, active action with resolved RNA paths, see #BKE_animsys_evaluate_animdata. */
+  AnimDataEvalPlanHandle *eval_plan;
 
   /* settings for animation evaluation */
   /** User-defined settings. */
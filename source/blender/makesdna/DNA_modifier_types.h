@@ -2480,6 +2480,8 @@ typedef struct NodesModifierData {
 
 typedef enum NodesModifierFlag {
   NODES_MODIFIER_HIDE_DATABLOCK_SELECTOR = (1 << 0),
+  /** Store evaluated geometry in the user's cache directory and reuse it when inputs match. */
+  NODES_MODIFIER_USE_DISK_CACHE = (1 << 1),
 } NodesModifierFlag;
 
 typedef struct MeshToVolumeModifierData {
@@ -336,7 +336,8 @@ typedef struct Editing {
   rctf overlay_frame_rect;
 
   int show_missing_media_flag;
-  int _pad1;
+  /** Number of frames that are rendered at the same time when prefetching. */
+  int prefetch_threads;
 
   struct SeqCache *cache;
 
@@ -754,7 +754,9 @@ typedef struct UserDef_Experimental {
   char use_new_file_import_nodes;
   char use_shader_node_previews;
   char use_animation_baklava;
-  char _pad[4];
+  char use_tiled_compositor;
+  char use_compositor_cache;
+  char _pad[2];
   /** `makesdna` does not allow empty structs. */
 } UserDef_Experimental;
 
@@ -1316,6 +1318,7 @@ typedef enum eUserpref_GPU_Flag {
   USER_GPU_FLAG_OVERLAY_SMOOTH_WIRE = (1 << 2),
   USER_GPU_FLAG_SUBDIVISION_EVALUATION = (1 << 3),
   USER_GPU_FLAG_FRESNEL_EDIT = (1 << 4),
+  USER_GPU_FLAG_DISPLAY_TRANSFORM_LUT = (1 << 5),
 } eUserpref_GPU_Flag;
 
 /** #UserDef.tablet_api */
@@ -1581,6 +1584,7 @@ typedef enum eUserpref_DiskCacheCompression {
   USER_SEQ_DISK_CACHE_COMPRESSION_NONE = 0,
   USER_SEQ_DISK_CACHE_COMPRESSION_LOW = 1,
   USER_SEQ_DISK_CACHE_COMPRESSION_HIGH = 2,
+  USER_SEQ_DISK_CACHE_COMPRESSION_FAST = 3,
 } eUserpref_DiskCacheCompression;
 
 typedef enum eUserpref_SeqProxySetup {
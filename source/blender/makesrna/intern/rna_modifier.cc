@@ -7905,6 +7905,15 @@ static void rna_def_modifier_nodes(BlenderRNA *brna)
   RNA_def_property_flag(prop, PROP_NO_DEG_UPDATE);
   RNA_def_property_update(prop, NC_OBJECT | ND_MODIFIER, nullptr);
 
+  prop = RNA_def_property(srna, "use_disk_cache", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, nullptr, "flag", NODES_MODIFIER_USE_DISK_CACHE);
+  RNA_def_property_ui_text(
+      prop,
+      "Disk Cache",
+      "Store the evaluated geometry in the cache directory and reuse it when the node group and "
+      "its inputs did not change, also across sessions");
+  RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
   rna_def_modifier_panel_open_prop(srna, "open_output_attributes_panel", 0);
   rna_def_modifier_panel_open_prop(srna, "open_manage_panel", 1);
   rna_def_modifier_panel_open_prop(srna, "open_bake_panel", 2);
@@ -2518,6 +2518,16 @@ static void rna_def_editor(BlenderRNA *brna)
       "Render frames ahead of current frame in the background for faster playback");
   RNA_def_property_update(prop, NC_SCENE | ND_SEQUENCER, nullptr);
 
+  prop = RNA_def_property(srna, "prefetch_threads", PROP_INT, PROP_NONE);
+  RNA_def_property_range(prop, 0, 64);
+  RNA_def_property_ui_range(prop, 1, 64, 1, -1);
+  RNA_def_property_ui_text(
+      prop,
+      "Prefetch Threads",
+      "Number of frames that are rendered at the same time when prefetching, limited by the "
+      "cache memory (0 or 1 renders one frame at a time)");
+  RNA_def_property_update(prop, NC_SCENE | ND_SEQUENCER, nullptr);
+
   /* functions */
 
   func = RNA_def_function(srna, "display_stack", "rna_SequenceEditor_display_stack");
@@ -5964,6 +5964,11 @@ static void rna_def_userdef_system(BlenderRNA *brna)
        0,
        "None",
        "Requires fast storage, but uses minimum CPU resources"},
+      {USER_SEQ_DISK_CACHE_COMPRESSION_FAST,
+       "FAST",
+       0,
+       "Fast",
+       "Light compression that is decoded at almost the speed of the storage device"},
       {USER_SEQ_DISK_CACHE_COMPRESSION_LOW,
        "LOW",
        0,
@@ -6132,6 +6137,14 @@ static void rna_def_userdef_system(BlenderRNA *brna)
       prop, "Image Display Method", "Method used for displaying images on the screen");
   RNA_def_property_update(prop, 0, "rna_userdef_update");
 
+  prop = RNA_def_property(srna, "use_display_transform_lut", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, nullptr, "gpu_flag", USER_GPU_FLAG_DISPLAY_TRANSFORM_LUT);
+  RNA_def_property_ui_text(prop,
+                           "Display Transform Lookup Table",
+                           "Bake the view and display transform into a lookup table when "
+                           "displaying large float images on the CPU. Faster, but less accurate");
+  RNA_def_property_update(prop, 0, "rna_userdef_update");
+
   prop = RNA_def_property(srna, "anisotropic_filter", PROP_ENUM, PROP_NONE);
   RNA_def_property_enum_sdna(prop, nullptr, "anisotropic_filter");
   RNA_def_property_enum_items(prop, anisotropic_items);
@@ -7421,6 +7434,19 @@ static void rna_def_userdef_experimental(BlenderRNA *brna)
       prop, "Shader Node Previews", "Enables previews in the shader node editor");
   RNA_def_property_update(prop, 0, "rna_userdef_ui_update");
 
+  prop = RNA_def_property(srna, "use_tiled_compositor", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_ui_text(prop,
+                           "Tiled Compositor",
+                           "Render chains of per-pixel operations of the CPU compositor tile by "
+                           "tile, reducing memory bandwidth and intermediate buffers");
+
+  prop = RNA_def_property(srna, "use_compositor_cache", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_ui_text(prop,
+                           "Compositor Cache",
+                           "Keep buffers of the CPU compositor between executions, so that edits "
+                           "only render the nodes affected by the change. Uses the memory cache "
+                           "limit");
+
   prop = RNA_def_property(srna, "use_extensions_debug", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_ui_text(
       prop,
@@ -6,6 +6,7 @@
  * \ingroup modifiers
  */
 
+#include <atomic>
 #include <cstring>
 #include <fmt/format.h>
 #include <iostream>
@@ -42,7 +43,9 @@
 
 #include "BKE_attribute_math.hh"
 #include "BKE_bake_data_block_map.hh"
+#include "BKE_bake_disk_cache.hh"
 #include "BKE_bake_geometry_nodes_modifier.hh"
+#include "BKE_blender_version.h"
 #include "BKE_compute_contexts.hh"
 #include "BKE_customdata.hh"
 #include "BKE_geometry_fields.hh"
@@ -1637,6 +1640,395 @@ static void add_data_block_items_writeback(const ModifierEvalContext &ctx,
       });
 }
 
+/**
+ * Nodes that depend on state which is not part of the disk cache key, or that have to be evaluated
+ * for their side effects.
+ */
+static bool node_prevents_disk_cache(const bNode &node)
+{
+  switch (node.type) {
+    case GEO_NODE_SELF_OBJECT:
+    case GEO_NODE_INPUT_ACTIVE_CAMERA:
+    case GEO_NODE_SIMULATION_INPUT:
+    case GEO_NODE_SIMULATION_OUTPUT:
+    case GEO_NODE_BAKE:
+    case GEO_NODE_VIEWER:
+      return true;
+  }
+  const StringRef idname = node.idname;
+  return idname.startswith("GeometryNodeTool") || idname.startswith("GeometryNodeImport");
+}
+
+/**
+ * Only materials can be referenced by the cached geometry, because they are the only data-blocks
+ * that don't affect the evaluated geometry itself.
+ */
+static bool add_id_to_disk_cache_key(const ID *id, bake::DiskCacheKeyBuilder &key)
+{
+  if (id == nullptr) {
+    key.add("");
+    return true;
+  }
+  if (GS(id->name) != ID_MA) {
+    return false;
+  }
+  key.add(id->name);
+  key.add(id->lib ? id->lib->id.name : "");
+  return true;
+}
+
+static bool add_socket_to_disk_cache_key(const bNodeSocket &socket,
+                                         bake::DiskCacheKeyBuilder &key)
+{
+  key.add(socket.identifier);
+  key.add(socket.idname);
+  if (socket.default_value == nullptr || socket.is_directly_linked()) {
+    return true;
+  }
+  /* Only add the values, the raw DNA structs also contain pointers and padding. */
+  switch (eNodeSocketDatatype(socket.type)) {
+    case SOCK_FLOAT:
+      key.add_value(socket.default_value_typed<bNodeSocketValueFloat>()->value);
+      return true;
+    case SOCK_INT:
+      key.add_value(socket.default_value_typed<bNodeSocketValueInt>()->value);
+      return true;
+    case SOCK_BOOLEAN:
+      key.add_value(socket.default_value_typed<bNodeSocketValueBoolean>()->value);
+      return true;
+    case SOCK_VECTOR:
+      key.add_value(socket.default_value_typed<bNodeSocketValueVector>()->value);
+      return true;
+    case SOCK_RGBA:
+      key.add_value(socket.default_value_typed<bNodeSocketValueRGBA>()->value);
+      return true;
+    case SOCK_ROTATION:
+      key.add_value(socket.default_value_typed<bNodeSocketValueRotation>()->value_euler);
+      return true;
+    case SOCK_STRING:
+      key.add(socket.default_value_typed<bNodeSocketValueString>()->value);
+      return true;
+    case SOCK_MENU:
+      key.add_value(socket.default_value_typed<bNodeSocketValueMenu>()->value);
+      return true;
+    case SOCK_OBJECT:
+      return socket.default_value_typed<bNodeSocketValueObject>()->value == nullptr;
+    case SOCK_COLLECTION:
+      return socket.default_value_typed<bNodeSocketValueCollection>()->value == nullptr;
+    case SOCK_TEXTURE:
+      return socket.default_value_typed<bNodeSocketValueTexture>()->value == nullptr;
+    case SOCK_IMAGE:
+      return socket.default_value_typed<bNodeSocketValueImage>()->value == nullptr;
+    case SOCK_MATERIAL: {
+      const Material *material = socket.default_value_typed<bNodeSocketValueMaterial>()->value;
+      return add_id_to_disk_cache_key(reinterpret_cast<const ID *>(material), key);
+    }
+    default:
+      return false;
+  }
+}
+
+/**
+ * Add the values of all RNA properties of the struct to the key, including nested structs like
+ * color ramps and curve mappings. This gives the same key in every session, unlike the raw DNA
+ * data which contains pointers.
+ * \param skip_base: Properties of this base type are skipped.
+ */
+static bool add_rna_struct_to_disk_cache_key(PointerRNA &ptr,
+                                             StructRNA *skip_base,
+                                             bake::DiskCacheKeyBuilder &key,
+                                             Set<const void *> &added_structs)
+{
+  if (!added_structs.add(ptr.data)) {
+    return true;
+  }
+  bool success = true;
+  RNA_STRUCT_BEGIN_SKIP_RNA_TYPE (&ptr, prop) {
+    const char *identifier = RNA_property_identifier(prop);
+    if (skip_base && RNA_struct_type_find_property(skip_base, identifier)) {
+      continue;
+    }
+    key.add(identifier);
+    const PropertyType type = RNA_property_type(prop);
+    const int array_len = ELEM(type, PROP_BOOLEAN, PROP_INT, PROP_FLOAT) ?
+                              RNA_property_array_length(&ptr, prop) :
+                              0;
+    switch (type) {
+      case PROP_BOOLEAN:
+        if (array_len > 0) {
+          Array<bool, 16> values(array_len);
+          RNA_property_boolean_get_array(&ptr, prop, values.data());
+          key.add(values.data(), values.as_span().size_in_bytes());
+        }
+        else {
+          key.add_value(RNA_property_boolean_get(&ptr, prop));
+        }
+        break;
+      case PROP_INT:
+        if (array_len > 0) {
+          Array<int, 16> values(array_len);
+          RNA_property_int_get_array(&ptr, prop, values.data());
+          key.add(values.data(), values.as_span().size_in_bytes());
+        }
+        else {
+          key.add_value(RNA_property_int_get(&ptr, prop));
+        }
+        break;
+      case PROP_FLOAT:
+        if (array_len > 0) {
+          Array<float, 16> values(array_len);
+          RNA_property_float_get_array(&ptr, prop, values.data());
+          key.add(values.data(), values.as_span().size_in_bytes());
+        }
+        else {
+          key.add_value(RNA_property_float_get(&ptr, prop));
+        }
+        break;
+      case PROP_ENUM:
+        key.add_value(RNA_property_enum_get(&ptr, prop));
+        break;
+      case PROP_STRING: {
+        char fixed_buf[256];
+        int len;
+        char *value = RNA_property_string_get_alloc(
+            &ptr, prop, fixed_buf, sizeof(fixed_buf), &len);
+        key.add(StringRef(value, len));
+        if (value != fixed_buf) {
+          MEM_freeN(value);
+        }
+        break;
+      }
+      case PROP_POINTER: {
+        PointerRNA value = RNA_property_pointer_get(&ptr, prop);
+        if (value.data == nullptr) {
+          key.add("");
+        }
+        else if (RNA_struct_is_ID(value.type)) {
+          success = add_id_to_disk_cache_key(static_cast<const ID *>(value.data), key);
+        }
+        else {
+          success = add_rna_struct_to_disk_cache_key(value, nullptr, key, added_structs);
+        }
+        break;
+      }
+      case PROP_COLLECTION: {
+        RNA_PROP_BEGIN (&ptr, item, prop) {
+          if (!add_rna_struct_to_disk_cache_key(item, nullptr, key, added_structs)) {
+            success = false;
+            break;
+          }
+        }
+        RNA_PROP_END;
+        break;
+      }
+    }
+    if (!success) {
+      break;
+    }
+  }
+  RNA_STRUCT_END;
+  return success;
+}
+
+/**
+ * Add the settings of the node that are not stored in its sockets, e.g. the values in
+ * #bNode::storage, by using its RNA properties.
+ */
+static bool add_node_settings_to_disk_cache_key(const bNodeTree &tree,
+                                                const bNode &node,
+                                                bake::DiskCacheKeyBuilder &key)
+{
+  PointerRNA ptr = RNA_pointer_create(
+      const_cast<ID *>(&tree.id), &RNA_Node, const_cast<bNode *>(&node));
+  /* Properties of all nodes like the name, location and sockets are added separately or don't
+   * affect the evaluation. */
+  Set<const void *> added_structs;
+  return add_rna_struct_to_disk_cache_key(ptr, &RNA_Node, key, added_structs);
+}
+
+/**
+ * Add everything that may affect the evaluation of the node tree to the key. Nested node groups
+ * are added when they are used for the first time.
+ * \return False if the result of the tree can't be cached.
+ */
+static bool add_node_tree_to_disk_cache_key(const bNodeTree &tree,
+                                            bake::DiskCacheKeyBuilder &key,
+                                            Set<const bNodeTree *> &added_trees)
+{
+  if (!added_trees.add(&tree)) {
+    return true;
+  }
+  tree.ensure_topology_cache();
+  tree.ensure_interface_cache();
+  for (const bNodeTreeInterfaceSocket *socket : tree.interface_inputs()) {
+    key.add(socket->identifier);
+    key.add(socket->socket_type);
+  }
+  for (const bNodeTreeInterfaceSocket *socket : tree.interface_outputs()) {
+    key.add(socket->identifier);
+    key.add(socket->socket_type);
+  }
+  for (const bNode *node : tree.all_nodes()) {
+    if (node_prevents_disk_cache(*node)) {
+      return false;
+    }
+    key.add(node->idname);
+    key.add(node->name);
+    key.add_value(node->custom1);
+    key.add_value(node->custom2);
+    key.add_value(node->custom3);
+    key.add_value(node->custom4);
+    key.add_value(node->is_muted());
+    if (!add_node_settings_to_disk_cache_key(tree, *node, key)) {
+      return false;
+    }
+    if (node->is_group()) {
+      key.add(node->id ? node->id->name : "");
+      if (node->id) {
+        if (!add_node_tree_to_disk_cache_key(
+                *reinterpret_cast<const bNodeTree *>(node->id), key, added_trees))
+        {
+          return false;
+        }
+      }
+    }
+    else if (!add_id_to_disk_cache_key(node->id, key)) {
+      return false;
+    }
+    for (const bNodeSocket *socket : node->input_sockets()) {
+      if (!add_socket_to_disk_cache_key(*socket, key)) {
+        return false;
+      }
+    }
+    for (const bNodeSocket *socket : node->output_sockets()) {
+      key.add(socket->identifier);
+      key.add(socket->idname);
+    }
+  }
+  for (const bNodeLink *link : tree.all_links()) {
+    key.add(link->fromnode->name);
+    key.add(link->fromsock->identifier);
+    key.add(link->tonode->name);
+    key.add(link->tosock->identifier);
+    key.add_value(link->is_muted());
+  }
+  return true;
+}
+
+static bool add_id_property_to_disk_cache_key(const IDProperty &property,
+                                              bake::DiskCacheKeyBuilder &key)
+{
+  key.add(property.name);
+  key.add_value(property.type);
+  switch (eIDPropertyType(property.type)) {
+    case IDP_INT:
+    case IDP_FLOAT:
+    case IDP_DOUBLE:
+    case IDP_BOOLEAN:
+      key.add_value(property.data.val);
+      key.add_value(property.data.val2);
+      return true;
+    case IDP_STRING:
+      key.add(IDP_String(&property));
+      return true;
+    case IDP_ARRAY: {
+      key.add_value(property.subtype);
+      key.add_value(property.len);
+      switch (eIDPropertyType(property.subtype)) {
+        case IDP_INT:
+          key.add(property.data.pointer, sizeof(int) * property.len);
+          return true;
+        case IDP_FLOAT:
+          key.add(property.data.pointer, sizeof(float) * property.len);
+          return true;
+        case IDP_DOUBLE:
+          key.add(property.data.pointer, sizeof(double) * property.len);
+          return true;
+        case IDP_BOOLEAN:
+          key.add(property.data.pointer, sizeof(int8_t) * property.len);
+          return true;
+        default:
+          return false;
+      }
+    }
+    case IDP_GROUP:
+      LISTBASE_FOREACH (const IDProperty *, child, &property.data.group) {
+        if (!add_id_property_to_disk_cache_key(*child, key)) {
+          return false;
+        }
+      }
+      return true;
+    case IDP_ID:
+      return add_id_to_disk_cache_key(IDP_Id(&property), key);
+    default:
+      return false;
+  }
+}
+
+/**
+ * Compute the key that identifies the result of the modifier in the persistent disk cache.
+ * \return None if the result can't be cached.
+ */
+static std::optional<std::string> compute_disk_cache_key(const NodesModifierData &nmd,
+                                                         const ModifierEvalContext &ctx,
+                                                         const bke::GeometrySet &input_geometry)
+{
+  if (!bake::geometry_is_disk_cacheable(input_geometry)) {
+    return std::nullopt;
+  }
+  const bNodeTree &tree = *nmd.node_group;
+
+  bake::DiskCacheKeyBuilder key;
+  key.add("geometry_nodes_modifier");
+  key.add(BKE_blender_version_string());
+  key.add_value(DEG_get_mode(ctx.depsgraph));
+
+  Set<const bNodeTree *> added_trees;
+  if (!add_node_tree_to_disk_cache_key(tree, key, added_trees)) {
+    return std::nullopt;
+  }
+  if (nmd.settings.properties) {
+    if (!add_id_property_to_disk_cache_key(*nmd.settings.properties, key)) {
+      return std::nullopt;
+    }
+  }
+  Set<const bNodeTree *> checked_groups;
+  if (check_tree_for_time_node(tree, checked_groups)) {
+    key.add_value(DEG_get_ctime(ctx.depsgraph));
+  }
+  key.add(input_geometry);
+  return key.build();
+}
+
+/**
+ * Geometry in the disk cache may have been written in a different session, so data-blocks are
+ * looked up by name.
+ */
+class DiskCacheDataBlockMap : public bake::BakeDataBlockMap {
+ private:
+  const Depsgraph &depsgraph_;
+
+ public:
+  std::atomic<bool> has_missing = false;
+
+  DiskCacheDataBlockMap(const Depsgraph &depsgraph) : depsgraph_(depsgraph) {}
+
+  ID *lookup_or_remember_missing(const bake::BakeDataBlockID &key) override
+  {
+    ID *id_orig = BKE_libblock_find_name_and_library(DEG_get_bmain(&depsgraph_),
+                                                     short(key.type),
+                                                     key.id_name.c_str(),
+                                                     key.lib_name.c_str());
+    if (id_orig == nullptr) {
+      this->has_missing = true;
+      return nullptr;
+    }
+    return DEG_get_evaluated_id(&depsgraph_, id_orig);
+  }
+
+  void try_add(ID & /*id*/) override {}
+};
+
 static void modifyGeometry(ModifierData *md,
                            const ModifierEvalContext *ctx,
                            bke::GeometrySet &geometry_set)
@@ -1718,11 +2110,38 @@ static void modifyGeometry(ModifierData *md,
 
   bke::ModifierComputeContext modifier_compute_context{nullptr, nmd->modifier.name};
 
-  geometry_set = nodes::execute_geometry_nodes_on_geometry(tree,
-                                                           nmd->settings.properties,
-                                                           modifier_compute_context,
-                                                           call_data,
-                                                           std::move(geometry_set));
+  /* The disk cache is not used when the evaluation has to be logged for the node editor, because
+   * loading the result from the cache would skip the logging. */
+  std::optional<std::string> disk_cache_key;
+  if ((nmd->flag & NODES_MODIFIER_USE_DISK_CACHE) && socket_log_contexts.is_empty() &&
+      side_effect_nodes.nodes_by_context.size() == 0 &&
+      side_effect_nodes.iterations_by_repeat_zone.size() == 0)
+  {
+    disk_cache_key = compute_disk_cache_key(*nmd, *ctx, geometry_set);
+  }
+
+  std::optional<bke::GeometrySet> cached_geometry;
+  if (disk_cache_key) {
+    DiskCacheDataBlockMap data_block_map{*ctx->depsgraph};
+    cached_geometry = bake::disk_cache_read_geometry(*disk_cache_key, &data_block_map);
+    if (data_block_map.has_missing) {
+      cached_geometry.reset();
+    }
+  }
+
+  if (cached_geometry) {
+    geometry_set = std::move(*cached_geometry);
+  }
+  else {
+    geometry_set = nodes::execute_geometry_nodes_on_geometry(tree,
+                                                             nmd->settings.properties,
+                                                             modifier_compute_context,
+                                                             call_data,
+                                                             std::move(geometry_set));
+    if (disk_cache_key && bake::geometry_is_disk_cacheable(geometry_set)) {
+      bake::disk_cache_write_geometry(*disk_cache_key, geometry_set);
+    }
+  }
 
   if (logging_enabled(ctx)) {
     nmd_orig->runtime->eval_log = std::move(eval_log);
@@ -2266,6 +2685,7 @@ static void draw_manage_panel(const bContext *C,
                               PointerRNA *modifier_ptr,
                               NodesModifierData &nmd)
 {
+  uiItemR(layout, modifier_ptr, "use_disk_cache", UI_ITEM_NONE, nullptr, ICON_NONE);
   if (uiLayout *panel_layout = uiLayoutPanelProp(
           C, layout, modifier_ptr, "open_bake_panel", IFACE_("Bake")))
   {
@@ -122,6 +122,8 @@ inline bool try_dispatch_float_math_fl_fl_to_fl(const int operation, Callback &&
 
   static auto exec_preset_fast = mf::build::exec_presets::AllSpanOrSingle();
   static auto exec_preset_slow = mf::build::exec_presets::Materialized();
+  /* Generic component-wise functions that are also evaluated with SIMD instructions. */
+  static auto exec_preset_simd = mf::build::exec_presets::ComponentWiseSimd();
 
   /* This is just an utility function to keep the individual cases smaller. */
   auto dispatch = [&](auto exec_preset, auto math_function) -> bool {
@@ -131,21 +133,22 @@ inline bool try_dispatch_float_math_fl_fl_to_fl(const int operation, Callback &&
 
   switch (operation) {
     case NODE_MATH_ADD:
-      return dispatch(exec_preset_fast, [](float a, float b) { return a + b; });
+      return dispatch(exec_preset_simd, [](auto a, auto b) { return a + b; });
     case NODE_MATH_SUBTRACT:
-      return dispatch(exec_preset_fast, [](float a, float b) { return a - b; });
+      return dispatch(exec_preset_simd, [](auto a, auto b) { return a - b; });
     case NODE_MATH_MULTIPLY:
-      return dispatch(exec_preset_fast, [](float a, float b) { return a * b; });
+      return dispatch(exec_preset_simd, [](auto a, auto b) { return a * b; });
     case NODE_MATH_DIVIDE:
-      return dispatch(exec_preset_fast, [](float a, float b) { return safe_divide(a, b); });
+      return dispatch(exec_preset_simd,
+                      [](auto a, auto b) { return math::safe_divide(a, b); });
     case NODE_MATH_POWER:
       return dispatch(exec_preset_slow, [](float a, float b) { return safe_powf(a, b); });
     case NODE_MATH_LOGARITHM:
       return dispatch(exec_preset_slow, [](float a, float b) { return safe_logf(a, b); });
     case NODE_MATH_MINIMUM:
-      return dispatch(exec_preset_fast, [](float a, float b) { return std::min(a, b); });
+      return dispatch(exec_preset_simd, [](auto a, auto b) { return math::min(a, b); });
     case NODE_MATH_MAXIMUM:
-      return dispatch(exec_preset_fast, [](float a, float b) { return std::max(a, b); });
+      return dispatch(exec_preset_simd, [](auto a, auto b) { return math::max(a, b); });
     case NODE_MATH_LESS_THAN:
       return dispatch(exec_preset_fast, [](float a, float b) { return (float)(a < b); });
     case NODE_MATH_GREATER_THAN:
@@ -184,8 +187,8 @@ inline bool try_dispatch_float_math_fl_fl_fl_to_fl(const int operation, Callback
 
   switch (operation) {
     case NODE_MATH_MULTIPLY_ADD:
-      return dispatch(mf::build::exec_presets::AllSpanOrSingle(),
-                      [](float a, float b, float c) { return a * b + c; });
+      return dispatch(mf::build::exec_presets::ComponentWiseSimd(),
+                      [](auto a, auto b, auto c) { return a * b + c; });
     case NODE_MATH_COMPARE:
       return dispatch(mf::build::exec_presets::SomeSpanOrSingle<0, 1>(),
                       [](float a, float b, float c) -> float {
@@ -220,6 +223,8 @@ inline bool try_dispatch_float_math_fl3_fl3_to_fl3(const NodeVectorMathOperation
 
   static auto exec_preset_fast = mf::build::exec_presets::AllSpanOrSingle();
   static auto exec_preset_slow = mf::build::exec_presets::Materialized();
+  /* Generic component-wise functions that are also evaluated with SIMD instructions. */
+  static auto exec_preset_simd = mf::build::exec_presets::ComponentWiseSimd();
 
   /* This is just a utility function to keep the individual cases smaller. */
   auto dispatch = [&](auto exec_preset, auto math_function) -> bool {
@@ -229,13 +234,13 @@ inline bool try_dispatch_float_math_fl3_fl3_to_fl3(const NodeVectorMathOperation
 
   switch (operation) {
     case NODE_VECTOR_MATH_ADD:
-      return dispatch(exec_preset_fast, [](float3 a, float3 b) { return a + b; });
+      return dispatch(exec_preset_simd, [](auto a, auto b) { return a + b; });
     case NODE_VECTOR_MATH_SUBTRACT:
-      return dispatch(exec_preset_fast, [](float3 a, float3 b) { return a - b; });
+      return dispatch(exec_preset_simd, [](auto a, auto b) { return a - b; });
     case NODE_VECTOR_MATH_MULTIPLY:
-      return dispatch(exec_preset_fast, [](float3 a, float3 b) { return a * b; });
+      return dispatch(exec_preset_simd, [](auto a, auto b) { return a * b; });
     case NODE_VECTOR_MATH_DIVIDE:
-      return dispatch(exec_preset_fast, [](float3 a, float3 b) { return safe_divide(a, b); });
+      return dispatch(exec_preset_simd, [](auto a, auto b) { return math::safe_divide(a, b); });
     case NODE_VECTOR_MATH_CROSS_PRODUCT:
       return dispatch(exec_preset_fast,
                       [](float3 a, float3 b) { return cross_high_precision(a, b); });
@@ -250,9 +255,9 @@ inline bool try_dispatch_float_math_fl3_fl3_to_fl3(const NodeVectorMathOperation
     case NODE_VECTOR_MATH_MODULO:
       return dispatch(exec_preset_slow, [](float3 a, float3 b) { return mod(a, b); });
     case NODE_VECTOR_MATH_MINIMUM:
-      return dispatch(exec_preset_fast, [](float3 a, float3 b) { return min(a, b); });
+      return dispatch(exec_preset_simd, [](auto a, auto b) { return math::min(a, b); });
     case NODE_VECTOR_MATH_MAXIMUM:
-      return dispatch(exec_preset_fast, [](float3 a, float3 b) { return max(a, b); });
+      return dispatch(exec_preset_simd, [](auto a, auto b) { return math::max(a, b); });
     default:
       return false;
   }
@@ -317,7 +322,8 @@ inline bool try_dispatch_float_math_fl3_fl3_fl3_to_fl3(const NodeVectorMathOpera
 
   switch (operation) {
     case NODE_VECTOR_MATH_MULTIPLY_ADD:
-      return dispatch(exec_preset_fast, [](float3 a, float3 b, float3 c) { return a * b + c; });
+      return dispatch(mf::build::exec_presets::ComponentWiseSimd(),
+                      [](auto a, auto b, auto c) { return a * b + c; });
     case NODE_VECTOR_MATH_WRAP:
       return dispatch(exec_preset_slow, [](float3 a, float3 b, float3 c) {
         return float3(wrapf(a.x, b.x, c.x), wrapf(a.y, b.y, c.y), wrapf(a.z, b.z, c.z));
@@ -242,19 +242,26 @@ static float3 clamp_range(const float3 value, const float3 min, const float3 max
                 clamp_range(value.z, min.z, max.z));
 }
 
+static mf::build::FloatLanes clamp_range(const mf::build::FloatLanes value,
+                                         const mf::build::FloatLanes min,
+                                         const mf::build::FloatLanes max)
+{
+  return math::clamp(value, math::min(min, max), math::max(min, max));
+}
+
 template<bool Clamp> static auto build_float_linear()
 {
   return mf::build::SI5_SO<float, float, float, float, float, float>(
       Clamp ? "Map Range (clamped)" : "Map Range (unclamped)",
-      [](float value, float from_min, float from_max, float to_min, float to_max) -> float {
-        const float factor = safe_divide(value - from_min, from_max - from_min);
-        float result = to_min + factor * (to_max - to_min);
+      [](auto value, auto from_min, auto from_max, auto to_min, auto to_max) {
+        const auto factor = math::safe_divide(value - from_min, from_max - from_min);
+        auto result = to_min + factor * (to_max - to_min);
         if constexpr (Clamp) {
           result = clamp_range(result, to_min, to_max);
         }
         return result;
       },
-      mf::build::exec_presets::SomeSpanOrSingle<0>());
+      mf::build::exec_presets::ComponentWiseSimd<mf::build::exec_presets::SomeSpanOrSingle<0>>());
 }
 
 template<bool Clamp> static auto build_float_stepped()
@@ -278,19 +285,19 @@ template<bool Clamp> static auto build_vector_linear()
 {
   return mf::build::SI5_SO<float3, float3, float3, float3, float3, float3>(
       Clamp ? "Vector Map Range (clamped)" : "Vector Map Range (unclamped)",
-      [](const float3 &value,
-         const float3 &from_min,
-         const float3 &from_max,
-         const float3 &to_min,
-         const float3 &to_max) -> float3 {
-        float3 factor = math::safe_divide(value - from_min, from_max - from_min);
-        float3 result = factor * (to_max - to_min) + to_min;
+      [](const auto &value,
+         const auto &from_min,
+         const auto &from_max,
+         const auto &to_min,
+         const auto &to_max) {
+        const auto factor = math::safe_divide(value - from_min, from_max - from_min);
+        auto result = factor * (to_max - to_min) + to_min;
         if constexpr (Clamp) {
           result = clamp_range(result, to_min, to_max);
         }
         return result;
       },
-      mf::build::exec_presets::SomeSpanOrSingle<0>());
+      mf::build::exec_presets::ComponentWiseSimd<mf::build::exec_presets::SomeSpanOrSingle<0>>());
 }
 
 template<bool Clamp> static auto build_vector_stepped()
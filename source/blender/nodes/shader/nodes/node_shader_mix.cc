@@ -464,16 +464,18 @@ static const mf::MultiFunction *get_multi_function(const bNode &node)
     case SOCK_FLOAT: {
       if (clamp_factor) {
         static auto fn = mf::build::SI3_SO<float, float, float, float>(
-            "Clamp Mix Float", [](float t, const float a, const float b) {
-              return math::interpolate(a, b, std::clamp(t, 0.0f, 1.0f));
-            });
+            "Clamp Mix Float",
+            [](const auto t, const auto a, const auto b) {
+              return math::interpolate(a, b, math::clamp(t, 0.0f, 1.0f));
+            },
+            mf::build::exec_presets::ComponentWiseSimd());
         return &fn;
       }
       else {
         static auto fn = mf::build::SI3_SO<float, float, float, float>(
-            "Mix Float", [](const float t, const float a, const float b) {
-              return math::interpolate(a, b, t);
-            });
+            "Mix Float",
+            [](const auto t, const auto a, const auto b) { return math::interpolate(a, b, t); },
+            mf::build::exec_presets::ComponentWiseSimd());
         return &fn;
       }
     }
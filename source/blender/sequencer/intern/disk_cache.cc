@@ -8,8 +8,17 @@
 
 #include <cstddef>
 #include <ctime>
+#include <fcntl.h>
 #include <memory.h>
 
+#ifndef WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
+#include <zstd.h>
+
 #include "MEM_guardedalloc.h"
 
 #include "DNA_scene_types.h"
@@ -25,6 +34,8 @@
 #include "BLI_fileops.h"
 #include "BLI_fileops_types.h"
 #include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_mmap.h"
 #include "BLI_path_util.h"
 #include "BLI_threads.h"
 
@@ -44,8 +55,12 @@
  * For each cached non-temp image, image data and supplementary info are written to HDD.
  * Multiple(DCACHE_IMAGES_PER_FILE) images share the same file.
  * Each of these files contains header DiskCacheHeader followed by image data.
- * ZLIB compression with user definable level can be used to compress image data(per image)
+ * ZSTD compression with user definable level can be used to compress image data(per image)
  * Images are written in order in which they are rendered.
+ * Writing happens on a background thread, images are queued by #seq_disk_cache_write_file and
+ * can be read back from the queue until they are written. Compression happens outside of the
+ * read/write lock, so that reading is only limited by storage bandwidth.
+ * Headers are read once and kept in memory, image data is read from memory-mapped files.
  * Overwriting of individual entry is not possible.
  * Stored images are deleted by invalidation, or when size of all files exceeds maximum
  * size specified in user preferences.
@@ -58,6 +73,8 @@
 #define DCACHE_FNAME_FORMAT "%d-%dx%d-%d%%(%d)-%d.dcf"
 #define DCACHE_IMAGES_PER_FILE 100
 #define DCACHE_CURRENT_VERSION 2
+/* Number of images that can wait to be written, before rendering has to wait for the disk. */
+#define DCACHE_WRITE_QUEUE_MAX 8
 #define COLORSPACE_NAME_MAX 64 /* XXX: defined in IMB intern. */
 
 struct DiskCacheHeaderEntry {
@@ -79,6 +96,30 @@ struct SeqDiskCache {
   ListBase files;
   ThreadMutex read_write_mutex;
   size_t size_total;
+
+  /** #DiskCacheWrite items, written in order by the writer thread. */
+  ListBase write_queue;
+  int write_queue_len;
+  /** Protects the write queue, except #DiskCacheWrite.discard. */
+  ThreadMutex write_queue_mutex;
+  /** Notified when an image was added to or removed from the queue. */
+  ThreadCondition write_queue_cond;
+  ListBase write_threads;
+  bool write_thread_stop;
+  /** Only used by the writer thread. */
+  ZSTD_CCtx *compress_ctx;
+};
+
+struct DiskCacheWrite {
+  DiskCacheWrite *next, *prev;
+  char filepath[FILE_MAX];
+  float frame_index;
+  int cache_type;
+  ImBuf *ibuf;
+  /** The writer thread is compressing or writing this image. */
+  bool is_writing;
+  /** The image was invalidated while it was written. Protected by `read_write_mutex`. */
+  bool discard;
 };
 
 struct DiskCacheFile {
@@ -93,10 +134,12 @@ struct DiskCacheFile {
   int render_size;
   int view_id;
   int start_frame;
+  /** Read on first access and kept up to date when writing, null until then. */
+  DiskCacheHeader *header;
+  /** Mapped on first read and kept for following reads, closed when the file is written. */
+  BLI_mmap_file *mmap_file;
 };
 
-static ThreadMutex cache_create_lock = BLI_MUTEX_INITIALIZER;
-
 static const char *seq_disk_cache_base_dir()
 {
   return U.sequencer_disk_cache_dir;
@@ -107,6 +150,9 @@ static int seq_disk_cache_compression_level()
   switch (U.sequencer_disk_cache_compression) {
     case USER_SEQ_DISK_CACHE_COMPRESSION_NONE:
       return 0;
+    case USER_SEQ_DISK_CACHE_COMPRESSION_FAST:
+      /* Negative levels are the `--fast` levels of zstd. */
+      return -5;
     case USER_SEQ_DISK_CACHE_COMPRESSION_LOW:
       return 1;
     case USER_SEQ_DISK_CACHE_COMPRESSION_HIGH:
@@ -152,6 +198,30 @@ static DiskCacheFile *seq_disk_cache_add_file_to_list(SeqDiskCache *disk_cache,
   return cache_file;
 }
 
+static void seq_disk_cache_close_mmap(DiskCacheFile *cache_file)
+{
+  if (cache_file->mmap_file) {
+    IMB_mmap_lock();
+    BLI_mmap_free(cache_file->mmap_file);
+    IMB_mmap_unlock();
+    cache_file->mmap_file = nullptr;
+  }
+}
+
+static void seq_disk_cache_free_file_data(DiskCacheFile *cache_file)
+{
+  seq_disk_cache_close_mmap(cache_file);
+  MEM_SAFE_FREE(cache_file->header);
+}
+
+static void seq_disk_cache_free_file_list(SeqDiskCache *disk_cache)
+{
+  LISTBASE_FOREACH (DiskCacheFile *, cache_file, &disk_cache->files) {
+    seq_disk_cache_free_file_data(cache_file);
+  }
+  BLI_freelistN(&disk_cache->files);
+}
+
 static void seq_disk_cache_get_files(SeqDiskCache *disk_cache, const char *dirpath)
 {
   direntry *filelist, *fl;
@@ -211,6 +281,7 @@ static DiskCacheFile *seq_disk_cache_get_oldest_file(SeqDiskCache *disk_cache)
 static void seq_disk_cache_delete_file(SeqDiskCache *disk_cache, DiskCacheFile *file)
 {
   disk_cache->size_total -= file->fstat.st_size;
+  seq_disk_cache_free_file_data(file);
   BLI_delete(file->filepath, false, false);
   BLI_remlink(&disk_cache->files, file);
   MEM_freeN(file);
@@ -230,7 +301,7 @@ bool seq_disk_cache_enforce_limits(SeqDiskCache *disk_cache)
 
     if (BLI_exists(oldest_file->filepath) == 0) {
       /* File may have been manually deleted during runtime, do re-scan. */
-      BLI_freelistN(&disk_cache->files);
+      seq_disk_cache_free_file_list(disk_cache);
       seq_disk_cache_get_files(disk_cache, seq_disk_cache_base_dir());
       continue;
     }
@@ -367,6 +438,12 @@ static void seq_disk_cache_handle_versioning(SeqDiskCache *disk_cache)
   }
 }
 
+static void seq_disk_cache_write_free(DiskCacheWrite *item)
+{
+  IMB_freeImBuf(item->ibuf);
+  MEM_freeN(item);
+}
+
 static void seq_disk_cache_delete_invalid_files(SeqDiskCache *disk_cache,
                                                 Scene *scene,
                                                 Sequence *seq,
@@ -392,6 +469,35 @@ static void seq_disk_cache_delete_invalid_files(SeqDiskCache *disk_cache,
     }
     cache_file = next_file;
   }
+
+  /* Images that are not written yet would otherwise re-create the deleted files. */
+  BLI_mutex_lock(&disk_cache->write_queue_mutex);
+  LISTBASE_FOREACH_MUTABLE (DiskCacheWrite *, item, &disk_cache->write_queue) {
+    if ((item->cache_type & invalidate_types) == 0) {
+      continue;
+    }
+    char item_dir[FILE_MAXDIR];
+    BLI_path_split_dir_part(item->filepath, item_dir, sizeof(item_dir));
+    if (!STREQ(cache_dir, item_dir)) {
+      continue;
+    }
+    const int start_frame = (int(item->frame_index) / DCACHE_IMAGES_PER_FILE) *
+                            DCACHE_IMAGES_PER_FILE;
+    int timeline_frame_start = seq_cache_frame_index_to_timeline_frame(seq, start_frame);
+    if (timeline_frame_start <= range_start || timeline_frame_start > range_end) {
+      continue;
+    }
+    if (item->is_writing) {
+      item->discard = true;
+    }
+    else {
+      BLI_remlink(&disk_cache->write_queue, item);
+      disk_cache->write_queue_len--;
+      seq_disk_cache_write_free(item);
+    }
+  }
+  BLI_condition_notify_all(&disk_cache->write_queue_cond);
+  BLI_mutex_unlock(&disk_cache->write_queue_mutex);
 }
 
 void seq_disk_cache_invalidate(SeqDiskCache *disk_cache,
@@ -413,41 +519,86 @@ void seq_disk_cache_invalidate(SeqDiskCache *disk_cache,
   BLI_mutex_unlock(&disk_cache->read_write_mutex);
 }
 
-static size_t deflate_imbuf_to_file(ImBuf *ibuf,
-                                    FILE *file,
-                                    int level,
-                                    DiskCacheHeaderEntry *header_entry)
+static void *seq_disk_cache_imbuf_data(ImBuf *ibuf)
 {
-  void *data = (ibuf->byte_buffer.data != nullptr) ? (void *)ibuf->byte_buffer.data :
-                                                     (void *)ibuf->float_buffer.data;
+  return (ibuf->byte_buffer.data != nullptr) ? (void *)ibuf->byte_buffer.data :
+                                               (void *)ibuf->float_buffer.data;
+}
 
-  /* Apply compression if wanted, otherwise just write directly to the file. */
-  if (level > 0) {
-    return BLI_file_zstd_from_mem_at_pos(
-        data, header_entry->size_raw, file, header_entry->offset, level);
+static size_t seq_disk_cache_imbuf_size(const ImBuf *ibuf)
+{
+  if (ibuf->byte_buffer.data) {
+    return size_t(ibuf->x) * ibuf->y * ibuf->channels;
+  }
+  return size_t(ibuf->x) * ibuf->y * ibuf->channels * 4;
+}
+
+static size_t seq_disk_cache_compress(
+    SeqDiskCache *disk_cache, const void *data, size_t size, void *dest, size_t dest_size)
+{
+  if (disk_cache->compress_ctx == nullptr) {
+    disk_cache->compress_ctx = ZSTD_createCCtx();
+  }
+  ZSTD_CCtx *ctx = disk_cache->compress_ctx;
+  ZSTD_CCtx_reset(ctx, ZSTD_reset_session_and_parameters);
+  ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, seq_disk_cache_compression_level());
+  /* Split large images into jobs that are compressed in parallel. This is silently ignored when
+   * zstd is built without multi-threading support. */
+  ZSTD_CCtx_setParameter(ctx, ZSTD_c_nbWorkers, min_ii(BLI_system_thread_count() / 2, 4));
+
+  const size_t ret = ZSTD_compress2(ctx, dest, dest_size, data, size);
+  return ZSTD_isError(ret) ? 0 : ret;
+}
+
+/* Map the file on first access, the mapping is reused until the file is written to. */
+static BLI_mmap_file *seq_disk_cache_ensure_mmap(DiskCacheFile *cache_file)
+{
+  if (cache_file->mmap_file) {
+    return cache_file->mmap_file;
+  }
+
+  const int fd = BLI_open(cache_file->filepath, O_BINARY | O_RDONLY, 0);
+  if (fd == -1) {
+    return nullptr;
   }
 
-  fseek(file, header_entry->offset, SEEK_SET);
-  return fwrite(data, 1, header_entry->size_raw, file);
+  IMB_mmap_lock();
+  cache_file->mmap_file = BLI_mmap_open(fd);
+  IMB_mmap_unlock();
+  close(fd);
+
+  return cache_file->mmap_file;
 }
 
-static size_t inflate_file_to_imbuf(ImBuf *ibuf, FILE *file, DiskCacheHeaderEntry *header_entry)
+/* Copy image data from the memory-mapped file, decompressing it if needed. */
+static size_t seq_disk_cache_read_entry(DiskCacheFile *cache_file,
+                                        const DiskCacheHeaderEntry *header_entry,
+                                        void *dest)
 {
-  void *data = (ibuf->byte_buffer.data != nullptr) ? (void *)ibuf->byte_buffer.data :
-                                                     (void *)ibuf->float_buffer.data;
-  char header[4];
-  fseek(file, header_entry->offset, SEEK_SET);
-  if (fread(header, 1, sizeof(header), file) != sizeof(header)) {
+  BLI_mmap_file *mmap_file = seq_disk_cache_ensure_mmap(cache_file);
+  if (mmap_file == nullptr) {
     return 0;
   }
 
-  /* Check if the data is compressed or raw. */
-  if (BLI_file_magic_is_zstd(header)) {
-    return BLI_file_unzstd_to_mem_at_pos(data, header_entry->size_raw, file, header_entry->offset);
+  size_t bytes_read = 0;
+  const char *mem = static_cast<const char *>(BLI_mmap_get_pointer(mmap_file));
+  const size_t offset = header_entry->offset;
+  const size_t size = header_entry->size_compressed;
+
+  if (offset + size <= BLI_mmap_get_length(mmap_file) && size >= 4) {
+    /* Check if the data is compressed or raw. */
+    if (BLI_file_magic_is_zstd(mem + offset)) {
+      const size_t ret = ZSTD_decompress(dest, header_entry->size_raw, mem + offset, size);
+      bytes_read = ZSTD_isError(ret) ? 0 : ret;
+    }
+    else if (size == header_entry->size_raw &&
+             BLI_mmap_read(mmap_file, dest, offset, header_entry->size_raw))
+    {
+      bytes_read = header_entry->size_raw;
+    }
   }
 
-  fseek(file, header_entry->offset, SEEK_SET);
-  return fread(data, 1, header_entry->size_raw, file);
+  return bytes_read;
 }
 
 static bool seq_disk_cache_read_header(FILE *file, DiskCacheHeader *header)
@@ -478,7 +629,32 @@ static size_t seq_disk_cache_write_header(FILE *file, const DiskCacheHeader *hea
   return fwrite(header, sizeof(*header), 1, file);
 }
 
-static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCacheHeader *header)
+/* Get the in-memory header of the file, reading it on first access. */
+static DiskCacheHeader *seq_disk_cache_ensure_header(DiskCacheFile *cache_file)
+{
+  if (cache_file->header) {
+    return cache_file->header;
+  }
+
+  DiskCacheHeader *header = MEM_cnew<DiskCacheHeader>("SeqDiskCacheHeader");
+  /* The file may be empty when it was just created, then the header is empty as well. */
+  if (cache_file->fstat.st_size != 0) {
+    FILE *file = BLI_fopen(cache_file->filepath, "rb");
+    const bool success = file && seq_disk_cache_read_header(file, header);
+    if (file) {
+      fclose(file);
+    }
+    if (!success) {
+      MEM_freeN(header);
+      return nullptr;
+    }
+  }
+
+  cache_file->header = header;
+  return header;
+}
+
+static int seq_disk_cache_add_header_entry(float frame_index, ImBuf *ibuf, DiskCacheHeader *header)
 {
   int i;
   uint64_t offset = sizeof(*header);
@@ -511,16 +687,15 @@ static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCa
   }
 
   header->entry[i].offset = offset;
-  header->entry[i].frameno = key->frame_index;
+  header->entry[i].frameno = frame_index;
+  header->entry[i].size_raw = seq_disk_cache_imbuf_size(ibuf);
 
   /* Store colorspace name of ibuf. */
   const char *colorspace_name;
   if (ibuf->byte_buffer.data) {
-    header->entry[i].size_raw = int64_t(ibuf->x) * ibuf->y * ibuf->channels;
     colorspace_name = IMB_colormanagement_get_rect_colorspace(ibuf);
   }
   else {
-    header->entry[i].size_raw = int64_t(ibuf->x) * ibuf->y * ibuf->channels * 4;
     colorspace_name = IMB_colormanagement_get_float_colorspace(ibuf);
   }
   STRNCPY(header->entry[i].colorspace_name, colorspace_name);
@@ -531,7 +706,7 @@ static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCa
 static int seq_disk_cache_get_header_entry(SeqCacheKey *key, const DiskCacheHeader *header)
 {
   for (int i = 0; i < DCACHE_IMAGES_PER_FILE; i++) {
-    if (header->entry[i].frameno == key->frame_index) {
+    if (header->entry[i].frameno == key->frame_index && header->entry[i].size_compressed != 0) {
       return i;
     }
   }
@@ -539,13 +714,13 @@ static int seq_disk_cache_get_header_entry(SeqCacheKey *key, const DiskCacheHead
   return -1;
 }
 
-bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf *ibuf)
+/* Append already compressed image data to the file, must be called with `read_write_mutex`. */
+static bool seq_disk_cache_write_entry(SeqDiskCache *disk_cache,
+                                       DiskCacheWrite *item,
+                                       const void *data,
+                                       size_t size)
 {
-  BLI_mutex_lock(&disk_cache->read_write_mutex);
-
-  char filepath[FILE_MAX];
-
-  seq_disk_cache_get_file_path(disk_cache, key, filepath, sizeof(filepath));
+  const char *filepath = item->filepath;
   BLI_file_ensure_parent_dir_exists(filepath);
 
   /* Touch the file. */
@@ -553,110 +728,221 @@ bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf
   if (!file) {
     file = BLI_fopen(filepath, "wb+");
     if (!file) {
-      BLI_mutex_unlock(&disk_cache->read_write_mutex);
       return false;
     }
-    seq_disk_cache_add_file_to_list(disk_cache, filepath);
   }
 
   DiskCacheFile *cache_file = seq_disk_cache_get_file_entry_by_path(disk_cache, filepath);
-  DiskCacheHeader header;
-  memset(&header, 0, sizeof(header));
-  /* The file may be empty when touched (above).
-   * This is fine, don't attempt reading the header in that case. */
-  if (cache_file->fstat.st_size != 0 && !seq_disk_cache_read_header(file, &header)) {
+  if (cache_file == nullptr) {
+    cache_file = seq_disk_cache_add_file_to_list(disk_cache, filepath);
+  }
+
+  /* The mapping doesn't cover data appended to the file. */
+  seq_disk_cache_close_mmap(cache_file);
+
+  DiskCacheHeader *header = seq_disk_cache_ensure_header(cache_file);
+  if (header == nullptr) {
     fclose(file);
     seq_disk_cache_delete_file(disk_cache, cache_file);
-    BLI_mutex_unlock(&disk_cache->read_write_mutex);
     return false;
   }
-  int entry_index = seq_disk_cache_add_header_entry(key, ibuf, &header);
-
-  size_t bytes_written = deflate_imbuf_to_file(
-      ibuf, file, seq_disk_cache_compression_level(), &header.entry[entry_index]);
+  int entry_index = seq_disk_cache_add_header_entry(item->frame_index, item->ibuf, header);
 
-  if (bytes_written != 0) {
-    /* Last step is writing header, as image data can be overwritten,
-     * but missing data would cause problems.
-     */
-    header.entry[entry_index].size_compressed = bytes_written;
-    seq_disk_cache_write_header(file, &header);
-    seq_disk_cache_update_file(disk_cache, filepath);
+  BLI_fseek(file, header->entry[entry_index].offset, SEEK_SET);
+  if (fwrite(data, 1, size, file) != size) {
+    memset(&header->entry[entry_index], 0, sizeof(header->entry[entry_index]));
     fclose(file);
+    return false;
+  }
 
-    BLI_mutex_unlock(&disk_cache->read_write_mutex);
-    return true;
+  /* Last step is writing header, as image data can be overwritten,
+   * but missing data would cause problems.
+   */
+  header->entry[entry_index].size_compressed = size;
+  seq_disk_cache_write_header(file, header);
+  fclose(file);
+  seq_disk_cache_update_file(disk_cache, filepath);
+
+  return true;
+}
+
+static bool seq_disk_cache_write_item(SeqDiskCache *disk_cache, DiskCacheWrite *item)
+{
+  const void *data = seq_disk_cache_imbuf_data(item->ibuf);
+  const size_t size_raw = seq_disk_cache_imbuf_size(item->ibuf);
+  size_t size = size_raw;
+  void *compressed = nullptr;
+
+  /* Compress before locking, so that reading is not blocked by the compressor. */
+  if (seq_disk_cache_compression_level() != 0) {
+    const size_t compressed_size_max = ZSTD_compressBound(size_raw);
+    compressed = MEM_mallocN(compressed_size_max, __func__);
+    size = seq_disk_cache_compress(disk_cache, data, size_raw, compressed, compressed_size_max);
+    if (size == 0) {
+      MEM_freeN(compressed);
+      return false;
+    }
+    data = compressed;
   }
 
+  BLI_mutex_lock(&disk_cache->read_write_mutex);
+  const bool success = !item->discard && seq_disk_cache_write_entry(disk_cache, item, data, size);
   BLI_mutex_unlock(&disk_cache->read_write_mutex);
-  return false;
+
+  MEM_SAFE_FREE(compressed);
+  return success;
 }
 
-ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *key)
+static void *seq_disk_cache_write_thread(void *data)
 {
-  BLI_mutex_lock(&disk_cache->read_write_mutex);
+  SeqDiskCache *disk_cache = static_cast<SeqDiskCache *>(data);
 
-  char filepath[FILE_MAX];
-  DiskCacheHeader header;
+  BLI_mutex_lock(&disk_cache->write_queue_mutex);
+  while (true) {
+    while (!disk_cache->write_thread_stop && BLI_listbase_is_empty(&disk_cache->write_queue)) {
+      BLI_condition_wait(&disk_cache->write_queue_cond, &disk_cache->write_queue_mutex);
+    }
+    if (disk_cache->write_thread_stop) {
+      break;
+    }
+
+    /* Keep the item in the queue while writing, so it can still be read. */
+    DiskCacheWrite *item = static_cast<DiskCacheWrite *>(disk_cache->write_queue.first);
+    item->is_writing = true;
+    BLI_mutex_unlock(&disk_cache->write_queue_mutex);
+
+    if (seq_disk_cache_write_item(disk_cache, item)) {
+      seq_disk_cache_enforce_limits(disk_cache);
+    }
+
+    BLI_mutex_lock(&disk_cache->write_queue_mutex);
+    BLI_remlink(&disk_cache->write_queue, item);
+    disk_cache->write_queue_len--;
+    seq_disk_cache_write_free(item);
+    BLI_condition_notify_all(&disk_cache->write_queue_cond);
+  }
+  BLI_mutex_unlock(&disk_cache->write_queue_mutex);
+
+  return nullptr;
+}
+
+/* Get image that is waiting to be written, so it is not rendered again in the meantime. */
+static ImBuf *seq_disk_cache_write_queue_find(SeqDiskCache *disk_cache,
+                                              const char *filepath,
+                                              float frame_index)
+{
+  ImBuf *ibuf = nullptr;
+
+  BLI_mutex_lock(&disk_cache->write_queue_mutex);
+  LISTBASE_FOREACH (DiskCacheWrite *, item, &disk_cache->write_queue) {
+    if (item->frame_index == frame_index && STREQ(item->filepath, filepath)) {
+      ibuf = item->ibuf;
+      IMB_refImBuf(ibuf);
+      break;
+    }
+  }
+  BLI_mutex_unlock(&disk_cache->write_queue_mutex);
+
+  return ibuf;
+}
+
+bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf *ibuf)
+{
+  DiskCacheWrite *item = MEM_cnew<DiskCacheWrite>("SeqDiskCacheWrite");
+  seq_disk_cache_get_file_path(disk_cache, key, item->filepath, sizeof(item->filepath));
+  item->frame_index = key->frame_index;
+  item->cache_type = key->type;
+  item->ibuf = ibuf;
+  IMB_refImBuf(ibuf);
+
+  BLI_mutex_lock(&disk_cache->write_queue_mutex);
+  /* Don't let the queue grow when images are rendered faster than they can be written. */
+  while (!disk_cache->write_thread_stop && disk_cache->write_queue_len >= DCACHE_WRITE_QUEUE_MAX)
+  {
+    BLI_condition_wait(&disk_cache->write_queue_cond, &disk_cache->write_queue_mutex);
+  }
+  BLI_addtail(&disk_cache->write_queue, item);
+  disk_cache->write_queue_len++;
+  BLI_condition_notify_all(&disk_cache->write_queue_cond);
+  BLI_mutex_unlock(&disk_cache->write_queue_mutex);
+
+  return true;
+}
 
+void seq_disk_cache_write_wait(SeqDiskCache *disk_cache)
+{
+  BLI_mutex_lock(&disk_cache->write_queue_mutex);
+  while (!disk_cache->write_thread_stop && disk_cache->write_queue_len > 0) {
+    BLI_condition_wait(&disk_cache->write_queue_cond, &disk_cache->write_queue_mutex);
+  }
+  BLI_mutex_unlock(&disk_cache->write_queue_mutex);
+}
+
+ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *key)
+{
+  char filepath[FILE_MAX];
   seq_disk_cache_get_file_path(disk_cache, key, filepath, sizeof(filepath));
-  BLI_file_ensure_parent_dir_exists(filepath);
 
-  FILE *file = BLI_fopen(filepath, "rb");
-  if (!file) {
+  ImBuf *ibuf = seq_disk_cache_write_queue_find(disk_cache, filepath, key->frame_index);
+  if (ibuf) {
+    return ibuf;
+  }
+
+  BLI_mutex_lock(&disk_cache->read_write_mutex);
+
+  /* All files are known since the cache directory was scanned when creating the disk cache. */
+  DiskCacheFile *cache_file = seq_disk_cache_get_file_entry_by_path(disk_cache, filepath);
+  if (cache_file == nullptr) {
     BLI_mutex_unlock(&disk_cache->read_write_mutex);
     return nullptr;
   }
 
-  if (!seq_disk_cache_read_header(file, &header)) {
-    fclose(file);
+  const DiskCacheHeader *header = seq_disk_cache_ensure_header(cache_file);
+  if (header == nullptr) {
     BLI_mutex_unlock(&disk_cache->read_write_mutex);
     return nullptr;
   }
-  int entry_index = seq_disk_cache_get_header_entry(key, &header);
+  int entry_index = seq_disk_cache_get_header_entry(key, header);
 
   /* Item not found. */
   if (entry_index < 0) {
-    fclose(file);
     BLI_mutex_unlock(&disk_cache->read_write_mutex);
     return nullptr;
   }
 
-  ImBuf *ibuf;
+  const DiskCacheHeaderEntry *header_entry = &header->entry[entry_index];
   uint64_t size_char = uint64_t(key->context.rectx) * key->context.recty * 4;
   uint64_t size_float = uint64_t(key->context.rectx) * key->context.recty * 16;
   size_t expected_size;
 
-  if (header.entry[entry_index].size_raw == size_char) {
+  if (header_entry->size_raw == size_char) {
     expected_size = size_char;
     ibuf = IMB_allocImBuf(
         key->context.rectx, key->context.recty, 32, IB_rect | IB_uninitialized_pixels);
-    IMB_colormanagement_assign_byte_colorspace(ibuf, header.entry[entry_index].colorspace_name);
+    IMB_colormanagement_assign_byte_colorspace(ibuf, header_entry->colorspace_name);
   }
-  else if (header.entry[entry_index].size_raw == size_float) {
+  else if (header_entry->size_raw == size_float) {
     expected_size = size_float;
     ibuf = IMB_allocImBuf(
         key->context.rectx, key->context.recty, 32, IB_rectfloat | IB_uninitialized_pixels);
-    IMB_colormanagement_assign_float_colorspace(ibuf, header.entry[entry_index].colorspace_name);
+    IMB_colormanagement_assign_float_colorspace(ibuf, header_entry->colorspace_name);
   }
   else {
-    fclose(file);
     BLI_mutex_unlock(&disk_cache->read_write_mutex);
     return nullptr;
   }
 
-  size_t bytes_read = inflate_file_to_imbuf(ibuf, file, &header.entry[entry_index]);
+  size_t bytes_read = seq_disk_cache_read_entry(
+      cache_file, header_entry, seq_disk_cache_imbuf_data(ibuf));
 
   /* Sanity check. */
   if (bytes_read != expected_size) {
-    fclose(file);
     IMB_freeImBuf(ibuf);
     BLI_mutex_unlock(&disk_cache->read_write_mutex);
     return nullptr;
   }
   BLI_file_touch(filepath);
   seq_disk_cache_update_file(disk_cache, filepath);
-  fclose(file);
 
   BLI_mutex_unlock(&disk_cache->read_write_mutex);
   return ibuf;
@@ -668,16 +954,33 @@ SeqDiskCache *seq_disk_cache_create(Main *bmain, Scene *scene)
       MEM_callocN(sizeof(SeqDiskCache), "SeqDiskCache"));
   disk_cache->bmain = bmain;
   BLI_mutex_init(&disk_cache->read_write_mutex);
+  BLI_mutex_init(&disk_cache->write_queue_mutex);
+  BLI_condition_init(&disk_cache->write_queue_cond);
   seq_disk_cache_handle_versioning(disk_cache);
   seq_disk_cache_get_files(disk_cache, seq_disk_cache_base_dir());
   disk_cache->timestamp = scene->ed->disk_cache_timestamp;
-  BLI_mutex_unlock(&cache_create_lock);
+  BLI_threadpool_init(&disk_cache->write_threads, seq_disk_cache_write_thread, 1);
+  BLI_threadpool_insert(&disk_cache->write_threads, disk_cache);
   return disk_cache;
 }
 
 void seq_disk_cache_free(SeqDiskCache *disk_cache)
 {
-  BLI_freelistN(&disk_cache->files);
+  BLI_mutex_lock(&disk_cache->write_queue_mutex);
+  disk_cache->write_thread_stop = true;
+  BLI_condition_notify_all(&disk_cache->write_queue_cond);
+  BLI_mutex_unlock(&disk_cache->write_queue_mutex);
+  BLI_threadpool_end(&disk_cache->write_threads);
+
+  /* Images that were not written yet are dropped, the cache doesn't have to be complete. */
+  LISTBASE_FOREACH_MUTABLE (DiskCacheWrite *, item, &disk_cache->write_queue) {
+    seq_disk_cache_write_free(item);
+  }
+  ZSTD_freeCCtx(disk_cache->compress_ctx);
+
+  seq_disk_cache_free_file_list(disk_cache);
+  BLI_condition_end(&disk_cache->write_queue_cond);
+  BLI_mutex_end(&disk_cache->write_queue_mutex);
   BLI_mutex_end(&disk_cache->read_write_mutex);
   MEM_freeN(disk_cache);
 }
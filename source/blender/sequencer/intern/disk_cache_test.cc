@@ -0,0 +1,215 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <cstring>
+#include <string>
+
+#include "BKE_main.hh"
+
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_system.h"
+#include "BLI_tempfile.h"
+
+#include "DNA_scene_types.h"
+#include "DNA_sequence_types.h"
+#include "DNA_userdef_types.h"
+
+#include "IMB_imbuf.hh"
+#include "IMB_imbuf_types.hh"
+
+#include "disk_cache.hh"
+#include "image_cache.hh"
+
+#include BLI_SYSTEM_PID_H
+
+namespace blender::seq::tests {
+
+static constexpr int image_width = 64;
+static constexpr int image_height = 32;
+
+class DiskCacheTest : public testing::Test {
+ public:
+  std::string temp_dir;
+  char disk_cache_dir_backup[sizeof(U.sequencer_disk_cache_dir)];
+  int disk_cache_size_limit_backup;
+  int disk_cache_compression_backup;
+  short disk_cache_flag_backup;
+  Main *bmain;
+  Scene scene;
+  Editing editing;
+  Sequence seq;
+
+  static void SetUpTestSuite()
+  {
+    IMB_init();
+  }
+
+  static void TearDownTestSuite()
+  {
+    IMB_exit();
+  }
+
+  void SetUp() override
+  {
+    char temp_dir_c[FILE_MAX];
+    BLI_temp_directory_path_get(temp_dir_c, sizeof(temp_dir_c));
+    temp_dir = std::string(temp_dir_c) + SEP_STR + "blender_seq_disk_cache_test_" +
+               std::to_string(getpid());
+    BLI_dir_create_recursive(temp_dir.c_str());
+
+    STRNCPY(disk_cache_dir_backup, U.sequencer_disk_cache_dir);
+    disk_cache_size_limit_backup = U.sequencer_disk_cache_size_limit;
+    disk_cache_compression_backup = U.sequencer_disk_cache_compression;
+    disk_cache_flag_backup = U.sequencer_disk_cache_flag;
+    STRNCPY(U.sequencer_disk_cache_dir, temp_dir.c_str());
+    U.sequencer_disk_cache_size_limit = 1;
+    U.sequencer_disk_cache_compression = USER_SEQ_DISK_CACHE_COMPRESSION_NONE;
+    U.sequencer_disk_cache_flag = SEQ_CACHE_DISK_CACHE_ENABLE;
+
+    bmain = BKE_main_new();
+    STRNCPY(bmain->filepath, (temp_dir + SEP_STR + "project.blend").c_str());
+    memset(&scene, 0, sizeof(scene));
+    memset(&editing, 0, sizeof(editing));
+    memset(&seq, 0, sizeof(seq));
+    STRNCPY(scene.id.name, "SCScene");
+    STRNCPY(seq.name, "SQStrip");
+    editing.disk_cache_timestamp = 1;
+    scene.ed = &editing;
+  }
+
+  void TearDown() override
+  {
+    BKE_main_free(bmain);
+    STRNCPY(U.sequencer_disk_cache_dir, disk_cache_dir_backup);
+    U.sequencer_disk_cache_size_limit = disk_cache_size_limit_backup;
+    U.sequencer_disk_cache_compression = disk_cache_compression_backup;
+    U.sequencer_disk_cache_flag = disk_cache_flag_backup;
+    BLI_delete(temp_dir.c_str(), true, true);
+  }
+
+  SeqCacheKey create_key(const float frame_index)
+  {
+    SeqCacheKey key{};
+    key.seq = &seq;
+    key.context.bmain = bmain;
+    key.context.scene = &scene;
+    key.context.rectx = image_width;
+    key.context.recty = image_height;
+    key.context.preview_render_size = 100;
+    key.frame_index = frame_index;
+    key.timeline_frame = frame_index;
+    key.type = SEQ_CACHE_STORE_FINAL_OUT;
+    return key;
+  }
+
+  SeqDiskCache *create_disk_cache()
+  {
+    EXPECT_TRUE(seq_disk_cache_is_enabled(bmain));
+    return seq_disk_cache_create(bmain, &scene);
+  }
+};
+
+/** Byte image where every frame has different content. */
+static ImBuf *create_image(const int frame)
+{
+  ImBuf *ibuf = IMB_allocImBuf(image_width, image_height, 32, IB_rect);
+  for (int i = 0; i < image_width * image_height * 4; i++) {
+    ibuf->byte_buffer.data[i] = uchar((i / 4 + frame * 7) % 256);
+  }
+  return ibuf;
+}
+
+static void expect_image_eq(const ImBuf *ibuf, const int frame)
+{
+  ASSERT_NE(ibuf, nullptr);
+  ASSERT_NE(ibuf->byte_buffer.data, nullptr);
+  ImBuf *expected = create_image(frame);
+  EXPECT_EQ(memcmp(ibuf->byte_buffer.data,
+                   expected->byte_buffer.data,
+                   size_t(image_width) * image_height * 4),
+            0)
+      << "frame " << frame;
+  IMB_freeImBuf(expected);
+}
+
+static void write_image(SeqDiskCache *disk_cache, SeqCacheKey key, const int frame)
+{
+  ImBuf *ibuf = create_image(frame);
+  seq_disk_cache_write_file(disk_cache, &key, ibuf);
+  /* The queue holds its own reference. */
+  IMB_freeImBuf(ibuf);
+}
+
+static void expect_read_image_eq(SeqDiskCache *disk_cache, SeqCacheKey key, const int frame)
+{
+  ImBuf *ibuf = seq_disk_cache_read_file(disk_cache, &key);
+  expect_image_eq(ibuf, frame);
+  IMB_freeImBuf(ibuf);
+}
+
+TEST_F(DiskCacheTest, ReadWhileQueued)
+{
+  /* Images are read back from the write queue or the file, depending on the writer thread. */
+  SeqDiskCache *disk_cache = create_disk_cache();
+  for (int frame = 0; frame < 20; frame++) {
+    write_image(disk_cache, create_key(frame), frame);
+    expect_read_image_eq(disk_cache, create_key(frame), frame);
+  }
+  seq_disk_cache_write_wait(disk_cache);
+  for (int frame = 0; frame < 20; frame++) {
+    expect_read_image_eq(disk_cache, create_key(frame), frame);
+  }
+  seq_disk_cache_free(disk_cache);
+}
+
+TEST_F(DiskCacheTest, ReadFromNewCache)
+{
+  for (const int compression :
+       {USER_SEQ_DISK_CACHE_COMPRESSION_NONE, USER_SEQ_DISK_CACHE_COMPRESSION_FAST})
+  {
+    U.sequencer_disk_cache_compression = compression;
+    editing.disk_cache_timestamp++;
+
+    SeqDiskCache *disk_cache = create_disk_cache();
+    for (int frame = 0; frame < 3; frame++) {
+      write_image(disk_cache, create_key(frame), frame);
+    }
+    seq_disk_cache_write_wait(disk_cache);
+    seq_disk_cache_free(disk_cache);
+
+    /* The files are found by scanning the cache directory, and the headers are read from disk.
+     * Reading twice reuses the memory-mapped file. */
+    disk_cache = create_disk_cache();
+    for (int i = 0; i < 2; i++) {
+      for (int frame = 0; frame < 3; frame++) {
+        expect_read_image_eq(disk_cache, create_key(frame), frame);
+      }
+    }
+    SeqCacheKey missing_key = create_key(3);
+    EXPECT_EQ(seq_disk_cache_read_file(disk_cache, &missing_key), nullptr);
+    seq_disk_cache_free(disk_cache);
+  }
+}
+
+TEST_F(DiskCacheTest, WriteAfterRead)
+{
+  SeqDiskCache *disk_cache = create_disk_cache();
+  write_image(disk_cache, create_key(0), 0);
+  seq_disk_cache_write_wait(disk_cache);
+  /* Maps the file. */
+  expect_read_image_eq(disk_cache, create_key(0), 0);
+
+  /* Appending to the file replaces the mapping, which doesn't cover the new data. */
+  write_image(disk_cache, create_key(1), 1);
+  seq_disk_cache_write_wait(disk_cache);
+  expect_read_image_eq(disk_cache, create_key(1), 1);
+  expect_read_image_eq(disk_cache, create_key(0), 0);
+  seq_disk_cache_free(disk_cache);
+}
+
+}  // namespace blender::seq::tests
@@ -3046,13 +3046,7 @@ static void draw_text_outline(const SeqRenderData *context,
   BLF_buffer(font, nullptr, out->byte_buffer.data, size.x, size.y, display);
 }
 
-static ImBuf *do_text_effect(const SeqRenderData *context,
-                             Sequence *seq,
-                             float /*timeline_frame*/,
-                             float /*fac*/,
-                             ImBuf * /* ibuf1*/,
-                             ImBuf * /* ibuf2*/,
-                             ImBuf * /* ibuf3*/)
+static ImBuf *render_text_effect(const SeqRenderData *context, Sequence *seq)
 {
   /* NOTE: text rasterization only fills in part of output image,
    * need to clear it. */
@@ -3165,6 +3159,26 @@ static ImBuf *do_text_effect(const SeqRenderData *context,
   return out;
 }
 
+/** BLF is not thread-safe, but prefetching may render multiple frames at the same time. */
+static ThreadMutex text_effect_blf_mutex = BLI_MUTEX_INITIALIZER;
+
+static ImBuf *do_text_effect(const SeqRenderData *context,
+                             Sequence *seq,
+                             float /*timeline_frame*/,
+                             float /*fac*/,
+                             ImBuf * /* ibuf1*/,
+                             ImBuf * /* ibuf2*/,
+                             ImBuf * /* ibuf3*/)
+{
+  ImBuf *out;
+  BLI_mutex_lock(&text_effect_blf_mutex);
+  /* Drawing the shadow and outline uses multiple threads. Isolate them, so that the thread holding
+   * the lock doesn't pick up the rendering of another frame that waits for the lock. */
+  threading::isolate_task([&]() { out = render_text_effect(context, seq); });
+  BLI_mutex_unlock(&text_effect_blf_mutex);
+  return out;
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -513,6 +513,20 @@ static void seq_cache_create(Main *bmain, Scene *scene)
   BLI_mutex_unlock(&cache_create_lock);
 }
 
+/* Get the disk cache, creating it on first use. Prefetch threads may need it at the same time,
+ * and every disk cache writes the same files from its own writer thread. */
+static SeqDiskCache *seq_cache_disk_cache_ensure(SeqCache *cache, const SeqRenderData *context)
+{
+  if (cache->disk_cache == nullptr) {
+    BLI_mutex_lock(&cache_create_lock);
+    if (cache->disk_cache == nullptr) {
+      cache->disk_cache = seq_disk_cache_create(context->bmain, context->scene);
+    }
+    BLI_mutex_unlock(&cache_create_lock);
+  }
+  return cache->disk_cache;
+}
+
 static void seq_cache_populate_key(SeqCacheKey *key,
                                    const SeqRenderData *context,
                                    Sequence *seq,
@@ -774,11 +788,7 @@ ImBuf *seq_cache_get(const SeqRenderData *context, Sequence *seq, float timeline
 
   /* Try disk cache: */
   if (seq_disk_cache_is_enabled(context->bmain)) {
-    if (cache->disk_cache == nullptr) {
-      cache->disk_cache = seq_disk_cache_create(context->bmain, context->scene);
-    }
-
-    ibuf = seq_disk_cache_read_file(cache->disk_cache, &key);
+    ibuf = seq_disk_cache_read_file(seq_cache_disk_cache_ensure(cache, context), &key);
 
     if (ibuf == nullptr) {
       return nullptr;
@@ -883,17 +893,20 @@ void seq_cache_put(
   seq_cache_lock(scene);
   SeqCache *cache = seq_cache_get_from_scene(scene);
   SeqCacheKey *key = seq_cache_allocate_key(cache, context, seq, timeline_frame, type);
+  /* Check again while the cache is locked, the same image may have been rendered by another
+   * prefetch thread in the mean-time. */
+  if (BLI_ghash_haskey(cache->hash, key)) {
+    BLI_mempool_free(cache->keys_pool, key);
+    seq_cache_unlock(scene);
+    return;
+  }
   seq_cache_put_ex(scene, key, i);
   seq_cache_unlock(scene);
 
   if (!key->is_temp_cache) {
     if (seq_disk_cache_is_enabled(context->bmain)) {
-      if (cache->disk_cache == nullptr) {
-        seq_disk_cache_create(context->bmain, context->scene);
-      }
-
-      seq_disk_cache_write_file(cache->disk_cache, key, i);
-      seq_disk_cache_enforce_limits(cache->disk_cache);
+      /* Written in the background, size limits are enforced after each written image. */
+      seq_disk_cache_write_file(seq_cache_disk_cache_ensure(cache, context), key, i);
     }
   }
 }
@@ -947,3 +960,10 @@ bool seq_cache_is_full()
 {
   return seq_cache_get_mem_total() < MEM_get_memory_in_use();
 }
+
+size_t seq_cache_memory_available()
+{
+  const size_t mem_total = seq_cache_get_mem_total();
+  const size_t mem_in_use = MEM_get_memory_in_use();
+  return mem_in_use < mem_total ? mem_total - mem_in_use : 0;
+}
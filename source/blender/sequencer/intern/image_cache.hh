@@ -58,4 +58,8 @@ void seq_cache_cleanup_sequence(Scene *scene,
                                 bool force_seq_changed_range);
 void seq_cache_thumbnail_cleanup(Scene *scene, rctf *view_area);
 bool seq_cache_is_full();
+/**
+ * Memory in bytes that can still be used before the cache is full.
+ */
+size_t seq_cache_memory_available();
 float seq_cache_frame_index_to_timeline_frame(Sequence *seq, float frame_index);
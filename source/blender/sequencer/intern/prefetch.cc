@@ -6,6 +6,7 @@
  * \ingroup bke
  */
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdlib>
 #include <cstring>
@@ -17,7 +18,10 @@
 #include "DNA_sequence_types.h"
 #include "DNA_space_types.h"
 
+#include "BLI_array.hh"
 #include "BLI_listbase.h"
+#include "BLI_system.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
 
 #include "IMB_imbuf.hh"
@@ -46,14 +50,26 @@
 #include "prefetch.hh"
 #include "render.hh"
 
+/**
+ * State needed to render one frame in the background. Every worker has its own evaluated copy of
+ * the scene, so that multiple frames can be rendered at the same time.
+ */
+struct PrefetchWorker {
+  Main *bmain_eval;
+  Scene *scene_eval;
+  Depsgraph *depsgraph;
+
+  SeqRenderData context_cpy;
+};
+
 struct PrefetchJob {
   PrefetchJob *next, *prev;
 
   Main *bmain;
-  Main *bmain_eval;
   Scene *scene;
-  Scene *scene_eval;
-  Depsgraph *depsgraph;
+
+  PrefetchWorker *workers;
+  int workers_num;
 
   ThreadMutex prefetch_suspend_mutex;
   ThreadCondition prefetch_suspend_cond;
@@ -62,13 +78,16 @@ struct PrefetchJob {
 
   /* context */
   SeqRenderData context;
-  SeqRenderData context_cpy;
   ListBase *seqbasep;
   ListBase *seqbasep_cpy;
 
   /* prefetch area */
   float cfra;
   int num_frames_prefetched;
+  /** Number of frames starting at #seq_prefetch_cfra that are being rendered at the moment. */
+  int num_frames_rendering;
+  /** Memory used by the last prefetched frame, to estimate how many frames fit into the cache. */
+  size_t frame_memory;
 
   /* control */
   bool running;
@@ -177,50 +196,101 @@ static float seq_prefetch_cfra(PrefetchJob *pfjob)
 {
   return pfjob->cfra + pfjob->num_frames_prefetched;
 }
-static AnimationEvalContext seq_prefetch_anim_eval_context(PrefetchJob *pfjob)
-{
-  return BKE_animsys_eval_context_construct(pfjob->depsgraph, seq_prefetch_cfra(pfjob));
-}
 
 void seq_prefetch_get_time_range(Scene *scene, int *r_start, int *r_end)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(scene);
 
   *r_start = pfjob->cfra;
-  *r_end = seq_prefetch_cfra(pfjob);
+  *r_end = seq_prefetch_cfra(pfjob) + max_ii(pfjob->num_frames_rendering, 1) - 1;
 }
 
-static void seq_prefetch_free_depsgraph(PrefetchJob *pfjob)
+static int seq_prefetch_workers_num(const Scene *scene)
 {
-  if (pfjob->depsgraph != nullptr) {
-    DEG_graph_free(pfjob->depsgraph);
-  }
-  pfjob->depsgraph = nullptr;
-  pfjob->scene_eval = nullptr;
+  return std::clamp(scene->ed->prefetch_threads, 1, BLI_system_thread_count());
 }
 
-static void seq_prefetch_update_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_free_depsgraph(PrefetchWorker *worker)
 {
-  DEG_evaluate_on_framechange(pfjob->depsgraph, seq_prefetch_cfra(pfjob));
+  if (worker->depsgraph != nullptr) {
+    DEG_graph_free(worker->depsgraph);
+  }
+  worker->depsgraph = nullptr;
+  worker->scene_eval = nullptr;
 }
 
-static void seq_prefetch_init_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_init_depsgraph(PrefetchJob *pfjob, PrefetchWorker *worker)
 {
-  Main *bmain = pfjob->bmain_eval;
+  Main *bmain = worker->bmain_eval;
   Scene *scene = pfjob->scene;
   ViewLayer *view_layer = BKE_view_layer_default_render(scene);
 
-  pfjob->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
-  DEG_debug_name_set(pfjob->depsgraph, "SEQUENCER PREFETCH");
+  worker->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
+  DEG_debug_name_set(worker->depsgraph, "SEQUENCER PREFETCH");
 
   /* Make sure there is a correct evaluated scene pointer. */
-  DEG_graph_build_for_render_pipeline(pfjob->depsgraph);
+  DEG_graph_build_for_render_pipeline(worker->depsgraph);
 
   /* Update immediately so we have proper evaluated scene. */
-  seq_prefetch_update_depsgraph(pfjob);
+  DEG_evaluate_on_framechange(worker->depsgraph, seq_prefetch_cfra(pfjob));
 
-  pfjob->scene_eval = DEG_get_evaluated_scene(pfjob->depsgraph);
-  pfjob->scene_eval->ed->cache_flag = 0;
+  worker->scene_eval = DEG_get_evaluated_scene(worker->depsgraph);
+  worker->scene_eval->ed->cache_flag = 0;
+}
+
+static void seq_prefetch_free_workers(PrefetchJob *pfjob)
+{
+  for (int i = 0; i < pfjob->workers_num; i++) {
+    PrefetchWorker *worker = &pfjob->workers[i];
+    seq_prefetch_free_depsgraph(worker);
+    BKE_main_free(worker->bmain_eval);
+  }
+  MEM_SAFE_FREE(pfjob->workers);
+  pfjob->workers_num = 0;
+}
+
+/**
+ * Change the number of workers, existing workers are kept. The depsgraphs of new workers still
+ * have to be created afterwards.
+ */
+static void seq_prefetch_ensure_workers(PrefetchJob *pfjob, const int workers_num)
+{
+  if (pfjob->workers_num == workers_num) {
+    return;
+  }
+  PrefetchWorker *workers = MEM_cnew_array<PrefetchWorker>(workers_num, __func__);
+  for (int i = 0; i < std::max(workers_num, pfjob->workers_num); i++) {
+    if (i >= workers_num) {
+      seq_prefetch_free_depsgraph(&pfjob->workers[i]);
+      BKE_main_free(pfjob->workers[i].bmain_eval);
+    }
+    else if (i < pfjob->workers_num) {
+      workers[i] = pfjob->workers[i];
+    }
+    else {
+      workers[i].bmain_eval = BKE_main_new();
+    }
+  }
+  MEM_SAFE_FREE(pfjob->workers);
+  pfjob->workers = workers;
+  pfjob->workers_num = workers_num;
+}
+
+/**
+ * Every worker has its own evaluated copy of the scene. Limit the number of workers, so that the
+ * copies take at most half of the memory that is not in use yet.
+ */
+static int seq_prefetch_workers_num_fit_memory(const int workers_num,
+                                               const size_t worker_memory,
+                                               const size_t memory_in_use)
+{
+  if (worker_memory == 0) {
+    return workers_num;
+  }
+  const size_t memory_max = BLI_system_memory_max_in_megabytes() * 1024 * 1024;
+  const size_t memory_available = memory_max > memory_in_use ? memory_max - memory_in_use : 0;
+  const size_t extra_workers_fit = memory_available / 2 / worker_memory;
+  return int(std::min(size_t(workers_num), extra_workers_fit + 1));
 }
 
 static void seq_prefetch_update_area(PrefetchJob *pfjob)
@@ -276,19 +346,22 @@ static void seq_prefetch_update_context(const SeqRenderData *context)
   PrefetchJob *pfjob;
   pfjob = seq_prefetch_job_get(context->scene);
 
-  SEQ_render_new_render_data(pfjob->bmain_eval,
-                             pfjob->depsgraph,
-                             pfjob->scene_eval,
-                             context->rectx,
-                             context->recty,
-                             context->preview_render_size,
-                             false,
-                             &pfjob->context_cpy);
-  pfjob->context_cpy.is_prefetch_render = true;
-  pfjob->context_cpy.task_id = SEQ_TASK_PREFETCH_RENDER;
+  for (int i = 0; i < pfjob->workers_num; i++) {
+    PrefetchWorker *worker = &pfjob->workers[i];
+    SEQ_render_new_render_data(worker->bmain_eval,
+                               worker->depsgraph,
+                               worker->scene_eval,
+                               context->rectx,
+                               context->recty,
+                               context->preview_render_size,
+                               false,
+                               &worker->context_cpy);
+    worker->context_cpy.is_prefetch_render = true;
+    worker->context_cpy.task_id = SEQ_TASK_PREFETCH_RENDER;
+  }
 
   SEQ_render_new_render_data(pfjob->bmain,
-                             pfjob->depsgraph,
+                             pfjob->workers[0].depsgraph,
                              pfjob->scene,
                              context->rectx,
                              context->recty,
@@ -313,21 +386,40 @@ static void seq_prefetch_update_scene(Scene *scene)
   }
 
   pfjob->scene = scene;
-  seq_prefetch_free_depsgraph(pfjob);
-  seq_prefetch_init_depsgraph(pfjob);
+  seq_prefetch_ensure_workers(pfjob, seq_prefetch_workers_num(scene));
+  for (int i = 0; i < pfjob->workers_num; i++) {
+    seq_prefetch_free_depsgraph(&pfjob->workers[i]);
+  }
+
+  /* The first worker is used to measure the memory of an evaluated copy of the scene. */
+  const size_t memory_before = MEM_get_memory_in_use();
+  seq_prefetch_init_depsgraph(pfjob, &pfjob->workers[0]);
+  const size_t memory_in_use = MEM_get_memory_in_use();
+  const size_t worker_memory = memory_in_use > memory_before ? memory_in_use - memory_before : 0;
+
+  seq_prefetch_ensure_workers(
+      pfjob,
+      seq_prefetch_workers_num_fit_memory(pfjob->workers_num, worker_memory, memory_in_use));
+  for (int i = 1; i < pfjob->workers_num; i++) {
+    seq_prefetch_init_depsgraph(pfjob, &pfjob->workers[i]);
+  }
 }
 
 static void seq_prefetch_update_active_seqbase(PrefetchJob *pfjob)
 {
   MetaStack *ms_orig = SEQ_meta_stack_active_get(SEQ_editing_get(pfjob->scene));
-  Editing *ed_eval = SEQ_editing_get(pfjob->scene_eval);
 
-  if (ms_orig != nullptr) {
-    Sequence *meta_eval = seq_prefetch_get_original_sequence(ms_orig->parseq, pfjob->scene_eval);
-    SEQ_seqbase_active_set(ed_eval, &meta_eval->seqbase);
-  }
-  else {
-    SEQ_seqbase_active_set(ed_eval, &ed_eval->seqbase);
+  for (int i = 0; i < pfjob->workers_num; i++) {
+    Scene *scene_eval = pfjob->workers[i].scene_eval;
+    Editing *ed_eval = SEQ_editing_get(scene_eval);
+
+    if (ms_orig != nullptr) {
+      Sequence *meta_eval = seq_prefetch_get_original_sequence(ms_orig->parseq, scene_eval);
+      SEQ_seqbase_active_set(ed_eval, &meta_eval->seqbase);
+    }
+    else {
+      SEQ_seqbase_active_set(ed_eval, &ed_eval->seqbase);
+    }
   }
 }
 
@@ -353,18 +445,17 @@ void seq_prefetch_free(Scene *scene)
   BLI_threadpool_end(&pfjob->threads);
   BLI_mutex_end(&pfjob->prefetch_suspend_mutex);
   BLI_condition_end(&pfjob->prefetch_suspend_cond);
-  seq_prefetch_free_depsgraph(pfjob);
-  BKE_main_free(pfjob->bmain_eval);
+  seq_prefetch_free_workers(pfjob);
   MEM_freeN(pfjob);
   scene->ed->prefetch_job = nullptr;
 }
 
-static bool seq_prefetch_seq_has_disk_cache(PrefetchJob *pfjob,
+static bool seq_prefetch_seq_has_disk_cache(PrefetchWorker *worker,
                                             Sequence *seq,
+                                            float cfra,
                                             bool can_have_final_image)
 {
-  SeqRenderData *ctx = &pfjob->context_cpy;
-  float cfra = seq_prefetch_cfra(pfjob);
+  SeqRenderData *ctx = &worker->context_cpy;
 
   ImBuf *ibuf = seq_cache_get(ctx, seq, cfra, SEQ_CACHE_STORE_PREPROCESSED);
   if (ibuf != nullptr) {
@@ -391,27 +482,28 @@ static bool seq_prefetch_seq_has_disk_cache(PrefetchJob *pfjob,
   return false;
 }
 
-static bool seq_prefetch_scene_strip_is_rendered(PrefetchJob *pfjob,
+static bool seq_prefetch_scene_strip_is_rendered(PrefetchWorker *worker,
+                                                 float cfra,
                                                  ListBase *channels,
                                                  ListBase *seqbase,
                                                  blender::Span<Sequence *> scene_strips,
                                                  bool is_recursive_check)
 {
-  float cfra = seq_prefetch_cfra(pfjob);
   blender::Vector<Sequence *> strips = seq_get_shown_sequences(
-      pfjob->scene_eval, channels, seqbase, cfra, 0);
+      worker->scene_eval, channels, seqbase, cfra, 0);
 
   /* Iterate over rendered strips. */
   for (Sequence *seq : strips) {
     if (seq->type == SEQ_TYPE_META &&
-        seq_prefetch_scene_strip_is_rendered(pfjob, channels, &seq->seqbase, scene_strips, true))
+        seq_prefetch_scene_strip_is_rendered(
+            worker, cfra, channels, &seq->seqbase, scene_strips, true))
     {
       return true;
     }
 
     /* Disable prefetching 3D scene strips, but check for disk cache. */
     if (seq->type == SEQ_TYPE_SCENE && (seq->flag & SEQ_SCENE_STRIPS) == 0 &&
-        !seq_prefetch_seq_has_disk_cache(pfjob, seq, !is_recursive_check))
+        !seq_prefetch_seq_has_disk_cache(worker, seq, cfra, !is_recursive_check))
     {
       return true;
     }
@@ -439,10 +531,14 @@ static blender::VectorSet<Sequence *> query_scene_strips(ListBase *seqbase)
 
 /* Prefetch must avoid rendering scene strips, because rendering in background locks UI and can
  * make it unresponsive for long time periods. */
-static bool seq_prefetch_must_skip_frame(PrefetchJob *pfjob, ListBase *channels, ListBase *seqbase)
+static bool seq_prefetch_must_skip_frame(PrefetchWorker *worker,
+                                         float cfra,
+                                         ListBase *channels,
+                                         ListBase *seqbase)
 {
   blender::VectorSet<Sequence *> scene_strips = query_scene_strips(seqbase);
-  if (seq_prefetch_scene_strip_is_rendered(pfjob, channels, seqbase, scene_strips, false)) {
+  if (seq_prefetch_scene_strip_is_rendered(worker, cfra, channels, seqbase, scene_strips, false))
+  {
     return true;
   }
   return false;
@@ -468,31 +564,89 @@ static void seq_prefetch_do_suspend(PrefetchJob *pfjob)
   BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
 }
 
+/**
+ * Number of frames that are rendered at the same time next. This is limited by the number of
+ * workers and by the memory that is still available in the cache.
+ */
+static int seq_prefetch_frames_num_to_render(PrefetchJob *pfjob)
+{
+  int frames_num = min_ii(pfjob->workers_num,
+                          int(pfjob->scene->r.efra - seq_prefetch_cfra(pfjob)) + 1);
+  if (pfjob->frame_memory > 0) {
+    const size_t frames_fit = seq_cache_memory_available() / pfjob->frame_memory;
+    frames_num = int(std::min(size_t(frames_num), frames_fit));
+  }
+  return max_ii(frames_num, 1);
+}
+
+/**
+ * Render a single frame with the given worker.
+ * \return False if the frame has been skipped.
+ */
+static bool seq_prefetch_render_frame(PrefetchJob *pfjob,
+                                      PrefetchWorker *worker,
+                                      const float cfra,
+                                      size_t *r_frame_memory)
+{
+  worker->scene_eval->ed->prefetch_job = nullptr;
+
+  DEG_evaluate_on_framechange(worker->depsgraph, cfra);
+  AnimData *adt = BKE_animdata_from_id(&worker->context_cpy.scene->id);
+  AnimationEvalContext anim_eval_context = BKE_animsys_eval_context_construct(worker->depsgraph,
+                                                                              cfra);
+  BKE_animsys_evaluate_animdata(
+      &worker->context_cpy.scene->id, adt, &anim_eval_context, ADT_RECALC_ALL, false);
+
+  /* This is quite hacky solution:
+   * We need cross-reference original scene with copy for cache.
+   * However depsgraph must not have this data, because it will try to kill this job.
+   * Scene copy don't reference original scene. Perhaps, this could be done by depsgraph.
+   * Set to nullptr before return!
+   */
+  worker->scene_eval->ed->prefetch_job = pfjob;
+
+  ListBase *seqbase = SEQ_active_seqbase_get(SEQ_editing_get(worker->scene_eval));
+  ListBase *channels = SEQ_channels_displayed_get(SEQ_editing_get(worker->scene_eval));
+  if (seq_prefetch_must_skip_frame(worker, cfra, channels, seqbase)) {
+    return false;
+  }
+
+  ImBuf *ibuf = SEQ_render_give_ibuf(&worker->context_cpy, cfra, 0);
+  if (ibuf != nullptr) {
+    *r_frame_memory = IMB_get_size_in_memory(ibuf);
+  }
+  IMB_freeImBuf(ibuf);
+  return true;
+}
+
 static void *seq_prefetch_frames(void *job)
 {
+  using namespace blender;
   PrefetchJob *pfjob = (PrefetchJob *)job;
 
   while (seq_prefetch_cfra(pfjob) <= pfjob->scene->r.efra) {
-    pfjob->scene_eval->ed->prefetch_job = nullptr;
-
-    seq_prefetch_update_depsgraph(pfjob);
-    AnimData *adt = BKE_animdata_from_id(&pfjob->context_cpy.scene->id);
-    AnimationEvalContext anim_eval_context = seq_prefetch_anim_eval_context(pfjob);
-    BKE_animsys_evaluate_animdata(
-        &pfjob->context_cpy.scene->id, adt, &anim_eval_context, ADT_RECALC_ALL, false);
-
-    /* This is quite hacky solution:
-     * We need cross-reference original scene with copy for cache.
-     * However depsgraph must not have this data, because it will try to kill this job.
-     * Scene copy don't reference original scene. Perhaps, this could be done by depsgraph.
-     * Set to nullptr before return!
-     */
-    pfjob->scene_eval->ed->prefetch_job = pfjob;
-
-    ListBase *seqbase = SEQ_active_seqbase_get(SEQ_editing_get(pfjob->scene_eval));
-    ListBase *channels = SEQ_channels_displayed_get(SEQ_editing_get(pfjob->scene_eval));
-    if (seq_prefetch_must_skip_frame(pfjob, channels, seqbase)) {
-      pfjob->num_frames_prefetched++;
+    /* Render multiple consecutive frames at the same time. The prefetched range is only extended
+     * once all of them are done, so that it does not have gaps. */
+    const int frames_num = seq_prefetch_frames_num_to_render(pfjob);
+    const float first_cfra = seq_prefetch_cfra(pfjob);
+    Array<bool> rendered(frames_num, false);
+    Array<size_t> frame_memory(frames_num, 0);
+    pfjob->num_frames_rendering = frames_num;
+    threading::parallel_for(IndexRange(frames_num), 1, [&](const IndexRange range) {
+      for (const int i : range) {
+        rendered[i] = seq_prefetch_render_frame(
+            pfjob, &pfjob->workers[i], first_cfra + i, &frame_memory[i]);
+      }
+    });
+    pfjob->num_frames_rendering = 1;
+    /* Workers share the temporary cache, so it's only cleared once all of them are done. */
+    seq_cache_free_temp_cache(pfjob->scene, pfjob->context.task_id, first_cfra + frames_num - 1);
+    for (const size_t memory : frame_memory) {
+      pfjob->frame_memory = std::max(pfjob->frame_memory, memory);
+    }
+
+    if (!rendered.as_span().contains(true)) {
+      pfjob->num_frames_prefetched += frames_num;
       /* Break instead of keep looping if the job should be terminated. */
       if (!(pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) || pfjob->stop) {
         break;
@@ -500,9 +654,8 @@ static void *seq_prefetch_frames(void *job)
       continue;
     }
 
-    ImBuf *ibuf = SEQ_render_give_ibuf(&pfjob->context_cpy, seq_prefetch_cfra(pfjob), 0);
-    seq_cache_free_temp_cache(pfjob->scene, pfjob->context.task_id, seq_prefetch_cfra(pfjob));
-    IMB_freeImBuf(ibuf);
+    /* Continue as if the last frame of the batch was rendered on its own. */
+    pfjob->num_frames_prefetched += frames_num - 1;
 
     /* Suspend thread if there is nothing to be prefetched. */
     seq_prefetch_do_suspend(pfjob);
@@ -523,7 +676,9 @@ static void *seq_prefetch_frames(void *job)
 
   seq_cache_free_temp_cache(pfjob->scene, pfjob->context.task_id, seq_prefetch_cfra(pfjob));
   pfjob->running = false;
-  pfjob->scene_eval->ed->prefetch_job = nullptr;
+  for (int i = 0; i < pfjob->workers_num; i++) {
+    pfjob->workers[i].scene_eval->ed->prefetch_job = nullptr;
+  }
 
   return nullptr;
 }
@@ -541,15 +696,15 @@ static PrefetchJob *seq_prefetch_start_ex(const SeqRenderData *context, float cf
       BLI_mutex_init(&pfjob->prefetch_suspend_mutex);
       BLI_condition_init(&pfjob->prefetch_suspend_cond);
 
-      pfjob->bmain_eval = BKE_main_new();
       pfjob->scene = context->scene;
-      seq_prefetch_init_depsgraph(pfjob);
     }
   }
   pfjob->bmain = context->bmain;
 
   pfjob->cfra = cfra;
   pfjob->num_frames_prefetched = 1;
+  pfjob->num_frames_rendering = 1;
+  pfjob->frame_memory = 0;
 
   pfjob->waiting = false;
   pfjob->stop = false;
@@ -83,7 +83,12 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
                                      float timeline_frame,
                                      int chanshown);
 
-static ThreadMutex seq_render_mutex = BLI_MUTEX_INITIALIZER;
+/* Prefetch threads render different frames with their own evaluated copy of the scene, so they
+ * only have to be kept from rendering at the same time as the main thread. The turnstile makes
+ * sure that the main thread does not have to wait for all prefetch threads to become idle at the
+ * same time. */
+static ThreadRWMutex seq_render_mutex = BLI_RWLOCK_INITIALIZER;
+static ThreadMutex seq_render_turnstile = BLI_MUTEX_INITIALIZER;
 SequencerDrawView sequencer_view3d_fn = nullptr; /* nullptr in background mode */
 
 /* -------------------------------------------------------------------- */
@@ -2145,7 +2150,15 @@ ImBuf *SEQ_render_give_ibuf(const SeqRenderData *context, float timeline_frame,
   SEQ_relations_free_all_anim_ibufs(context->scene, timeline_frame);
 
   if (!strips.is_empty() && !out) {
-    BLI_mutex_lock(&seq_render_mutex);
+    BLI_mutex_lock(&seq_render_turnstile);
+    if (context->is_prefetch_render) {
+      BLI_mutex_unlock(&seq_render_turnstile);
+      BLI_rw_mutex_lock(&seq_render_mutex, THREAD_LOCK_READ);
+    }
+    else {
+      BLI_rw_mutex_lock(&seq_render_mutex, THREAD_LOCK_WRITE);
+      BLI_mutex_unlock(&seq_render_turnstile);
+    }
     out = seq_render_strip_stack(context, &state, channels, seqbasep, timeline_frame, chanshown);
 
     if (context->is_prefetch_render) {
@@ -2155,7 +2168,7 @@ ImBuf *SEQ_render_give_ibuf(const SeqRenderData *context, float timeline_frame,
       seq_cache_put_if_possible(
           context, strips.last(), timeline_frame, SEQ_CACHE_STORE_FINAL_OUT, out);
     }
-    BLI_mutex_unlock(&seq_render_mutex);
+    BLI_rw_mutex_unlock(&seq_render_mutex);
   }
 
   seq_prefetch_start(context, timeline_frame);
@@ -219,6 +219,12 @@ static void open_anim_filepath(Sequence *seq,
                                   seq->streamindex,
                                   seq->strip->colorspace_settings.name);
   }
+
+  if (sanim->anim) {
+    /* Decode a few frames ahead during playback, without using too much memory for large
+     * movies. */
+    IMB_anim_set_read_ahead(sanim->anim, 4);
+  }
 }
 
 static bool use_proxy(Editing *ed, Sequence *seq)
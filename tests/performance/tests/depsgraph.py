@@ -0,0 +1,99 @@
+# SPDX-FileCopyrightText: 2024 Blender Authors
+#
+# SPDX-License-Identifier: Apache-2.0
+
+import api
+
+
+def _run(args):
+    import bpy
+    import time
+
+    num_objects = args['num_objects']
+
+    # Synthetic scene: objects sharing a mesh, parented in small chains and
+    # constrained to each other, so that every object has a few relations.
+    mesh = bpy.data.meshes.new("Mesh")
+    mesh.from_pydata([(0.0, 0.0, 0.0), (1.0, 0.0, 0.0), (0.0, 1.0, 0.0)], [], [(0, 1, 2)])
+
+    collection = bpy.context.scene.collection
+    objects = []
+    for i in range(num_objects):
+        ob = bpy.data.objects.new(f"Object{i}", mesh)
+        ob.location = (i % 100, i // 100, 0.0)
+        if i % 10 != 0:
+            ob.parent = objects[-1]
+        if i % 7 == 0 and i > 0:
+            constraint = ob.constraints.new('COPY_ROTATION')
+            constraint.target = objects[i // 2]
+        collection.objects.link(ob)
+        objects.append(ob)
+
+    view_layer = bpy.context.view_layer
+    view_layer.update()
+
+    # Measure rebuilding relations after a structural change, which is what
+    # happens when objects are added to or removed from the scene.
+    extra_object = bpy.data.objects.new("Extra", None)
+
+    # Only the number of updates is returned, the time spent building relations is printed by
+    # Blender for every update and parsed from the output. Timing the whole update would include
+    # evaluation, which is also single threaded with --debug-depsgraph-no-threads.
+    start_time = time.time()
+    elapsed_time = 0.0
+    num_updates = 0
+
+    while elapsed_time < 10.0 or num_updates < 2:
+        if num_updates % 2 == 0:
+            collection.objects.link(extra_object)
+        else:
+            collection.objects.unlink(extra_object)
+        view_layer.update()
+
+        num_updates += 1
+        elapsed_time = time.time() - start_time
+
+    result = {'num_updates': num_updates}
+    return result
+
+
+def _parse_build_times(lines, num_updates):
+    prefix = "Depsgraph built in "
+    build_times = [float(line[len(prefix):].split()[0])
+                   for line in lines if line.startswith(prefix)]
+    # Builds of the initial scene come first, only keep the measured updates.
+    return build_times[-num_updates:]
+
+
+class DepsgraphBuildTest(api.Test):
+    def __init__(self, num_objects, use_threads):
+        self.num_objects = num_objects
+        self.use_threads = use_threads
+
+    def name(self):
+        suffix = "" if self.use_threads else "_no_threads"
+        return f"relations_rebuild_{self.num_objects}_objects{suffix}"
+
+    def category(self):
+        return "depsgraph"
+
+    def run(self, env, device_id):
+        args = {'num_objects': self.num_objects}
+        # Single threaded build as a reference for the parallel passes of the builders.
+        blender_args = ['--debug-depsgraph-time']
+        if not self.use_threads:
+            blender_args.append('--debug-depsgraph-no-threads')
+        result, lines = env.run_in_blender(_run, args, blender_args)
+        if not result:
+            return result
+
+        build_times = _parse_build_times(lines, result['num_updates'])
+        if len(build_times) != result['num_updates']:
+            raise Exception("Depsgraph build times not found in output")
+        return {'time': sum(build_times) / len(build_times)}
+
+
+def generate(env):
+    return [DepsgraphBuildTest(num_objects, use_threads)
+            for num_objects in (10000, 100000)
+            for use_threads in (True, False)]